@@ -0,0 +1,1652 @@
+// OBJ import (welded, unwelded, multithreaded and the old stream parser), binary FBX import, cooked .mesh loads, vertex welding,
+// index optimization, 16-bit index splitting, vertex packing, simplification, meshlet building and culling and the tangent
+// pass on synthetic meshes from 10k up to 10M triangles.
+// The meshes are wavy grids written once to the temp directory and reused by later runs; the FBX import is also
+// measured on the shipped Resources/AK47_CS2.fbx against the same mesh as OBJ, which is also optimized and cooked with its LOD chain.
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "Benchmark.h"
+#include "SdlStubs.h"
+
+#include "FBXImport.h"
+#include "Camera.h"
+#include "Math.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+#include "TangentSpace.h"
+#include "Utils.h"
+#include "VertexPacking.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	struct MeshSize
+	{
+		const char* pName;
+		uint64_t triangles;
+	};
+
+	constexpr MeshSize meshSizes[]{ { "10k", 10'000 }, { "100k", 100'000 }, { "1m", 1'000'000 }, { "10m", 10'000'000 } };
+
+	//The stream parser needs ~25 s for the 10M mesh, so it is only measured up to this size
+	constexpr uint64_t maxStreamParseTriangles{ 1'000'000 };
+	//The simplifier keeps ~100 bytes of quadrics and adjacency per vertex, the 10M mesh is left out
+	constexpr uint64_t maxSimplifyTriangles{ 1'000'000 };
+
+	void AppendFloat(std::string& text, float value)
+	{
+		char buffer[32];
+		const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		text.append(buffer, result.ptr);
+	}
+
+	void AppendIndex(std::string& text, uint64_t value)
+	{
+		char buffer[24];
+		const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		text.append(buffer, result.ptr);
+	}
+
+	//(side + 1)^2 shared v/vt/vn and 2 * side^2 faces "f a/a/a b/b/b c/c/c", the layout exporters produce
+	bool WriteGridOBJ(const std::filesystem::path& path, uint32_t side)
+	{
+		const std::filesystem::path tempPath = path.string() + ".tmp";
+		std::ofstream file{ tempPath, std::ios::binary };
+		if (!file)
+			return false;
+
+		std::string text{};
+		const auto flush = [&](bool force)
+			{
+				if (force || text.size() > (1u << 20))
+				{
+					file.write(text.data(), static_cast<std::streamsize>(text.size()));
+					text.clear();
+				}
+			};
+
+		text += "# synthetic benchmark grid\n";
+		const float invSide = 1.f / static_cast<float>(side);
+		for (uint32_t y{ 0 }; y <= side; ++y)
+		{
+			for (uint32_t x{ 0 }; x <= side; ++x)
+			{
+				const float fx = static_cast<float>(x), fy = static_cast<float>(y);
+				text += "v ";
+				AppendFloat(text, fx);
+				text += ' ';
+				AppendFloat(text, std::sin(fx * 0.1f) * std::cos(fy * 0.1f));
+				text += ' ';
+				AppendFloat(text, fy);
+				text += '\n';
+				flush(false);
+			}
+		}
+		for (uint32_t y{ 0 }; y <= side; ++y)
+		{
+			for (uint32_t x{ 0 }; x <= side; ++x)
+			{
+				text += "vt ";
+				AppendFloat(text, static_cast<float>(x) * invSide);
+				text += ' ';
+				AppendFloat(text, static_cast<float>(y) * invSide);
+				text += '\n';
+				flush(false);
+			}
+		}
+		for (uint32_t y{ 0 }; y <= side; ++y)
+		{
+			for (uint32_t x{ 0 }; x <= side; ++x)
+			{
+				const Vector3 normal = Vector3{ -std::cos(x * 0.1f) * 0.1f, 1.f, std::sin(y * 0.1f) * 0.1f }.Normalized();
+				text += "vn ";
+				AppendFloat(text, normal.x);
+				text += ' ';
+				AppendFloat(text, normal.y);
+				text += ' ';
+				AppendFloat(text, normal.z);
+				text += '\n';
+				flush(false);
+			}
+		}
+
+		const auto appendCorner = [&](uint64_t index)
+			{
+				text += ' ';
+				AppendIndex(text, index);
+				text += '/';
+				AppendIndex(text, index);
+				text += '/';
+				AppendIndex(text, index);
+			};
+
+		for (uint32_t y{ 0 }; y < side; ++y)
+		{
+			for (uint32_t x{ 0 }; x < side; ++x)
+			{
+				const uint64_t i00 = uint64_t(y) * (side + 1) + x + 1; //OBJ indices are 1-based
+				const uint64_t i10 = i00 + 1;
+				const uint64_t i01 = i00 + side + 1;
+				const uint64_t i11 = i01 + 1;
+
+				text += 'f'; appendCorner(i00); appendCorner(i10); appendCorner(i01); text += '\n';
+				text += 'f'; appendCorner(i10); appendCorner(i11); appendCorner(i01); text += '\n';
+				flush(false);
+			}
+		}
+		flush(true);
+		file.close();
+		if (!file)
+			return false;
+
+		std::error_code error{};
+		std::filesystem::rename(tempPath, path, error);
+		return !error;
+	}
+
+	std::filesystem::path GetGridOBJ(const MeshSize& size, uint32_t side)
+	{
+		std::error_code error{};
+		const std::filesystem::path directory = std::filesystem::temp_directory_path(error) / "directx_benchmark";
+		std::filesystem::create_directories(directory, error);
+
+		const std::filesystem::path path = directory / (std::string{ "grid_" } + size.pName + ".obj");
+		if (!std::filesystem::exists(path))
+		{
+			std::fprintf(stderr, "Writing %s...\n", path.string().c_str());
+			if (!WriteGridOBJ(path, side))
+				return {};
+		}
+		return path;
+	}
+
+	//Binary FBX 7400 records: a node is its end offset, property count and size, name, properties and, when it has
+	//children, those followed by a null record
+	class FBXWriter final
+	{
+	public:
+		FBXWriter()
+		{
+			m_Bytes.append("Kaydara FBX Binary  \0\x1A\0", 23);
+			Append<uint32_t>(7400);
+		}
+
+		void BeginNode(std::string_view name)
+		{
+			CloseProperties();
+			m_Open.push_back({ m_Bytes.size() });
+			m_Bytes.append(12, '\0');
+			m_Bytes += static_cast<char>(name.size());
+			m_Bytes += name;
+			m_Open.back().propertyStart = m_Bytes.size();
+		}
+
+		void EndNode()
+		{
+			OpenNode& node = m_Open.back();
+			if (node.hasChildren)
+				m_Bytes.append(13, '\0');
+			else
+				CloseProperties();
+			Patch<uint32_t>(node.start, static_cast<uint32_t>(m_Bytes.size()));
+			Patch<uint32_t>(node.start + 4, node.propertyCount);
+			Patch<uint32_t>(node.start + 8, static_cast<uint32_t>(node.propertyEnd - node.propertyStart));
+			m_Open.pop_back();
+		}
+
+		void AddString(std::string_view value)
+		{
+			AddProperty('S');
+			Append<uint32_t>(static_cast<uint32_t>(value.size()));
+			m_Bytes += value;
+		}
+
+		void AddInteger(int32_t value) { AddProperty('I'); Append(value); }
+		void AddLong(int64_t value) { AddProperty('L'); Append(value); }
+		void AddDouble(double value) { AddProperty('D'); Append(value); }
+
+		//Uncompressed: the deflate path is covered by the exported file
+		template<typename T>
+		void AddArray(const std::vector<T>& values)
+		{
+			AddProperty(std::is_same_v<T, double> ? 'd' : 'i');
+			Append<uint32_t>(static_cast<uint32_t>(values.size()));
+			Append<uint32_t>(0);
+			Append<uint32_t>(static_cast<uint32_t>(values.size() * sizeof(T)));
+			m_Bytes.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+		}
+
+		//A node with one property, the way most of FBX's fields are stored
+		template<typename T>
+		void AddField(std::string_view name, const T& value)
+		{
+			BeginNode(name);
+			if constexpr (std::is_same_v<T, std::vector<double>> || std::is_same_v<T, std::vector<int32_t>>)
+				AddArray(value);
+			else if constexpr (std::is_integral_v<T>)
+				AddInteger(value);
+			else
+				AddString(value);
+			EndNode();
+		}
+
+		//"OO" connection of child to parent, "OP" to one of its properties
+		void AddConnection(int64_t child, int64_t parent, std::string_view property = {})
+		{
+			BeginNode("C");
+			AddString(property.empty() ? "OO" : "OP");
+			AddLong(child);
+			AddLong(parent);
+			if (!property.empty())
+				AddString(property);
+			EndNode();
+		}
+
+		//Ends the top level
+		const std::string& Finish()
+		{
+			m_Bytes.append(13, '\0');
+			return m_Bytes;
+		}
+
+	private:
+		struct OpenNode
+		{
+			size_t start{};
+			size_t propertyStart{};
+			size_t propertyEnd{};
+			uint32_t propertyCount{};
+			bool hasChildren{};
+		};
+
+		std::string m_Bytes{};
+		std::vector<OpenNode> m_Open{};
+
+		template<typename T>
+		void Append(T value) { m_Bytes.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+		template<typename T>
+		void Patch(size_t offset, T value) { std::memcpy(m_Bytes.data() + offset, &value, sizeof(T)); }
+
+		void AddProperty(char type)
+		{
+			++m_Open.back().propertyCount;
+			m_Bytes += type;
+		}
+
+		//The parent's properties end where its first child starts
+		void CloseProperties()
+		{
+			if (m_Open.empty() || m_Open.back().hasChildren)
+				return;
+			m_Open.back().propertyEnd = m_Bytes.size();
+			m_Open.back().hasChildren = true;
+		}
+	};
+
+	constexpr int64_t gridGeometryId{ 1 }, gridModelId{ 2 }, gridMaterialId{ 3 }, gridTextureId{ 4 }, gridSkinId{ 5 };
+	//Two bones, their clusters with ids boneClusterId + bone and their models boneModelId + bone
+	constexpr int64_t boneClusterId{ 10 }, boneModelId{ 20 };
+
+	//The same grid as WriteGridOBJ as one Geometry: control points, normals by control point and uvs indexed per corner.
+	//It also has a material with a diffuse texture and a skin of two bones, the first weighted x / side and the
+	//second 1 - x / side.
+	bool WriteGridFBX(const std::filesystem::path& path, uint32_t side)
+	{
+		const size_t pointCount = size_t(side + 1) * (side + 1);
+		const float invSide = 1.f / static_cast<float>(side);
+		std::vector<double> positions{}, normals{}, uvs{};
+		positions.reserve(pointCount * 3);
+		normals.reserve(pointCount * 3);
+		uvs.reserve(pointCount * 2);
+		for (uint32_t y{ 0 }; y <= side; ++y)
+		{
+			for (uint32_t x{ 0 }; x <= side; ++x)
+			{
+				const float fx = static_cast<float>(x), fy = static_cast<float>(y);
+				const Vector3 normal = Vector3{ -std::cos(x * 0.1f) * 0.1f, 1.f, std::sin(y * 0.1f) * 0.1f }.Normalized();
+				positions.insert(positions.end(), { fx, std::sin(fx * 0.1f) * std::cos(fy * 0.1f), fy });
+				normals.insert(normals.end(), { normal.x, normal.y, normal.z });
+				uvs.insert(uvs.end(), { static_cast<float>(x) * invSide, static_cast<float>(y) * invSide });
+			}
+		}
+
+		//The last corner of a polygon is stored as ~index
+		std::vector<int32_t> polygonVertices{}, uvIndices{};
+		polygonVertices.reserve(size_t(side) * side * 6);
+		for (uint32_t y{ 0 }; y < side; ++y)
+		{
+			for (uint32_t x{ 0 }; x < side; ++x)
+			{
+				const int32_t i00 = static_cast<int32_t>(y * (side + 1) + x);
+				const int32_t i10 = i00 + 1;
+				const int32_t i01 = i00 + static_cast<int32_t>(side) + 1;
+				const int32_t i11 = i01 + 1;
+				polygonVertices.insert(polygonVertices.end(), { i00, i10, ~i01, i10, i11, ~i01 });
+				uvIndices.insert(uvIndices.end(), { i00, i10, i01, i10, i11, i01 });
+			}
+		}
+
+		FBXWriter writer{};
+		writer.BeginNode("FBXHeaderExtension");
+		writer.AddField("FBXVersion", 7400);
+		writer.EndNode();
+
+		writer.BeginNode("Objects");
+		writer.BeginNode("Geometry");
+		writer.AddLong(gridGeometryId);
+		writer.AddString(std::string_view{ "grid\0\1Geometry", 14 });
+		writer.AddString("Mesh");
+		writer.AddField("Vertices", positions);
+		writer.AddField("PolygonVertexIndex", polygonVertices);
+		writer.BeginNode("LayerElementNormal");
+		writer.AddInteger(0);
+		writer.AddField("MappingInformationType", "ByControlPoint");
+		writer.AddField("ReferenceInformationType", "Direct");
+		writer.AddField("Normals", normals);
+		writer.EndNode();
+		writer.BeginNode("LayerElementUV");
+		writer.AddInteger(0);
+		writer.AddField("MappingInformationType", "ByPolygonVertex");
+		writer.AddField("ReferenceInformationType", "IndexToDirect");
+		writer.AddField("UV", uvs);
+		writer.AddField("UVIndex", uvIndices);
+		writer.EndNode();
+		writer.BeginNode("LayerElementMaterial");
+		writer.AddInteger(0);
+		writer.AddField("MappingInformationType", "AllSame");
+		writer.AddField("ReferenceInformationType", "IndexToDirect");
+		writer.AddField("Materials", std::vector<int32_t>{ 0 });
+		writer.EndNode();
+		writer.EndNode();
+
+		writer.BeginNode("Model");
+		writer.AddLong(gridModelId);
+		writer.AddString(std::string_view{ "grid\0\1Model", 11 });
+		writer.AddString("Mesh");
+		writer.EndNode();
+
+		writer.BeginNode("Material");
+		writer.AddLong(gridMaterialId);
+		writer.AddString(std::string_view{ "grid_material\0\1Material", 23 });
+		writer.AddString("");
+		writer.EndNode();
+
+		writer.BeginNode("Texture");
+		writer.AddLong(gridTextureId);
+		writer.AddString(std::string_view{ "grid_color\0\1Texture", 19 });
+		writer.AddString("");
+		writer.AddField("RelativeFilename", "grid_color.png");
+		writer.EndNode();
+
+		writer.BeginNode("Deformer");
+		writer.AddLong(gridSkinId);
+		writer.AddString(std::string_view{ "grid\0\1Deformer", 14 });
+		writer.AddString("Skin");
+		writer.EndNode();
+
+		std::vector<int32_t> clusterIndices(pointCount);
+		std::vector<double> clusterWeights(pointCount);
+		for (int64_t bone{ 0 }; bone < 2; ++bone)
+		{
+			for (size_t point{ 0 }; point < pointCount; ++point)
+			{
+				const double weight = static_cast<double>(point % (side + 1)) / side;
+				clusterIndices[point] = static_cast<int32_t>(point);
+				clusterWeights[point] = bone == 0 ? weight : 1.0 - weight;
+			}
+
+			const std::string boneName = "bone" + std::to_string(bone);
+			writer.BeginNode("Deformer");
+			writer.AddLong(boneClusterId + bone);
+			writer.AddString(boneName + std::string{ "\0\1SubDeformer", 13 });
+			writer.AddString("Cluster");
+			writer.AddField("Indexes", clusterIndices);
+			writer.AddField("Weights", clusterWeights);
+			writer.EndNode();
+
+			writer.BeginNode("Model");
+			writer.AddLong(boneModelId + bone);
+			writer.AddString(boneName + std::string{ "\0\1Model", 7 });
+			writer.AddString("LimbNode");
+			writer.EndNode();
+		}
+		writer.EndNode();
+
+		writer.BeginNode("Connections");
+		writer.AddConnection(gridModelId, 0);
+		writer.AddConnection(gridGeometryId, gridModelId);
+		writer.AddConnection(gridMaterialId, gridModelId);
+		writer.AddConnection(gridTextureId, gridMaterialId, "DiffuseColor");
+		writer.AddConnection(gridSkinId, gridGeometryId);
+		for (int64_t bone{ 0 }; bone < 2; ++bone)
+		{
+			writer.AddConnection(boneClusterId + bone, gridSkinId);
+			writer.AddConnection(boneModelId + bone, boneClusterId + bone);
+		}
+		writer.EndNode();
+
+		const std::filesystem::path tempPath = path.string() + ".tmp";
+		{
+			const std::string& bytes = writer.Finish();
+			std::ofstream file{ tempPath, std::ios::binary };
+			if (!file.write(bytes.data(), static_cast<std::streamsize>(bytes.size())))
+				return false;
+		}
+
+		std::error_code error{};
+		std::filesystem::rename(tempPath, path, error);
+		return !error;
+	}
+
+	std::filesystem::path GetGridFBX(const MeshSize& size, uint32_t side)
+	{
+		std::filesystem::path path = GetGridOBJ(size, side);
+		if (path.empty())
+			return {};
+
+		path.replace_extension(".fbx");
+		if (!std::filesystem::exists(path))
+		{
+			std::fprintf(stderr, "Writing %s...\n", path.string().c_str());
+			if (!WriteGridFBX(path, side))
+				return {};
+		}
+		return path;
+	}
+
+	//The imported mesh back as an OBJ (mirrored back to the file's right-handed space), so both formats load the same asset
+	bool WriteMeshOBJ(const std::filesystem::path& path, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		std::ofstream file{ path, std::ios::binary };
+		if (!file)
+			return false;
+
+		std::string text{};
+		const auto appendVector = [&text](const char* pCommand, std::initializer_list<float> values)
+			{
+				text += pCommand;
+				for (const float value : values)
+				{
+					text += ' ';
+					AppendFloat(text, value);
+				}
+				text += '\n';
+			};
+		for (const Vertex& vertex : vertices)
+			appendVector("v", { vertex.position.x, vertex.position.y, -vertex.position.z });
+		for (const Vertex& vertex : vertices)
+			appendVector("vt", { vertex.uv.x, 1.f - vertex.uv.y });
+		for (const Vertex& vertex : vertices)
+			appendVector("vn", { vertex.normal.x, vertex.normal.y, -vertex.normal.z });
+
+		//The import flips the winding, so the file has it the other way around
+		for (size_t i{ 0 }; i + 2 < indices.size(); i += 3)
+		{
+			text += 'f';
+			for (const uint32_t index : { indices[i], indices[i + 2], indices[i + 1] })
+			{
+				text += ' ';
+				for (int component{ 0 }; component < 3; ++component)
+				{
+					if (component > 0)
+						text += '/';
+					AppendIndex(text, uint64_t(index) + 1);
+				}
+			}
+			text += '\n';
+		}
+		file.write(text.data(), static_cast<std::streamsize>(text.size()));
+		return static_cast<bool>(file);
+	}
+
+	//The vertex every corner uses agrees: positions, uvs and normals exactly, tangents within tolerance (regenerated from
+	//differently ordered vertices)
+	bool HaveSameCorners(const std::vector<Vertex>& verticesA, const std::vector<uint32_t>& indicesA, const std::vector<Vertex>& verticesB,
+		const std::vector<uint32_t>& indicesB, float tangentTolerance)
+	{
+		if (indicesA.size() != indicesB.size())
+			return false;
+		for (size_t i{ 0 }; i < indicesA.size(); ++i)
+		{
+			const Vertex& a = verticesA[indicesA[i]];
+			const Vertex& b = verticesB[indicesB[i]];
+			const Vector4 tangentDifference = a.tangent - b.tangent;
+			if (std::memcmp(&a.position, &b.position, sizeof(Vector3)) != 0 || std::memcmp(&a.uv, &b.uv, sizeof(Vector2)) != 0
+				|| std::memcmp(&a.normal, &b.normal, sizeof(Vector3)) != 0 || Vector4::Dot(tangentDifference, tangentDifference) > tangentTolerance * tangentTolerance)
+				return false;
+		}
+		return true;
+	}
+
+	//The std::ifstream parser Utils::ParseOBJ replaced, kept as the speed and output reference
+	bool ParseOBJWithStreams(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
+	{
+		std::ifstream file(filename);
+		if (!file)
+			return false;
+
+		std::vector<Vector3> positions{};
+		std::vector<Vector3> normals{};
+		std::vector<Vector2> UVs{};
+
+		vertices.clear();
+		indices.clear();
+
+		std::string sCommand;
+		while (file >> sCommand)
+		{
+			if (sCommand == "v")
+			{
+				float x, y, z;
+				file >> x >> y >> z;
+				positions.emplace_back(x, y, z);
+			}
+			else if (sCommand == "vt")
+			{
+				float u, v;
+				file >> u >> v;
+				UVs.emplace_back(u, 1 - v);
+			}
+			else if (sCommand == "vn")
+			{
+				float x, y, z;
+				file >> x >> y >> z;
+				normals.emplace_back(x, y, z);
+			}
+			else if (sCommand == "f")
+			{
+				Vertex vertex{};
+				size_t iPosition, iTexCoord, iNormal;
+
+				uint32_t tempIndices[3];
+				for (size_t iFace = 0; iFace < 3; iFace++)
+				{
+					file >> iPosition;
+					vertex.position = positions[iPosition - 1];
+
+					if ('/' == file.peek())
+					{
+						file.ignore();
+						if ('/' != file.peek())
+						{
+							file >> iTexCoord;
+							vertex.uv = UVs[iTexCoord - 1];
+						}
+						if ('/' == file.peek())
+						{
+							file.ignore();
+							file >> iNormal;
+							vertex.normal = normals[iNormal - 1];
+						}
+					}
+
+					vertices.push_back(vertex);
+					tempIndices[iFace] = uint32_t(vertices.size()) - 1;
+				}
+
+				indices.push_back(tempIndices[0]);
+				if (flipAxisAndWinding)
+				{
+					indices.push_back(tempIndices[2]);
+					indices.push_back(tempIndices[1]);
+				}
+				else
+				{
+					indices.push_back(tempIndices[1]);
+					indices.push_back(tempIndices[2]);
+				}
+			}
+			file.ignore(1000, '\n');
+		}
+
+		TangentSpace::Generate(vertices, indices);
+
+		if (flipAxisAndWinding)
+		{
+			for (auto& v : vertices)
+			{
+				v.position.z *= -1.f;
+				v.normal.z *= -1.f;
+				v.tangent.z *= -1.f;
+				v.tangent.w *= -1.f;
+			}
+		}
+
+		return true;
+	}
+
+#if !defined(_WIN32)
+	//Asks the kernel to drop the file's cached pages, so the next read comes from the disk
+	void EvictFromPageCache(const std::string& filename)
+	{
+		const int file = open(filename.c_str(), O_RDONLY);
+		if (file < 0)
+			return;
+		posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+		close(file);
+	}
+#endif
+
+	//Triangle order as an exporter that ignores the vertex cache could leave it
+	std::vector<uint32_t> ShuffleTriangles(const std::vector<uint32_t>& indices)
+	{
+		std::vector<uint32_t> order(indices.size() / 3);
+		std::iota(order.begin(), order.end(), 0u);
+		std::shuffle(order.begin(), order.end(), std::mt19937{ 12345 });
+
+		std::vector<uint32_t> shuffled(indices.size());
+		for (size_t i{ 0 }; i < order.size(); ++i)
+		{
+			std::copy_n(indices.begin() + order[i] * 3, 3, shuffled.begin() + i * 3);
+		}
+		return shuffled;
+	}
+
+	//Same vertices in any order and the same triangles in any order and rotation, with the winding kept.
+	//Expects no duplicate vertices, which holds for the welded grids.
+	bool IsSameTriangles(const std::vector<Vertex>& verticesA, const std::vector<uint32_t>& indicesA, const std::vector<Vertex>& verticesB, const std::vector<uint32_t>& indicesB)
+	{
+		if (verticesA.size() != verticesB.size() || indicesA.size() != indicesB.size())
+			return false;
+
+		const auto sortVertices = [](const std::vector<Vertex>& vertices)
+			{
+				std::vector<uint32_t> order(vertices.size());
+				std::iota(order.begin(), order.end(), 0u);
+				std::sort(order.begin(), order.end(), [&vertices](uint32_t a, uint32_t b) { return std::memcmp(&vertices[a], &vertices[b], sizeof(Vertex)) < 0; });
+				return order;
+			};
+		const std::vector<uint32_t> orderA = sortVertices(verticesA);
+		const std::vector<uint32_t> orderB = sortVertices(verticesB);
+
+		//B's vertex ids in A's numbering
+		std::vector<uint32_t> toA(verticesB.size());
+		for (size_t i{ 0 }; i < orderA.size(); ++i)
+		{
+			if (std::memcmp(&verticesA[orderA[i]], &verticesB[orderB[i]], sizeof(Vertex)) != 0)
+				return false;
+			toA[orderB[i]] = orderA[i];
+		}
+
+		const auto getTriangles = [](const std::vector<uint32_t>& indices, const std::vector<uint32_t>* pRemap)
+			{
+				std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+				for (size_t i{ 0 }; i < triangles.size(); ++i)
+				{
+					std::array<uint32_t, 3>& triangle = triangles[i];
+					for (size_t corner{ 0 }; corner < 3; ++corner)
+					{
+						triangle[corner] = pRemap ? (*pRemap)[indices[i * 3 + corner]] : indices[i * 3 + corner];
+					}
+					std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+				}
+				std::sort(triangles.begin(), triangles.end());
+				return triangles;
+			};
+		return getTriangles(indicesA, nullptr) == getTriangles(indicesB, &toA);
+	}
+
+	//Two triangles on a mirrored uv seam, and a triangle whose uvs are all the same
+	void CheckTangentEdgeCases(Benchmark::Suite& suite)
+	{
+		const auto makeVertex = [](Vector3 position, Vector2 uv)
+			{
+				Vertex vertex{};
+				vertex.position = position;
+				vertex.uv = uv;
+				vertex.normal = Vector3::UnitY;
+				return vertex;
+			};
+
+		//The uvs fold over the shared edge, so its two vertices have to be split
+		std::vector<Vertex> seamVertices{ makeVertex({ 0.f, 0.f, 0.f }, { 0.f, 0.f }), makeVertex({ 1.f, 0.f, 0.f }, { 1.f, 0.f }),
+			makeVertex({ 0.f, 0.f, 1.f }, { 0.f, 1.f }), makeVertex({ 1.f, 0.f, 1.f }, { 0.f, 0.f }) };
+		std::vector<uint32_t> seamIndices{ 0, 1, 2, 2, 1, 3 };
+		const size_t splitCount = TangentSpace::Generate(seamVertices, seamIndices);
+		bool isExpected{ splitCount == 2 && seamVertices.size() == 6 };
+		for (size_t i{ 0 }; isExpected && i < 3; ++i)
+		{
+			isExpected = seamVertices[seamIndices[i]].tangent.w == seamVertices[seamIndices[0]].tangent.w
+				&& seamVertices[seamIndices[i + 3]].tangent.w == -seamVertices[seamIndices[0]].tangent.w;
+		}
+		if (!isExpected)
+			suite.Fail("TangentSpace::Generate didn't split the vertices on a mirrored uv seam");
+
+		std::vector<Vertex> flatVertices{ makeVertex({ 0.f, 0.f, 0.f }, { 0.5f, 0.5f }), makeVertex({ 1.f, 0.f, 0.f }, { 0.5f, 0.5f }),
+			makeVertex({ 0.f, 0.f, 1.f }, { 0.5f, 0.5f }) };
+		std::vector<uint32_t> flatIndices{ 0, 1, 2 };
+		TangentSpace::Generate(flatVertices, flatIndices);
+		for (const Vertex& vertex : flatVertices)
+		{
+			const Vector3 tangent = vertex.tangent.GetXYZ();
+			if (!(std::abs(tangent.Magnitude() - 1.f) < 1e-5f && std::abs(Vector3::Dot(tangent, vertex.normal)) < 1e-5f))
+			{
+				suite.Fail("TangentSpace::Generate gave no usable tangent for a triangle without uv area");
+				break;
+			}
+		}
+	}
+
+	bool IsSameMesh(const std::vector<Vertex>& verticesA, const std::vector<uint32_t>& indicesA, const std::vector<Vertex>& verticesB, const std::vector<uint32_t>& indicesB)
+	{
+		return verticesA.size() == verticesB.size() && indicesA.size() == indicesB.size()
+			&& std::memcmp(verticesA.data(), verticesB.data(), verticesA.size() * sizeof(Vertex)) == 0
+			&& std::memcmp(indicesA.data(), indicesB.data(), indicesA.size() * sizeof(uint32_t)) == 0;
+	}
+
+	void RunGridFBXBenchmarks(Benchmark::Suite& suite, const MeshSize& size, uint32_t side, const std::vector<Vertex>& objVertices, const std::vector<uint32_t>& objIndices,
+		const std::string& loadName, const std::string& parallelLoadName)
+	{
+		const std::filesystem::path path = GetGridFBX(size, side);
+		if (path.empty())
+		{
+			suite.Fail(std::string{ "could not write the " } + size.pName + " triangle FBX");
+			return;
+		}
+		const std::string filename = path.string();
+		const uint64_t fileBytes = std::filesystem::file_size(path);
+		const uint64_t triangles = objIndices.size() / 3;
+
+		FBX::ImportSettings settings{};
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		FBX::Scene scene{};
+		bool imported{ true };
+		const auto import = [&]() { imported &= FBX::Import(filename, vertices, indices, settings, nullptr, &scene); };
+		if (suite.IsEnabled(loadName))
+		{
+			suite.Run(loadName, "triangle", triangles, fileBytes, [&]()
+				{
+					import();
+					Benchmark::DoNotOptimize(vertices.empty() ? 0.f : vertices.back().position.x);
+				});
+		}
+		else
+		{
+			import();
+		}
+
+		if (!imported || !IsSameMesh(objVertices, objIndices, vertices, indices))
+			suite.Fail("importing " + filename + " didn't give the mesh of its OBJ");
+		if (scene.materials.size() != 1 || scene.materials[0].name != "grid_material" || scene.materials[0].diffuseTexture != "grid_color.png"
+			|| scene.submeshes.size() != 1 || scene.submeshes[0].indexCount != indices.size() || !scene.bones.empty())
+			suite.Fail("the material or submesh of " + filename + " is wrong");
+
+		if (suite.IsEnabled(parallelLoadName))
+		{
+			FBX::ImportSettings parallelSettings{};
+			parallelSettings.threadCount = 0;
+			std::vector<Vertex> parallelVertices{};
+			std::vector<uint32_t> parallelIndices{};
+			suite.Run(parallelLoadName, "triangle", triangles, fileBytes, [&]()
+				{
+					FBX::Import(filename, parallelVertices, parallelIndices, parallelSettings);
+					Benchmark::DoNotOptimize(parallelVertices.empty() ? 0.f : parallelVertices.back().position.x);
+				});
+			if (!IsSameMesh(vertices, indices, parallelVertices, parallelIndices))
+				suite.Fail("the multithreaded and single-threaded FBX import disagree on " + filename);
+		}
+
+		if (&size != &meshSizes[0])
+			return;
+
+		//Bone 0 weighs x / side and bone 1 the rest at every vertex
+		settings.importSkin = true;
+		if (!FBX::Import(filename, vertices, indices, settings, nullptr, &scene) || scene.bones.size() != 2 || scene.bones[0] != "bone0"
+			|| scene.skinWeights.size() != vertices.size())
+		{
+			suite.Fail("importing the skin of " + filename + " failed");
+			return;
+		}
+		for (size_t vertex{ 0 }; vertex < vertices.size(); ++vertex)
+		{
+			const FBX::SkinWeights& skin = scene.skinWeights[vertex];
+			float boneWeights[2]{};
+			for (int i{ 0 }; i < 4; ++i)
+			{
+				if (skin.weights[i] > 0.f)
+					boneWeights[skin.bones[i]] += skin.weights[i];
+			}
+			const float expected = vertices[vertex].position.x / static_cast<float>(side);
+			if (std::abs(boneWeights[0] - expected) > 1e-5f || std::abs(boneWeights[0] + boneWeights[1] - 1.f) > 1e-5f)
+			{
+				suite.Fail("the skin weights of " + filename + " are wrong at vertex " + std::to_string(vertex));
+				break;
+			}
+		}
+	}
+
+	//Meshlets over the whole grid: they have to stay within the limits, hold every triangle once through their local vertex
+	//lists and bound their vertices. Culling runs from below and above the grid with the same frustum; the grid is almost
+	//flat and its triangles are wound to face down (against its normals), so from above the cones have to cull everything
+	//the frustum lets through and from below nothing.
+	void RunGridMeshletBenchmarks(Benchmark::Suite& suite, const std::string& filename, uint32_t side, const std::vector<Vertex>& vertices,
+		const std::vector<uint32_t>& indices, const std::string& buildName, const std::string& cullName)
+	{
+		std::vector<uint32_t> meshletIndices{};
+		Meshlets::MeshletData data{};
+		const auto build = [&]()
+			{
+				meshletIndices = indices;
+				Meshlets::Build(vertices, meshletIndices, {}, data);
+			};
+		if (suite.IsEnabled(buildName))
+		{
+			suite.Run(buildName, "triangle", indices.size() / 3, vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t), [&]()
+				{
+					build();
+					Benchmark::DoNotOptimize(data.meshlets.back().bounds.radius);
+				});
+		}
+		else
+		{
+			build();
+		}
+
+		bool isValid{ !data.meshlets.empty() && data.triangles.size() == meshletIndices.size() };
+		uint32_t nextIndex{ 0 }, nextVertex{ 0 };
+		for (const Meshlet& meshlet : data.meshlets)
+		{
+			isValid &= meshlet.firstIndex == nextIndex && meshlet.firstVertex == nextVertex && meshlet.triangleCount > 0 && meshlet.triangleCount <= Meshlets::maxTriangles
+				&& meshlet.vertexCount > 0 && meshlet.vertexCount <= Meshlets::maxVertices && meshlet.firstVertex + meshlet.vertexCount <= data.vertices.size()
+				&& meshlet.firstIndex + meshlet.triangleCount * 3 <= meshletIndices.size();
+			if (!isValid)
+				break;
+			for (uint32_t i{ meshlet.firstIndex }; isValid && i < meshlet.firstIndex + meshlet.triangleCount * 3; ++i)
+				isValid = data.triangles[i] < meshlet.vertexCount && data.vertices[meshlet.firstVertex + data.triangles[i]] == meshletIndices[i];
+			for (uint32_t local{ 0 }; isValid && local < meshlet.vertexCount; ++local)
+			{
+				const float distance = (vertices[data.vertices[meshlet.firstVertex + local]].position - meshlet.bounds.center).Magnitude();
+				isValid = distance <= meshlet.bounds.radius * 1.0001f + 1e-5f;
+			}
+			nextIndex += meshlet.triangleCount * 3;
+			nextVertex += meshlet.vertexCount;
+		}
+		if (!isValid || nextIndex != meshletIndices.size() || nextVertex != data.vertices.size() || !IsSameTriangles(vertices, indices, vertices, meshletIndices))
+		{
+			suite.Fail("the meshlets of " + filename + " don't hold its triangles once each within the limits");
+			return;
+		}
+		std::fprintf(stderr, "%s: %zu meshlets, %.1f triangles and %.1f vertices on average\n", std::filesystem::path{ filename }.filename().string().c_str(),
+			data.meshlets.size(), meshletIndices.size() / 3.0 / data.meshlets.size(), double(data.vertices.size()) / data.meshlets.size());
+		if (!suite.IsEnabled(cullName))
+			return;
+
+		//Looking 80 degrees down (or up) at the grid's middle from half its width away; the OBJ import puts it at negative z
+		const auto getCamera = [side](float height)
+			{
+				Camera camera{};
+				camera.Initialize(45.f, { side * 0.5f, height, side * -0.5f }, 16.f / 9.f);
+				camera.farPlane = side * 2.f;
+				camera.totalPitch = 80.f * TO_RADIANS;
+				camera.CalculateViewMatrix();
+				if ((camera.forward.y > 0.f) == (height > 0.f))
+				{
+					camera.totalPitch = -camera.totalPitch;
+					camera.CalculateViewMatrix();
+				}
+				camera.CalculateProjectionMatrix();
+				return camera;
+			};
+		const Camera front = getCamera(-(side * 0.5f));
+		const Camera back = getCamera(side * 0.5f);
+
+		const SphereArray spheres = Meshlets::GetSpheres(data.meshlets);
+		const uint32_t meshletCount = static_cast<uint32_t>(data.meshlets.size());
+		std::vector<uint32_t> visibility{};
+		std::vector<Meshlets::DrawRange> ranges{};
+		size_t visibleCount{};
+		suite.Run(cullName, "meshlet", meshletCount, data.meshlets.size() * sizeof(Meshlet), [&]()
+			{
+				front.GetFrustum().Cull(spheres, visibility);
+				ranges.clear();
+				visibleCount = Meshlets::AppendVisible(data.meshlets, 0, meshletCount, visibility, front.origin, true, 0, ranges);
+				Benchmark::DoNotOptimize(static_cast<float>(ranges.size()));
+			});
+
+		size_t frustumCount{ 0 };
+		for (uint32_t i{ 0 }; i < meshletCount; ++i)
+			frustumCount += Frustum::IsVisible(visibility, i) ? 1 : 0;
+		uint64_t drawnIndexCount{ 0 };
+		uint32_t rangeEnd{ 0 };
+		for (const Meshlets::DrawRange& range : ranges)
+		{
+			isValid &= range.firstIndex >= rangeEnd && range.indexCount > 0 && range.firstIndex + range.indexCount <= meshletIndices.size();
+			rangeEnd = range.firstIndex + range.indexCount;
+			drawnIndexCount += range.indexCount;
+		}
+
+		std::vector<uint32_t> backVisibility{};
+		std::vector<Meshlets::DrawRange> backRanges{};
+		back.GetFrustum().Cull(spheres, backVisibility);
+		const size_t backCount = Meshlets::AppendVisible(data.meshlets, 0, meshletCount, backVisibility, back.origin, true, 0, backRanges);
+		if (!isValid || visibleCount == 0 || visibleCount != frustumCount || visibleCount == meshletCount || backCount != 0 || !backRanges.empty())
+			suite.Fail("culling the meshlets of " + filename + " from below and above the grid gave " + std::to_string(visibleCount) + " and "
+				+ std::to_string(backCount) + " of " + std::to_string(meshletCount) + " visible, or broken draw ranges");
+		std::fprintf(stderr, "%s: %zu of %u meshlets visible (%.1f%% of the triangles) in %zu draw ranges\n", std::filesystem::path{ filename }.filename().string().c_str(),
+			visibleCount, meshletCount, 100.0 * drawnIndexCount / meshletIndices.size(), ranges.size());
+	}
+
+	//The LOD chain as cooking builds it, then cooked for real: the .mesh has to keep every level as its own index range over
+	//the shared vertices, and SelectLOD has to pick LOD 0 up close and the coarsest level far away
+	void RunLODChainBenchmark(Benchmark::Suite& suite, const std::string& name, const std::filesystem::path& path, const std::vector<Vertex>& vertices,
+		const std::vector<uint32_t>& indices)
+	{
+		const MeshSimplifier::LODChainSettings settings{};
+		std::vector<MeshSimplifier::LODLevel> levels{};
+		suite.Run(name, "triangle", indices.size() / 3, vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t), [&]()
+			{
+				levels = MeshSimplifier::BuildLODChain(vertices, indices, settings);
+				Benchmark::DoNotOptimize(levels.back().error);
+			});
+
+		for (size_t lod{ 0 }; lod < levels.size(); ++lod)
+		{
+			std::fprintf(stderr, "%s: LOD %zu %zu triangles, error %.3g\n", path.filename().string().c_str(), lod, levels[lod].indices.size() / 3, levels[lod].error);
+			if (lod > 0 && !(levels[lod].indices.size() < levels[lod - 1].indices.size() && levels[lod].error >= levels[lod - 1].error))
+				suite.Fail("LOD " + std::to_string(lod) + " of " + path.string() + " isn't coarser than the one before");
+		}
+		if (levels.size() < 2)
+		{
+			suite.Fail("simplifying " + path.string() + " gave no LODs");
+			return;
+		}
+
+		std::error_code error{};
+		const std::filesystem::path meshPath = std::filesystem::temp_directory_path(error) / "directx_benchmark" / "AK47_CS2.lods.mesh";
+		std::filesystem::create_directories(meshPath.parent_path(), error);
+		MeshFile::CookStats stats{};
+		if (!MeshFile::Cook(path.string(), meshPath.string(), {}, &stats))
+		{
+			suite.Fail("could not cook " + path.string());
+			return;
+		}
+		const CookedMesh mesh{ meshPath.string() };
+		const MeshView& view = mesh.GetView();
+		bool isValid{ mesh.IsValid() && view.lods.size() == levels.size() && stats.lods.size() == levels.size() };
+		uint32_t nextSubmesh{ 0 };
+		for (size_t lod{ 0 }; isValid && lod < view.lods.size(); ++lod)
+		{
+			const MeshLOD& meshLOD = view.lods[lod];
+			uint64_t indexCount{ 0 };
+			for (uint32_t submesh{ meshLOD.firstSubmesh }; submesh < meshLOD.firstSubmesh + meshLOD.submeshCount; ++submesh)
+				indexCount += view.submeshes[submesh].indexCount;
+			isValid &= meshLOD.firstSubmesh == nextSubmesh && indexCount == levels[lod].indices.size() && meshLOD.error == levels[lod].error;
+			nextSubmesh += meshLOD.submeshCount;
+		}
+		if (!isValid || nextSubmesh != view.submeshes.size() || view.vertexCount > vertices.size())
+			suite.Fail("the cooked " + meshPath.string() + " doesn't hold the LOD chain");
+		if (view.meshlets.empty() || view.meshlets.size() != stats.meshletCount || view.meshletTriangles.size() != view.indexCount)
+			suite.Fail("the cooked " + meshPath.string() + " doesn't hold its meshlets");
+
+		//The reported ACMR has to be the one of the indices in the file, which are in meshlet order
+		const MeshOptimizer::VertexCacheStats cookedCache = MeshFile::AnalyzeVertexCache(view);
+		std::fprintf(stderr, "%s: cooked LOD 0 ACMR FIFO %u %.3f (imported %.3f)\n", meshPath.filename().string().c_str(), MeshOptimizer::vertexCacheSize, cookedCache.acmr,
+			stats.optimize.before.acmr);
+		if (cookedCache.acmr != stats.optimize.after.acmr || cookedCache.transformCount != stats.optimize.after.transformCount)
+			suite.Fail("the cook stats report an ACMR of " + std::to_string(stats.optimize.after.acmr) + " for " + meshPath.string() + ", whose indices give "
+				+ std::to_string(cookedCache.acmr));
+
+		//The cache goes by the source bytes and the settings that change the output, not by timestamps
+		MeshFile::CookSettings otherSettings{};
+		otherSettings.lods.maxError = 0.1f;
+		MeshFile::CookSettings otherThreads{};
+		otherThreads.import.threadCount = 4;
+		if (!MeshFile::IsUpToDate(path.string(), meshPath.string(), {}) || !MeshFile::IsUpToDate(path.string(), meshPath.string(), otherThreads)
+			|| MeshFile::IsUpToDate(path.string(), meshPath.string(), otherSettings))
+			suite.Fail("the .mesh cache doesn't follow the cook settings");
+
+		//A 1080 pixel high view with a 45 degree field of view
+		const float pixelsPerUnitAtOne = 1080.f / (2.f * std::tan(22.5f * TO_RADIANS));
+		if (SelectLOD(view.lods, pixelsPerUnitAtOne / 0.1f, 1.f) != 0 || SelectLOD(view.lods, pixelsPerUnitAtOne / 1e6f, 1.f) != view.lods.size() - 1)
+			suite.Fail("SelectLOD doesn't go from LOD 0 up close to the coarsest LOD far away");
+	}
+
+	//The shipped AK-47 (zlib-compressed arrays) against the same mesh as text OBJ
+	void RunExportedFBXBenchmarks(Benchmark::Suite& suite)
+	{
+		const std::string loadName{ "fbx.load.ak47" };
+		const std::string parallelLoadName{ "fbx.load_mt.ak47" };
+		const std::string objParseName{ "obj.parse.ak47" };
+		const std::string lodChainName{ "mesh.lod_chain.ak47" };
+		const std::string optimizeName{ "mesh.optimize.ak47" };
+		if (!suite.IsEnabled(loadName) && !suite.IsEnabled(parallelLoadName) && !suite.IsEnabled(objParseName) && !suite.IsEnabled(lodChainName)
+			&& !suite.IsEnabled(optimizeName))
+			return;
+
+		const std::filesystem::path path = std::filesystem::path{ BENCHMARK_RESOURCES_DIR } / "AK47_CS2.fbx";
+		std::error_code error{};
+		if (!std::filesystem::exists(path, error))
+		{
+			std::fprintf(stderr, "%s not found, skipping\n", path.string().c_str());
+			return;
+		}
+		const std::string filename = path.string();
+		const uint64_t fileBytes = std::filesystem::file_size(path);
+
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		FBX::ImportStats stats{};
+		FBX::Scene scene{};
+		if (!FBX::Import(filename, vertices, indices, {}, &stats, &scene) || indices.empty())
+		{
+			suite.Fail("could not import " + filename);
+			return;
+		}
+		const uint64_t triangles = indices.size() / 3;
+		std::fprintf(stderr, "%s: %zu corners welded to %zu vertices, %zu arrays, %.1f MB inflated from %.1f MB\n", path.filename().string().c_str(), stats.cornerCount,
+			stats.vertexCount, stats.arrayCount, stats.inflatedBytes / 1e6, stats.compressedBytes / 1e6);
+		if (scene.materials.size() != 1 || scene.materials[0].name != "weapon_rif_ak47" || scene.materials[0].diffuseTexture.empty() || scene.materials[0].normalTexture.empty()
+			|| scene.submeshes.size() != 1 || scene.submeshes[0].indexCount != indices.size())
+			suite.Fail("the material of " + filename + " wasn't found");
+
+		if (suite.IsEnabled(loadName))
+		{
+			suite.Run(loadName, "triangle", triangles, fileBytes, [&]()
+				{
+					FBX::Import(filename, vertices, indices);
+					Benchmark::DoNotOptimize(vertices.back().position.x);
+				});
+		}
+
+		if (suite.IsEnabled(parallelLoadName))
+		{
+			FBX::ImportSettings parallelSettings{};
+			parallelSettings.threadCount = 0;
+			std::vector<Vertex> parallelVertices{};
+			std::vector<uint32_t> parallelIndices{};
+			suite.Run(parallelLoadName, "triangle", triangles, fileBytes, [&]()
+				{
+					FBX::Import(filename, parallelVertices, parallelIndices, parallelSettings);
+					Benchmark::DoNotOptimize(parallelVertices.empty() ? 0.f : parallelVertices.back().position.x);
+				});
+			parallelSettings.threadCount = 3;
+			FBX::Import(filename, parallelVertices, parallelIndices, parallelSettings);
+			if (!IsSameMesh(vertices, indices, parallelVertices, parallelIndices))
+				suite.Fail("the multithreaded and single-threaded FBX import disagree on " + filename);
+		}
+
+		//The mesh as exported is already close to what Tipsify reaches, so unlike on the shuffled grids the overdraw sort's
+		//cost shows: it has to stay within its budget of the Tipsify order
+		if (suite.IsEnabled(optimizeName))
+		{
+			std::vector<Vertex> optimizedVertices{};
+			std::vector<uint32_t> optimizedIndices{};
+			std::vector<Submesh> optimizedSubmeshes{};
+			MeshOptimizer::OptimizeStats optimizeStats{};
+			suite.Run(optimizeName, "triangle", triangles, vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t), [&]()
+				{
+					optimizedVertices = vertices;
+					optimizedIndices = indices;
+					MeshOptimizer::Optimize(optimizedVertices, optimizedIndices, optimizedSubmeshes, &optimizeStats);
+					Benchmark::DoNotOptimize(optimizedVertices.back().position.x);
+				});
+
+			std::vector<uint32_t> tipsifyIndices{ indices };
+			MeshOptimizer::OptimizeVertexCache(tipsifyIndices, vertices.size());
+			const float tipsifyAcmr = MeshOptimizer::AnalyzeVertexCache(tipsifyIndices, vertices.size()).acmr;
+			std::fprintf(stderr, "%s: ACMR FIFO %u as imported %.3f, vertex cache pass %.3f, optimized %.3f\n", path.filename().string().c_str(), MeshOptimizer::vertexCacheSize,
+				optimizeStats.before.acmr, tipsifyAcmr, optimizeStats.after.acmr);
+			if (!IsSameTriangles(vertices, indices, optimizedVertices, optimizedIndices))
+				suite.Fail("optimizing " + filename + " changed its triangles");
+			if (optimizeStats.after.acmr > MeshOptimizer::overdrawThreshold * tipsifyAcmr)
+				suite.Fail("optimizing " + filename + " raised its ACMR to " + std::to_string(optimizeStats.after.acmr));
+		}
+
+		if (suite.IsEnabled(lodChainName))
+			RunLODChainBenchmark(suite, lodChainName, path, vertices, indices);
+
+		if (!suite.IsEnabled(objParseName))
+			return;
+
+		const std::filesystem::path objPath = std::filesystem::temp_directory_path(error) / "directx_benchmark" / "AK47_CS2.obj";
+		std::filesystem::create_directories(objPath.parent_path(), error);
+		if (!WriteMeshOBJ(objPath, vertices, indices))
+		{
+			suite.Fail("could not write " + objPath.string());
+			return;
+		}
+		const std::string objFilename = objPath.string();
+		const uint64_t objBytes = std::filesystem::file_size(objPath);
+		std::fprintf(stderr, "%s: %.2f MB FBX, %.2f MB OBJ\n", path.filename().string().c_str(), fileBytes / 1e6, objBytes / 1e6);
+
+		std::vector<Vertex> objVertices{};
+		std::vector<uint32_t> objIndices{};
+		suite.Run(objParseName, "triangle", triangles, objBytes, [&]()
+			{
+				Utils::ParseOBJ(objFilename, objVertices, objIndices);
+				Benchmark::DoNotOptimize(objVertices.empty() ? 0.f : objVertices.back().position.x);
+			});
+		if (!HaveSameCorners(vertices, indices, objVertices, objIndices, 1e-4f))
+			suite.Fail("the FBX and OBJ import of " + filename + " disagree");
+	}
+}
+
+namespace Benchmark
+{
+	void RunAssetBenchmarks(Suite& suite)
+	{
+		for (const MeshSize& size : meshSizes)
+		{
+			if (size.triangles > suite.GetOptions().maxTriangles)
+				break;
+
+			const std::string parseName = std::string{ "obj.parse." } + size.pName;
+			const std::string unweldedParseName = std::string{ "obj.parse_unwelded." } + size.pName;
+			const std::string streamParseName = std::string{ "obj.parse_iostream." } + size.pName;
+			const std::string weldName = std::string{ "mesh.weld_epsilon." } + size.pName;
+			const std::string tangentName = std::string{ "mesh.tangents." } + size.pName;
+			const std::string parallelParseName = std::string{ "obj.parse_mt." } + size.pName;
+			const std::string warmLoadName = std::string{ "mesh.load_warm." } + size.pName;
+			const std::string coldLoadName = std::string{ "mesh.load_cold." } + size.pName;
+			const std::string parallelTangentName = std::string{ "mesh.tangents_mt." } + size.pName;
+			const std::string optimizeName = std::string{ "mesh.optimize." } + size.pName;
+			const std::string index16Name = std::string{ "mesh.index16." } + size.pName;
+			const std::string packName = std::string{ "mesh.pack_vertices." } + size.pName;
+			const std::string scalarPackName = std::string{ "mesh.pack_vertices_scalar." } + size.pName;
+			const std::string fbxLoadName = std::string{ "fbx.load." } + size.pName;
+			const std::string fbxParallelLoadName = std::string{ "fbx.load_mt." } + size.pName;
+			const std::string simplifyName = std::string{ "mesh.simplify." } + size.pName;
+			const std::string meshletName = std::string{ "mesh.meshlets." } + size.pName;
+			const std::string meshletCullName = std::string{ "mesh.meshlet_cull." } + size.pName;
+			const bool runSimplify = size.triangles <= maxSimplifyTriangles && suite.IsEnabled(simplifyName);
+			const bool runStreamParse = size.triangles <= maxStreamParseTriangles && suite.IsEnabled(streamParseName);
+			if (!suite.IsEnabled(parseName) && !suite.IsEnabled(unweldedParseName) && !runStreamParse && !suite.IsEnabled(weldName) && !suite.IsEnabled(tangentName)
+				&& !suite.IsEnabled(parallelParseName) && !suite.IsEnabled(parallelTangentName) && !suite.IsEnabled(warmLoadName) && !suite.IsEnabled(coldLoadName)
+				&& !suite.IsEnabled(optimizeName) && !suite.IsEnabled(index16Name) && !suite.IsEnabled(packName) && !suite.IsEnabled(scalarPackName)
+				&& !suite.IsEnabled(fbxLoadName) && !suite.IsEnabled(fbxParallelLoadName) && !runSimplify && !suite.IsEnabled(meshletName) && !suite.IsEnabled(meshletCullName))
+				continue;
+
+			const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(size.triangles) / 2.0)));
+			const uint64_t triangles = 2ull * side * side;
+			const uint64_t gridVertices = uint64_t(side + 1) * (side + 1);
+
+			const std::filesystem::path path = GetGridOBJ(size, side);
+			if (path.empty())
+			{
+				std::fprintf(stderr, "Could not write the %s triangle OBJ, skipping\n", size.pName);
+				continue;
+			}
+			const uint64_t fileBytes = std::filesystem::file_size(path);
+			const std::string filename = path.string();
+
+			//Welded: every grid point is one v/vt/vn triplet, shared by up to 6 triangles
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			Utils::OBJImportStats stats{};
+			bool parsed{ true };
+			const auto parse = [&]() { parsed &= Utils::ParseOBJ(filename, vertices, indices, {}, &stats); };
+			if (suite.IsEnabled(parseName))
+			{
+				suite.Run(parseName, "triangle", triangles, fileBytes, [&]()
+					{
+						parse();
+						DoNotOptimize(vertices.empty() ? 0.f : vertices.back().position.x);
+					});
+			}
+			else
+			{
+				parse();
+			}
+
+			if (!parsed || indices.size() != triangles * 3 || vertices.size() != gridVertices)
+			{
+				suite.Fail("parsing " + filename + " gave " + std::to_string(vertices.size()) + " vertices and " + std::to_string(indices.size()) + " indices, expected "
+					+ std::to_string(gridVertices) + " and " + std::to_string(triangles * 3));
+				continue;
+			}
+			std::fprintf(stderr, "%s: %zu corners welded to %zu vertices (%.1f MB -> %.1f MB vertex buffer)\n", path.filename().string().c_str(), stats.cornerCount, stats.vertexCount,
+				stats.cornerCount * sizeof(Vertex) / 1e6, stats.vertexCount * sizeof(Vertex) / 1e6);
+
+			//The same grid as binary FBX, which has to import to the same bytes as the OBJ
+			if (suite.IsEnabled(fbxLoadName) || suite.IsEnabled(fbxParallelLoadName))
+				RunGridFBXBenchmarks(suite, size, side, vertices, indices, fbxLoadName, fbxParallelLoadName);
+
+			//Vertex cache, overdraw and vertex fetch reordering of the shuffled grid, including copying the input
+			if (suite.IsEnabled(optimizeName))
+			{
+				const std::vector<uint32_t> shuffledIndices = ShuffleTriangles(indices);
+				std::vector<Vertex> optimizedVertices{};
+				std::vector<uint32_t> optimizedIndices{};
+				std::vector<Submesh> optimizedSubmeshes{};
+				MeshOptimizer::OptimizeStats optimizeStats{};
+				suite.Run(optimizeName, "triangle", triangles, vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t), [&]()
+					{
+						optimizedVertices = vertices;
+						optimizedIndices = shuffledIndices;
+						MeshOptimizer::Optimize(optimizedVertices, optimizedIndices, optimizedSubmeshes, &optimizeStats);
+						DoNotOptimize(optimizedVertices.back().position.x);
+					});
+
+				if (!IsSameTriangles(vertices, shuffledIndices, optimizedVertices, optimizedIndices))
+					suite.Fail("optimizing " + filename + " changed its triangles");
+				if (!(optimizeStats.after.acmr < optimizeStats.before.acmr))
+					suite.Fail("optimizing " + filename + " didn't lower its ACMR");
+
+				const auto getAcmr = [](const std::vector<uint32_t>& indices, size_t vertexCount, MeshOptimizer::CacheModel model)
+					{
+						return MeshOptimizer::AnalyzeVertexCache(indices, vertexCount, MeshOptimizer::vertexCacheSize, model).acmr;
+					};
+				std::fprintf(stderr, "%s: ACMR FIFO/LRU %u exported %.3f/%.3f, shuffled %.3f/%.3f, optimized %.3f/%.3f (ATVR %.3f)\n", path.filename().string().c_str(),
+					MeshOptimizer::vertexCacheSize,
+					getAcmr(indices, vertices.size(), MeshOptimizer::CacheModel::FIFO), getAcmr(indices, vertices.size(), MeshOptimizer::CacheModel::LRU),
+					getAcmr(shuffledIndices, vertices.size(), MeshOptimizer::CacheModel::FIFO), getAcmr(shuffledIndices, vertices.size(), MeshOptimizer::CacheModel::LRU),
+					getAcmr(optimizedIndices, vertices.size(), MeshOptimizer::CacheModel::FIFO), getAcmr(optimizedIndices, vertices.size(), MeshOptimizer::CacheModel::LRU),
+					optimizeStats.after.atvr);
+			}
+
+			//Down to a quarter of the triangles. The grid's outline is open and stays locked, so every vertex on it has to
+			//survive; the rest has to stay a valid triangle list over the original vertices.
+			if (runSimplify)
+			{
+				const size_t targetIndexCount = indices.size() / 4 / 3 * 3;
+				std::vector<uint32_t> simplifiedIndices{};
+				MeshSimplifier::SimplifyResult result{};
+				suite.Run(simplifyName, "triangle", triangles, vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t), [&]()
+					{
+						result = MeshSimplifier::Simplify(indices, vertices, targetIndexCount, 1.f, simplifiedIndices);
+						DoNotOptimize(result.error);
+					});
+
+				bool isValid{ simplifiedIndices.size() <= targetIndexCount && simplifiedIndices.size() % 3 == 0 };
+				std::vector<uint8_t> isUsed(vertices.size(), 0);
+				for (size_t first{ 0 }; isValid && first < simplifiedIndices.size(); first += 3)
+				{
+					const uint32_t a = simplifiedIndices[first], b = simplifiedIndices[first + 1], c = simplifiedIndices[first + 2];
+					isValid &= a < vertices.size() && b < vertices.size() && c < vertices.size() && a != b && b != c && a != c;
+					if (isValid)
+						isUsed[a] = isUsed[b] = isUsed[c] = 1;
+				}
+				//The outline is where x or z is at the grid's bounds, y is the wave
+				float minX{ FLT_MAX }, maxX{ -FLT_MAX }, minZ{ FLT_MAX }, maxZ{ -FLT_MAX };
+				for (const Vertex& vertex : vertices)
+				{
+					minX = std::min(minX, vertex.position.x);
+					maxX = std::max(maxX, vertex.position.x);
+					minZ = std::min(minZ, vertex.position.z);
+					maxZ = std::max(maxZ, vertex.position.z);
+				}
+				size_t outlineCount{ 0 };
+				for (size_t i{ 0 }; isValid && i < vertices.size(); ++i)
+				{
+					const Vector3& p = vertices[i].position;
+					if (p.x == minX || p.x == maxX || p.z == minZ || p.z == maxZ)
+					{
+						isValid &= isUsed[i] != 0;
+						++outlineCount;
+					}
+				}
+				isValid &= outlineCount == 4 * side;
+				if (!isValid)
+					suite.Fail("simplifying " + filename + " gave " + std::to_string(simplifiedIndices.size() / 3) + " triangles, broken ones or lost border vertices");
+				std::fprintf(stderr, "%s: simplified %zu -> %zu triangles, %zu collapses, %zu locked vertices, error %.3g\n", path.filename().string().c_str(),
+					indices.size() / 3, simplifiedIndices.size() / 3, result.collapseCount, result.lockedVertexCount, result.error);
+			}
+
+			if (suite.IsEnabled(meshletName) || suite.IsEnabled(meshletCullName))
+				RunGridMeshletBenchmarks(suite, filename, side, vertices, indices, meshletName, meshletCullName);
+
+			//Narrowing to 16-bit indices as cooking does it, after the optimizer. The grids up to 100k triangles have fewer than
+			//65536 vertices, bigger ones are split into submeshes.
+			if (suite.IsEnabled(index16Name))
+			{
+				std::vector<Vertex> optimizedVertices = vertices;
+				std::vector<uint32_t> optimizedIndices = indices;
+				std::vector<Submesh> optimizedSubmeshes{};
+				MeshOptimizer::Optimize(optimizedVertices, optimizedIndices, optimizedSubmeshes);
+
+				std::vector<Vertex> splitVertices{};
+				std::vector<uint16_t> indices16{};
+				std::vector<Submesh> submeshes{};
+				size_t duplicatedCount{};
+				suite.Run(index16Name, "triangle", triangles, optimizedVertices.size() * sizeof(Vertex) + optimizedIndices.size() * sizeof(uint32_t), [&]()
+					{
+						splitVertices = optimizedVertices;
+						submeshes = optimizedSubmeshes;
+						duplicatedCount = MeshOptimizer::SplitFor16BitIndices(splitVertices, optimizedIndices, indices16, submeshes);
+						DoNotOptimize(splitVertices.back().position.x);
+					});
+
+				//Every corner has to reach the same vertex through its submesh's base vertex
+				const Submesh wholeMesh{ 0, static_cast<uint32_t>(indices16.size()), 0, 0, {} };
+				const std::span<const Submesh> drawnSubmeshes = submeshes.empty() ? std::span<const Submesh>{ &wholeMesh, 1 } : std::span<const Submesh>{ submeshes };
+				uint64_t drawnIndexCount{ 0 };
+				bool isSame{ indices16.size() == optimizedIndices.size() };
+				for (const Submesh& submesh : drawnSubmeshes)
+				{
+					isSame &= submesh.firstIndex == drawnIndexCount;
+					drawnIndexCount += submesh.indexCount;
+					for (uint32_t i{ submesh.firstIndex }; isSame && i < submesh.firstIndex + submesh.indexCount; ++i)
+					{
+						const size_t vertex = size_t(submesh.baseVertex) + indices16[i];
+						isSame = vertex < splitVertices.size() && std::memcmp(&splitVertices[vertex], &optimizedVertices[optimizedIndices[i]], sizeof(Vertex)) == 0;
+					}
+				}
+				if (!isSame || drawnIndexCount != optimizedIndices.size())
+					suite.Fail("the 16-bit indices of " + filename + " don't draw the same triangles");
+
+				std::filesystem::path meshPath = path;
+				meshPath.replace_extension(".index16.mesh");
+				if (!MeshFile::Write(meshPath.string(), MeshView::FromVertices(splitVertices, indices16, submeshes)))
+				{
+					suite.Fail("could not write " + meshPath.string());
+				}
+				else
+				{
+					const CookedMesh mesh{ meshPath.string() };
+					const MeshView& view = mesh.GetView();
+					if (!mesh.IsValid() || view.indexSize != sizeof(uint16_t) || view.indexCount != indices16.size() || view.vertexCount != splitVertices.size()
+						|| view.submeshes.size() != drawnSubmeshes.size()
+						|| std::memcmp(view.pIndices, indices16.data(), indices16.size() * sizeof(uint16_t)) != 0
+						|| !std::ranges::equal(view.submeshes, drawnSubmeshes, [](const Submesh& a, const Submesh& b)
+							{
+								return a.firstIndex == b.firstIndex && a.indexCount == b.indexCount && a.baseVertex == b.baseVertex;
+							}))
+						suite.Fail("loading " + meshPath.string() + " didn't give back the 16-bit indices");
+				}
+
+				std::fprintf(stderr, "%s: 16-bit indices in %zu submesh(es), %zu vertices duplicated, %.1f MB -> %.1f MB vertex + index buffers\n", path.filename().string().c_str(),
+					drawnSubmeshes.size(), duplicatedCount, (optimizedVertices.size() * sizeof(Vertex) + optimizedIndices.size() * sizeof(uint32_t)) / 1e6,
+					(splitVertices.size() * sizeof(Vertex) + indices16.size() * sizeof(uint16_t)) / 1e6);
+			}
+
+			//Vertex -> PackedVertex as cooking does it, SIMD and the scalar reference
+			if (suite.IsEnabled(packName) || suite.IsEnabled(scalarPackName))
+			{
+				const AABB bounds = AABB::FromPoints(&vertices.data()->position, sizeof(Vertex), vertices.size());
+				std::vector<PackedVertex> packed(vertices.size());
+				std::vector<PackedVertex> scalarPacked(vertices.size());
+				const uint64_t bytes = vertices.size() * (sizeof(Vertex) + sizeof(PackedVertex));
+				if (suite.IsEnabled(packName))
+				{
+					suite.Run(packName, "vertex", vertices.size(), bytes, [&]()
+						{
+							VertexPacking::Encode(vertices, bounds, packed);
+							DoNotOptimize(packed.back().position[0]);
+						});
+				}
+				else
+				{
+					VertexPacking::Encode(vertices, bounds, packed);
+				}
+				if (suite.IsEnabled(scalarPackName))
+				{
+					suite.Run(scalarPackName, "vertex", vertices.size(), bytes, [&]()
+						{
+							VertexPacking::EncodeScalar(vertices, bounds, scalarPacked);
+							DoNotOptimize(scalarPacked.back().position[0]);
+						});
+				}
+				else
+				{
+					VertexPacking::EncodeScalar(vertices, bounds, scalarPacked);
+				}
+
+				//Rounding may land the two paths one integer step apart, no more
+				const auto isNear = [](const auto& a, const auto& b)
+					{
+						for (size_t i{ 0 }; i < std::size(a); ++i)
+						{
+							if (std::abs(int(a[i]) - int(b[i])) > 1)
+								return false;
+						}
+						return true;
+					};
+				for (size_t i{ 0 }; i < packed.size(); ++i)
+				{
+					if (!isNear(packed[i].position, scalarPacked[i].position) || !isNear(packed[i].uv, scalarPacked[i].uv) || !isNear(packed[i].frame, scalarPacked[i].frame))
+					{
+						suite.Fail("the SIMD and scalar packing of " + filename + " differ at vertex " + std::to_string(i));
+						break;
+					}
+				}
+
+				float maxUV{ 0.f };
+				for (const Vertex& vertex : vertices)
+					maxUV = std::max({ maxUV, std::abs(vertex.uv.x), std::abs(vertex.uv.y) });
+				std::vector<Vertex> decoded(vertices.size());
+				VertexPacking::Decode(packed, bounds, decoded);
+				const VertexPacking::PackingError error = VertexPacking::MeasureError(vertices, decoded);
+				const VertexPacking::PackingError bound = VertexPacking::GetErrorBound(bounds, maxUV);
+				if (error.position > bound.position || error.uv > bound.uv || error.normalDegrees > bound.normalDegrees || error.tangentDegrees > bound.tangentDegrees)
+					suite.Fail("packing " + filename + " lost more precision than VertexPacking::GetErrorBound allows");
+
+				std::filesystem::path meshPath = path;
+				meshPath.replace_extension(".packed.mesh");
+				if (!MeshFile::Write(meshPath.string(), MeshView::FromPackedVertices(packed, bounds, indices)))
+				{
+					suite.Fail("could not write " + meshPath.string());
+				}
+				else
+				{
+					const CookedMesh mesh{ meshPath.string() };
+					const MeshView& view = mesh.GetView();
+					if (!mesh.IsValid() || view.vertexStride != sizeof(PackedVertex) || !std::ranges::equal(view.attributes, VertexFormat<PackedVertex>::attributes)
+						|| view.vertexCount != packed.size() || std::memcmp(view.pVertices, packed.data(), packed.size() * sizeof(PackedVertex)) != 0)
+						suite.Fail("loading " + meshPath.string() + " didn't give back the packed vertices");
+				}
+
+				std::fprintf(stderr, "%s: packed %zu -> %zu bytes per vertex, max error (bound) position %.2g (%.2g), uv %.2g (%.2g), normal %.2g (%.2g) deg, tangent %.2g (%.2g) deg\n",
+					path.filename().string().c_str(), sizeof(Vertex), sizeof(PackedVertex), error.position, bound.position, error.uv, bound.uv,
+					error.normalDegrees, bound.normalDegrees, error.tangentDegrees, bound.tangentDegrees);
+			}
+
+			//Cooked .mesh load: map, validate and the copy CreateBuffer makes from pSysMem, into buffers allocated once.
+			//Cold drops the file from the OS page cache first (not on Windows), which is timed along with the load.
+			if (suite.IsEnabled(warmLoadName) || suite.IsEnabled(coldLoadName))
+			{
+				std::filesystem::path meshPath = path;
+				meshPath.replace_extension(".mesh");
+				const std::string meshFilename = meshPath.string();
+				if (!MeshFile::Write(meshFilename, MeshView::FromVertices(vertices, indices)))
+				{
+					suite.Fail("could not write " + meshFilename);
+					continue;
+				}
+				const uint64_t meshBytes = std::filesystem::file_size(meshPath);
+
+				std::vector<Vertex> uploadedVertices(vertices.size());
+				std::vector<uint32_t> uploadedIndices(indices.size());
+				bool loaded{ true };
+				const auto load = [&]()
+					{
+						const CookedMesh mesh{ meshFilename };
+						const MeshView& view = mesh.GetView();
+						loaded &= mesh.IsValid() && view.vertexCount == uploadedVertices.size() && view.indexSize == sizeof(uint32_t) && view.indexCount == uploadedIndices.size();
+						if (!loaded)
+							return;
+						std::memcpy(uploadedVertices.data(), view.pVertices, size_t(view.vertexCount) * view.vertexStride);
+						std::memcpy(uploadedIndices.data(), view.pIndices, size_t(view.indexCount) * sizeof(uint32_t));
+					};
+
+				if (suite.IsEnabled(warmLoadName))
+				{
+					suite.Run(warmLoadName, "triangle", triangles, meshBytes, [&]()
+						{
+							load();
+							DoNotOptimize(uploadedVertices.back().position.x);
+						});
+				}
+#if !defined(_WIN32)
+				if (suite.IsEnabled(coldLoadName))
+				{
+					suite.Run(coldLoadName, "triangle", triangles, meshBytes, [&]()
+						{
+							EvictFromPageCache(meshFilename);
+							load();
+							DoNotOptimize(uploadedVertices.back().position.x);
+						});
+				}
+#endif
+				if (!loaded || !IsSameMesh(vertices, indices, uploadedVertices, uploadedIndices))
+					suite.Fail("loading " + meshFilename + " didn't give back the cooked mesh");
+			}
+
+			//All hardware threads; files under 1 MB per thread use fewer. Also checked at thread counts that split the file
+			//differently than this machine would, with and without welding.
+			if (suite.IsEnabled(parallelParseName))
+			{
+				Utils::OBJImportSettings parallelSettings{};
+				parallelSettings.threadCount = 0;
+				std::vector<Vertex> parallelVertices{};
+				std::vector<uint32_t> parallelIndices{};
+				suite.Run(parallelParseName, "triangle", triangles, fileBytes, [&]()
+					{
+						Utils::ParseOBJ(filename, parallelVertices, parallelIndices, parallelSettings);
+						DoNotOptimize(parallelVertices.empty() ? 0.f : parallelVertices.back().position.x);
+					});
+				if (!IsSameMesh(vertices, indices, parallelVertices, parallelIndices))
+					suite.Fail("the multithreaded and single-threaded import disagree on " + filename);
+
+				for (const unsigned threadCount : { 3u, 16u })
+				{
+					for (const bool weld : { true, false })
+					{
+						parallelSettings.threadCount = threadCount;
+						parallelSettings.weldVertices = weld;
+						Utils::ParseOBJ(filename, parallelVertices, parallelIndices, parallelSettings);
+
+						Utils::OBJImportSettings serialSettings{};
+						serialSettings.weldVertices = weld;
+						std::vector<Vertex> serialVertices{};
+						std::vector<uint32_t> serialIndices{};
+						Utils::ParseOBJ(filename, serialVertices, serialIndices, serialSettings);
+						if (!IsSameMesh(serialVertices, serialIndices, parallelVertices, parallelIndices))
+							suite.Fail("the import on " + std::to_string(threadCount) + " threads (weld " + std::to_string(weld) + ") differs from the single-threaded one on " + filename);
+					}
+				}
+			}
+
+			//One vertex per corner, which is what the stream parser produced
+			const bool needUnwelded = suite.IsEnabled(unweldedParseName) || runStreamParse || suite.IsEnabled(weldName);
+			Utils::OBJImportSettings unweldedSettings{};
+			unweldedSettings.weldVertices = false;
+			std::vector<Vertex> unweldedVertices{};
+			std::vector<uint32_t> unweldedIndices{};
+			if (suite.IsEnabled(unweldedParseName))
+			{
+				suite.Run(unweldedParseName, "triangle", triangles, fileBytes, [&]()
+					{
+						Utils::ParseOBJ(filename, unweldedVertices, unweldedIndices, unweldedSettings);
+						DoNotOptimize(unweldedVertices.empty() ? 0.f : unweldedVertices.back().position.x);
+					});
+			}
+			else if (needUnwelded)
+			{
+				Utils::ParseOBJ(filename, unweldedVertices, unweldedIndices, unweldedSettings);
+			}
+
+			if (runStreamParse)
+			{
+				std::vector<Vertex> streamVertices{};
+				std::vector<uint32_t> streamIndices{};
+				suite.Run(streamParseName, "triangle", triangles, fileBytes, [&]()
+					{
+						ParseOBJWithStreams(filename, streamVertices, streamIndices);
+						DoNotOptimize(streamVertices.empty() ? 0.f : streamVertices.back().position.x);
+					});
+
+				if (!IsSameMesh(unweldedVertices, unweldedIndices, streamVertices, streamIndices))
+					suite.Fail("Utils::ParseOBJ without welding and the stream parser disagree on " + filename);
+			}
+
+			if (suite.IsEnabled(weldName))
+			{
+				//Includes copying the unwelded mesh, the weld works in place
+				std::vector<Vertex> weldVertices{};
+				std::vector<uint32_t> weldIndices{};
+				suite.Run(weldName, "vertex", unweldedVertices.size(), unweldedVertices.size() * sizeof(Vertex), [&]()
+					{
+						weldVertices = unweldedVertices;
+						weldIndices = unweldedIndices;
+						Utils::WeldVertices(weldVertices, weldIndices, 1e-5f);
+						DoNotOptimize(weldVertices.back().position.x);
+					});
+
+				if (weldVertices.size() != gridVertices)
+					suite.Fail("welding " + filename + " gave " + std::to_string(weldVertices.size()) + " vertices, expected " + std::to_string(gridVertices));
+				for (size_t i{ 0 }; i < weldIndices.size(); ++i)
+				{
+					const Vector3 difference = weldVertices[weldIndices[i]].position - unweldedVertices[unweldedIndices[i]].position;
+					if (difference.SqrMagnitude() > 1e-10f)
+					{
+						suite.Fail("welding " + filename + " moved corner " + std::to_string(i));
+						break;
+					}
+				}
+			}
+
+			if (suite.IsEnabled(parallelTangentName))
+			{
+				std::vector<Vertex> parallelVertices = vertices;
+				std::vector<uint32_t> parallelIndices = indices;
+				suite.Run(parallelTangentName, "triangle", triangles, vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t), [&]()
+					{
+						TangentSpace::Generate(parallelVertices, parallelIndices, 0);
+						DoNotOptimize(parallelVertices[parallelVertices.size() / 2].tangent.x);
+					});
+
+				std::vector<Vertex> serialVertices = vertices;
+				std::vector<uint32_t> serialIndices = indices;
+				TangentSpace::Generate(serialVertices, serialIndices);
+				TangentSpace::Generate(parallelVertices, parallelIndices, 5);
+				if (!IsSameMesh(serialVertices, serialIndices, parallelVertices, parallelIndices))
+					suite.Fail("the multithreaded and single-threaded tangents differ on " + filename);
+			}
+
+			if (!suite.IsEnabled(tangentName))
+				continue;
+
+			if (&size == &meshSizes[0])
+				CheckTangentEdgeCases(suite);
+
+			size_t splitCount{};
+			suite.Run(tangentName, "triangle", triangles, vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t), [&]()
+				{
+					splitCount = TangentSpace::Generate(vertices, indices);
+					DoNotOptimize(vertices[vertices.size() / 2].tangent.x);
+				});
+
+			//The grid's u runs along +x and v along +z under a +y normal: a mirrored mapping (cross(u, v) points against the normal),
+			//so every sign is negative. Mirroring the uvs once more flips the tangents and gives the unmirrored, positive sign.
+			std::vector<Vertex> mirroredVertices = vertices;
+			std::vector<uint32_t> mirroredIndices = indices;
+			for (Vertex& vertex : mirroredVertices)
+				vertex.uv.x = 1.f - vertex.uv.x;
+			TangentSpace::Generate(mirroredVertices, mirroredIndices);
+
+			bool isExpected{ splitCount == 0 && mirroredVertices.size() == vertices.size() };
+			for (size_t i{ 0 }; isExpected && i < vertices.size(); ++i)
+			{
+				const Vector3 tangent = vertices[i].tangent.GetXYZ(), mirroredTangent = mirroredVertices[i].tangent.GetXYZ();
+				isExpected = vertices[i].tangent.w == -1.f && mirroredVertices[i].tangent.w == 1.f && tangent.x > 0.99f
+					&& std::abs(Vector3::Dot(tangent, vertices[i].normal)) < 1e-5f && Vector3::Dot(tangent, mirroredTangent) < -0.9999f;
+			}
+			if (!isExpected)
+				suite.Fail("the tangents of " + filename + " or its mirrored copy don't follow its uvs");
+		}
+
+		RunExportedFBXBenchmarks(suite);
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+// Minimal harness for the CPU benchmark suite: every benchmark is a named piece of work that is repeated until
+// enough time has passed, and ends up as one entry in the JSON report (ns/op, bytes/s, allocations/op).
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Benchmark
+{
+	//Counted by the global operator new replacement in BenchmarkSuite.cpp
+	struct AllocationStats
+	{
+		uint64_t count{};
+		uint64_t bytes{};
+	};
+	AllocationStats GetAllocationStats();
+
+	struct Options
+	{
+		bool quick{ false };
+		double minSeconds{ 0.5 };			//total timed duration per benchmark (split over the samples)
+		int samples{ 5 };					//the fastest sample is reported
+		uint64_t maxTriangles{ 1'000'000 };	//largest synthetic mesh, up to 10M
+		std::string filter{};				//only run benchmarks whose name contains this
+	};
+
+	struct Result
+	{
+		std::string name{};
+		std::string unit{};					//what a single op is: "matrix", "vector", "frame", "triangle", ...
+		uint64_t opsPerSample{};
+		double nsPerOp{};
+		double bytesPerSecond{};			//0 when the benchmark has no meaningful byte count
+		double allocationsPerOp{};
+		double allocatedBytesPerOp{};
+	};
+
+	class Suite final
+	{
+	public:
+		explicit Suite(const Options& options);
+
+		bool IsEnabled(const std::string& name) const;
+
+		//work() does opsPerCall ops and touches bytesPerCall bytes. It runs once untimed to warm up, then is
+		//repeated in samples.
+		void Run(const std::string& name, const std::string& unit, uint64_t opsPerCall, uint64_t bytesPerCall, const std::function<void()>& work);
+
+		//Self-checks (e.g. two implementations disagreeing) report here; the suite then exits with an error
+		void Fail(const std::string& message);
+
+		const Options& GetOptions() const { return m_Options; }
+		const std::vector<Result>& GetResults() const { return m_Results; }
+		size_t GetFailureCount() const { return m_FailureCount; }
+
+	private:
+		Options m_Options;
+		std::vector<Result> m_Results{};
+		size_t m_FailureCount{};
+	};
+
+	//Keeps a value observable so the optimizer can't drop the work that produced it
+	void DoNotOptimize(float value);
+
+	void RunMathBenchmarks(Suite& suite);
+	void RunAssetBenchmarks(Suite& suite);
+	void RunTextureBenchmarks(Suite& suite);
+}
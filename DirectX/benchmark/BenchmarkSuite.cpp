@@ -0,0 +1,312 @@
+// CPU benchmark suite for the math and asset pipeline code, runs without a GPU or window.
+// Writes a JSON report; pass a previous report with --baseline to get per-benchmark speedups between two commits.
+//
+//   BenchmarkSuite [--quick] [--filter <text>] [--max-triangles <n>] [--min-time <seconds>]
+//                  [--out <report.json>] [--baseline <report.json>]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <thread>
+
+#include "Benchmark.h"
+#include "SIMD.h"
+
+namespace
+{
+	std::atomic<uint64_t> g_AllocationCount{ 0 };
+	std::atomic<uint64_t> g_AllocatedBytes{ 0 };
+}
+
+//Counting replacements of the global allocation functions; the array forms forward here by default
+void* operator new(std::size_t size)
+{
+	g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	g_AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* p = std::malloc(size != 0 ? size : 1))
+		return p;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace Benchmark
+{
+	AllocationStats GetAllocationStats()
+	{
+		return { g_AllocationCount.load(std::memory_order_relaxed), g_AllocatedBytes.load(std::memory_order_relaxed) };
+	}
+
+	void DoNotOptimize(float value)
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		static volatile float sink{};
+		sink = value;
+#else
+		//An empty asm that claims to read value: the compiler has to compute it, but no store is emitted
+		asm volatile("" : : "r"(value) : "memory");
+#endif
+	}
+
+	Suite::Suite(const Options& options) :
+		m_Options{ options }
+	{
+	}
+
+	void Suite::Fail(const std::string& message)
+	{
+		std::fprintf(stderr, "FAILED: %s\n", message.c_str());
+		++m_FailureCount;
+	}
+
+	bool Suite::IsEnabled(const std::string& name) const
+	{
+		return m_Options.filter.empty() || name.find(m_Options.filter) != std::string::npos;
+	}
+
+	void Suite::Run(const std::string& name, const std::string& unit, uint64_t opsPerCall, uint64_t bytesPerCall, const std::function<void()>& work)
+	{
+		if (!IsEnabled(name))
+			return;
+
+		using Clock = std::chrono::steady_clock;
+		const auto elapsedNs = [](Clock::time_point start) { return std::chrono::duration<double, std::nano>(Clock::now() - start).count(); };
+
+		//The warm-up call doubles as calibration: a sample is as many calls as fit in minSeconds / samples,
+		//and slow benchmarks (large mesh parses) drop samples instead of running for minutes
+		const auto warmUpStart = Clock::now();
+		work();
+		const double callNs = std::max(elapsedNs(warmUpStart), 1.0);
+
+		const double budgetNs = m_Options.minSeconds * 1e9;
+		int samples = m_Options.samples;
+		uint64_t callsPerSample = static_cast<uint64_t>(budgetNs / samples / callNs);
+		if (callsPerSample == 0)
+		{
+			callsPerSample = 1;
+			samples = std::clamp(static_cast<int>(budgetNs / callNs), 1, m_Options.samples);
+		}
+
+		double bestNs{ 1e300 };
+		const AllocationStats before = GetAllocationStats();
+		for (int sample{ 0 }; sample < samples; ++sample)
+		{
+			const auto start = Clock::now();
+			for (uint64_t call{ 0 }; call < callsPerSample; ++call)
+			{
+				work();
+			}
+			bestNs = std::min(bestNs, elapsedNs(start) / static_cast<double>(callsPerSample));
+		}
+		const AllocationStats after = GetAllocationStats();
+
+		const double totalOps = static_cast<double>(samples) * static_cast<double>(callsPerSample) * static_cast<double>(opsPerCall);
+
+		Result result{};
+		result.name = name;
+		result.unit = unit;
+		result.opsPerSample = callsPerSample * opsPerCall;
+		result.nsPerOp = bestNs / static_cast<double>(opsPerCall);
+		result.bytesPerSecond = bytesPerCall != 0 ? static_cast<double>(bytesPerCall) / (bestNs * 1e-9) : 0.0;
+		result.allocationsPerOp = static_cast<double>(after.count - before.count) / totalOps;
+		result.allocatedBytesPerOp = static_cast<double>(after.bytes - before.bytes) / totalOps;
+
+		std::fprintf(stderr, "%-32s %14.3f ns/%s", name.c_str(), result.nsPerOp, unit.c_str());
+		if (result.bytesPerSecond > 0.0)
+			std::fprintf(stderr, "  %10.1f MB/s", result.bytesPerSecond / 1e6);
+		std::fprintf(stderr, "  %8.3f allocs/%s\n", result.allocationsPerOp, unit.c_str());
+
+		m_Results.push_back(std::move(result));
+	}
+}
+
+namespace
+{
+	const char* GetSimdName()
+	{
+#if defined(__AVX2__)
+		return "AVX2";
+#elif defined(__AVX__)
+		return "AVX";
+#elif defined(MATH_USE_SSE)
+		return "SSE2";
+#else
+		return "scalar";
+#endif
+	}
+
+	std::string GetCompilerName()
+	{
+		std::ostringstream stream{};
+#if defined(_MSC_VER)
+		stream << "MSVC " << _MSC_VER;
+#elif defined(__clang__)
+		stream << "clang " << __clang_major__ << '.' << __clang_minor__;
+#elif defined(__GNUC__)
+		stream << "gcc " << __GNUC__ << '.' << __GNUC_MINOR__;
+#else
+		stream << "unknown";
+#endif
+		return stream.str();
+	}
+
+	//Names and units are plain identifiers, only quotes and backslashes need escaping
+	std::string Quote(const std::string& text)
+	{
+		std::string quoted{ "\"" };
+		for (const char c : text)
+		{
+			if (c == '"' || c == '\\')
+				quoted += '\\';
+			quoted += c;
+		}
+		return quoted + '"';
+	}
+
+	//Reads name -> ns_per_op back from a report written by this executable (not a general JSON parser)
+	std::map<std::string, double> ReadBaseline(const std::string& path)
+	{
+		std::map<std::string, double> baseline{};
+
+		std::ifstream file{ path };
+		if (!file)
+		{
+			std::fprintf(stderr, "Could not open baseline %s\n", path.c_str());
+			return baseline;
+		}
+		const std::string text{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+
+		const std::string nameKey{ "\"name\": \"" };
+		const std::string nsKey{ "\"ns_per_op\": " };
+		for (size_t position = text.find(nameKey); position != std::string::npos; position = text.find(nameKey, position))
+		{
+			position += nameKey.size();
+			const size_t nameEnd = text.find('"', position);
+			const size_t nsPosition = text.find(nsKey, nameEnd);
+			if (nameEnd == std::string::npos || nsPosition == std::string::npos)
+				break;
+
+			baseline[text.substr(position, nameEnd - position)] = std::strtod(text.c_str() + nsPosition + nsKey.size(), nullptr);
+		}
+
+		return baseline;
+	}
+
+	void WriteReport(std::FILE* pFile, const Benchmark::Suite& suite, const std::map<std::string, double>& baseline)
+	{
+		const Benchmark::Options& options = suite.GetOptions();
+
+		std::fprintf(pFile, "{\n");
+		std::fprintf(pFile, "  \"compiler\": %s,\n", Quote(GetCompilerName()).c_str());
+		std::fprintf(pFile, "  \"simd\": \"%s\",\n", GetSimdName());
+		std::fprintf(pFile, "  \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+#if defined(NDEBUG)
+		std::fprintf(pFile, "  \"optimized\": true,\n");
+#else
+		std::fprintf(pFile, "  \"optimized\": false,\n");
+#endif
+		std::fprintf(pFile, "  \"quick\": %s,\n", options.quick ? "true" : "false");
+		std::fprintf(pFile, "  \"results\": [");
+
+		const std::vector<Benchmark::Result>& results = suite.GetResults();
+		for (size_t i{ 0 }; i < results.size(); ++i)
+		{
+			const Benchmark::Result& result = results[i];
+			std::fprintf(pFile, "%s\n    {\n", i == 0 ? "" : ",");
+			std::fprintf(pFile, "      \"name\": %s,\n", Quote(result.name).c_str());
+			std::fprintf(pFile, "      \"unit\": %s,\n", Quote(result.unit).c_str());
+			std::fprintf(pFile, "      \"ops_per_sample\": %llu,\n", static_cast<unsigned long long>(result.opsPerSample));
+			std::fprintf(pFile, "      \"ns_per_op\": %.4f,\n", result.nsPerOp);
+			std::fprintf(pFile, "      \"bytes_per_second\": %.1f,\n", result.bytesPerSecond);
+			std::fprintf(pFile, "      \"allocations_per_op\": %.6f,\n", result.allocationsPerOp);
+			std::fprintf(pFile, "      \"allocated_bytes_per_op\": %.3f", result.allocatedBytesPerOp);
+
+			const auto it = baseline.find(result.name);
+			if (it != baseline.end() && result.nsPerOp > 0.0)
+			{
+				std::fprintf(pFile, ",\n      \"baseline_ns_per_op\": %.4f,\n", it->second);
+				std::fprintf(pFile, "      \"speedup\": %.3f", it->second / result.nsPerOp);
+			}
+			std::fprintf(pFile, "\n    }");
+		}
+		std::fprintf(pFile, "\n  ]\n}\n");
+	}
+
+	void PrintUsage()
+	{
+		std::fprintf(stderr, "Usage: BenchmarkSuite [--quick] [--filter <text>] [--max-triangles <n>] [--min-time <seconds>] [--out <report.json>] [--baseline <report.json>]\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Benchmark::Options options{};
+	std::string outPath{};
+	std::string baselinePath{};
+
+	for (int i{ 1 }; i < argc; ++i)
+	{
+		const std::string argument{ argv[i] };
+		const bool hasValue = i + 1 < argc;
+
+		if (argument == "--quick")
+		{
+			options.quick = true;
+			options.minSeconds = 0.02;
+			options.samples = 3;
+			options.maxTriangles = 10'000;
+		}
+		else if (argument == "--filter" && hasValue)
+			options.filter = argv[++i];
+		else if (argument == "--max-triangles" && hasValue)
+			options.maxTriangles = std::strtoull(argv[++i], nullptr, 10);
+		else if (argument == "--min-time" && hasValue)
+			options.minSeconds = std::max(std::strtod(argv[++i], nullptr), 0.0);
+		else if (argument == "--out" && hasValue)
+			outPath = argv[++i];
+		else if (argument == "--baseline" && hasValue)
+			baselinePath = argv[++i];
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	Benchmark::Suite suite{ options };
+	Benchmark::RunMathBenchmarks(suite);
+	Benchmark::RunAssetBenchmarks(suite);
+	Benchmark::RunTextureBenchmarks(suite);
+
+	const std::map<std::string, double> baseline = baselinePath.empty() ? std::map<std::string, double>{} : ReadBaseline(baselinePath);
+
+	if (outPath.empty())
+	{
+		WriteReport(stdout, suite, baseline);
+		return suite.GetFailureCount() == 0 ? 0 : 1;
+	}
+
+	std::FILE* pFile = std::fopen(outPath.c_str(), "w");
+	if (!pFile)
+	{
+		std::fprintf(stderr, "Could not write %s\n", outPath.c_str());
+		return 1;
+	}
+	WriteReport(pFile, suite, baseline);
+	std::fclose(pFile);
+	return suite.GetFailureCount() == 0 ? 0 : 1;
+}
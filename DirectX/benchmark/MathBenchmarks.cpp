@@ -0,0 +1,385 @@
+// Matrix / Vector3 kernels and the per-frame camera update.
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <vector>
+
+#include "Benchmark.h"
+#include "SdlStubs.h"
+
+#include "Math.h"
+#include "Camera.h"
+#include "Timer.h"
+#include "Utils.h"
+
+namespace
+{
+	constexpr size_t matrixCount{ 1024 };
+	constexpr size_t vectorCount{ 4096 };
+
+	std::vector<Matrix> CreateMatrices()
+	{
+		std::vector<Matrix> matrices{};
+		matrices.reserve(matrixCount);
+		for (size_t i{ 0 }; i < matrixCount; ++i)
+		{
+			const float f = static_cast<float>(i);
+			matrices.push_back(Matrix::CreateScale(1.f + f * 0.001f, 1.f, 1.f + f * 0.002f)
+				* Matrix::CreateRotation(f * 0.01f, f * 0.02f, f * 0.03f)
+				* Matrix::CreateTranslation(f, -f, f * 0.5f));
+		}
+		return matrices;
+	}
+
+	std::vector<Vector3> CreateVectors(float offset)
+	{
+		std::vector<Vector3> vectors(vectorCount);
+		for (size_t i{ 0 }; i < vectorCount; ++i)
+		{
+			const float f = static_cast<float>(i) + offset;
+			vectors[i] = Vector3{ std::sin(f) * 10.f, std::cos(f * 0.7f) * 5.f + 6.f, f * 0.01f + 1.f };
+		}
+		return vectors;
+	}
+
+	float MaxElementDifference(const Matrix& a, const Matrix& b)
+	{
+		float maxDifference{ 0.f };
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			for (int c{ 0 }; c < 4; ++c)
+				maxDifference = std::max(maxDifference, std::abs(a[r][c] - b[r][c]));
+		}
+		return maxDifference;
+	}
+
+	//MaxElementDifference relative to the size of the expected matrix, for transforms with large translations
+	float RelativeDifference(const Matrix& actual, const Matrix& expected)
+	{
+		float maxElement{ 0.f };
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			for (int c{ 0 }; c < 4; ++c)
+				maxElement = std::max(maxElement, std::abs(expected[r][c]));
+		}
+		return MaxElementDifference(actual, expected) / (1.f + maxElement);
+	}
+
+	//Largest difference between the batched Matrix::Transform* overloads and the scalar TransformPoint/TransformVector,
+	//over counts that leave partial SSE/AVX tails, both into a separate buffer and in place
+	float BatchedTransformError(const Matrix& matrix, const std::vector<Vector3>& vectors)
+	{
+		//A projective copy so the Vector4 results have a w that depends on the input
+		Matrix projective{ matrix };
+		projective[0][3] = 0.01f;
+		projective[2][3] = 1.f;
+		projective[3][3] = 0.5f;
+
+		float maxError{ 0.f };
+		const auto distance = [](const Vector4& a, const Vector4& b) { return (a - b).Magnitude(); };
+		for (const size_t count : { size_t{ 1 }, size_t{ 3 }, size_t{ 5 }, size_t{ 7 }, size_t{ 13 }, vectors.size() - 3 })
+		{
+			const std::span<const Vector3> in{ vectors.data(), count };
+			std::vector<Vector3> points(count);
+			std::vector<Vector3> directions(count);
+			std::vector<Vector3> inPlacePoints(in.begin(), in.end());
+			std::vector<Vector3> inPlaceDirections(in.begin(), in.end());
+			matrix.TransformPoints(in, points);
+			matrix.TransformVectors(in, directions);
+			matrix.TransformPoints(inPlacePoints, inPlacePoints);
+			matrix.TransformVectors(inPlaceDirections, inPlaceDirections);
+
+			std::vector<Vector4> homogeneous(count);
+			std::vector<Vector4> points4(count);
+			std::vector<Vector4> inPlacePoints4(count);
+			for (size_t i{ 0 }; i < count; ++i)
+				inPlacePoints4[i] = Vector4{ in[i], 0.5f + static_cast<float>(i % 3) * 0.5f };
+			const std::vector<Vector4> in4{ inPlacePoints4 };
+			projective.TransformPoints(in, homogeneous);
+			projective.TransformPoints(in4, points4);
+			projective.TransformPoints(inPlacePoints4, inPlacePoints4);
+
+			for (size_t i{ 0 }; i < count; ++i)
+			{
+				const Vector3 point = matrix.TransformPoint(in[i]);
+				const Vector3 direction = matrix.TransformVector(in[i]);
+				const Vector4 point4 = projective.TransformPoint(in4[i]);
+				maxError = std::max({ maxError, (points[i] - point).Magnitude(), (inPlacePoints[i] - point).Magnitude(),
+					(directions[i] - direction).Magnitude(), (inPlaceDirections[i] - direction).Magnitude(),
+					distance(homogeneous[i], projective.TransformPoint(Vector4{ in[i], 1.f })),
+					distance(points4[i], point4), distance(inPlacePoints4[i], point4) });
+			}
+		}
+		return maxError;
+	}
+}
+
+namespace Benchmark
+{
+	void RunMathBenchmarks(Suite& suite)
+	{
+		const std::vector<Matrix> matrices = CreateMatrices();
+		std::vector<Matrix> matrixOut(matrixCount);
+		constexpr uint64_t matrixBytes{ matrixCount * sizeof(Matrix) };
+
+		suite.Run("matrix.multiply", "matrix", matrixCount - 1, 3 * (matrixCount - 1) * sizeof(Matrix), [&]()
+			{
+				for (size_t i{ 1 }; i < matrixCount; ++i) matrixOut[i] = matrices[i - 1] * matrices[i];
+				DoNotOptimize(matrixOut[matrixCount / 2][3][0]);
+			});
+
+		suite.Run("matrix.inverse", "matrix", matrixCount, 2 * matrixBytes, [&]()
+			{
+				for (size_t i{ 0 }; i < matrixCount; ++i) matrixOut[i] = Matrix::Inverse(matrices[i]);
+				DoNotOptimize(matrixOut[matrixCount / 2][3][0]);
+			});
+
+		//AffineTransform against the Matrix operations it replaces. matrices are scaled non-uniformly; the rigid ones are
+		//rotation * translation like the camera's inverse view.
+		std::vector<AffineTransform> affines(matrixCount);
+		std::vector<AffineTransform> rigids(matrixCount);
+		for (size_t i{ 0 }; i < matrixCount; ++i)
+		{
+			const float f = static_cast<float>(i);
+			affines[i] = AffineTransform{ matrices[i] };
+			rigids[i] = AffineTransform{ Matrix::CreateRotation(f * 0.03f, f * 0.02f, f * 0.01f) } * AffineTransform::CreateTranslation({ f, f * 0.5f, -f });
+		}
+		const Matrix projection = Matrix::CreatePerspectiveFovLH(1.f, 16.f / 9.f, 0.1f, 1000.f);
+		float affineInverseError{ 0.f };
+		float rigidInverseError{ 0.f };
+		float compositionError{ 0.f };
+		for (size_t i{ 1 }; i < matrixCount; ++i)
+		{
+			//The identity's translation cancels out the transform's own, so its rounding scales with that
+			const float translationSize{ 1.f + affines[i].translation.Magnitude() };
+			affineInverseError = std::max({ affineInverseError, MaxElementDifference((affines[i] * affines[i].InverseAffine()).ToMatrix(), Matrix::Identity) / translationSize,
+				MaxElementDifference((affines[i].InverseAffine() * affines[i]).ToMatrix(), Matrix::Identity) / translationSize });
+			rigidInverseError = std::max(rigidInverseError, RelativeDifference(rigids[i].InverseRigid().ToMatrix(), Matrix::Inverse(rigids[i].ToMatrix())));
+			compositionError = std::max({ compositionError,
+				RelativeDifference((affines[i - 1] * affines[i]).ToMatrix(), affines[i - 1].ToMatrix() * affines[i].ToMatrix()),
+				RelativeDifference(affines[i] * (matrices[i - 1] * projection), affines[i].ToMatrix() * (matrices[i - 1] * projection)) });
+		}
+		if (affineInverseError > 1e-5f)
+			suite.Fail("AffineTransform * InverseAffine() differs from the identity by " + std::to_string(affineInverseError));
+		if (rigidInverseError > 1e-5f)
+			suite.Fail("AffineTransform::InverseRigid differs from Matrix::Inverse by " + std::to_string(rigidInverseError));
+		if (compositionError > 1e-5f)
+			suite.Fail("AffineTransform products differ from their ToMatrix() products by " + std::to_string(compositionError));
+
+		std::vector<AffineTransform> affineOut(matrixCount);
+		constexpr uint64_t affineBytes{ matrixCount * sizeof(AffineTransform) };
+		suite.Run("matrix.inverse_rigid", "matrix", matrixCount, 2 * affineBytes, [&]()
+			{
+				for (size_t i{ 0 }; i < matrixCount; ++i) affineOut[i] = rigids[i].InverseRigid();
+				DoNotOptimize(affineOut[matrixCount / 2].translation.x);
+			});
+
+		suite.Run("matrix.inverse_affine", "matrix", matrixCount, 2 * affineBytes, [&]()
+			{
+				for (size_t i{ 0 }; i < matrixCount; ++i) affineOut[i] = affines[i].InverseAffine();
+				DoNotOptimize(affineOut[matrixCount / 2].translation.x);
+			});
+
+		suite.Run("matrix.transpose", "matrix", matrixCount, 2 * matrixBytes, [&]()
+			{
+				for (size_t i{ 0 }; i < matrixCount; ++i) matrixOut[i] = Matrix::Transpose(matrices[i]);
+				DoNotOptimize(matrixOut[matrixCount / 2][3][0]);
+			});
+
+		std::vector<Vector3> eulerAngles = CreateVectors(0.f);
+		eulerAngles.resize(matrixCount);
+		suite.Run("matrix.create_rotation", "matrix", matrixCount, matrixBytes, [&]()
+			{
+				for (size_t i{ 0 }; i < matrixCount; ++i) matrixOut[i] = Matrix::CreateRotation(eulerAngles[i]);
+				DoNotOptimize(matrixOut[matrixCount / 2][1][2]);
+			});
+
+		//Quaternion::FromAxisAngle has to turn the same way as the matrix builders, per axis and composed in Euler order
+		float quaternionError{ 0.f };
+		for (const Vector3& e : eulerAngles)
+		{
+			const Quaternion pitch = Quaternion::FromAxisAngle(Vector3::UnitX, e.x);
+			const Quaternion yaw = Quaternion::FromAxisAngle(Vector3::UnitY, e.y);
+			const Quaternion roll = Quaternion::FromAxisAngle(Vector3::UnitZ, e.z);
+			quaternionError = std::max({ quaternionError, MaxElementDifference(pitch.ToMatrix(), Matrix::CreateRotationX(e.x)),
+				MaxElementDifference(yaw.ToMatrix(), Matrix::CreateRotationY(e.y)), MaxElementDifference(roll.ToMatrix(), Matrix::CreateRotationZ(e.z)),
+				MaxElementDifference((roll * yaw * pitch).ToMatrix(), Matrix::CreateRotation(e)) });
+		}
+		if (quaternionError > 1e-5f)
+			suite.Fail("Quaternion::FromAxisAngle differs from Matrix::CreateRotationX/Y/Z by " + std::to_string(quaternionError));
+
+		//Products, Rotate and renormalization on rotations about arbitrary axes
+		const std::vector<Vector3> axes = CreateVectors(2.f);
+		float productError{ 0.f };
+		float rotateError{ 0.f };
+		for (size_t i{ 1 }; i < axes.size(); ++i)
+		{
+			const Quaternion q1 = Quaternion::FromAxisAngle(axes[i - 1], static_cast<float>(i) * 0.37f);
+			const Quaternion q2 = Quaternion::FromAxisAngle(axes[i], static_cast<float>(i) * 0.11f);
+			productError = std::max(productError, MaxElementDifference((q1 * q2).ToMatrix(), q2.ToMatrix() * q1.ToMatrix()));
+			rotateError = std::max(rotateError, (q1.Rotate(axes[i]) - q1.ToMatrix().TransformVector(axes[i])).Magnitude() / axes[i].Magnitude());
+		}
+		if (productError > 1e-5f)
+			suite.Fail("(q1 * q2).ToMatrix() differs from q2.ToMatrix() * q1.ToMatrix() by " + std::to_string(productError));
+		if (rotateError > 1e-5f)
+			suite.Fail("Quaternion::Rotate differs from ToMatrix().TransformVector by " + std::to_string(rotateError));
+
+		//Mesh::Rotate's accumulation: one small turn per frame, renormalized every 64 of them
+		Quaternion accumulated{};
+		float unitError{ 0.f };
+		for (size_t frame{ 0 }; frame < 100'000; ++frame)
+		{
+			accumulated *= Quaternion::FromAxisAngle(axes[frame % axes.size()], 0.01f);
+			if (frame % 64 == 63)
+				accumulated.Normalize();
+			unitError = std::max(unitError, std::abs(accumulated.SqrMagnitude() - 1.f));
+		}
+		if (unitError > 1e-4f)
+			suite.Fail("Accumulated quaternion drifts from unit length by " + std::to_string(unitError));
+
+		const std::vector<Vector3> vectors = CreateVectors(0.f);
+		const std::vector<Vector3> normals = [&]()
+			{
+				std::vector<Vector3> result = CreateVectors(1.5f);
+				for (Vector3& n : result) n.Normalize();
+				return result;
+			}();
+		std::vector<Vector3> vectorOut(vectorCount);
+		constexpr uint64_t vectorBytes{ vectorCount * sizeof(Vector3) };
+
+		suite.Run("matrix.transform_points", "vector", vectorCount, 2 * vectorBytes, [&]()
+			{
+				matrices[7].TransformPoints(vectors, vectorOut);
+				DoNotOptimize(vectorOut[vectorCount / 2].x);
+			});
+
+		const float batchedError = BatchedTransformError(matrices[7], vectors);
+		if (batchedError > 1e-3f)
+			suite.Fail("Matrix::TransformPoints/TransformVectors differ from TransformPoint/TransformVector by " + std::to_string(batchedError));
+
+		//The strided in-place path over Vertex, checked against transforming every field on its own
+		std::vector<Vertex> vertices(vectorCount);
+		for (size_t i{ 0 }; i < vectorCount; ++i)
+			vertices[i] = { vectors[i], Vector2{ 0.5f, 0.5f }, normals[i], Vector4{ normals[(i + 1) % vectorCount], -1.f } };
+		std::vector<Vertex> vertexOut{ vertices };
+		Utils::TransformVertices(vertexOut, matrices[7]);
+		suite.Run("matrix.transform_vertices", "vertex", vectorCount, 2 * vectorCount * sizeof(Vertex), [&]()
+			{
+				vertexOut = vertices;
+				Utils::TransformVertices(vertexOut, matrices[7]);
+				DoNotOptimize(vertexOut[vectorCount / 2].position.x);
+			});
+		float maxError{ 0.f };
+		const auto distance = [](const Vector3& a, const Vector3& b) { return (a - b).Magnitude(); };
+		for (size_t i{ 0 }; i < vectorCount; ++i)
+		{
+			const Vertex& in = vertices[i];
+			const Vertex& out = vertexOut[i];
+			maxError = std::max({ maxError, distance(out.position, matrices[7].TransformPoint(in.position)), distance(out.normal, matrices[7].TransformVector(in.normal)),
+				distance(Vector3{ out.tangent.x, out.tangent.y, out.tangent.z }, matrices[7].TransformVector(Vector3{ in.tangent.x, in.tangent.y, in.tangent.z })) });
+			if (out.uv.x != in.uv.x || out.uv.y != in.uv.y || out.tangent.w != in.tangent.w)
+				maxError = INFINITY;
+		}
+		if (maxError > 1e-3f)
+			suite.Fail("Utils::TransformVertices differs from TransformPoint/TransformVector by " + std::to_string(maxError));
+
+		suite.Run("vector3.normalized", "vector", vectorCount, 2 * vectorBytes, [&]()
+			{
+				for (size_t i{ 0 }; i < vectorCount; ++i) vectorOut[i] = vectors[i].Normalized();
+				DoNotOptimize(vectorOut[vectorCount / 2].x);
+			});
+
+		suite.Run("vector3.reject", "vector", vectorCount, 3 * vectorBytes, [&]()
+			{
+				for (size_t i{ 0 }; i < vectorCount; ++i) vectorOut[i] = Vector3::Reject(vectors[i], normals[i]);
+				DoNotOptimize(vectorOut[vectorCount / 2].x);
+			});
+
+		//Frustum culling of objects scattered around the camera, roughly a fifth of them visible
+		Camera cullCamera{};
+		cullCamera.Initialize(45.f, { 0.f, 0.f, 0.f }, 16.f / 9.f);
+		cullCamera.CalculateViewMatrix();
+		cullCamera.CalculateProjectionMatrix();
+		const Frustum frustum = cullCamera.GetFrustum();
+
+		//Not a multiple of 8, so Cull's scalar tail after the SIMD groups runs too
+		constexpr size_t objectCount{ vectorCount - 3 };
+		const std::vector<Vector3> centers = CreateVectors(3.f);
+		std::vector<AABB> boxList(objectCount);
+		AABBArray boxes{};
+		SphereArray spheres{};
+		for (size_t i{ 0 }; i < objectCount; ++i)
+		{
+			const Vector3 center{ centers[i].x * 20.f, centers[i].y * 20.f - 120.f, (centers[i].z - 21.f) * 10.f };
+			boxList[i] = AABB{ center, Vector3{ 1.f, 2.f, 3.f } * (1.f + static_cast<float>(i % 5)) };
+			boxes.Add(boxList[i]);
+			spheres.Add(BoundingSphere::FromAABB(boxList[i]));
+		}
+		std::vector<uint32_t> visibility{};
+
+		//Every bit of both bitmasks has to agree with Intersects() on that object, and the bits past the end stay clear
+		std::vector<uint32_t> sphereVisibility{};
+		frustum.Cull(boxes, visibility);
+		frustum.Cull(spheres, sphereVisibility);
+		size_t boxMismatches{ 0 };
+		size_t sphereMismatches{ 0 };
+		for (size_t i{ 0 }; i < visibility.size() * 32; ++i)
+		{
+			const bool isBoxVisible = i < objectCount && frustum.Intersects(boxList[i]);
+			const bool isSphereVisible = i < objectCount && frustum.Intersects(BoundingSphere::FromAABB(boxList[i]));
+			boxMismatches += ((visibility[i / 32] >> (i % 32)) & 1u) != (isBoxVisible ? 1u : 0u);
+			sphereMismatches += ((sphereVisibility[i / 32] >> (i % 32)) & 1u) != (isSphereVisible ? 1u : 0u);
+		}
+		if (boxMismatches != 0)
+			suite.Fail("Frustum::Cull(AABBArray) disagrees with Intersects on " + std::to_string(boxMismatches) + " boxes");
+		if (sphereMismatches != 0)
+			suite.Fail("Frustum::Cull(SphereArray) disagrees with Intersects on " + std::to_string(sphereMismatches) + " spheres");
+
+		suite.Run("frustum.intersects_aabb", "object", objectCount, objectCount * sizeof(AABB), [&]()
+			{
+				uint32_t visible{ 0 };
+				for (const AABB& box : boxList) visible += frustum.Intersects(box) ? 1 : 0;
+				DoNotOptimize(static_cast<float>(visible));
+			});
+
+		suite.Run("frustum.cull_aabbs", "object", objectCount, objectCount * sizeof(AABB), [&]()
+			{
+				frustum.Cull(boxes, visibility);
+				DoNotOptimize(static_cast<float>(visibility[0]));
+			});
+
+		suite.Run("frustum.cull_spheres", "object", objectCount, objectCount * sizeof(BoundingSphere), [&]()
+			{
+				frustum.Cull(spheres, visibility);
+				DoNotOptimize(static_cast<float>(visibility[0]));
+			});
+
+		//Camera::Update as the render loop calls it: a 60 Hz timer, W held and the right mouse button dragging
+		SdlStubs::SetFrameRate(60);
+		SdlStubs::SetKey(SDL_SCANCODE_W, true);
+		SdlStubs::SetMouse(SDL_BUTTON_RMASK, 1, 0);
+
+		Timer timer{};
+		timer.Start();
+		Camera camera{};
+
+		constexpr uint64_t framesPerCall{ 1000 };
+		suite.Run("camera.update", "frame", framesPerCall, 0, [&]()
+			{
+				//Restart from the same pose so the angles stay in their usual range however many calls are timed
+				camera.Initialize(45.f, { 0.f, 0.f, -132.827f }, 16.f / 9.f);
+				camera.totalPitch = 0.f;
+				camera.totalYaw = 0.f;
+
+				for (uint64_t frame{ 0 }; frame < framesPerCall; ++frame)
+				{
+					timer.Update();
+					camera.Update(&timer);
+				}
+				DoNotOptimize(camera.GetWorldViewProjection()[3][2]);
+			});
+
+		SdlStubs::SetKey(SDL_SCANCODE_W, false);
+		SdlStubs::SetMouse(0, 0, 0);
+	}
+}
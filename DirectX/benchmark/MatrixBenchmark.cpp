@@ -0,0 +1,216 @@
+// Compares Matrix::operator* against the previous transpose + Vector4::Dot implementation,
+// the batched Matrix::TransformPoints against a per-point TransformPoint loop,
+// and the fused Euler rotation builders against the X * Y * Z product they replace.
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Math.h"
+
+namespace
+{
+	//The Matrix::operator* implementation before the SIMD kernel, kept here as the baseline
+	Matrix ReferenceMultiply(const Matrix& lhs, const Matrix& rhs)
+	{
+		Matrix result{};
+		const Matrix rhsTransposed = Matrix::Transpose(rhs);
+
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			for (int c{ 0 }; c < 4; ++c)
+			{
+				result[r][c] = Vector4::Dot(lhs[r], rhsTransposed[c]);
+			}
+		}
+
+		return result;
+	}
+
+	std::vector<Matrix> CreateMatrices(size_t count)
+	{
+		std::vector<Matrix> matrices{};
+		matrices.reserve(count);
+		for (size_t i{ 0 }; i < count; ++i)
+		{
+			const float f = static_cast<float>(i);
+			matrices.push_back(Matrix::CreateScale(1.f + f * 0.001f, 1.f, 1.f + f * 0.002f)
+				* Matrix::CreateRotation(f * 0.01f, f * 0.02f, f * 0.03f)
+				* Matrix::CreateTranslation(f, -f, f * 0.5f));
+		}
+		return matrices;
+	}
+
+	template<typename Multiply>
+	double MeasureNsPerOp(const std::vector<Matrix>& matrices, int repetitions, Matrix& sink, Multiply multiply)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (int rep{ 0 }; rep < repetitions; ++rep)
+		{
+			for (size_t i{ 1 }; i < matrices.size(); ++i)
+			{
+				sink = multiply(matrices[i - 1], matrices[i]) ;
+				sink[3][3] += 1e-9f; //keep the result observable
+			}
+		}
+		const auto end = std::chrono::steady_clock::now();
+
+		const double ops = static_cast<double>(repetitions) * static_cast<double>(matrices.size() - 1);
+		return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+	}
+
+	template<typename Transform>
+	double MeasureNsPerPoint(std::vector<Vector3>& points, int repetitions, Transform transform)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (int rep{ 0 }; rep < repetitions; ++rep)
+		{
+			transform(points);
+		}
+		const auto end = std::chrono::steady_clock::now();
+
+		const double ops = static_cast<double>(repetitions) * static_cast<double>(points.size());
+		return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+	}
+
+	bool BenchmarkBatchedTransforms(int repetitions)
+	{
+		const Matrix transform = Matrix::CreateRotation(0.1f, 0.2f, 0.3f) * Matrix::CreateTranslation(0.f, 1e-6f, 0.f);
+
+		//Not a multiple of 4 or 8, so the scalar tail after the SIMD lanes runs too
+		std::vector<Vector3> points(100'003);
+		for (size_t i{ 0 }; i < points.size(); ++i)
+		{
+			points[i] = Vector3{ static_cast<float>(i % 97), static_cast<float>(i % 89), static_cast<float>(i % 83) };
+		}
+
+		std::vector<Vector3> batched{ points };
+		transform.TransformPoints(batched, batched);
+		for (size_t i{ 0 }; i < points.size(); ++i)
+		{
+			const Vector3 expected = transform.TransformPoint(points[i]);
+			if ((batched[i] - expected).Magnitude() > 1e-4f * (1.f + expected.Magnitude()))
+			{
+				std::printf("TransformPoints mismatch at %zu: (%f, %f, %f) vs (%f, %f, %f)\n", i,
+					batched[i].x, batched[i].y, batched[i].z, expected.x, expected.y, expected.z);
+				return false;
+			}
+		}
+
+		const double scalarNs = MeasureNsPerPoint(points, repetitions, [&](std::vector<Vector3>& p)
+			{
+				for (Vector3& point : p) point = transform.TransformPoint(point);
+			});
+		const double batchedNs = MeasureNsPerPoint(points, repetitions, [&](std::vector<Vector3>& p)
+			{
+				transform.TransformPoints(p, p);
+			});
+
+		std::printf("TransformPoint loop:   %8.3f ns/point\n", scalarNs);
+		std::printf("TransformPoints batch: %8.3f ns/point\n", batchedNs);
+		std::printf("Speedup: %.2fx (checksum %f)\n", scalarNs / batchedNs, points[points.size() / 2].x);
+		return true;
+	}
+
+	bool BenchmarkRotations(int repetitions)
+	{
+		std::vector<Vector3> eulerAngles(4096);
+		for (size_t i{ 0 }; i < eulerAngles.size(); ++i)
+		{
+			const float f = static_cast<float>(i);
+			eulerAngles[i] = Vector3{ std::fmod(f * 0.37f, 2.f * PI) - PI, std::fmod(f * 0.11f, PI) - PI_DIV_2, std::fmod(f * 0.07f, 2.f * PI) - PI };
+		}
+		std::vector<Matrix> rotations(eulerAngles.size());
+
+		Matrix::CreateRotations(eulerAngles, rotations);
+		for (size_t i{ 0 }; i < eulerAngles.size(); ++i)
+		{
+			const Vector3& e = eulerAngles[i];
+			const Matrix expected = Matrix::CreateRotationX(e.x) * Matrix::CreateRotationY(e.y) * Matrix::CreateRotationZ(e.z);
+			const Matrix fused = Matrix::CreateRotation(e);
+			for (int r{ 0 }; r < 4; ++r)
+			{
+				for (int c{ 0 }; c < 4; ++c)
+				{
+					if (!AreEqual(expected[r][c], fused[r][c], 1e-5f) || !AreEqual(expected[r][c], rotations[i][r][c], 1e-5f))
+					{
+						std::printf("Rotation mismatch at %zu [%d][%d]: %f vs %f / %f\n", i, r, c, expected[r][c], fused[r][c], rotations[i][r][c]);
+						return false;
+					}
+				}
+			}
+		}
+
+		const auto measure = [&](auto build)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				for (int rep{ 0 }; rep < repetitions; ++rep) build();
+				const auto end = std::chrono::steady_clock::now();
+				return std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(repetitions) * static_cast<double>(eulerAngles.size()));
+			};
+
+		const double productNs = measure([&]
+			{
+				for (size_t i{ 0 }; i < eulerAngles.size(); ++i)
+				{
+					const Vector3& e = eulerAngles[i];
+					rotations[i] = Matrix::CreateRotationX(e.x) * Matrix::CreateRotationY(e.y) * Matrix::CreateRotationZ(e.z);
+				}
+			});
+		const double fusedNs = measure([&]
+			{
+				for (size_t i{ 0 }; i < eulerAngles.size(); ++i) rotations[i] = Matrix::CreateRotation(eulerAngles[i]);
+			});
+		const double batchNs = measure([&] { Matrix::CreateRotations(eulerAngles, rotations); });
+
+		std::printf("CreateRotation X * Y * Z:  %8.2f ns/matrix\n", productNs);
+		std::printf("CreateRotation fused:      %8.2f ns/matrix\n", fusedNs);
+		std::printf("CreateRotations batch:     %8.2f ns/matrix\n", batchNs);
+		std::printf("Speedup: %.2fx fused, %.2fx batch (checksum %f)\n", productNs / fusedNs, productNs / batchNs, rotations[7][1][2]);
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+	const int repetitions = quick ? 20 : 2000;
+
+	const std::vector<Matrix> matrices = CreateMatrices(1024);
+
+	//Both paths have to agree before the timings mean anything
+	for (size_t i{ 1 }; i < matrices.size(); ++i)
+	{
+		const Matrix expected = ReferenceMultiply(matrices[i - 1], matrices[i]);
+		Matrix accumulated{ matrices[i - 1] };
+		accumulated *= matrices[i];
+		const Matrix actual = matrices[i - 1] * matrices[i];
+
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			for (int c{ 0 }; c < 4; ++c)
+			{
+				const float tolerance = 1e-4f * (1.f + std::abs(expected[r][c]));
+				if (!AreEqual(expected[r][c], actual[r][c], tolerance) || !AreEqual(expected[r][c], accumulated[r][c], tolerance))
+				{
+					std::printf("Mismatch at matrix %zu [%d][%d]: %f vs %f\n", i, r, c, expected[r][c], actual[r][c]);
+					return 1;
+				}
+			}
+		}
+	}
+
+	Matrix sink{};
+	const double referenceNs = MeasureNsPerOp(matrices, repetitions, sink,
+		[](const Matrix& lhs, const Matrix& rhs) { return ReferenceMultiply(lhs, rhs); });
+	const double simdNs = MeasureNsPerOp(matrices, repetitions, sink,
+		[](const Matrix& lhs, const Matrix& rhs) { return lhs * rhs; });
+
+	std::printf("Matrix multiply (reference transpose + dot): %8.2f ns/op\n", referenceNs);
+	std::printf("Matrix multiply (row * matrix kernel):       %8.2f ns/op\n", simdNs);
+	std::printf("Speedup: %.2fx (checksum %f)\n", referenceNs / simdNs, sink[3][3]);
+
+	if (!BenchmarkBatchedTransforms(quick ? 2 : 200))
+		return 1;
+	return BenchmarkRotations(quick ? 5 : 500) ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+#include "SdlStubs.h"
+
+#include <SDL_timer.h>
+
+namespace
+{
+	constexpr Uint64 countsPerSecond{ 1'000'000'000 };
+
+	Uint8 g_KeyboardState[SDL_NUM_SCANCODES]{};
+	Uint32 g_MouseButtons{};
+	int g_MouseX{};
+	int g_MouseY{};
+	Uint64 g_Counter{};
+	Uint64 g_CountsPerFrame{ countsPerSecond / 60 };
+}
+
+namespace SdlStubs
+{
+	void SetKey(SDL_Scancode key, bool isDown)
+	{
+		g_KeyboardState[key] = isDown ? 1 : 0;
+	}
+
+	void SetMouse(uint32_t buttonMask, int relativeX, int relativeY)
+	{
+		g_MouseButtons = buttonMask;
+		g_MouseX = relativeX;
+		g_MouseY = relativeY;
+	}
+
+	void SetFrameRate(uint32_t framesPerSecond)
+	{
+		g_CountsPerFrame = countsPerSecond / framesPerSecond;
+	}
+}
+
+const Uint8* SDL_GetKeyboardState(int* numkeys)
+{
+	if (numkeys)
+		*numkeys = SDL_NUM_SCANCODES;
+	return g_KeyboardState;
+}
+
+Uint32 SDL_GetRelativeMouseState(int* x, int* y)
+{
+	if (x) *x = g_MouseX;
+	if (y) *y = g_MouseY;
+	return g_MouseButtons;
+}
+
+Uint64 SDL_GetPerformanceCounter(void)
+{
+	g_Counter += g_CountsPerFrame;
+	return g_Counter;
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+	return countsPerSecond;
+}
@@ -0,0 +1,14 @@
+#pragma once
+// The few SDL entry points the CPU-side code calls (input state for Camera::Update, the performance counter for
+// Timer), implemented in SdlStubs.cpp so the benchmarks don't need SDL or a window. The input is scripted.
+#include <cstdint>
+#include <SDL_keyboard.h>
+#include <SDL_mouse.h>
+
+namespace SdlStubs
+{
+	void SetKey(SDL_Scancode key, bool isDown);
+	void SetMouse(uint32_t buttonMask, int relativeX, int relativeY);
+	//Every SDL_GetPerformanceCounter call advances the clock by one frame at this rate
+	void SetFrameRate(uint32_t framesPerSecond);
+}
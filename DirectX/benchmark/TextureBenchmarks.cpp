@@ -0,0 +1,735 @@
+// Texture pipeline: mip chain generation on synthetic 1k and 4k images (only 1k with --quick), block compression of
+// synthetic 1k chains and of the shipped AK-47 maps, cooking those to .tex files and loading them back.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+
+#include "BlockCompression.h"
+#include "MipChain.h"
+#include "PNG.h"
+#include "ResourceCache.h"
+#include "TextureFile.h"
+
+namespace
+{
+	struct TextureSize
+	{
+		const char* pName;
+		uint32_t side;
+	};
+
+	constexpr TextureSize textureSizes[]{ { "1k", 1024 }, { "4k", 4096 } };
+
+	//A smooth gradient under a one-texel checkerboard and some noise, the worst case for aliasing
+	std::vector<uint8_t> CreateColorImage(uint32_t side)
+	{
+		std::vector<uint8_t> pixels(size_t(side) * side * 4);
+		uint32_t noise{ 12345 };
+		for (uint32_t y{ 0 }; y < side; ++y)
+		{
+			for (uint32_t x{ 0 }; x < side; ++x)
+			{
+				noise = noise * 1664525u + 1013904223u;
+				const int checker = ((x ^ y) & 1) ? 40 : -40;
+				uint8_t* pTexel = &pixels[(size_t(y) * side + x) * 4];
+				pTexel[0] = uint8_t(std::clamp(int(x * 255 / side) + checker, 0, 255));
+				pTexel[1] = uint8_t(std::clamp(int(y * 255 / side) - checker, 0, 255));
+				pTexel[2] = uint8_t(noise >> 24);
+				pTexel[3] = uint8_t(255 - (x + y) * 255 / (2 * side));
+			}
+		}
+		return pixels;
+	}
+
+	//Bumps of random slope, encoded as a normal map would be
+	std::vector<uint8_t> CreateNormalImage(uint32_t side)
+	{
+		std::vector<uint8_t> pixels(size_t(side) * side * 4);
+		uint32_t noise{ 777 };
+		for (size_t texel{ 0 }; texel < size_t(side) * side; ++texel)
+		{
+			noise = noise * 1664525u + 1013904223u;
+			const float x = float(int(noise >> 24) - 128) / 160.f;
+			const float y = float(int((noise >> 16) & 0xFF) - 128) / 160.f;
+			const float invLength = 1.f / std::sqrt(x * x + y * y + 1.f);
+			const float nx = x * invLength, ny = y * invLength, nz = invLength;
+			pixels[texel * 4] = uint8_t((nx * 0.5f + 0.5f) * 255.f + 0.5f);
+			pixels[texel * 4 + 1] = uint8_t((ny * 0.5f + 0.5f) * 255.f + 0.5f);
+			pixels[texel * 4 + 2] = uint8_t((nz * 0.5f + 0.5f) * 255.f + 0.5f);
+			pixels[texel * 4 + 3] = 255;
+		}
+		return pixels;
+	}
+
+	float SRGBToLinear(float c)
+	{
+		return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSRGB(float c)
+	{
+		return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+	}
+
+	//The first rows of level 1 of a box-filtered color chain against the 2x2 averages in linear light, rounded straight
+	//from the formulas
+	bool MatchesBoxReference(const MipChain::Image& image, const std::vector<uint8_t>& pixels, uint32_t side)
+	{
+		const TextureLevel& level = image.levels[1];
+		const uint8_t* pLevel = image.GetPixels(1);
+		for (uint32_t y{ 0 }; y < std::min(level.height, 64u); ++y)
+		{
+			for (uint32_t x{ 0 }; x < level.width; ++x)
+			{
+				for (uint32_t channel{ 0 }; channel < 4; ++channel)
+				{
+					float sum{ 0.f };
+					for (uint32_t corner{ 0 }; corner < 4; ++corner)
+					{
+						const float value = pixels[((size_t(y) * 2 + corner / 2) * side + x * 2 + corner % 2) * 4 + channel] / 255.f;
+						sum += channel == 3 ? value : SRGBToLinear(value);
+					}
+					const float average = sum * 0.25f;
+					const int expected = int((channel == 3 ? average : LinearToSRGB(average)) * 255.f + 0.5f);
+					if (std::abs(int(pLevel[(size_t(y) * level.width + x) * 4 + channel]) - expected) > 1)
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	//Every level's size and place, down to 1x1
+	bool HasValidLevels(const MipChain::Image& image, uint32_t side)
+	{
+		if (image.levels.size() != MipChain::GetLevelCount(side, side))
+			return false;
+		size_t offset{ 0 };
+		for (size_t level{ 0 }; level < image.levels.size(); ++level)
+		{
+			const TextureLevel& mip = image.levels[level];
+			if (mip.width != std::max(side >> level, 1u) || mip.height != mip.width || mip.offset != offset)
+				return false;
+			offset += size_t(mip.width) * mip.height * 4;
+		}
+		return offset == image.pixels.size() && image.levels.back().width == 1;
+	}
+
+	struct CompressCase
+	{
+		const char* pName;
+		MipChain::Content content;
+		TextureFormat format;
+		BlockCompression::Quality quality;
+		float minimumPSNR;	//on the synthetic images, which are far noisier than real textures
+	};
+
+	constexpr CompressCase compressCases[]{
+		{ "texture.bc1", MipChain::Content::Color, TextureFormat::BC1, BlockCompression::Quality::Normal, 17.f },
+		{ "texture.bc7_fast", MipChain::Content::Color, TextureFormat::BC7, BlockCompression::Quality::Fast, 19.f },
+		{ "texture.bc7", MipChain::Content::Color, TextureFormat::BC7, BlockCompression::Quality::Normal, 19.f },
+		{ "texture.bc7_high", MipChain::Content::Color, TextureFormat::BC7, BlockCompression::Quality::High, 19.f },
+		{ "texture.bc5", MipChain::Content::Normal, TextureFormat::BC5, BlockCompression::Quality::Normal, 32.f },
+		{ "texture.bc4", MipChain::Content::Linear, TextureFormat::BC4, BlockCompression::Quality::Normal, 50.f }
+	};
+
+	//Flat blocks have to come back (nearly) exact in every format, whatever the endpoints snap to
+	bool RoundTripsFlatBlocks(TextureFormat format)
+	{
+		uint32_t noise{ 4242 };
+		for (int block{ 0 }; block < 256; ++block)
+		{
+			noise = noise * 1664525u + 1013904223u;
+			uint8_t texels[64];
+			for (uint32_t texel{ 0 }; texel < 16; ++texel)
+			{
+				for (uint32_t channel{ 0 }; channel < 4; ++channel)
+					texels[texel * 4 + channel] = uint8_t(noise >> (channel * 8));
+			}
+
+			uint8_t encoded[16]{};
+			switch (format)
+			{
+			case TextureFormat::BC1: BlockCompression::EncodeBC1(texels, BlockCompression::Quality::Normal, encoded); break;
+			case TextureFormat::BC4: BlockCompression::EncodeBC4(texels, 0, BlockCompression::Quality::Normal, encoded); break;
+			case TextureFormat::BC5: BlockCompression::EncodeBC5(texels, BlockCompression::Quality::Normal, encoded); break;
+			default: BlockCompression::EncodeBC7(texels, BlockCompression::Quality::Normal, encoded); break;
+			}
+			uint8_t decoded[64];
+			BlockCompression::DecodeBlock(format, encoded, decoded);
+
+			const uint32_t channelCount = format == TextureFormat::BC4 ? 1 : format == TextureFormat::BC5 ? 2 : format == TextureFormat::BC1 ? 3 : 4;
+			//BC1's single-color endpoints miss some values by one or two codes, the rest round once at most
+			const int tolerance = format == TextureFormat::BC1 ? 2 : 1;
+			for (uint32_t texel{ 0 }; texel < 16; ++texel)
+			{
+				for (uint32_t channel{ 0 }; channel < channelCount; ++channel)
+				{
+					if (std::abs(int(decoded[texel * 4 + channel]) - texels[texel * 4 + channel]) > tolerance)
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	void RunCompressionBenchmarks(Benchmark::Suite& suite)
+	{
+		constexpr uint32_t side{ 1024 };
+		const std::vector<uint8_t> colors = CreateColorImage(side);
+		const std::vector<uint8_t> normals = CreateNormalImage(side);
+
+		for (const CompressCase& compressCase : compressCases)
+		{
+			const std::string name = std::string{ compressCase.pName } + ".1k";
+			const std::string parallelName = std::string{ compressCase.pName } + "_mt.1k";
+			const bool isParallelCase = compressCase.format == TextureFormat::BC7 && compressCase.quality == BlockCompression::Quality::Normal;
+			if (!suite.IsEnabled(name) && !(isParallelCase && suite.IsEnabled(parallelName)))
+				continue;
+
+			MipChain::Settings mipSettings{};
+			mipSettings.content = compressCase.content;
+			MipChain::Image chain{};
+			MipChain::Generate((compressCase.content == MipChain::Content::Normal ? normals : colors).data(), side, side, side * 4, mipSettings, chain);
+
+			BlockCompression::Settings settings{ compressCase.format, compressCase.quality, 1 };
+			BlockCompression::Image image{};
+			if (suite.IsEnabled(name))
+			{
+				suite.Run(name, "texel", uint64_t(side) * side, chain.pixels.size(), [&]()
+					{
+						BlockCompression::Compress(chain.GetView(), settings, image);
+						Benchmark::DoNotOptimize(float(image.data.back()));
+					});
+			}
+
+			BlockCompression::CompressStats stats{};
+			BlockCompression::Compress(chain.GetView(), settings, image, &stats);
+			const float ratio = float(chain.pixels.size()) / float(image.data.size());
+			std::fprintf(stderr, "%s: %.2f dB, %.1fx smaller than RGBA8\n", name.c_str(), stats.psnr, ratio);
+			//4x or 8x, less a little for the 2x2 and 1x1 levels that still take a whole block
+			if (image.format != compressCase.format || image.levels.size() != chain.levels.size() || ratio < 3.9f)
+				suite.Fail(name + " didn't compress every level to " + GetTextureFormatName(compressCase.format));
+			if (stats.psnr < compressCase.minimumPSNR)
+				suite.Fail(name + " only reaches " + std::to_string(stats.psnr) + " dB");
+			if (!RoundTripsFlatBlocks(compressCase.format))
+				suite.Fail(name + " doesn't reproduce flat blocks");
+
+			if (isParallelCase && suite.IsEnabled(parallelName))
+			{
+				BlockCompression::Settings parallelSettings{ compressCase.format, compressCase.quality, 0 };
+				BlockCompression::Image parallelImage{};
+				suite.Run(parallelName, "texel", uint64_t(side) * side, chain.pixels.size(), [&]()
+					{
+						BlockCompression::Compress(chain.GetView(), parallelSettings, parallelImage);
+						Benchmark::DoNotOptimize(float(parallelImage.data.back()));
+					});
+				parallelSettings.threadCount = 3;
+				BlockCompression::Compress(chain.GetView(), parallelSettings, parallelImage);
+				if (parallelImage.data != image.data)
+					suite.Fail("the multithreaded and single-threaded " + name + " blocks differ");
+			}
+		}
+	}
+
+	//The four maps the renderer loads
+	struct Map
+	{
+		const char* pFile;
+		MipChain::Content content;
+		float minimumPSNR;
+	};
+
+	constexpr Map maps[]{
+		{ "ak47_default.png", MipChain::Content::Color, 45.f },
+		{ "ak47_default_normal.png", MipChain::Content::Normal, 40.f },
+		{ "ak47_default_specular.png", MipChain::Content::Linear, 40.f },
+		{ "ak47_default_gloss.png", MipChain::Content::Linear, 40.f }
+	};
+
+	//Each map in the format BlockCompression::ChooseFormat gives its role
+	void RunAK47CompressionBenchmark(Benchmark::Suite& suite)
+	{
+		const std::string name{ "texture.compress.ak47" };
+		if (!suite.IsEnabled(name))
+			return;
+
+		std::vector<MipChain::Image> chains(std::size(maps));
+		uint64_t rgbaBytes{ 0 };
+		for (size_t map{ 0 }; map < std::size(maps); ++map)
+		{
+			const std::filesystem::path path = std::filesystem::path{ BENCHMARK_RESOURCES_DIR } / maps[map].pFile;
+			std::error_code error{};
+			if (!std::filesystem::exists(path, error))
+			{
+				std::fprintf(stderr, "%s not found, skipping\n", path.string().c_str());
+				return;
+			}
+			std::vector<uint8_t> pixels{};
+			uint32_t width{}, height{};
+			if (!PNG::Load(path.string(), pixels, width, height))
+			{
+				suite.Fail("could not decode " + path.string());
+				return;
+			}
+			MipChain::Settings mipSettings{};
+			mipSettings.content = maps[map].content;
+			MipChain::Generate(pixels.data(), width, height, width * 4, mipSettings, chains[map]);
+			rgbaBytes += chains[map].pixels.size();
+		}
+
+		std::vector<BlockCompression::Image> images(std::size(maps));
+		const auto compressAll = [&](std::vector<BlockCompression::CompressStats>* pStats)
+			{
+				for (size_t map{ 0 }; map < std::size(maps); ++map)
+				{
+					BlockCompression::Settings settings{};
+					settings.format = BlockCompression::ChooseFormat(maps[map].content, settings.quality);
+					BlockCompression::Compress(chains[map].GetView(), settings, images[map], pStats ? &(*pStats)[map] : nullptr);
+				}
+			};
+		suite.Run(name, "texture", std::size(maps), rgbaBytes, [&]()
+			{
+				compressAll(nullptr);
+				Benchmark::DoNotOptimize(float(images.back().data.back()));
+			});
+
+		std::vector<BlockCompression::CompressStats> stats(std::size(maps));
+		compressAll(&stats);
+		uint64_t compressedBytes{ 0 };
+		for (size_t map{ 0 }; map < std::size(maps); ++map)
+		{
+			const TextureLevel& top = images[map].levels[0];
+			std::fprintf(stderr, "%s: %s %ux%u, %zu levels, %.2f MB -> %.2f MB, %.2f dB, %.0f ms\n", maps[map].pFile, GetTextureFormatName(images[map].format), top.width, top.height,
+				images[map].levels.size(), chains[map].pixels.size() / 1e6, images[map].data.size() / 1e6, stats[map].psnr, stats[map].seconds * 1e3);
+			if (stats[map].psnr < maps[map].minimumPSNR)
+				suite.Fail(std::string{ maps[map].pFile } + " only reaches " + std::to_string(stats[map].psnr) + " dB");
+			compressedBytes += images[map].data.size();
+		}
+		std::fprintf(stderr, "ak47 maps: %.2f MB -> %.2f MB (%.1fx)\n", rgbaBytes / 1e6, compressedBytes / 1e6, double(rgbaBytes) / compressedBytes);
+		if (compressedBytes * 4 > rgbaBytes)
+			suite.Fail("the compressed AK-47 maps are less than 4x smaller than RGBA8");
+	}
+
+	//Startup cost of the maps: decoding the PNGs and building their levels against mapping the cooked .tex files and
+	//reading their levels as the upload does
+	void RunCookedTextureBenchmarks(Benchmark::Suite& suite)
+	{
+		const std::string cookName{ "texture.cook.ak47" };
+		const std::string decodeName{ "texture.load_png.ak47" };
+		const std::string mapName{ "texture.load_cooked.ak47" };
+		if (!suite.IsEnabled(cookName) && !suite.IsEnabled(decodeName) && !suite.IsEnabled(mapName))
+			return;
+
+		std::error_code error{};
+		const std::filesystem::path directory = std::filesystem::temp_directory_path(error) / "directx_benchmark";
+		std::filesystem::create_directories(directory, error);
+
+		std::vector<std::string> sourcePaths{}, cookedPaths{};
+		uint64_t sourceBytes{ 0 };
+		for (const Map& map : maps)
+		{
+			const std::filesystem::path path = std::filesystem::path{ BENCHMARK_RESOURCES_DIR } / map.pFile;
+			if (!std::filesystem::exists(path, error))
+			{
+				std::fprintf(stderr, "%s not found, skipping\n", path.string().c_str());
+				return;
+			}
+			sourcePaths.push_back(path.string());
+			cookedPaths.push_back(TextureFile::GetCookedPath((directory / map.pFile).string()));
+			sourceBytes += std::filesystem::file_size(path, error);
+		}
+
+		const auto getCookSettings = [](const Map& map)
+			{
+				TextureFile::CookSettings settings{};
+				settings.content = map.content;
+				return settings;
+			};
+		const auto cookAll = [&](std::vector<TextureFile::CookStats>* pStats)
+			{
+				bool isCooked{ true };
+				for (size_t map{ 0 }; map < std::size(maps); ++map)
+					isCooked &= TextureFile::Cook(sourcePaths[map], cookedPaths[map], getCookSettings(maps[map]), pStats ? &(*pStats)[map] : nullptr);
+				return isCooked;
+			};
+		if (suite.IsEnabled(cookName))
+		{
+			suite.Run(cookName, "texture", std::size(maps), sourceBytes, [&]()
+				{
+					cookAll(nullptr);
+					Benchmark::DoNotOptimize(0.f);
+				});
+		}
+		std::vector<TextureFile::CookStats> stats(std::size(maps));
+		if (!cookAll(&stats))
+		{
+			suite.Fail("could not cook the AK-47 maps to " + directory.string());
+			return;
+		}
+
+		uint64_t cookedBytes{ 0 };
+		for (size_t map{ 0 }; map < std::size(maps); ++map)
+		{
+			const uint64_t fileBytes = std::filesystem::file_size(cookedPaths[map], error);
+			std::fprintf(stderr, "%s: %.2f MB PNG -> %.2f MB .tex (%s, %zu levels) in %.0f ms\n", maps[map].pFile, stats[map].sourceBytes / 1e6, fileBytes / 1e6,
+				GetTextureFormatName(stats[map].format), stats[map].levelCount, stats[map].seconds * 1e3);
+			cookedBytes += fileBytes;
+
+			const CookedTexture cooked{ cookedPaths[map] };
+			if (!cooked.IsValid() || cooked.GetView().format != stats[map].format || cooked.GetView().levels.size() != stats[map].levelCount
+				|| cooked.GetView().levels[0].offset % TextureFile::blobAlignment != 0)
+				suite.Fail(cookedPaths[map] + " doesn't map back to the levels it was cooked with");
+			if (!TextureFile::IsUpToDate(sourcePaths[map], cookedPaths[map], getCookSettings(maps[map])))
+				suite.Fail(cookedPaths[map] + " counts as stale right after cooking");
+		}
+
+		//What startup did before: decode and filter every map (compressing them came on top)
+		if (suite.IsEnabled(decodeName))
+		{
+			std::vector<uint8_t> pixels{};
+			MipChain::Image chain{};
+			suite.Run(decodeName, "texture", std::size(maps), sourceBytes, [&]()
+				{
+					for (size_t map{ 0 }; map < std::size(maps); ++map)
+					{
+						uint32_t width{}, height{};
+						PNG::Load(sourcePaths[map], pixels, width, height);
+						MipChain::Generate(pixels.data(), width, height, width * 4, { maps[map].content }, chain);
+					}
+					Benchmark::DoNotOptimize(float(chain.pixels.back()));
+				});
+		}
+
+		//Mapping, validating and reading every level once, as CreateTexture2D copies them
+		if (suite.IsEnabled(mapName))
+		{
+			suite.Run(mapName, "texture", std::size(maps), cookedBytes, [&]()
+				{
+					uint64_t hash{ 0 };
+					for (const std::string& cookedPath : cookedPaths)
+					{
+						const CookedTexture cooked{ cookedPath };
+						const TextureView& view = cooked.GetView();
+						for (size_t level{ 0 }; level < view.levels.size(); ++level)
+							hash ^= HashContent({ view.GetLevelData(level), size_t(view.GetLevelSize(level)) });
+					}
+					Benchmark::DoNotOptimize(float(hash & 0xFFFF));
+				});
+		}
+
+		//The cache goes by content: rewriting the same bytes keeps the cooked file, one changed byte or other settings don't
+		const std::filesystem::path copyPath = directory / "cache_check.png";
+		const std::string copyCookedPath = TextureFile::GetCookedPath(copyPath.string());
+		std::filesystem::copy_file(sourcePaths.back(), copyPath, std::filesystem::copy_options::overwrite_existing, error);
+		const TextureFile::CookSettings copySettings = getCookSettings(maps[std::size(maps) - 1]);
+		if (error || !TextureFile::Cook(copyPath.string(), copyCookedPath, copySettings))
+		{
+			suite.Fail("could not cook a copy of " + sourcePaths.back());
+			return;
+		}
+		std::filesystem::copy_file(sourcePaths.back(), copyPath, std::filesystem::copy_options::overwrite_existing, error);
+		const bool keepsSameContent = TextureFile::IsUpToDate(copyPath.string(), copyCookedPath, copySettings);
+		TextureFile::CookSettings otherSettings = copySettings;
+		otherSettings.quality = BlockCompression::Quality::High;
+		const bool dropsOtherSettings = !TextureFile::IsUpToDate(copyPath.string(), copyCookedPath, otherSettings);
+		{
+			std::fstream file{ copyPath, std::ios::binary | std::ios::in | std::ios::out };
+			file.seekg(1000);
+			const char original = static_cast<char>(file.get());
+			file.seekp(1000);
+			file.put(static_cast<char>(~original));
+		}
+		const bool dropsChangedContent = !TextureFile::IsUpToDate(copyPath.string(), copyCookedPath, copySettings);
+		if (!keepsSameContent || !dropsOtherSettings || !dropsChangedContent)
+			suite.Fail("the .tex cache doesn't follow the source content and settings");
+
+		std::filesystem::resize_file(copyCookedPath, std::filesystem::file_size(copyCookedPath, error) - 1, error);
+		if (CookedTexture{ copyCookedPath }.IsValid())
+			suite.Fail("a truncated .tex maps as valid");
+		std::filesystem::remove(copyPath, error);
+		std::filesystem::remove(copyCookedPath, error);
+	}
+
+	//Specular and gloss packed into one texture as the renderer loads them. The AK-47 ships both as the same texels, so
+	//they have to end up in one BC4 channel; two different channels (the normal map's x and y) have to come out as BC5.
+	void RunPackedTextureBenchmark(Benchmark::Suite& suite)
+	{
+		const std::string name{ "texture.pack.ak47" };
+		if (!suite.IsEnabled(name))
+			return;
+
+		const std::filesystem::path resources{ BENCHMARK_RESOURCES_DIR };
+		const TextureFile::ChannelSource surfaceChannels[]{ { (resources / "ak47_default_specular.png").string(), 0 }, { (resources / "ak47_default_gloss.png").string(), 0 } };
+		const TextureFile::ChannelSource normalChannels[]{ { (resources / "ak47_default_normal.png").string(), 0 }, { (resources / "ak47_default_normal.png").string(), 1 } };
+		std::error_code error{};
+		for (const TextureFile::ChannelSource& source : { surfaceChannels[0], surfaceChannels[1], normalChannels[0] })
+		{
+			if (!std::filesystem::exists(source.path, error))
+			{
+				std::fprintf(stderr, "%s not found, skipping\n", source.path.c_str());
+				return;
+			}
+		}
+
+		TextureFile::CookSettings settings{};
+		settings.content = MipChain::Content::Linear;
+		BlockCompression::Image image{};
+		TextureFile::ChannelMap sourceChannels{};
+		uint64_t sourceBytes{ 0 };
+		for (const TextureFile::ChannelSource& source : surfaceChannels)
+			sourceBytes += std::filesystem::file_size(source.path, error);
+		suite.Run(name, "texture", 1, sourceBytes, [&]()
+			{
+				TextureFile::BuildPacked(surfaceChannels, settings, image, sourceChannels);
+				Benchmark::DoNotOptimize(float(image.data.back()));
+			});
+
+		TextureFile::CookStats stats{};
+		if (!TextureFile::BuildPacked(surfaceChannels, settings, image, sourceChannels, &stats))
+		{
+			suite.Fail("could not pack the AK-47's specular and gloss maps");
+			return;
+		}
+		//Loaded one by one they were two BC4 textures of the same size
+		std::fprintf(stderr, "specular + gloss: %s, channels %u and %u, %.2f MB instead of %.2f MB, %.2f dB, %.0f ms\n", GetTextureFormatName(image.format), sourceChannels[0],
+			sourceChannels[1], image.data.size() / 1e6, 2 * image.data.size() / 1e6, stats.compress.psnr, stats.seconds * 1e3);
+		if (image.format != TextureFormat::BC4 || sourceChannels[0] != 0 || sourceChannels[1] != 0)
+			suite.Fail("the AK-47's identical specular and gloss maps aren't stored once");
+		if (stats.compress.psnr < 40.f)
+			suite.Fail("the packed specular map only reaches " + std::to_string(stats.compress.psnr) + " dB");
+
+		TextureFile::ChannelMap normalSourceChannels{};
+		if (!TextureFile::BuildPacked(normalChannels, settings, image, normalSourceChannels, &stats) || image.format != TextureFormat::BC5 || normalSourceChannels[0] != 0
+			|| normalSourceChannels[1] != 1 || stats.compress.psnr < 40.f)
+			suite.Fail("two different channels don't pack into the two channels of a BC5 texture");
+
+		//The channel map survives cooking, and the cache notices a different packing of the same files
+		const std::string cookedPath = (std::filesystem::temp_directory_path(error) / "directx_benchmark" / "ak47_default_surface.tex").string();
+		std::filesystem::create_directories(std::filesystem::path{ cookedPath }.parent_path(), error);
+		if (!TextureFile::CookPacked(surfaceChannels, cookedPath, settings))
+		{
+			suite.Fail("could not cook the packed specular and gloss maps to " + cookedPath);
+			return;
+		}
+		const CookedTexture cooked{ cookedPath };
+		if (!cooked.IsValid() || cooked.GetView().format != TextureFormat::BC4 || cooked.GetSourceChannels() != sourceChannels)
+			suite.Fail(cookedPath + " doesn't map back to the channels it was packed with");
+		const TextureFile::ChannelSource swappedChannels[]{ surfaceChannels[1], surfaceChannels[0] };
+		if (!TextureFile::IsUpToDate(surfaceChannels, cookedPath, settings) || TextureFile::IsUpToDate(swappedChannels, cookedPath, settings)
+			|| TextureFile::IsUpToDate(std::span{ surfaceChannels, 1 }, cookedPath, settings))
+			suite.Fail("the packed .tex cache doesn't follow which channels it was packed from");
+		std::filesystem::remove(cookedPath, error);
+	}
+
+	//Stands in for a GPU texture: only its size and when it is destroyed matter to the cache
+	struct CacheEntry
+	{
+		uint64_t bytes{};
+		size_t* pDestroyedCount{};
+
+		~CacheEntry() { ++*pDestroyedCount; }
+		uint64_t GetSizeInBytes() const { return bytes; }
+	};
+
+	//Many meshes sharing one material through ResourceCache as TextureCache uses it: the time is one Acquire hit per
+	//texture, path normalization included. Checks sharing, the counters, LRU eviction under the budget and that every
+	//resource is destroyed exactly once.
+	void RunTextureCacheBenchmark(Benchmark::Suite& suite)
+	{
+		const std::string name{ "texture.cache.acquire" };
+		if (!suite.IsEnabled(name))
+			return;
+
+		constexpr uint64_t megabyte{ 1ull << 20 };
+		const std::string materialPaths[]{ "Resources/ak47_default.png", "Resources/ak47_default_normal.png", "Resources/ak47_default_surface.tex" };
+		constexpr size_t meshCount{ 64 };
+		size_t destroyedCount{ 0 };
+		size_t loadCount{ 0 };
+		{
+			ResourceCache<CacheEntry> cache{ 16 * megabyte };
+			const auto acquire = [&](const std::string& path, uint64_t bytes)
+				{
+					return cache.Acquire(NormalizeResourcePath(path), [&]()
+						{
+							++loadCount;
+							return std::make_unique<CacheEntry>(bytes, &destroyedCount);
+						});
+				};
+
+			std::vector<ResourceCache<CacheEntry>::Handle> handles{};
+			handles.reserve(meshCount * std::size(materialPaths));
+			suite.Run(name, "acquire", meshCount * std::size(materialPaths), 0, [&]()
+				{
+					handles.clear();
+					for (size_t mesh{ 0 }; mesh < meshCount; ++mesh)
+					{
+						for (const std::string& path : materialPaths)
+							handles.push_back(acquire(path, 4 * megabyte));
+					}
+					Benchmark::DoNotOptimize(float(handles.back()->bytes));
+				});
+
+			//However the path is spelled, every mesh shares the one texture
+			const ResourceCache<CacheEntry>::Handle respelled = acquire("Resources/./textures/../ak47_default.png", 4 * megabyte);
+			if (loadCount != std::size(materialPaths) || respelled != handles[0] || handles[3] != handles[0] || cache.GetStats().residentCount != std::size(materialPaths)
+				|| cache.GetStats().residentBytes != 12 * megabyte || cache.GetStats().misses != std::size(materialPaths))
+				suite.Fail("meshes sharing a material don't share its textures");
+			std::fprintf(stderr, "%zu meshes x %zu textures: %zu loads, %llu hits, %.0f MB resident\n", meshCount, std::size(materialPaths), loadCount,
+				static_cast<unsigned long long>(cache.GetStats().hits), cache.GetStats().residentBytes / double(megabyte));
+
+			//Released textures stay resident under the budget, the least recently released go first over it
+			handles.clear();
+			const ResourceCache<CacheEntry>::Handle diffuse = acquire(materialPaths[0], 4 * megabyte);
+			if (cache.GetStats().residentCount != std::size(materialPaths) || cache.GetStats().referencedCount != 1 || destroyedCount != 0)
+				suite.Fail("the cache drops textures no mesh uses while under its budget");
+			{
+				const ResourceCache<CacheEntry>::Handle normal = acquire(materialPaths[1], 4 * megabyte);
+			}
+			const ResourceCache<CacheEntry>::Handle large = acquire("Resources/large.png", 8 * megabyte);
+			const std::string normalKey = NormalizeResourcePath(materialPaths[1]);
+			const std::string surfaceKey = NormalizeResourcePath(materialPaths[2]);
+			if (cache.IsResident(surfaceKey) || !cache.IsResident(normalKey) || cache.GetStats().evictions != 1 || destroyedCount != 1)
+				suite.Fail("going over the budget doesn't evict the least recently released texture");
+
+			//Referenced textures stay whatever the budget; failed loads aren't cached
+			cache.SetBudget(0);
+			if (cache.GetStats().residentCount != 2 || cache.GetStats().residentBytes != 12 * megabyte || destroyedCount != 2)
+				suite.Fail("a zero budget evicts textures still in use or keeps unused ones");
+			const uint64_t missCount = cache.GetStats().misses;
+			for (int attempt{ 0 }; attempt < 2; ++attempt)
+				cache.Acquire("missing.png", []() { return std::unique_ptr<CacheEntry>{}; });
+			if (cache.GetStats().misses != missCount + 2 || cache.IsResident("missing.png"))
+				suite.Fail("a failed load is cached");
+		}
+		if (destroyedCount != loadCount)
+			suite.Fail(std::to_string(loadCount) + " textures loaded but " + std::to_string(destroyedCount) + " destroyed");
+	}
+}
+
+namespace Benchmark
+{
+	void RunTextureBenchmarks(Suite& suite)
+	{
+		for (const TextureSize& size : textureSizes)
+		{
+			if (suite.GetOptions().quick && size.side > 1024)
+				break;
+
+			const std::string boxName = std::string{ "texture.mips." } + size.pName;
+			const std::string parallelName = std::string{ "texture.mips_mt." } + size.pName;
+			const std::string kaiserName = std::string{ "texture.mips_kaiser." } + size.pName;
+			const std::string normalName = std::string{ "texture.mips_normal." } + size.pName;
+			if (!suite.IsEnabled(boxName) && !suite.IsEnabled(parallelName) && !suite.IsEnabled(kaiserName) && !suite.IsEnabled(normalName))
+				continue;
+
+			const uint32_t side = size.side;
+			const uint64_t texels = uint64_t(side) * side;
+			const std::vector<uint8_t> pixels = CreateColorImage(side);
+
+			//Single-threaded box filter, the reference for the rest
+			MipChain::Settings settings{};
+			settings.threadCount = 1;
+			MipChain::Image image{};
+			const auto generate = [&]() { MipChain::Generate(pixels.data(), side, side, side * 4, settings, image); };
+			if (suite.IsEnabled(boxName))
+			{
+				suite.Run(boxName, "texel", texels, pixels.size(), [&]()
+					{
+						generate();
+						DoNotOptimize(image.pixels.back());
+					});
+			}
+			else
+			{
+				generate();
+			}
+			if (!HasValidLevels(image, side) || !MatchesBoxReference(image, pixels, side))
+				suite.Fail("the box-filtered mips of the " + std::string{ size.pName } + " image are wrong or not gamma-correct");
+
+			if (suite.IsEnabled(parallelName))
+			{
+				MipChain::Settings parallelSettings{};
+				MipChain::Image parallelImage{};
+				suite.Run(parallelName, "texel", texels, pixels.size(), [&]()
+					{
+						MipChain::Generate(pixels.data(), side, side, side * 4, parallelSettings, parallelImage);
+						DoNotOptimize(parallelImage.pixels.back());
+					});
+				parallelSettings.threadCount = 3;
+				MipChain::Generate(pixels.data(), side, side, side * 4, parallelSettings, parallelImage);
+				if (parallelImage.pixels != image.pixels)
+					suite.Fail("the multithreaded and single-threaded mips of the " + std::string{ size.pName } + " image differ");
+			}
+
+			if (suite.IsEnabled(kaiserName))
+			{
+				MipChain::Settings kaiserSettings{};
+				kaiserSettings.filter = MipChain::Filter::Kaiser;
+				kaiserSettings.threadCount = 1;
+				MipChain::Image kaiserImage{};
+				suite.Run(kaiserName, "texel", texels, pixels.size(), [&]()
+					{
+						MipChain::Generate(pixels.data(), side, side, side * 4, kaiserSettings, kaiserImage);
+						DoNotOptimize(kaiserImage.pixels.back());
+					});
+
+				//The weights have to add up to one: a flat image stays flat down to 1x1
+				const std::vector<uint8_t> flat(pixels.size(), 200);
+				MipChain::Generate(flat.data(), side, side, side * 4, kaiserSettings, kaiserImage);
+				if (!HasValidLevels(kaiserImage, side) || std::any_of(kaiserImage.pixels.begin(), kaiserImage.pixels.end(), [](uint8_t value) { return value != 200; }))
+					suite.Fail("the Kaiser-filtered mips of a flat " + std::string{ size.pName } + " image aren't flat");
+			}
+
+			//A black and white checkerboard has to average to half the light, sRGB 187 or 188, not to code 128
+			std::vector<uint8_t> checker(pixels.size());
+			for (size_t texel{ 0 }; texel < texels; ++texel)
+			{
+				const uint8_t value = ((texel % side) ^ (texel / side)) & 1 ? 255 : 0;
+				std::fill_n(checker.begin() + texel * 4, 3, value);
+				checker[texel * 4 + 3] = 255;
+			}
+			MipChain::Generate(checker.data(), side, side, side * 4, settings, image);
+			if (image.GetPixels(1)[0] < 187 || image.GetPixels(1)[0] > 188)
+				suite.Fail("a black and white checkerboard mips to " + std::to_string(image.GetPixels(1)[0]) + " instead of 187/188");
+
+			//Normal maps: every texel on every level has to decode to a unit vector again
+			if (suite.IsEnabled(normalName))
+			{
+				const std::vector<uint8_t> normals = CreateNormalImage(side);
+				MipChain::Settings normalSettings{};
+				normalSettings.content = MipChain::Content::Normal;
+				MipChain::Image normalImage{};
+				suite.Run(normalName, "texel", texels, normals.size(), [&]()
+					{
+						MipChain::Generate(normals.data(), side, side, side * 4, normalSettings, normalImage);
+						DoNotOptimize(normalImage.pixels.back());
+					});
+
+				float maxError{ 0.f };
+				for (size_t texel{ 0 }; texel < normalImage.pixels.size() / 4; ++texel)
+				{
+					const uint8_t* pTexel = &normalImage.pixels[texel * 4];
+					const float x = pTexel[0] * (2.f / 255.f) - 1.f, y = pTexel[1] * (2.f / 255.f) - 1.f, z = pTexel[2] * (2.f / 255.f) - 1.f;
+					maxError = std::max(maxError, std::abs(std::sqrt(x * x + y * y + z * z) - 1.f));
+				}
+				if (maxError > 0.02f)
+					suite.Fail("the normal map mips of the " + std::string{ size.pName } + " image aren't unit length (off by " + std::to_string(maxError) + ")");
+				std::fprintf(stderr, "%s normal map: %zu levels, largest length error %.4f\n", size.pName, normalImage.levels.size(), maxError);
+			}
+		}
+
+		RunCompressionBenchmarks(suite);
+		RunAK47CompressionBenchmark(suite);
+		RunCookedTextureBenchmarks(suite);
+		RunPackedTextureBenchmark(suite);
+		RunTextureCacheBenchmark(suite);
+	}
+}
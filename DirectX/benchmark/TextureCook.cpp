@@ -0,0 +1,168 @@
+// Offline cooker for the .tex files Texture maps at startup: PNG -> mip chain -> block compression, written next to
+// each image. Files already cooked from the same bytes and settings are skipped.
+//
+//   TextureCook [--content color|linear|normal] [--filter box|kaiser] [--quality fast|normal|high] [--threads <n>]
+//               [--force] [--pack <packed.tex>] <image.png[:r|g|b|a]>...
+//
+// Without --content, names ending in _normal are cooked as normal maps and names ending in _specular or _gloss as data
+// maps, the roles Mesh loads the AK-47's maps with; anything else is color. --pack packs one channel of each image (red
+// unless named) into a single data texture instead, the way Mesh loads the specular and gloss maps:
+//
+//   TextureCook --pack ak47_default_surface.tex ak47_default_specular.png ak47_default_gloss.png
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "TextureFile.h"
+
+namespace
+{
+	bool EndsWith(const std::string& text, const std::string& suffix)
+	{
+		return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+
+	MipChain::Content GuessContent(const std::string& path)
+	{
+		const std::string stem = std::filesystem::path{ path }.stem().string();
+		if (EndsWith(stem, "_normal"))
+			return MipChain::Content::Normal;
+		if (EndsWith(stem, "_specular") || EndsWith(stem, "_gloss"))
+			return MipChain::Content::Linear;
+		return MipChain::Content::Color;
+	}
+
+	//image.png:g -> green of image.png, red without a suffix
+	std::optional<TextureFile::ChannelSource> ParseChannel(const std::string& argument)
+	{
+		static constexpr char channelNames[]{ "rgba" };
+		const size_t colon = argument.rfind(':');
+		if (colon == std::string::npos || colon + 2 != argument.size())
+			return TextureFile::ChannelSource{ argument, 0 };
+		const char* const pName = std::strchr(channelNames, argument.back());
+		if (!pName)
+			return std::nullopt;
+		return TextureFile::ChannelSource{ argument.substr(0, colon), static_cast<uint32_t>(pName - channelNames) };
+	}
+
+	void PrintUsage()
+	{
+		std::fprintf(stderr, "Usage: TextureCook [--content color|linear|normal] [--filter box|kaiser] [--quality fast|normal|high] [--threads <n>] [--force] [--pack <packed.tex>] <image.png[:r|g|b|a]>...\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	TextureFile::CookSettings settings{};
+	std::optional<MipChain::Content> content{};
+	bool force{ false };
+	std::string packedPath{};
+	std::vector<std::string> paths{};
+
+	for (int i{ 1 }; i < argc; ++i)
+	{
+		const std::string argument{ argv[i] };
+		const std::string value = i + 1 < argc ? argv[i + 1] : "";
+
+		if (argument == "--content" && (value == "color" || value == "linear" || value == "normal"))
+		{
+			content = value == "color" ? MipChain::Content::Color : value == "linear" ? MipChain::Content::Linear : MipChain::Content::Normal;
+			++i;
+		}
+		else if (argument == "--filter" && (value == "box" || value == "kaiser"))
+		{
+			settings.filter = value == "box" ? MipChain::Filter::Box : MipChain::Filter::Kaiser;
+			++i;
+		}
+		else if (argument == "--quality" && (value == "fast" || value == "normal" || value == "high"))
+		{
+			settings.quality = value == "fast" ? BlockCompression::Quality::Fast : value == "normal" ? BlockCompression::Quality::Normal : BlockCompression::Quality::High;
+			++i;
+		}
+		else if (argument == "--threads" && !value.empty())
+		{
+			settings.threadCount = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+			++i;
+		}
+		else if (argument == "--force")
+			force = true;
+		else if (argument == "--pack" && !value.empty())
+		{
+			packedPath = value;
+			++i;
+		}
+		else if (!argument.empty() && argument[0] != '-')
+			paths.push_back(argument);
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (paths.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (!packedPath.empty())
+	{
+		std::vector<TextureFile::ChannelSource> channels{};
+		for (const std::string& path : paths)
+		{
+			const std::optional<TextureFile::ChannelSource> channel = ParseChannel(path);
+			if (!channel || channels.size() == 4)
+			{
+				PrintUsage();
+				return 1;
+			}
+			channels.push_back(*channel);
+		}
+		settings.content = content.value_or(MipChain::Content::Linear);
+		if (!force && TextureFile::IsUpToDate(channels, packedPath, settings))
+		{
+			std::printf("%s: up to date\n", packedPath.c_str());
+			return 0;
+		}
+
+		TextureFile::CookStats stats{};
+		if (!TextureFile::CookPacked(channels, packedPath, settings, &stats))
+		{
+			std::fprintf(stderr, "%s: could not pack (8-bit non-interlaced PNGs of the same size only)\n", packedPath.c_str());
+			return 1;
+		}
+		const CookedTexture packed{ packedPath };
+		std::printf("%s: %s %ux%u, %zu levels, %zu sources in %zu channels, %.2f MB, PSNR %.2f dB, %.0f ms\n", packedPath.c_str(), GetTextureFormatName(stats.format), stats.width,
+			stats.height, stats.levelCount, channels.size(), size_t(*std::max_element(packed.GetSourceChannels().begin(), packed.GetSourceChannels().begin() + channels.size())) + 1,
+			stats.cookedBytes / 1e6, stats.compress.psnr, stats.seconds * 1e3);
+		return 0;
+	}
+
+	int failureCount{ 0 };
+	for (const std::string& path : paths)
+	{
+		settings.content = content.value_or(GuessContent(path));
+		const std::string cookedPath = TextureFile::GetCookedPath(path);
+		if (!force && TextureFile::IsUpToDate(path, cookedPath, settings))
+		{
+			std::printf("%s: up to date\n", cookedPath.c_str());
+			continue;
+		}
+
+		TextureFile::CookStats stats{};
+		if (!TextureFile::Cook(path, cookedPath, settings, &stats))
+		{
+			std::fprintf(stderr, "%s: could not cook (8-bit non-interlaced PNGs only)\n", path.c_str());
+			++failureCount;
+			continue;
+		}
+		std::printf("%s: %s %ux%u, %zu levels, %.2f MB -> %.2f MB, PSNR %.2f dB, %.0f ms\n", cookedPath.c_str(), GetTextureFormatName(stats.format), stats.width,
+			stats.height, stats.levelCount, stats.uncompressedBytes / 1e6, stats.cookedBytes / 1e6, stats.compress.psnr, stats.seconds * 1e3);
+	}
+	return failureCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <cassert>
+#include <type_traits>
+
+#include "MathHelpers.h"
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+
+//3x4 affine transform, same row-vector layout as Matrix with the constant (0, 0, 0, 1) last column left out.
+//Composing two of these skips the multiplies against that column, and rigid transforms (rotation + translation)
+//invert with a transpose and one back-transformed translation instead of a general 4x4 inverse.
+struct AffineTransform
+{
+	Vector3 axisX{ Vector3::UnitX };
+	Vector3 axisY{ Vector3::UnitY };
+	Vector3 axisZ{ Vector3::UnitZ };
+	Vector3 translation{};
+
+	constexpr AffineTransform() noexcept = default;
+	constexpr AffineTransform(const Vector3& xAxis, const Vector3& yAxis, const Vector3& zAxis, const Vector3& t) noexcept :
+		axisX{ xAxis }, axisY{ yAxis }, axisZ{ zAxis }, translation{ t }
+	{
+	}
+
+	//Drops the last column, which has to be (0, 0, 0, 1)
+	explicit constexpr AffineTransform(const Matrix& m) noexcept :
+		axisX{ m.GetAxisX() }, axisY{ m.GetAxisY() }, axisZ{ m.GetAxisZ() }, translation{ m.GetTranslation() }
+	{
+		assert(m[0][3] == 0.f && m[1][3] == 0.f && m[2][3] == 0.f && m[3][3] == 1.f && "Matrix is not affine");
+	}
+
+	//Scale, then rotate, then translate (the Scale * Rotation * Translation world matrix) without any matrix multiply
+	static constexpr AffineTransform Create(const Vector3& scale, const Quaternion& rotation, const Vector3& position) noexcept
+	{
+		const Matrix r = rotation.ToMatrix();
+		return { r.GetAxisX() * scale.x, r.GetAxisY() * scale.y, r.GetAxisZ() * scale.z, position };
+	}
+
+	static constexpr AffineTransform CreateTranslation(const Vector3& t) noexcept
+	{
+		return { Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, t };
+	}
+
+	static constexpr AffineTransform CreateScale(const Vector3& s) noexcept
+	{
+		return { Vector3::UnitX * s.x, Vector3::UnitY * s.y, Vector3::UnitZ * s.z, Vector3::Zero };
+	}
+
+	constexpr Matrix ToMatrix() const noexcept
+	{
+		return { axisX, axisY, axisZ, translation };
+	}
+
+	constexpr Vector3 TransformVector(const Vector3& v) const noexcept
+	{
+		return axisX * v.x + axisY * v.y + axisZ * v.z;
+	}
+
+	constexpr Vector3 TransformPoint(const Vector3& p) const noexcept
+	{
+		return TransformVector(p) + translation;
+	}
+
+	//Only valid for rotation + translation: the inverse rotation is the transpose
+	constexpr AffineTransform InverseRigid() const noexcept
+	{
+		const AffineTransform inverse{
+			{ axisX.x, axisY.x, axisZ.x },
+			{ axisX.y, axisY.y, axisZ.y },
+			{ axisX.z, axisY.z, axisZ.z },
+			Vector3::Zero };
+
+		return { inverse.axisX, inverse.axisY, inverse.axisZ, -inverse.TransformVector(translation) };
+	}
+
+	//Any invertible 3x3 part (scale/shear allowed): adjugate of the 3x3 via cross products
+	constexpr AffineTransform InverseAffine() const
+	{
+		const Vector3 c0 = Vector3::Cross(axisY, axisZ);
+		const Vector3 c1 = Vector3::Cross(axisZ, axisX);
+		const Vector3 c2 = Vector3::Cross(axisX, axisY);
+
+		const float det = Vector3::Dot(axisX, c0);
+		assert((!AreEqual(det, 0.f)) && "ERROR: determinant is 0, there is no INVERSE!");
+		const float invDet = 1.f / det;
+
+		const AffineTransform inverse{
+			Vector3{ c0.x, c1.x, c2.x } * invDet,
+			Vector3{ c0.y, c1.y, c2.y } * invDet,
+			Vector3{ c0.z, c1.z, c2.z } * invDet,
+			Vector3::Zero };
+
+		return { inverse.axisX, inverse.axisY, inverse.axisZ, -inverse.TransformVector(translation) };
+	}
+
+#pragma region Operator Overloads
+	//Applies this transform first, then t (same order as Matrix::operator*): 36 multiplies instead of 64
+	constexpr AffineTransform operator*(const AffineTransform& t) const noexcept
+	{
+		return { t.TransformVector(axisX), t.TransformVector(axisY), t.TransformVector(axisZ), t.TransformPoint(translation) };
+	}
+
+	constexpr AffineTransform& operator*=(const AffineTransform& t) noexcept
+	{
+		*this = *this * t;
+		return *this;
+	}
+
+	//Affine * full 4x4 (e.g. world * viewProjection): the implicit last column saves 16 multiplies
+	constexpr Matrix operator*(const Matrix& m) const noexcept
+	{
+		const Vector4 m0 = m[0], m1 = m[1], m2 = m[2], m3 = m[3];
+		const auto row = [&](const Vector3& v) { return m0 * v.x + m1 * v.y + m2 * v.z; };
+
+		return { row(axisX), row(axisY), row(axisZ), row(translation) + m3 };
+	}
+#pragma endregion
+};
+
+static_assert(std::is_trivially_copyable_v<AffineTransform>);
@@ -0,0 +1,857 @@
+#include "pch.h"
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#include "Parallel.h"
+#include "SIMD.h"
+
+namespace
+{
+	using BlockCompression::Quality;
+
+	//16 texels channel by channel, so the index search loads 4 or 8 texels of one channel at once
+	struct Block
+	{
+		alignas(32) float values[4][16];
+	};
+
+	//Palette entries are padded to 4 channels whatever the format uses
+	using PaletteEntry = float[4];
+
+#if defined(MATH_USE_SSE)
+#if defined(__AVX__)
+	using Lane = __m256;
+#else
+	using Lane = __m128;
+#endif
+	constexpr uint32_t laneWidth{ sizeof(Lane) / sizeof(float) };
+#endif
+
+	Block ToBlock(const uint8_t* pTexels, uint32_t firstChannel, uint32_t channelCount)
+	{
+		Block block{};
+		for (uint32_t texel{ 0 }; texel < 16; ++texel)
+		{
+			for (uint32_t channel{ 0 }; channel < channelCount; ++channel)
+				block.values[channel][texel] = pTexels[texel * 4 + firstChannel + channel];
+		}
+		return block;
+	}
+
+	uint32_t GetRefitCount(Quality quality)
+	{
+		return quality == Quality::Fast ? 0 : quality == Quality::Normal ? 1 : 3;
+	}
+
+	//Nearest palette entry for every texel, returns the summed squared error
+	template<uint32_t ChannelCount>
+	float FitIndices(const Block& block, const PaletteEntry* pPalette, uint32_t paletteSize, uint8_t* pIndices)
+	{
+		float error{ 0.f };
+#if defined(MATH_USE_SSE)
+		for (uint32_t first{ 0 }; first < 16; first += laneWidth)
+		{
+			Lane best = SIMD::Broadcast<Lane>(FLT_MAX);
+			Lane bestIndex = SIMD::Broadcast<Lane>(0.f);
+			for (uint32_t entry{ 0 }; entry < paletteSize; ++entry)
+			{
+				Lane distance = SIMD::Broadcast<Lane>(0.f);
+				for (uint32_t channel{ 0 }; channel < ChannelCount; ++channel)
+				{
+					const Lane difference = SIMD::Sub(SIMD::Load<Lane>(&block.values[channel][first]), SIMD::Broadcast<Lane>(pPalette[entry][channel]));
+					distance = SIMD::MulAdd(difference, difference, distance);
+				}
+				bestIndex = SIMD::Select(SIMD::Less(distance, best), SIMD::Broadcast<Lane>(float(entry)), bestIndex);
+				best = SIMD::Min(distance, best);
+			}
+
+			alignas(32) float distances[laneWidth];
+			alignas(32) float indices[laneWidth];
+			SIMD::Store(distances, best);
+			SIMD::Store(indices, bestIndex);
+			for (uint32_t lane{ 0 }; lane < laneWidth; ++lane)
+			{
+				pIndices[first + lane] = uint8_t(indices[lane]);
+				error += distances[lane];
+			}
+		}
+#else
+		for (uint32_t texel{ 0 }; texel < 16; ++texel)
+		{
+			float best{ FLT_MAX };
+			for (uint32_t entry{ 0 }; entry < paletteSize; ++entry)
+			{
+				float distance{ 0.f };
+				for (uint32_t channel{ 0 }; channel < ChannelCount; ++channel)
+				{
+					const float difference = block.values[channel][texel] - pPalette[entry][channel];
+					distance += difference * difference;
+				}
+				if (distance < best)
+				{
+					best = distance;
+					pIndices[texel] = uint8_t(entry);
+				}
+			}
+			error += best;
+		}
+#endif
+		return error;
+	}
+
+	//Endpoints minimizing the squared error for fixed indices, with texel = (1 - w) * e0 + w * e1 and w the index's
+	//weight. False when every texel has the same weight, the system is singular then.
+	template<uint32_t ChannelCount>
+	bool FitEndpoints(const Block& block, const uint8_t* pIndices, const float* pWeights, float* pEndpoint0, float* pEndpoint1)
+	{
+		float aa{ 0.f }, ab{ 0.f }, bb{ 0.f };
+		float ax[4]{}, bx[4]{};
+		for (uint32_t texel{ 0 }; texel < 16; ++texel)
+		{
+			const float b = pWeights[pIndices[texel]];
+			const float a = 1.f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (uint32_t channel{ 0 }; channel < ChannelCount; ++channel)
+			{
+				ax[channel] += a * block.values[channel][texel];
+				bx[channel] += b * block.values[channel][texel];
+			}
+		}
+
+		const float determinant = aa * bb - ab * ab;
+		if (std::abs(determinant) < 1e-6f)
+			return false;
+		const float invDeterminant = 1.f / determinant;
+		for (uint32_t channel{ 0 }; channel < ChannelCount; ++channel)
+		{
+			pEndpoint0[channel] = std::clamp((bb * ax[channel] - ab * bx[channel]) * invDeterminant, 0.f, 255.f);
+			pEndpoint1[channel] = std::clamp((aa * bx[channel] - ab * ax[channel]) * invDeterminant, 0.f, 255.f);
+		}
+		return true;
+	}
+
+	//The line the texels spread along: their mean and the direction of largest variance, by power iteration on the
+	//covariance matrix. Flat blocks get a zero axis.
+	template<uint32_t ChannelCount>
+	void FindPrincipalAxis(const Block& block, float* pMean, float* pAxis, float& minimum, float& maximum)
+	{
+		for (uint32_t channel{ 0 }; channel < ChannelCount; ++channel)
+		{
+			float sum{ 0.f };
+			for (uint32_t texel{ 0 }; texel < 16; ++texel)
+				sum += block.values[channel][texel];
+			pMean[channel] = sum / 16.f;
+		}
+
+		float covariance[4][4]{};
+		for (uint32_t texel{ 0 }; texel < 16; ++texel)
+		{
+			for (uint32_t i{ 0 }; i < ChannelCount; ++i)
+			{
+				const float di = block.values[i][texel] - pMean[i];
+				for (uint32_t j{ i }; j < ChannelCount; ++j)
+					covariance[i][j] += di * (block.values[j][texel] - pMean[j]);
+			}
+		}
+
+		//Start from the row of the channel that varies most, it can't be orthogonal to the answer
+		uint32_t widest{ 0 };
+		for (uint32_t i{ 0 }; i < ChannelCount; ++i)
+		{
+			for (uint32_t j{ 0 }; j < i; ++j)
+				covariance[i][j] = covariance[j][i];
+			if (covariance[i][i] > covariance[widest][widest])
+				widest = i;
+		}
+		for (uint32_t channel{ 0 }; channel < ChannelCount; ++channel)
+			pAxis[channel] = covariance[widest][channel];
+
+		for (int iteration{ 0 }; iteration < 8; ++iteration)
+		{
+			float next[4]{};
+			float scale{ 0.f };
+			for (uint32_t i{ 0 }; i < ChannelCount; ++i)
+			{
+				for (uint32_t j{ 0 }; j < ChannelCount; ++j)
+					next[i] += covariance[i][j] * pAxis[j];
+				scale = std::max(scale, std::abs(next[i]));
+			}
+			if (scale < 1e-9f)
+				break;
+			for (uint32_t channel{ 0 }; channel < ChannelCount; ++channel)
+				pAxis[channel] = next[channel] / scale;
+		}
+
+		float lengthSquared{ 0.f };
+		for (uint32_t channel{ 0 }; channel < ChannelCount; ++channel)
+			lengthSquared += pAxis[channel] * pAxis[channel];
+		const float invLength = lengthSquared > 1e-12f ? 1.f / std::sqrt(lengthSquared) : 0.f;
+		for (uint32_t channel{ 0 }; channel < ChannelCount; ++channel)
+			pAxis[channel] *= invLength;
+
+		minimum = FLT_MAX;
+		maximum = -FLT_MAX;
+		for (uint32_t texel{ 0 }; texel < 16; ++texel)
+		{
+			float t{ 0.f };
+			for (uint32_t channel{ 0 }; channel < ChannelCount; ++channel)
+				t += (block.values[channel][texel] - pMean[channel]) * pAxis[channel];
+			minimum = std::min(minimum, t);
+			maximum = std::max(maximum, t);
+		}
+	}
+
+	//Little-endian bit stream over a zeroed block
+	struct BitWriter
+	{
+		uint8_t* pBytes;
+		uint32_t position{ 0 };
+
+		void Write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t bit{ 0 }; bit < bitCount; ++bit, ++position)
+			{
+				if ((value >> bit) & 1)
+					pBytes[position / 8] |= uint8_t(1 << (position % 8));
+			}
+		}
+	};
+
+	struct BitReader
+	{
+		const uint8_t* pBytes;
+		uint32_t position{ 0 };
+
+		uint32_t Read(uint32_t bitCount)
+		{
+			uint32_t value{ 0 };
+			for (uint32_t bit{ 0 }; bit < bitCount; ++bit, ++position)
+				value |= uint32_t((pBytes[position / 8] >> (position % 8)) & 1) << bit;
+			return value;
+		}
+	};
+
+	//BC1
+
+	uint32_t Expand(uint32_t value, uint32_t bits)
+	{
+		return (value << (8 - bits)) | (value >> (2 * bits - 8));
+	}
+
+	uint16_t To565(const float* pColor)
+	{
+		const auto quantize = [](float value, float levels) { return uint16_t(std::clamp(value * levels / 255.f + 0.5f, 0.f, levels)); };
+		return uint16_t(quantize(pColor[0], 31.f) << 11 | quantize(pColor[1], 63.f) << 5 | quantize(pColor[2], 31.f));
+	}
+
+	//Four colors when color0 > color1, otherwise three and transparent black
+	void GetBC1Palette(uint16_t color0, uint16_t color1, PaletteEntry* pPalette)
+	{
+		const uint32_t colors[2][3]{
+			{ Expand(color0 >> 11, 5), Expand((color0 >> 5) & 63, 6), Expand(color0 & 31, 5) },
+			{ Expand(color1 >> 11, 5), Expand((color1 >> 5) & 63, 6), Expand(color1 & 31, 5) } };
+		for (uint32_t channel{ 0 }; channel < 3; ++channel)
+		{
+			const uint32_t c0 = colors[0][channel], c1 = colors[1][channel];
+			pPalette[0][channel] = float(c0);
+			pPalette[1][channel] = float(c1);
+			if (color0 > color1)
+			{
+				pPalette[2][channel] = float((2 * c0 + c1 + 1) / 3);
+				pPalette[3][channel] = float((c0 + 2 * c1 + 1) / 3);
+			}
+			else
+			{
+				pPalette[2][channel] = float((c0 + c1) / 2);
+				pPalette[3][channel] = 0.f;
+			}
+		}
+		for (uint32_t entry{ 0 }; entry < 4; ++entry)
+			pPalette[entry][3] = color0 <= color1 && entry == 3 ? 0.f : 255.f;
+	}
+
+	struct SingleColorMatch
+	{
+		uint8_t endpoint0;
+		uint8_t endpoint1;
+	};
+
+	//For every 8-bit value, the 5- or 6-bit endpoints whose 2/3 point lands closest to it: flat blocks then come out
+	//nearly exact instead of snapping to the nearest 565 color
+	template<uint32_t Bits>
+	const std::array<SingleColorMatch, 256>& GetSingleColorTable()
+	{
+		static const std::array<SingleColorMatch, 256> table = []()
+			{
+				std::array<SingleColorMatch, 256> matches{};
+				for (int value{ 0 }; value < 256; ++value)
+				{
+					int bestError{ INT_MAX };
+					for (uint32_t e0{ 0 }; e0 < (1u << Bits); ++e0)
+					{
+						for (uint32_t e1{ 0 }; e1 < (1u << Bits); ++e1)
+						{
+							const int error = std::abs(int((2 * Expand(e0, Bits) + Expand(e1, Bits) + 1) / 3) - value);
+							if (error < bestError)
+							{
+								bestError = error;
+								matches[value] = { uint8_t(e0), uint8_t(e1) };
+							}
+						}
+					}
+				}
+				return matches;
+			}();
+		return table;
+	}
+
+	void WriteBC1(uint16_t color0, uint16_t color1, const uint8_t* pIndices, uint8_t* pBlock)
+	{
+		uint32_t indices{ 0 };
+		for (uint32_t texel{ 0 }; texel < 16; ++texel)
+			indices |= uint32_t(pIndices[texel]) << (texel * 2);
+		const uint8_t bytes[8]{ uint8_t(color0), uint8_t(color0 >> 8), uint8_t(color1), uint8_t(color1 >> 8),
+			uint8_t(indices), uint8_t(indices >> 8), uint8_t(indices >> 16), uint8_t(indices >> 24) };
+		std::memcpy(pBlock, bytes, 8);
+	}
+
+	//BC4
+
+	//Eight values when value0 > value1, otherwise six plus 0 and 255
+	void GetBC4Palette(uint8_t value0, uint8_t value1, PaletteEntry* pPalette)
+	{
+		pPalette[0][0] = value0;
+		pPalette[1][0] = value1;
+		if (value0 > value1)
+		{
+			for (uint32_t step{ 1 }; step < 7; ++step)
+				pPalette[step + 1][0] = float(((7 - step) * value0 + step * value1 + 3) / 7);
+		}
+		else
+		{
+			for (uint32_t step{ 1 }; step < 5; ++step)
+				pPalette[step + 1][0] = float(((5 - step) * value0 + step * value1 + 2) / 5);
+			pPalette[6][0] = 0.f;
+			pPalette[7][0] = 255.f;
+		}
+	}
+
+	//block holds the channel in values[0]
+	void EncodeBC4Block(const Block& block, Quality quality, uint8_t* pBlock)
+	{
+		const float* pValues = block.values[0];
+		const auto [pMinimum, pMaximum] = std::minmax_element(pValues, pValues + 16);
+
+		uint8_t value0 = uint8_t(*pMaximum), value1 = uint8_t(*pMinimum);
+		uint8_t indices[16]{};
+		PaletteEntry palette[8]{};
+		const auto evaluate = [&](uint8_t v0, uint8_t v1, uint8_t* pIndices)
+			{
+				GetBC4Palette(v0, v1, palette);
+				return FitIndices<1>(block, palette, 8, pIndices);
+			};
+
+		if (value0 != value1)
+		{
+			float error = evaluate(value0, value1, indices);
+
+			static constexpr float weights[8]{ 0.f, 1.f, 1.f / 7.f, 2.f / 7.f, 3.f / 7.f, 4.f / 7.f, 5.f / 7.f, 6.f / 7.f };
+			for (uint32_t refit{ 0 }; refit < GetRefitCount(quality); ++refit)
+			{
+				float fitted0{}, fitted1{};
+				if (!FitEndpoints<1>(block, indices, weights, &fitted0, &fitted1))
+					break;
+				uint8_t candidate0 = uint8_t(fitted0 + 0.5f), candidate1 = uint8_t(fitted1 + 0.5f);
+				if (candidate0 < candidate1)
+					std::swap(candidate0, candidate1);
+				if (candidate0 == candidate1)
+					break;
+				uint8_t candidateIndices[16];
+				const float candidateError = evaluate(candidate0, candidate1, candidateIndices);
+				if (candidateError >= error)
+					break;
+				error = candidateError;
+				value0 = candidate0;
+				value1 = candidate1;
+				std::copy_n(candidateIndices, 16, indices);
+			}
+
+			//Blocks that touch 0 or 255 can spend all six interpolated values on the texels in between
+			if (quality == Quality::High && (*pMinimum == 0.f || *pMaximum == 255.f))
+			{
+				float inner0{ 255.f }, inner1{ 0.f };
+				for (uint32_t texel{ 0 }; texel < 16; ++texel)
+				{
+					if (pValues[texel] > 0.f && pValues[texel] < 255.f)
+					{
+						inner0 = std::min(inner0, pValues[texel]);
+						inner1 = std::max(inner1, pValues[texel]);
+					}
+				}
+				uint8_t candidateIndices[16];
+				if (inner0 <= inner1 && evaluate(uint8_t(inner0), uint8_t(inner1), candidateIndices) < error)
+				{
+					value0 = uint8_t(inner0);
+					value1 = uint8_t(inner1);
+					std::copy_n(candidateIndices, 16, indices);
+				}
+			}
+		}
+
+		uint64_t bits{ 0 };
+		for (uint32_t texel{ 0 }; texel < 16; ++texel)
+			bits |= uint64_t(indices[texel]) << (texel * 3);
+		pBlock[0] = value0;
+		pBlock[1] = value1;
+		for (uint32_t byte{ 0 }; byte < 6; ++byte)
+			pBlock[2 + byte] = uint8_t(bits >> (byte * 8));
+	}
+
+	//BC7, mode 6 only: one subset of rgba endpoints with 7 bits per channel plus a shared low bit per endpoint (p-bit),
+	//and 4-bit indices. The mode with the finest gradients, which covers the smooth maps this renderer uses.
+
+	constexpr uint32_t bc7Weights[16]{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BC7Endpoints
+	{
+		uint8_t quantized[2][4];	//7 bits
+		uint8_t pBits[2];
+	};
+
+	void GetBC7Palette(const BC7Endpoints& endpoints, PaletteEntry* pPalette)
+	{
+		for (uint32_t channel{ 0 }; channel < 4; ++channel)
+		{
+			const uint32_t e0 = uint32_t(endpoints.quantized[0][channel]) << 1 | endpoints.pBits[0];
+			const uint32_t e1 = uint32_t(endpoints.quantized[1][channel]) << 1 | endpoints.pBits[1];
+			for (uint32_t entry{ 0 }; entry < 16; ++entry)
+				pPalette[entry][channel] = float(((64 - bc7Weights[entry]) * e0 + bc7Weights[entry] * e1 + 32) >> 6);
+		}
+	}
+
+	//Squared error of an endpoint snapped to 7 bits with the given p-bit
+	float QuantizeBC7(const float* pEndpoint, uint32_t pBit, uint8_t* pQuantized)
+	{
+		float error{ 0.f };
+		for (uint32_t channel{ 0 }; channel < 4; ++channel)
+		{
+			pQuantized[channel] = uint8_t(std::clamp(int((pEndpoint[channel] - float(pBit)) * 0.5f + 0.5f), 0, 127));
+			const float difference = pEndpoint[channel] - float(pQuantized[channel] * 2 + pBit);
+			error += difference * difference;
+		}
+		return error;
+	}
+
+	//Each endpoint gets the p-bit that snaps it closest
+	BC7Endpoints QuantizeBC7(const float* pEndpoint0, const float* pEndpoint1)
+	{
+		BC7Endpoints endpoints{};
+		const float* endpointValues[2]{ pEndpoint0, pEndpoint1 };
+		for (uint32_t endpoint{ 0 }; endpoint < 2; ++endpoint)
+		{
+			uint8_t withOne[4];
+			const float errorZero = QuantizeBC7(endpointValues[endpoint], 0, endpoints.quantized[endpoint]);
+			if (QuantizeBC7(endpointValues[endpoint], 1, withOne) < errorZero)
+			{
+				std::copy_n(withOne, 4, endpoints.quantized[endpoint]);
+				endpoints.pBits[endpoint] = 1;
+			}
+		}
+		return endpoints;
+	}
+
+	void WriteBC7(BC7Endpoints endpoints, uint8_t* pIndices, uint8_t* pBlock)
+	{
+		//The first texel's index is stored with 3 bits, its top bit implied 0: mirror the line when it would be 1
+		if (pIndices[0] & 8)
+		{
+			std::swap(endpoints.quantized[0], endpoints.quantized[1]);
+			std::swap(endpoints.pBits[0], endpoints.pBits[1]);
+			for (uint32_t texel{ 0 }; texel < 16; ++texel)
+				pIndices[texel] = uint8_t(15 - pIndices[texel]);
+		}
+
+		std::memset(pBlock, 0, 16);
+		BitWriter writer{ pBlock };
+		writer.Write(1 << 6, 7);
+		for (uint32_t channel{ 0 }; channel < 4; ++channel)
+		{
+			writer.Write(endpoints.quantized[0][channel], 7);
+			writer.Write(endpoints.quantized[1][channel], 7);
+		}
+		writer.Write(endpoints.pBits[0], 1);
+		writer.Write(endpoints.pBits[1], 1);
+		for (uint32_t texel{ 0 }; texel < 16; ++texel)
+			writer.Write(pIndices[texel], texel == 0 ? 3 : 4);
+	}
+
+	//RGBA8 levels are copied through
+	void CopyLevels(const TextureView& rgba, BlockCompression::Image& image)
+	{
+		for (size_t level{ 0 }; level < rgba.levels.size(); ++level)
+			std::memcpy(image.data.data() + image.levels[level].offset, rgba.GetLevelData(level), rgba.GetLevelSize(level));
+	}
+
+	void EncodeBlock(TextureFormat format, const uint8_t* pTexels, Quality quality, uint8_t* pBlock)
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1: BlockCompression::EncodeBC1(pTexels, quality, pBlock); break;
+		case TextureFormat::BC4: BlockCompression::EncodeBC4(pTexels, 0, quality, pBlock); break;
+		case TextureFormat::BC5: BlockCompression::EncodeBC5(pTexels, quality, pBlock); break;
+		default: BlockCompression::EncodeBC7(pTexels, quality, pBlock); break;
+		}
+	}
+}
+
+namespace BlockCompression
+{
+	TextureFormat ChooseFormat(MipChain::Content content, Quality quality)
+	{
+		switch (content)
+		{
+		case MipChain::Content::Normal: return TextureFormat::BC5;
+		case MipChain::Content::Linear: return TextureFormat::BC4;
+		default: return quality == Quality::Fast ? TextureFormat::BC1 : TextureFormat::BC7;
+		}
+	}
+
+	void EncodeBC1(const uint8_t* pTexels, Quality quality, uint8_t* pBlock)
+	{
+		const Block block = ToBlock(pTexels, 0, 3);
+		uint8_t indices[16]{};
+
+		bool isFlat{ true };
+		for (uint32_t texel{ 1 }; texel < 16 && isFlat; ++texel)
+			isFlat = std::memcmp(pTexels, pTexels + texel * 4, 3) == 0;
+		if (isFlat)
+		{
+			const SingleColorMatch& red = GetSingleColorTable<5>()[pTexels[0]];
+			const SingleColorMatch& green = GetSingleColorTable<6>()[pTexels[1]];
+			const SingleColorMatch& blue = GetSingleColorTable<5>()[pTexels[2]];
+			uint16_t color0 = uint16_t(red.endpoint0 << 11 | green.endpoint0 << 5 | blue.endpoint0);
+			uint16_t color1 = uint16_t(red.endpoint1 << 11 | green.endpoint1 << 5 | blue.endpoint1);
+			uint8_t index{ 2 };
+			if (color0 < color1)
+			{
+				std::swap(color0, color1);
+				index = 3;
+			}
+			else if (color0 == color1)
+			{
+				index = 0;
+			}
+			std::fill_n(indices, 16, index);
+			WriteBC1(color0, color1, indices, pBlock);
+			return;
+		}
+
+		//Always four colors: swapping the endpoints keeps color0 > color1, equal ones leave a single color
+		PaletteEntry palette[4]{};
+		const auto evaluate = [&](const float* pEndpoint0, const float* pEndpoint1, uint16_t& color0, uint16_t& color1, uint8_t* pIndices)
+			{
+				color0 = To565(pEndpoint0);
+				color1 = To565(pEndpoint1);
+				if (color0 < color1)
+					std::swap(color0, color1);
+				GetBC1Palette(color0, color1, palette);
+				return FitIndices<3>(block, palette, color0 == color1 ? 1 : 4, pIndices);
+			};
+
+		float mean[4]{}, axis[4]{}, minimum{}, maximum{};
+		FindPrincipalAxis<3>(block, mean, axis, minimum, maximum);
+		float endpoint0[3]{}, endpoint1[3]{};
+		for (uint32_t channel{ 0 }; channel < 3; ++channel)
+		{
+			endpoint0[channel] = std::clamp(mean[channel] + axis[channel] * maximum, 0.f, 255.f);
+			endpoint1[channel] = std::clamp(mean[channel] + axis[channel] * minimum, 0.f, 255.f);
+		}
+
+		uint16_t color0{}, color1{};
+		float error = evaluate(endpoint0, endpoint1, color0, color1, indices);
+
+		static constexpr float weights[4]{ 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+		for (uint32_t refit{ 0 }; refit < GetRefitCount(quality) && color0 != color1; ++refit)
+		{
+			if (!FitEndpoints<3>(block, indices, weights, endpoint0, endpoint1))
+				break;
+			uint16_t candidate0{}, candidate1{};
+			uint8_t candidateIndices[16];
+			const float candidateError = evaluate(endpoint0, endpoint1, candidate0, candidate1, candidateIndices);
+			if (candidateError >= error)
+				break;
+			error = candidateError;
+			color0 = candidate0;
+			color1 = candidate1;
+			std::copy_n(candidateIndices, 16, indices);
+		}
+		WriteBC1(color0, color1, indices, pBlock);
+	}
+
+	void EncodeBC4(const uint8_t* pTexels, uint32_t channel, Quality quality, uint8_t* pBlock)
+	{
+		EncodeBC4Block(ToBlock(pTexels, channel, 1), quality, pBlock);
+	}
+
+	void EncodeBC5(const uint8_t* pTexels, Quality quality, uint8_t* pBlock)
+	{
+		EncodeBC4(pTexels, 0, quality, pBlock);
+		EncodeBC4(pTexels, 1, quality, pBlock + 8);
+	}
+
+	void EncodeBC7(const uint8_t* pTexels, Quality quality, uint8_t* pBlock)
+	{
+		const Block block = ToBlock(pTexels, 0, 4);
+
+		float mean[4]{}, axis[4]{}, minimum{}, maximum{};
+		FindPrincipalAxis<4>(block, mean, axis, minimum, maximum);
+		float endpoint0[4]{}, endpoint1[4]{};
+		for (uint32_t channel{ 0 }; channel < 4; ++channel)
+		{
+			endpoint0[channel] = std::clamp(mean[channel] + axis[channel] * minimum, 0.f, 255.f);
+			endpoint1[channel] = std::clamp(mean[channel] + axis[channel] * maximum, 0.f, 255.f);
+		}
+
+		PaletteEntry palette[16]{};
+		const auto evaluate = [&](const BC7Endpoints& endpoints, uint8_t* pIndices)
+			{
+				GetBC7Palette(endpoints, palette);
+				return FitIndices<4>(block, palette, 16, pIndices);
+			};
+
+		//High tries all four p-bit pairs on the whole block instead of snapping each endpoint on its own
+		BC7Endpoints best{};
+		uint8_t indices[16]{};
+		float error{ FLT_MAX };
+		const auto tryEndpoints = [&](const float* pEndpoint0, const float* pEndpoint1)
+			{
+				bool improved{ false };
+				const auto tryCandidate = [&](const BC7Endpoints& candidate)
+					{
+						uint8_t candidateIndices[16];
+						const float candidateError = evaluate(candidate, candidateIndices);
+						if (candidateError < error)
+						{
+							error = candidateError;
+							best = candidate;
+							std::copy_n(candidateIndices, 16, indices);
+							improved = true;
+						}
+					};
+				if (quality != Quality::High)
+				{
+					tryCandidate(QuantizeBC7(pEndpoint0, pEndpoint1));
+					return improved;
+				}
+				for (uint32_t pBits{ 0 }; pBits < 4; ++pBits)
+				{
+					BC7Endpoints candidate{};
+					candidate.pBits[0] = uint8_t(pBits & 1);
+					candidate.pBits[1] = uint8_t(pBits >> 1);
+					QuantizeBC7(pEndpoint0, candidate.pBits[0], candidate.quantized[0]);
+					QuantizeBC7(pEndpoint1, candidate.pBits[1], candidate.quantized[1]);
+					tryCandidate(candidate);
+				}
+				return improved;
+			};
+
+		tryEndpoints(endpoint0, endpoint1);
+
+		static constexpr auto weights = []()
+			{
+				std::array<float, 16> values{};
+				for (uint32_t entry{ 0 }; entry < 16; ++entry)
+					values[entry] = float(bc7Weights[entry]) / 64.f;
+				return values;
+			}();
+		for (uint32_t refit{ 0 }; refit < GetRefitCount(quality) && error > 0.f; ++refit)
+		{
+			if (!FitEndpoints<4>(block, indices, weights.data(), endpoint0, endpoint1) || !tryEndpoints(endpoint0, endpoint1))
+				break;
+		}
+		WriteBC7(best, indices, pBlock);
+	}
+
+	void DecodeBlock(TextureFormat format, const uint8_t* pBlock, uint8_t* pTexels)
+	{
+		PaletteEntry palette[16]{};
+		uint8_t indices[16]{};
+		switch (format)
+		{
+		case TextureFormat::BC1:
+		{
+			GetBC1Palette(uint16_t(pBlock[0] | pBlock[1] << 8), uint16_t(pBlock[2] | pBlock[3] << 8), palette);
+			for (uint32_t texel{ 0 }; texel < 16; ++texel)
+				indices[texel] = (pBlock[4 + texel / 4] >> (texel % 4 * 2)) & 3;
+			break;
+		}
+		case TextureFormat::BC4:
+		case TextureFormat::BC5:
+		{
+			for (uint32_t texel{ 0 }; texel < 16; ++texel)
+				std::fill_n(pTexels + texel * 4, 4, uint8_t(0));
+			const uint32_t channelCount = format == TextureFormat::BC4 ? 1 : 2;
+			for (uint32_t channel{ 0 }; channel < channelCount; ++channel)
+			{
+				const uint8_t* pChannel = pBlock + channel * 8;
+				GetBC4Palette(pChannel[0], pChannel[1], palette);
+				uint64_t bits{ 0 };
+				for (uint32_t byte{ 0 }; byte < 6; ++byte)
+					bits |= uint64_t(pChannel[2 + byte]) << (byte * 8);
+				for (uint32_t texel{ 0 }; texel < 16; ++texel)
+					pTexels[texel * 4 + channel] = uint8_t(palette[(bits >> (texel * 3)) & 7][0]);
+			}
+			for (uint32_t texel{ 0 }; texel < 16; ++texel)
+				pTexels[texel * 4 + 3] = 255;
+			return;
+		}
+		default:
+		{
+			BitReader reader{ pBlock };
+			if (reader.Read(7) != 1 << 6)
+			{
+				std::fill_n(pTexels, 64, uint8_t(0));
+				return;
+			}
+			BC7Endpoints endpoints{};
+			for (uint32_t channel{ 0 }; channel < 4; ++channel)
+			{
+				endpoints.quantized[0][channel] = uint8_t(reader.Read(7));
+				endpoints.quantized[1][channel] = uint8_t(reader.Read(7));
+			}
+			endpoints.pBits[0] = uint8_t(reader.Read(1));
+			endpoints.pBits[1] = uint8_t(reader.Read(1));
+			GetBC7Palette(endpoints, palette);
+			for (uint32_t texel{ 0 }; texel < 16; ++texel)
+				indices[texel] = uint8_t(reader.Read(texel == 0 ? 3 : 4));
+			break;
+		}
+		}
+
+		for (uint32_t texel{ 0 }; texel < 16; ++texel)
+		{
+			for (uint32_t channel{ 0 }; channel < 4; ++channel)
+				pTexels[texel * 4 + channel] = uint8_t(palette[indices[texel]][channel]);
+		}
+	}
+
+	void Compress(const TextureView& rgba, const Settings& settings, Image& image, CompressStats* pStats)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		const TextureLevel& top = rgba.levels[0];
+		image.format = top.width % 4 == 0 && top.height % 4 == 0 ? settings.format : TextureFormat::RGBA8;
+		image.levels.assign(rgba.levels.begin(), rgba.levels.end());
+		uint64_t byteCount{ 0 };
+		for (TextureLevel& level : image.levels)
+		{
+			level.offset = byteCount;
+			byteCount += GetTextureLevelSize(image.format, level.width, level.height);
+		}
+		image.data.resize(byteCount);
+
+		if (image.format == TextureFormat::RGBA8)
+		{
+			CopyLevels(rgba, image);
+		}
+		else
+		{
+			//Every block row of every level is one job, level 0's rows first
+			struct BlockRow
+			{
+				uint32_t level;
+				uint32_t row;
+			};
+			std::vector<BlockRow> rows{};
+			for (uint32_t level{ 0 }; level < image.levels.size(); ++level)
+			{
+				for (uint32_t row{ 0 }; row < (image.levels[level].height + 3) / 4; ++row)
+					rows.push_back({ level, row });
+			}
+
+			const uint32_t blockSize = GetTexelBlockSize(image.format);
+			Parallel::ForRanges(rows.size(), Parallel::GetThreadCount(settings.threadCount), [&](unsigned, size_t begin, size_t end)
+				{
+					uint8_t texels[64];
+					for (size_t job{ begin }; job < end; ++job)
+					{
+						const TextureLevel& level = image.levels[rows[job].level];
+						const uint8_t* pSource = rgba.GetLevelData(rows[job].level);
+						uint8_t* pBlock = image.data.data() + level.offset + uint64_t(rows[job].row) * GetTextureRowPitch(image.format, level.width);
+						for (uint32_t blockX{ 0 }; blockX < (level.width + 3) / 4; ++blockX, pBlock += blockSize)
+						{
+							for (uint32_t texel{ 0 }; texel < 16; ++texel)
+							{
+								const uint32_t x = std::min(blockX * 4 + texel % 4, level.width - 1);
+								const uint32_t y = std::min(rows[job].row * 4 + texel / 4, level.height - 1);
+								std::memcpy(texels + texel * 4, pSource + (size_t(y) * level.width + x) * 4, 4);
+							}
+							EncodeBlock(image.format, texels, settings.quality, pBlock);
+						}
+					}
+				});
+		}
+
+		if (pStats)
+		{
+			pStats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::vector<uint8_t> decoded{};
+			Decompress(image.GetView(), 0, decoded);
+			pStats->psnr = MeasurePSNR(image.format, { rgba.GetLevelData(0), size_t(rgba.GetLevelSize(0)) }, decoded);
+		}
+	}
+
+	void Decompress(const TextureView& compressed, size_t level, std::vector<uint8_t>& rgba)
+	{
+		const TextureLevel& mip = compressed.levels[level];
+		rgba.resize(size_t(mip.width) * mip.height * 4);
+		if (!IsBlockCompressed(compressed.format))
+		{
+			std::memcpy(rgba.data(), compressed.GetLevelData(level), rgba.size());
+			return;
+		}
+
+		const uint8_t* pBlock = compressed.GetLevelData(level);
+		uint8_t texels[64];
+		for (uint32_t blockY{ 0 }; blockY < (mip.height + 3) / 4; ++blockY)
+		{
+			for (uint32_t blockX{ 0 }; blockX < (mip.width + 3) / 4; ++blockX, pBlock += GetTexelBlockSize(compressed.format))
+			{
+				DecodeBlock(compressed.format, pBlock, texels);
+				for (uint32_t texel{ 0 }; texel < 16; ++texel)
+				{
+					const uint32_t x = blockX * 4 + texel % 4, y = blockY * 4 + texel / 4;
+					if (x < mip.width && y < mip.height)
+						std::memcpy(&rgba[(size_t(y) * mip.width + x) * 4], texels + texel * 4, 4);
+				}
+			}
+		}
+	}
+
+	float MeasurePSNR(TextureFormat format, std::span<const uint8_t> original, std::span<const uint8_t> decoded)
+	{
+		const uint32_t channelCount = format == TextureFormat::BC4 ? 1 : format == TextureFormat::BC5 ? 2 : format == TextureFormat::BC1 ? 3 : 4;
+		double squaredError{ 0.0 };
+		for (size_t texel{ 0 }; texel < std::min(original.size(), decoded.size()) / 4; ++texel)
+		{
+			for (uint32_t channel{ 0 }; channel < channelCount; ++channel)
+			{
+				const double difference = double(original[texel * 4 + channel]) - decoded[texel * 4 + channel];
+				squaredError += difference * difference;
+			}
+		}
+		const double meanSquaredError = squaredError / (double(original.size() / 4) * channelCount);
+		if (meanSquaredError <= 0.0)
+			return 99.f;
+		return float(10.0 * std::log10(255.0 * 255.0 / meanSquaredError));
+	}
+}
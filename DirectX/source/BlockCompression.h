@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "DataTypes.h"
+#include "MipChain.h"
+
+//CPU encoders for the BC formats D3D11 samples natively (BlockCompression.cpp). Every block is fitted on its own:
+//endpoints along the block's principal axis, indices projected on that line, then least-squares refits of the
+//endpoints for the chosen indices. Block rows are split over the threads, the index search runs 4 or 8 texels wide.
+namespace BlockCompression
+{
+	//Trades encoding time for error: more endpoint refits and, for BC7, a search over the p-bits
+	enum class Quality
+	{
+		Fast,
+		Normal,
+		High
+	};
+
+	struct Settings
+	{
+		TextureFormat format{ TextureFormat::BC7 };
+		Quality quality{ Quality::Normal };
+		unsigned threadCount{ 0 };	//0: one per hardware thread
+	};
+
+	//BC7 for color (BC1 when Fast, dropping alpha), BC5 for normal maps (x and y, the shader rebuilds z) and BC4 for the
+	//single-channel data maps, which keeps their red channel
+	TextureFormat ChooseFormat(MipChain::Content content, Quality quality);
+
+	//A compressed chain in one allocation, laid out like MipChain::Image
+	struct Image
+	{
+		TextureFormat format{ TextureFormat::RGBA8 };
+		std::vector<TextureLevel> levels{};
+		std::vector<uint8_t> data{};
+
+		TextureView GetView() const { return { format, levels, data.data() }; }
+	};
+
+	struct CompressStats
+	{
+		double seconds{};
+		float psnr{};	//of level 0, over the channels the format keeps
+	};
+
+	//Encodes every level of an RGBA8 chain. Levels that don't fill their last blocks (the 2x2 and 1x1 ones) repeat their
+	//last row and column. BC formats need level 0 to be a multiple of 4 texels on each side: other sizes are copied
+	//as RGBA8. The PSNR is only measured when pStats is given, it decodes level 0 again.
+	void Compress(const TextureView& rgba, const Settings& settings, Image& image, CompressStats* pStats = nullptr);
+
+	//One level back to RGBA8 as the GPU would sample it: BC4 fills only red, BC5 red and green, the rest reads 0 and
+	//alpha 255 (BC1 too).
+	void Decompress(const TextureView& compressed, size_t level, std::vector<uint8_t>& rgba);
+
+	//Peak signal-to-noise ratio in dB between two RGBA8 images of the same size, over the channels format keeps.
+	//Identical images return 99.
+	float MeasurePSNR(TextureFormat format, std::span<const uint8_t> original, std::span<const uint8_t> decoded);
+
+	//Single blocks of 16 RGBA8 texels, row by row. BC4 encodes one channel of them, BC5 the first two.
+	void EncodeBC1(const uint8_t* pTexels, Quality quality, uint8_t* pBlock);
+	void EncodeBC4(const uint8_t* pTexels, uint32_t channel, Quality quality, uint8_t* pBlock);
+	void EncodeBC5(const uint8_t* pTexels, Quality quality, uint8_t* pBlock);
+	void EncodeBC7(const uint8_t* pTexels, Quality quality, uint8_t* pBlock);
+
+	//Blocks of any BC format back to texels; BC7 decodes mode 6 only, the one EncodeBC7 writes (other modes
+	//decode to zero)
+	void DecodeBlock(TextureFormat format, const uint8_t* pBlock, uint8_t* pTexels);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+
+#include "MathHelpers.h"
+#include "Vector3.h"
+#include "AffineTransform.h"
+
+//Axis-aligned box stored as center + half extents, which is what the plane tests and the transform need
+struct AABB
+{
+	Vector3 center{};
+	Vector3 extents{};
+
+	//Bounds of count points spaced stride bytes apart, e.g. &vertices[0].position with sizeof(Vertex)
+	static AABB FromPoints(const void* pPoints, size_t stride, size_t count) noexcept
+	{
+		if (count == 0)
+			return {};
+
+		const std::byte* pBytes = static_cast<const std::byte*>(pPoints);
+		Vector3 min = *reinterpret_cast<const Vector3*>(pBytes);
+		Vector3 max = min;
+		for (size_t i{ 1 }; i < count; ++i)
+		{
+			const Vector3& p = *reinterpret_cast<const Vector3*>(pBytes + i * stride);
+			min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+			max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+		}
+
+		return FromMinMax(min, max);
+	}
+
+	static constexpr AABB FromMinMax(const Vector3& min, const Vector3& max) noexcept
+	{
+		return { (min + max) * 0.5f, (max - min) * 0.5f };
+	}
+
+	constexpr Vector3 GetMin() const noexcept { return center - extents; }
+	constexpr Vector3 GetMax() const noexcept { return center + extents; }
+
+	//Box around the transformed box (Arvo): the new extents are |M| * extents, so no corners are transformed
+	constexpr AABB Transformed(const AffineTransform& transform) const noexcept
+	{
+		const auto absolute = [](const Vector3& v) { return Vector3{ v.x < 0.f ? -v.x : v.x, v.y < 0.f ? -v.y : v.y, v.z < 0.f ? -v.z : v.z }; };
+
+		return {
+			transform.TransformPoint(center),
+			absolute(transform.axisX) * extents.x + absolute(transform.axisY) * extents.y + absolute(transform.axisZ) * extents.z
+		};
+	}
+};
+
+struct BoundingSphere
+{
+	Vector3 center{};
+	float radius{};
+
+	//Encloses the box; looser than a fitted sphere but free to compute
+	static BoundingSphere FromAABB(const AABB& box) noexcept
+	{
+		return { box.center, box.extents.Magnitude() };
+	}
+};
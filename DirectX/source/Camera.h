@@ -1,5 +1,6 @@
 #pragma once
 #include <cassert>
+#include <cfloat>
 #include <SDL_keyboard.h>
 #include <SDL_mouse.h>
 
@@ -33,8 +34,8 @@ struct Camera
 	float totalPitch{};
 	float totalYaw{};
 
-	Matrix invViewMatrix{};
-	Matrix viewMatrix{};
+	AffineTransform invViewTransform{};
+	AffineTransform viewTransform{};
 	Matrix projectionMatrix{};
 
 	float nearPlane{ 0.1f };
@@ -60,15 +61,15 @@ struct Camera
 		//Inverse(ONB) => ViewMatrix
 		if (inspectMode == false)
 		{
-			Matrix translationMatrix = Matrix::CreateTranslation(origin);
-			Matrix rotationMatrix = Matrix::CreateRotation(totalPitch, totalYaw, 0.f);
+			const Matrix rotationMatrix = Matrix::CreateRotation(totalPitch, totalYaw, 0.f);
 
 			forward = rotationMatrix.TransformVector(Vector3::UnitZ);
 			right = Vector3::Cross(Vector3::UnitY, forward).Normalized();
 			up = Vector3::Cross(forward, right).Normalized();
 
-			invViewMatrix = rotationMatrix * translationMatrix;
-			viewMatrix = invViewMatrix.Inverse();
+			//rotation * translation is rigid, so the view is the transposed rotation with a back-rotated translation
+			invViewTransform = AffineTransform{ rotationMatrix } * AffineTransform::CreateTranslation(origin);
+			viewTransform = invViewTransform.InverseRigid();
 		}
 		else
 		{
@@ -166,9 +167,19 @@ struct Camera
 		inspectMode = !inspectMode;
 	}
 
-	const Matrix& GetViewMatrix() const { return viewMatrix; }
-	const Matrix& GetInvMatrix() const { return invViewMatrix; }
+	Matrix GetViewMatrix() const { return viewTransform.ToMatrix(); }
+	Matrix GetInvMatrix() const { return invViewTransform.ToMatrix(); }
 	const Matrix& GetProjectionMatrix() const { return projectionMatrix; }
 
-	const Matrix GetWorldViewProjection() const { return GetViewMatrix() * GetProjectionMatrix(); }
+	//Only the projection is a full 4x4, the view side of the product skips the affine last column
+	Matrix GetWorldViewProjection() const { return viewTransform * projectionMatrix; }
+
+	//Normalized world-space planes of view * projection, for culling world bounds
+	Frustum GetFrustum() const { return Frustum::FromViewProjection(GetWorldViewProjection()); }
+
+	//How many pixels of a viewportHeight high image one world unit covers at distance in front of the camera
+	float GetPixelsPerUnit(float distance, float viewportHeight) const
+	{
+		return distance > 0.f ? viewportHeight / (2.f * fov * distance) : FLT_MAX;
+	}
 };
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include "MathHelpers.h"
 
 struct ColorRGB
@@ -7,20 +8,20 @@ struct ColorRGB
 	float g{};
 	float b{};
 
-	void MaxToOne()
+	constexpr void MaxToOne() noexcept
 	{
 		const float maxValue = std::max(r, std::max(g, b));
 		if (maxValue > 1.f)
 			*this /= maxValue;
 	}
 
-	static ColorRGB Lerp(const ColorRGB& c1, const ColorRGB& c2, float factor)
+	static constexpr ColorRGB Lerp(const ColorRGB& c1, const ColorRGB& c2, float factor) noexcept
 	{
 		return { Lerpf(c1.r, c2.r, factor), Lerpf(c1.g, c2.g, factor), Lerpf(c1.b, c2.b, factor) };
 	}
 
 #pragma region ColorRGB (Member) Operators
-	const ColorRGB& operator+=(const ColorRGB& c)
+	constexpr const ColorRGB& operator+=(const ColorRGB& c) noexcept
 	{
 		r += c.r;
 		g += c.g;
@@ -29,12 +30,12 @@ struct ColorRGB
 		return *this;
 	}
 
-	ColorRGB operator+(const ColorRGB& c) const
+	constexpr ColorRGB operator+(const ColorRGB& c) const noexcept
 	{
 		return { r + c.r, g + c.g, b + c.b };
 	}
 
-	const ColorRGB& operator-=(const ColorRGB& c)
+	constexpr const ColorRGB& operator-=(const ColorRGB& c) noexcept
 	{
 		r -= c.r;
 		g -= c.g;
@@ -43,12 +44,12 @@ struct ColorRGB
 		return *this;
 	}
 
-	ColorRGB operator-(const ColorRGB& c) const
+	constexpr ColorRGB operator-(const ColorRGB& c) const noexcept
 	{
 		return { r - c.r, g - c.g, b - c.b };
 	}
 
-	const ColorRGB& operator*=(const ColorRGB& c)
+	constexpr const ColorRGB& operator*=(const ColorRGB& c) noexcept
 	{
 		r *= c.r;
 		g *= c.g;
@@ -57,12 +58,12 @@ struct ColorRGB
 		return *this;
 	}
 
-	ColorRGB operator*(const ColorRGB& c) const
+	constexpr ColorRGB operator*(const ColorRGB& c) const noexcept
 	{
 		return { r * c.r, g * c.g, b * c.b };
 	}
 
-	const ColorRGB& operator/=(const ColorRGB& c)
+	constexpr const ColorRGB& operator/=(const ColorRGB& c) noexcept
 	{
 		r /= c.r;
 		g /= c.g;
@@ -71,7 +72,7 @@ struct ColorRGB
 		return *this;
 	}
 
-	const ColorRGB& operator*=(float s)
+	constexpr const ColorRGB& operator*=(float s) noexcept
 	{
 		r *= s;
 		g *= s;
@@ -80,12 +81,12 @@ struct ColorRGB
 		return *this;
 	}
 
-	ColorRGB operator*(float s) const
+	constexpr ColorRGB operator*(float s) const noexcept
 	{
 		return { r * s, g * s,b * s };
 	}
 
-	const ColorRGB& operator/=(float s)
+	constexpr const ColorRGB& operator/=(float s) noexcept
 	{
 		r /= s;
 		g /= s;
@@ -94,7 +95,7 @@ struct ColorRGB
 		return *this;
 	}
 
-	ColorRGB operator/(float s) const
+	constexpr ColorRGB operator/(float s) const noexcept
 	{
 		return { r / s, g / s,b / s };
 	}
@@ -102,20 +103,20 @@ struct ColorRGB
 };
 
 //ColorRGB (Global) Operators
-inline ColorRGB operator*(float s, const ColorRGB& c)
+constexpr ColorRGB operator*(float s, const ColorRGB& c) noexcept
 {
 	return c * s;
 }
 
 namespace colors
 {
-	static ColorRGB Red{ 1,0,0 };
-	static ColorRGB Blue{ 0,0,1 };
-	static ColorRGB Green{ 0,1,0 };
-	static ColorRGB Yellow{ 1,1,0 };
-	static ColorRGB Cyan{ 0,1,1 };
-	static ColorRGB Magenta{ 1,0,1 };
-	static ColorRGB White{ 1,1,1 };
-	static ColorRGB Black{ 0,0,0 };
-	static ColorRGB Gray{ 0.5f,0.5f,0.5f };
+	inline constexpr ColorRGB Red{ 1,0,0 };
+	inline constexpr ColorRGB Blue{ 0,0,1 };
+	inline constexpr ColorRGB Green{ 0,1,0 };
+	inline constexpr ColorRGB Yellow{ 1,1,0 };
+	inline constexpr ColorRGB Cyan{ 0,1,1 };
+	inline constexpr ColorRGB Magenta{ 1,0,1 };
+	inline constexpr ColorRGB White{ 1,1,1 };
+	inline constexpr ColorRGB Black{ 0,0,0 };
+	inline constexpr ColorRGB Gray{ 0.5f,0.5f,0.5f };
 }
\ No newline at end of file
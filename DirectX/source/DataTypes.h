@@ -1,4 +1,8 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
 #include "Math.h"
 #include "vector"
 
@@ -9,10 +13,26 @@ struct Vertex
 	///ColorRGB color{colors::White};
 	Vector2 uv{}; //W2
 	Vector3 normal{}; //W4
-	Vector3 tangent{}; //W4
+	Vector4 tangent{}; //xyz tangent, w bitangent sign: bitangent = cross(normal, tangent.xyz) * w
 	///Vector3 viewDirection{}; //W4
 };
 
+//20-byte alternative to Vertex for meshes whose draws are bound by vertex fetch (VertexPacking.h).
+//Position as 16-bit UNORM inside the mesh bounds (w unused), uv as halfs, normal and tangent as one unit quaternion
+//(QTangent) in 16-bit SNORM whose w sign is the bitangent sign.
+struct PackedVertex
+{
+	uint16_t position[4]{};
+	uint16_t uv[2]{};
+	int16_t frame[4]{};
+};
+
+//Position only, for passes that don't shade
+struct PositionVertex
+{
+	Vector3 position{};
+};
+
 struct Vertex_Out
 {
 	Vector4 position{};
@@ -28,3 +48,278 @@ enum class PrimitiveTopology
 	TriangleList,
 	TriangleStrip
 };
+
+enum class VertexSemantic : uint8_t
+{
+	Position,
+	TexCoord,
+	Normal,
+	Tangent,
+	TangentFrame	//quaternion rotating x to the tangent and z to the normal
+};
+
+enum class VertexComponentType : uint8_t
+{
+	Float32,
+	Float16,
+	UNorm16,
+	SNorm16
+};
+
+//One attribute of a vertex format, laid out as it is stored in .mesh files
+struct VertexAttribute
+{
+	VertexSemantic semantic{};
+	VertexComponentType componentType{};
+	uint8_t componentCount{};
+	uint8_t reserved{};
+	uint32_t offset{};
+
+	bool operator==(const VertexAttribute& other) const = default;
+};
+
+constexpr uint32_t GetComponentSize(VertexComponentType type)
+{
+	return type == VertexComponentType::Float32 ? 4 : 2;
+}
+
+//Compile-time description of a vertex struct: specialize it with a static constexpr attributes table in offset order.
+//VertexLayout.h turns the table into the D3D11 input layout, .mesh files store it to say what their vertex blob holds.
+template<typename VertexType>
+struct VertexFormat;
+
+//True when the attributes cover VertexType exactly: in offset order, aligned to their components, without gaps or overlaps.
+//Offsets come from offsetof, so this is what catches an attribute declared with the wrong type or component count.
+template<typename VertexType>
+consteval bool CoversVertex(std::span<const VertexAttribute> attributes)
+{
+	uint32_t offset{ 0 };
+	for (const VertexAttribute& attribute : attributes)
+	{
+		const uint32_t componentSize = GetComponentSize(attribute.componentType);
+		if (attribute.offset != offset || attribute.offset % componentSize != 0 || attribute.componentCount == 0 || attribute.componentCount > 4)
+			return false;
+		offset += componentSize * attribute.componentCount;
+	}
+	return offset == sizeof(VertexType);
+}
+
+template<>
+struct VertexFormat<Vertex>
+{
+	static constexpr VertexAttribute attributes[]
+	{
+		{ VertexSemantic::Position, VertexComponentType::Float32, 3, 0, offsetof(Vertex, position) },
+		{ VertexSemantic::TexCoord, VertexComponentType::Float32, 2, 0, offsetof(Vertex, uv) },
+		{ VertexSemantic::Normal, VertexComponentType::Float32, 3, 0, offsetof(Vertex, normal) },
+		{ VertexSemantic::Tangent, VertexComponentType::Float32, 4, 0, offsetof(Vertex, tangent) }
+	};
+};
+static_assert(CoversVertex<Vertex>(VertexFormat<Vertex>::attributes));
+
+template<>
+struct VertexFormat<PackedVertex>
+{
+	static constexpr VertexAttribute attributes[]
+	{
+		{ VertexSemantic::Position, VertexComponentType::UNorm16, 4, 0, offsetof(PackedVertex, position) },
+		{ VertexSemantic::TexCoord, VertexComponentType::Float16, 2, 0, offsetof(PackedVertex, uv) },
+		{ VertexSemantic::TangentFrame, VertexComponentType::SNorm16, 4, 0, offsetof(PackedVertex, frame) }
+	};
+};
+static_assert(CoversVertex<PackedVertex>(VertexFormat<PackedVertex>::attributes));
+
+template<>
+struct VertexFormat<PositionVertex>
+{
+	static constexpr VertexAttribute attributes[]
+	{
+		{ VertexSemantic::Position, VertexComponentType::Float32, 3, 0, offsetof(PositionVertex, position) }
+	};
+};
+static_assert(CoversVertex<PositionVertex>(VertexFormat<PositionVertex>::attributes));
+
+//The vertex formats Mesh can draw and .mesh files may contain
+template<typename... VertexTypes>
+struct VertexFormatList
+{
+	//Calls visitor.template operator()<VertexType>() for each format in turn until one returns true
+	template<typename Visitor>
+	static constexpr bool Find(Visitor&& visitor)
+	{
+		return (visitor.template operator()<VertexTypes>() || ...);
+	}
+};
+using VertexFormats = VertexFormatList<Vertex, PackedVertex, PositionVertex>;
+
+//A range of the index buffer drawn on its own
+struct Submesh
+{
+	uint32_t firstIndex{};
+	uint32_t indexCount{};
+	int32_t baseVertex{};
+	uint32_t materialIndex{};
+	AABB bounds{};
+};
+
+//A level of detail: its own run of submeshes over the vertices all levels share (MeshSimplifier.h), LOD 0 first
+struct MeshLOD
+{
+	uint32_t firstSubmesh{};
+	uint32_t submeshCount{};
+	float error{};	//how far its surface may be from LOD 0's, in mesh units
+	uint32_t reserved{};
+};
+
+//The coarsest LOD whose error covers at most maxPixelError pixels at pixelsPerUnit (Camera::GetPixelsPerUnit)
+inline size_t SelectLOD(std::span<const MeshLOD> lods, float pixelsPerUnit, float maxPixelError)
+{
+	size_t selected{ 0 };
+	for (size_t lod{ 1 }; lod < lods.size(); ++lod)
+	{
+		if (lods[lod].error * pixelsPerUnit <= maxPixelError)
+			selected = lod;
+	}
+	return selected;
+}
+
+//Up to Meshlets::maxVertices vertices and Meshlets::maxTriangles triangles, consecutive in the index buffer, with what
+//culling needs (Meshlets.h). Positions are the mesh's own, not the world's.
+struct Meshlet
+{
+	uint32_t firstIndex{};
+	uint32_t triangleCount{};
+	//Its vertices in MeshView::meshletVertices, as the index buffer stores them (relative to the submesh's base vertex)
+	uint32_t firstVertex{};
+	uint32_t vertexCount{};
+	BoundingSphere bounds{};
+	//Every triangle faces away from a camera at c when dot(normalize(coneApex - c), coneAxis) >= coneCutoff;
+	//a cutoff of 1 (normals spread too far) never culls
+	Vector3 coneApex{};
+	float coneCutoff{ 1.f };
+	Vector3 coneAxis{};
+	uint32_t reserved{};
+};
+
+//Mesh data in memory owned by someone else: the vectors of an import, or a mapped .mesh file.
+//Mesh uploads straight from these pointers.
+struct MeshView
+{
+	std::span<const VertexAttribute> attributes{};
+	uint32_t vertexStride{};
+	uint32_t vertexCount{};
+	const void* pVertices{};
+
+	uint32_t indexSize{ sizeof(uint32_t) };	//2 or 4 bytes
+	uint32_t indexCount{};
+	const void* pIndices{};
+
+	std::span<const Submesh> submeshes{};	//empty: all indices are one submesh
+	std::span<const MeshLOD> lods{};		//empty: all submeshes are LOD 0
+	//Empty, or covering every submesh's triangles in index buffer order. meshletTriangles holds indexCount bytes:
+	//each corner's index into its meshlet's vertices.
+	std::span<const Meshlet> meshlets{};
+	std::span<const uint32_t> meshletVertices{};
+	std::span<const uint8_t> meshletTriangles{};
+	AABB bounds{};
+
+	//For formats with a float position (Vertex, PositionVertex), the bounds are computed from it
+	template<typename VertexType, typename Index>
+	static MeshView FromVertices(const std::vector<VertexType>& vertices, const std::vector<Index>& indices, std::span<const Submesh> submeshes = {},
+		std::span<const MeshLOD> lods = {})
+	{
+		static_assert(std::is_same_v<Index, uint16_t> || std::is_same_v<Index, uint32_t>, "index buffers are 16 or 32 bit");
+
+		MeshView view{};
+		view.attributes = VertexFormat<VertexType>::attributes;
+		view.vertexStride = sizeof(VertexType);
+		view.vertexCount = static_cast<uint32_t>(vertices.size());
+		view.pVertices = vertices.data();
+		view.indexSize = sizeof(Index);
+		view.indexCount = static_cast<uint32_t>(indices.size());
+		view.pIndices = indices.data();
+		view.submeshes = submeshes;
+		view.lods = lods;
+		if (!vertices.empty())
+			view.bounds = AABB::FromPoints(&vertices[0].position, sizeof(VertexType), vertices.size());
+		return view;
+	}
+
+	//bounds have to be the ones the positions were quantized to, they are what Mesh dequantizes with
+	template<typename Index>
+	static MeshView FromPackedVertices(const std::vector<PackedVertex>& vertices, const AABB& bounds, const std::vector<Index>& indices, std::span<const Submesh> submeshes = {},
+		std::span<const MeshLOD> lods = {})
+	{
+		static_assert(std::is_same_v<Index, uint16_t> || std::is_same_v<Index, uint32_t>, "index buffers are 16 or 32 bit");
+
+		MeshView view{};
+		view.attributes = VertexFormat<PackedVertex>::attributes;
+		view.vertexStride = sizeof(PackedVertex);
+		view.vertexCount = static_cast<uint32_t>(vertices.size());
+		view.pVertices = vertices.data();
+		view.indexSize = sizeof(Index);
+		view.indexCount = static_cast<uint32_t>(indices.size());
+		view.pIndices = indices.data();
+		view.submeshes = submeshes;
+		view.lods = lods;
+		view.bounds = bounds;
+		return view;
+	}
+};
+
+//How a texture's texels are stored. The BC formats hold 4x4 blocks of 8 (BC1, BC4) or 16 bytes (BC5, BC7)
+//(BlockCompression.h).
+enum class TextureFormat : uint32_t
+{
+	RGBA8,
+	BC1,	//rgb, 4 bits per texel
+	BC4,	//one channel, 4 bits per texel
+	BC5,	//two channels, 8 bits per texel
+	BC7		//rgba, 8 bits per texel
+};
+
+inline bool IsBlockCompressed(TextureFormat format) { return format != TextureFormat::RGBA8; }
+
+inline const char* GetTextureFormatName(TextureFormat format)
+{
+	constexpr const char* names[]{ "RGBA8", "BC1", "BC4", "BC5", "BC7" };
+	return names[static_cast<uint32_t>(format)];
+}
+
+//Bytes per texel for RGBA8, per 4x4 block for the BC formats
+inline uint32_t GetTexelBlockSize(TextureFormat format)
+{
+	return format == TextureFormat::BC1 || format == TextureFormat::BC4 ? 8 : format == TextureFormat::RGBA8 ? 4 : 16;
+}
+
+//One mip level; its rows (of texels or of blocks) have no padding
+struct TextureLevel
+{
+	uint32_t width{};
+	uint32_t height{};
+	uint64_t offset{};
+};
+
+//Bytes of one row of texels, or of blocks for the BC formats
+inline uint32_t GetTextureRowPitch(TextureFormat format, uint32_t width)
+{
+	return IsBlockCompressed(format) ? (width + 3) / 4 * GetTexelBlockSize(format) : width * GetTexelBlockSize(format);
+}
+
+inline uint64_t GetTextureLevelSize(TextureFormat format, uint32_t width, uint32_t height)
+{
+	return uint64_t(GetTextureRowPitch(format, width)) * (IsBlockCompressed(format) ? (height + 3) / 4 : height);
+}
+
+//Texture data in memory owned by someone else: a generated mip chain, an encoder's output or a mapped cooked file.
+//Texture uploads straight from these pointers, largest level first.
+struct TextureView
+{
+	TextureFormat format{ TextureFormat::RGBA8 };
+	std::span<const TextureLevel> levels{};
+	const uint8_t* pData{};
+
+	const uint8_t* GetLevelData(size_t level) const { return pData + levels[level].offset; }
+	uint32_t GetRowPitch(size_t level) const { return GetTextureRowPitch(format, levels[level].width); }
+	uint64_t GetLevelSize(size_t level) const { return GetTextureLevelSize(format, levels[level].width, levels[level].height); }
+};
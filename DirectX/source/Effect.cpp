@@ -25,16 +25,22 @@ Effect::Effect(ID3D11Device* pDevice, const std::wstring& assetFile)
 		std::wcout << L"m_pNormalMapVariable not valid!\n";
 	}
 
-	m_pSpecularMapVariable = m_pEffect->GetVariableByName("gSpecularMap")->AsShaderResource();
-	if (!m_pSpecularMapVariable->IsValid())
+	m_pSurfaceMapVariable = m_pEffect->GetVariableByName("gSurfaceMap")->AsShaderResource();
+	if (!m_pSurfaceMapVariable->IsValid())
 	{
-		std::wcout << L"m_pSpecularMapVariable not valid!\n";
+		std::wcout << L"m_pSurfaceMapVariable not valid!\n";
 	}
 
-	m_pGlossinessMapVariable = m_pEffect->GetVariableByName("gGlossinessMap")->AsShaderResource();
-	if (!m_pGlossinessMapVariable->IsValid())
+	m_pSpecularChannelVariable = m_pEffect->GetVariableByName("gSpecularChannel")->AsVector();
+	if (!m_pSpecularChannelVariable->IsValid())
 	{
-		std::wcout << L"m_pGlossinessMapVariable not valid!\n";
+		std::wcout << L"m_pSpecularChannelVariable not valid!\n";
+	}
+
+	m_pGlossinessChannelVariable = m_pEffect->GetVariableByName("gGlossinessChannel")->AsVector();
+	if (!m_pGlossinessChannelVariable->IsValid())
+	{
+		std::wcout << L"m_pGlossinessChannelVariable not valid!\n";
 	}
 
 	m_pMatWorldViewProjVariable = m_pEffect->GetVariableByName("gWorldViewProj")->AsMatrix();
@@ -55,6 +61,18 @@ Effect::Effect(ID3D11Device* pDevice, const std::wstring& assetFile)
 		std::wcout << L"m_pWorldVariable not valid!\n";
 	}
 
+	m_pPositionOffsetVariable = m_pEffect->GetVariableByName("gPositionOffset")->AsVector();
+	if (!m_pPositionOffsetVariable->IsValid())
+	{
+		std::wcout << L"m_pPositionOffsetVariable not valid!\n";
+	}
+
+	m_pPositionScaleVariable = m_pEffect->GetVariableByName("gPositionScale")->AsVector();
+	if (!m_pPositionScaleVariable->IsValid())
+	{
+		std::wcout << L"m_pPositionScaleVariable not valid!\n";
+	}
+
 }
 
 Effect::~Effect()
@@ -139,7 +157,13 @@ void Effect::SetWorldMatrix(const Matrix& worldMatrix)
 
 void Effect::SetInvViewMatrix(const Matrix& invMatrix)
 {
-	m_pWorldVariable->SetMatrix(reinterpret_cast<const float*>(&invMatrix));
+	m_pViewInverseVariable->SetMatrix(reinterpret_cast<const float*>(&invMatrix));
+}
+
+void Effect::SetPositionDequantization(const Vector3& offset, const Vector3& scale)
+{
+	m_pPositionOffsetVariable->SetFloatVector(reinterpret_cast<const float*>(&offset));
+	m_pPositionScaleVariable->SetFloatVector(reinterpret_cast<const float*>(&scale));
 }
 
 void Effect::SetDiffuseMap(Texture* pDiffuseTexture)
@@ -158,38 +182,53 @@ void Effect::SetNormalMap(Texture* pNormalTexture)
 	}
 }
 
-void Effect::SetSpecularMap(Texture* pSpecularTexture)
+void Effect::SetSurfaceMap(Texture* pSurfaceTexture, uint32_t specularChannel, uint32_t glossinessChannel)
 {
-	if (m_pSpecularMapVariable)
+	if (m_pSurfaceMapVariable)
 	{
-		m_pSpecularMapVariable->SetResource(pSpecularTexture->GetShaderResourceView());
+		m_pSurfaceMapVariable->SetResource(pSurfaceTexture->GetShaderResourceView());
 	}
-}
 
-void Effect::SetGlossingessMap(Texture* pGlossinessTexture)
-{
-	if (m_pGlossinessMapVariable)
-	{
-		m_pGlossinessMapVariable->SetResource(pGlossinessTexture->GetShaderResourceView());
-	}
+	//The shader picks a channel with a dot product against a one-hot mask
+	float specularMask[4]{};
+	float glossinessMask[4]{};
+	specularMask[specularChannel] = 1.f;
+	glossinessMask[glossinessChannel] = 1.f;
+	m_pSpecularChannelVariable->SetFloatVector(specularMask);
+	m_pGlossinessChannelVariable->SetFloatVector(glossinessMask);
 }
 
 void Effect::SetFilterMode(FilterMode mode)
 {
+	//Per vertex input, per filter mode. Position-only drawing doesn't sample textures, so it has one technique.
+	static constexpr const char* techniqueNames[][3]
+	{
+		{ "PointFilterTechnique", "LinearFilterTechnique", "AnisotropicFilterTechnique" },
+		{ "PointFilterPackedTechnique", "LinearFilterPackedTechnique", "AnisotropicFilterPackedTechnique" },
+		{ "PositionOnlyTechnique", "PositionOnlyTechnique", "PositionOnlyTechnique" }
+	};
+
+	m_FilterMode = mode;
 	switch (mode)
 	{
 	case Effect::Point:
-		m_pTechnique = m_pEffect->GetTechniqueByName("PointFilterTechnique");
+		m_pTechnique = m_pEffect->GetTechniqueByName(techniqueNames[static_cast<int>(m_VertexInput)][Point]);
 		if (!m_pTechnique->IsValid()) std::wcout << L"PointTechnique not valid\n";
 		break;
 	case Effect::Linear:
-		m_pTechnique = m_pEffect->GetTechniqueByName("LinearFilterTechnique");
+		m_pTechnique = m_pEffect->GetTechniqueByName(techniqueNames[static_cast<int>(m_VertexInput)][Linear]);
 		if (!m_pTechnique->IsValid()) std::wcout << L"LinearTechnique not valid\n";
 		break;
 	case Effect::Anisotropic:
-		m_pTechnique = m_pEffect->GetTechniqueByName("AnisotropicFilterTechnique");
+		m_pTechnique = m_pEffect->GetTechniqueByName(techniqueNames[static_cast<int>(m_VertexInput)][Anisotropic]);
 		if (!m_pTechnique->IsValid()) std::wcout << L"AnisotropicTechnique not valid\n";
 		break;
 	}
 
 }
+
+void Effect::SetVertexInput(VertexInput input)
+{
+	m_VertexInput = input;
+	SetFilterMode(m_FilterMode);
+}
@@ -20,11 +20,14 @@ public:
 	void SetWorldViewProjectionMatrix(const Matrix& worldViewProj);
 	void SetWorldMatrix(const Matrix& worldMatrix);
 	void SetInvViewMatrix(const Matrix& invMatrix);
+	//Maps the [0, 1] positions of packed vertices to object space: offset + position * scale
+	void SetPositionDequantization(const Vector3& offset, const Vector3& scale);
 //-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 	void SetDiffuseMap(Texture* pDiffuseTexture);
 	void SetNormalMap(Texture* pNormalTexture);
-	void SetSpecularMap(Texture* pSpecularTexture);
-	void SetGlossingessMap(Texture* pGlossinessTexture);
+	//Specular intensity and glossiness packed in one texture, each in the given channel (the same one when both maps hold
+	//the same texels)
+	void SetSurfaceMap(Texture* pSurfaceTexture, uint32_t specularChannel, uint32_t glossinessChannel);
 
 
 
@@ -33,10 +36,21 @@ public:
 	};
 	FilterMode m_CurrentFilterMode;
 	void SetFilterMode(FilterMode mode);
+	//Which vertex struct the techniques' vertex shader reads
+	enum class VertexInput
+	{
+		Full,			//Vertex
+		Packed,			//PackedVertex
+		PositionOnly	//PositionVertex, flat shaded
+	};
+	//Switches to the techniques for this vertex input, keeping the filter mode
+	void SetVertexInput(VertexInput input);
 
 private:
 	ID3DX11Effect* m_pEffect{};
 	ID3DX11EffectTechnique* m_pTechnique{};
+	FilterMode m_FilterMode{ Point };
+	VertexInput m_VertexInput{ VertexInput::Full };
 //-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //
 // D3DX11MatrixVariables
@@ -45,6 +59,10 @@ private:
 	ID3DX11EffectMatrixVariable* m_pMatWorldViewProjVariable{};
 	ID3DX11EffectMatrixVariable* m_pViewInverseVariable{};
 	ID3DX11EffectMatrixVariable* m_pWorldVariable{};
+	ID3DX11EffectVectorVariable* m_pPositionOffsetVariable{};
+	ID3DX11EffectVectorVariable* m_pPositionScaleVariable{};
+	ID3DX11EffectVectorVariable* m_pSpecularChannelVariable{};
+	ID3DX11EffectVectorVariable* m_pGlossinessChannelVariable{};
 //-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 
 //-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
@@ -54,8 +72,7 @@ private:
 //-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 	ID3DX11EffectShaderResourceVariable* m_pDiffuseMapVariable{};
 	ID3DX11EffectShaderResourceVariable* m_pNormalMapVariable{};
-	ID3DX11EffectShaderResourceVariable* m_pSpecularMapVariable{};
-	ID3DX11EffectShaderResourceVariable* m_pGlossinessMapVariable{};
+	ID3DX11EffectShaderResourceVariable* m_pSurfaceMapVariable{};
 
 //-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 	static ID3DX11Effect* LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile);
@@ -0,0 +1,1287 @@
+#include "pch.h"
+#include "FBXImport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "TangentSpace.h"
+#include "Zlib.h"
+
+namespace
+{
+	constexpr uint32_t noIndex{ UINT32_MAX };
+
+	//"Kaydara FBX Binary  \0", 0x1A, 0x00 and the version
+	constexpr char magic[]{ "Kaydara FBX Binary  " };
+	constexpr size_t headerSize{ 27 };
+	constexpr uint32_t minVersion{ 7100 };
+	//From 7500 on node records use 64-bit offsets and counts
+	constexpr uint32_t firstWideVersion{ 7500 };
+	//Deeper nesting than any exporter writes means a corrupt file
+	constexpr uint32_t maxDepth{ 32 };
+
+	template<typename T>
+	inline T ReadValue(const char* p)
+	{
+		T value;
+		std::memcpy(&value, p, sizeof(T));
+		return value;
+	}
+
+	struct Node
+	{
+		std::string_view name{};
+		const char* pProperties{};
+		const char* pPropertiesEnd{};
+		uint64_t propertyCount{};
+		uint32_t firstChild{ noIndex };
+		uint32_t nextSibling{ noIndex };
+	};
+
+	struct Property
+	{
+		char type{};
+		const char* pData{};		//the value, the string's bytes or the array's (compressed) bytes
+		uint32_t size{};			//bytes at pData for strings, raw data and arrays
+		uint32_t count{};			//array elements
+		bool isCompressed{};
+	};
+
+	//Bytes per array element, 0 for types that aren't arrays
+	inline uint32_t GetElementSize(char type)
+	{
+		switch (type)
+		{
+		case 'b': return 1;
+		case 'i': case 'f': return 4;
+		case 'l': case 'd': return 8;
+		}
+		return 0;
+	}
+
+	//Reads a node's properties in order
+	class PropertyReader final
+	{
+	public:
+		explicit PropertyReader(const Node& node)
+			: m_p{ node.pProperties }, m_pEnd{ node.pPropertiesEnd }, m_Remaining{ node.propertyCount }
+		{
+		}
+
+		//False after the last property and for malformed ones
+		bool Next(Property& property)
+		{
+			if (m_Remaining == 0 || m_p >= m_pEnd)
+				return false;
+			--m_Remaining;
+
+			property = {};
+			property.type = *m_p++;
+			const size_t available = static_cast<size_t>(m_pEnd - m_p);
+			switch (property.type)
+			{
+			case 'C': property.size = 1; break;
+			case 'Y': property.size = 2; break;
+			case 'I': case 'F': property.size = 4; break;
+			case 'L': case 'D': property.size = 8; break;
+			case 'S': case 'R':
+				if (available < 4)
+					return false;
+				property.size = ReadValue<uint32_t>(m_p);
+				m_p += 4;
+				break;
+			case 'b': case 'i': case 'f': case 'l': case 'd':
+			{
+				if (available < 12)
+					return false;
+				property.count = ReadValue<uint32_t>(m_p);
+				const uint32_t encoding = ReadValue<uint32_t>(m_p + 4);
+				property.size = ReadValue<uint32_t>(m_p + 8);
+				property.isCompressed = encoding == 1;
+				m_p += 12;
+				if (encoding > 1 || (!property.isCompressed && uint64_t(property.count) * GetElementSize(property.type) != property.size))
+					return false;
+				break;
+			}
+			default:
+				return false;
+			}
+
+			if (property.size > static_cast<size_t>(m_pEnd - m_p))
+				return false;
+			property.pData = m_p;
+			m_p += property.size;
+			return true;
+		}
+
+	private:
+		const char* m_p;
+		const char* m_pEnd;
+		uint64_t m_Remaining;
+	};
+
+	Property GetProperty(const Node& node, uint32_t index)
+	{
+		PropertyReader reader{ node };
+		Property property{};
+		for (uint32_t i{ 0 }; i <= index; ++i)
+		{
+			if (!reader.Next(property))
+				return {};
+		}
+		return property;
+	}
+
+	int64_t ToInteger(const Property& property)
+	{
+		switch (property.type)
+		{
+		case 'C': return ReadValue<uint8_t>(property.pData);
+		case 'Y': return ReadValue<int16_t>(property.pData);
+		case 'I': return ReadValue<int32_t>(property.pData);
+		case 'L': return ReadValue<int64_t>(property.pData);
+		case 'F': return static_cast<int64_t>(ReadValue<float>(property.pData));
+		case 'D': return static_cast<int64_t>(ReadValue<double>(property.pData));
+		}
+		return 0;
+	}
+
+	double ToReal(const Property& property)
+	{
+		switch (property.type)
+		{
+		case 'F': return ReadValue<float>(property.pData);
+		case 'D': return ReadValue<double>(property.pData);
+		}
+		return static_cast<double>(ToInteger(property));
+	}
+
+	std::string_view ToString(const Property& property)
+	{
+		return property.type == 'S' || property.type == 'R' ? std::string_view{ property.pData, property.size } : std::string_view{};
+	}
+
+	//Object names are stored as "Name\x00\x01Class"
+	std::string_view GetObjectName(const Node& node)
+	{
+		const std::string_view name = ToString(GetProperty(node, 1));
+		return name.substr(0, name.find(std::string_view{ "\x00\x01", 2 }));
+	}
+
+	//The node records of the whole file, pointing into the mapping
+	class NodeTree final
+	{
+	public:
+		bool Parse(const char* pData, size_t size, uint32_t version)
+		{
+			m_pData = pData;
+			m_pFileEnd = pData + size;
+			m_IsWide = version >= firstWideVersion;
+			m_Nodes.reserve(size / 64);
+
+			const char* p = pData + headerSize;
+			return ParseSiblings(p, m_pFileEnd, 0, m_FirstRoot);
+		}
+
+		const Node& operator[](uint32_t index) const { return m_Nodes[index]; }
+
+		//The first child called name, noIndex for none. noIndex as parent searches the top level.
+		uint32_t FindChild(uint32_t parent, std::string_view name) const
+		{
+			for (uint32_t child = GetFirstChild(parent); child != noIndex; child = m_Nodes[child].nextSibling)
+			{
+				if (m_Nodes[child].name == name)
+					return child;
+			}
+			return noIndex;
+		}
+
+		uint32_t GetFirstChild(uint32_t parent) const { return parent == noIndex ? m_FirstRoot : m_Nodes[parent].firstChild; }
+
+	private:
+		std::vector<Node> m_Nodes{};
+		const char* m_pData{};
+		const char* m_pFileEnd{};
+		uint32_t m_FirstRoot{ noIndex };
+		bool m_IsWide{};
+
+		//Reads records until pEnd or the null record ending the list and links them as siblings
+		bool ParseSiblings(const char*& p, const char* pEnd, uint32_t depth, uint32_t& first)
+		{
+			if (depth > maxDepth)
+				return false;
+
+			const size_t recordHeaderSize = m_IsWide ? 25 : 13;
+			uint32_t previous{ noIndex };
+			while (static_cast<size_t>(pEnd - p) >= recordHeaderSize)
+			{
+				const uint64_t endOffset = m_IsWide ? ReadValue<uint64_t>(p) : ReadValue<uint32_t>(p);
+				const uint64_t propertyCount = m_IsWide ? ReadValue<uint64_t>(p + 8) : ReadValue<uint32_t>(p + 4);
+				const uint64_t propertyBytes = m_IsWide ? ReadValue<uint64_t>(p + 16) : ReadValue<uint32_t>(p + 8);
+				const uint8_t nameLength = ReadValue<uint8_t>(p + recordHeaderSize - 1);
+				if (endOffset == 0)
+				{
+					p += recordHeaderSize;
+					return true;
+				}
+
+				const char* const pRecordEnd = m_pData + endOffset;
+				const char* const pName = p + recordHeaderSize;
+				if (endOffset > static_cast<uint64_t>(pEnd - m_pData) || pRecordEnd < pName || nameLength > pRecordEnd - pName
+					|| propertyBytes > static_cast<uint64_t>(pRecordEnd - pName - nameLength))
+					return false;
+
+				const uint32_t index = static_cast<uint32_t>(m_Nodes.size());
+				Node& node = m_Nodes.emplace_back();
+				node.name = { pName, nameLength };
+				node.pProperties = pName + nameLength;
+				node.pPropertiesEnd = node.pProperties + propertyBytes;
+				node.propertyCount = propertyCount;
+
+				if (previous == noIndex)
+					first = index;
+				else
+					m_Nodes[previous].nextSibling = index;
+				previous = index;
+
+				const char* pChildren = node.pPropertiesEnd;
+				uint32_t firstChild{ noIndex };
+				if (pChildren < pRecordEnd && !ParseSiblings(pChildren, pRecordEnd, depth + 1, firstChild))
+					return false;
+				m_Nodes[index].firstChild = firstChild;
+				p = pRecordEnd;
+			}
+			return true;
+		}
+	};
+
+	//An array property decoded into the type the import works with
+	template<typename T>
+	bool DecodeArray(const Property& property, std::vector<T>& values)
+	{
+		const uint32_t elementSize = GetElementSize(property.type);
+		if (elementSize == 0)
+			return false;
+
+		const size_t rawBytes = size_t(property.count) * elementSize;
+		const auto convert = [&]<typename Source>(const char* pRaw)
+			{
+				for (size_t i{ 0 }; i < values.size(); ++i)
+				{
+					values[i] = static_cast<T>(ReadValue<Source>(pRaw + i * sizeof(Source)));
+				}
+			};
+		const auto convertAll = [&](const char* pRaw)
+			{
+				switch (property.type)
+				{
+				case 'b': convert.template operator()<uint8_t>(pRaw); break;
+				case 'i': convert.template operator()<int32_t>(pRaw); break;
+				case 'l': convert.template operator()<int64_t>(pRaw); break;
+				case 'f': convert.template operator()<float>(pRaw); break;
+				case 'd': convert.template operator()<double>(pRaw); break;
+				}
+			};
+
+		values.resize(property.count);
+		const bool isSameType = elementSize == sizeof(T) && (std::is_floating_point_v<T> == (property.type == 'f' || property.type == 'd'));
+		if (!property.isCompressed)
+		{
+			if (isSameType)
+				std::memcpy(values.data(), property.pData, rawBytes);
+			else
+				convertAll(property.pData);
+			return true;
+		}
+
+		const std::span<const uint8_t> input{ reinterpret_cast<const uint8_t*>(property.pData), property.size };
+		if (isSameType)
+			return Zlib::Inflate(input, { reinterpret_cast<uint8_t*>(values.data()), rawBytes });
+
+		std::vector<uint8_t> raw(rawBytes);
+		if (!Zlib::Inflate(input, raw))
+			return false;
+		convertAll(reinterpret_cast<const char*>(raw.data()));
+		return true;
+	}
+
+	//An array to decode and where to. Reals and integers are the only two types the import needs.
+	struct ArrayJob
+	{
+		Property property{};
+		std::vector<double>* pReals{};
+		std::vector<int32_t>* pIntegers{};
+		bool isDecoded{};
+	};
+
+	//Column-vector affine transform in double precision, like the file's values: p' = linear * p + translation
+	struct Transform
+	{
+		double linear[3][3]{ { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+		double translation[3]{};
+
+		//This after other
+		Transform operator*(const Transform& other) const
+		{
+			Transform result{};
+			for (int row{ 0 }; row < 3; ++row)
+			{
+				for (int column{ 0 }; column < 3; ++column)
+				{
+					result.linear[row][column] = linear[row][0] * other.linear[0][column] + linear[row][1] * other.linear[1][column] + linear[row][2] * other.linear[2][column];
+				}
+				result.translation[row] = linear[row][0] * other.translation[0] + linear[row][1] * other.translation[1] + linear[row][2] * other.translation[2] + translation[row];
+			}
+			return result;
+		}
+
+		Vector3 TransformVector(const double* v) const
+		{
+			return {
+				static_cast<float>(linear[0][0] * v[0] + linear[0][1] * v[1] + linear[0][2] * v[2]),
+				static_cast<float>(linear[1][0] * v[0] + linear[1][1] * v[1] + linear[1][2] * v[2]),
+				static_cast<float>(linear[2][0] * v[0] + linear[2][1] * v[1] + linear[2][2] * v[2]) };
+		}
+
+		Vector3 TransformPoint(const double* p) const
+		{
+			const Vector3 v = TransformVector(p);
+			return { v.x + static_cast<float>(translation[0]), v.y + static_cast<float>(translation[1]), v.z + static_cast<float>(translation[2]) };
+		}
+
+		double GetDeterminant() const
+		{
+			return linear[0][0] * (linear[1][1] * linear[2][2] - linear[1][2] * linear[2][1])
+				- linear[0][1] * (linear[1][0] * linear[2][2] - linear[1][2] * linear[2][0])
+				+ linear[0][2] * (linear[1][0] * linear[2][1] - linear[1][1] * linear[2][0]);
+		}
+
+		bool IsIdentity() const
+		{
+			const Transform identity{};
+			return std::equal(&linear[0][0], &linear[0][0] + 9, &identity.linear[0][0]) && std::equal(translation, translation + 3, identity.translation);
+		}
+
+		//Rotations and mirrors keep unit vectors unit, so their normals and tangents are passed on as the file stores them
+		bool IsOrthonormal() const
+		{
+			for (int row{ 0 }; row < 3; ++row)
+			{
+				for (int other{ 0 }; other < 3; ++other)
+				{
+					const double dot = linear[row][0] * linear[other][0] + linear[row][1] * linear[other][1] + linear[row][2] * linear[other][2];
+					if (std::abs(dot - (row == other ? 1.0 : 0.0)) > 1e-9)
+						return false;
+				}
+			}
+			return true;
+		}
+
+		//Cofactor matrix: transforms normals for any invertible linear part, up to a positive scale for positive determinants
+		Transform GetNormalTransform() const
+		{
+			Transform result{};
+			for (int row{ 0 }; row < 3; ++row)
+			{
+				for (int column{ 0 }; column < 3; ++column)
+				{
+					const int r0 = (row + 1) % 3, r1 = (row + 2) % 3, c0 = (column + 1) % 3, c1 = (column + 2) % 3;
+					result.linear[row][column] = linear[r0][c0] * linear[r1][c1] - linear[r0][c1] * linear[r1][c0];
+				}
+			}
+			return result;
+		}
+
+		static Transform CreateTranslation(const double* t)
+		{
+			Transform result{};
+			std::copy_n(t, 3, result.translation);
+			return result;
+		}
+
+		static Transform CreateScale(const double* s)
+		{
+			Transform result{};
+			for (int i{ 0 }; i < 3; ++i)
+				result.linear[i][i] = s[i];
+			return result;
+		}
+
+		//Right-handed rotation about one axis, in degrees like the file stores them
+		static Transform CreateRotation(int axis, double degrees)
+		{
+			const double radians = degrees * 3.14159265358979323846 / 180.0;
+			const double c = std::cos(radians), s = std::sin(radians);
+			const int a = (axis + 1) % 3, b = (axis + 2) % 3;
+			Transform result{};
+			result.linear[a][a] = c;
+			result.linear[a][b] = -s;
+			result.linear[b][a] = s;
+			result.linear[b][b] = c;
+			return result;
+		}
+
+		//Euler angles applied in the order FbxEuler::EOrder names them (0: XYZ, x first)
+		static Transform CreateEuler(const double* degrees, int64_t order)
+		{
+			constexpr int axisOrders[6][3]{ { 0, 1, 2 }, { 0, 2, 1 }, { 1, 2, 0 }, { 1, 0, 2 }, { 2, 0, 1 }, { 2, 1, 0 } };
+			const int* pAxes = axisOrders[order >= 0 && order < 6 ? order : 0];
+			Transform result{};
+			for (int i{ 0 }; i < 3; ++i)
+			{
+				result = CreateRotation(pAxes[i], degrees[pAxes[i]]) * result;
+			}
+			return result;
+		}
+	};
+
+	//The P entries of a Properties70 block: name, type, label, flags, values...
+	struct Properties70
+	{
+		const NodeTree& tree;
+		uint32_t block;
+
+		uint32_t Find(std::string_view name) const
+		{
+			if (block == noIndex)
+				return noIndex;
+			for (uint32_t child = tree.GetFirstChild(block); child != noIndex; child = tree[child].nextSibling)
+			{
+				if (tree[child].name == "P" && ToString(GetProperty(tree[child], 0)) == name)
+					return child;
+			}
+			return noIndex;
+		}
+
+		int64_t GetInteger(std::string_view name, int64_t fallback) const
+		{
+			const uint32_t entry = Find(name);
+			return entry == noIndex ? fallback : ToInteger(GetProperty(tree[entry], 4));
+		}
+
+		void GetVector(std::string_view name, double* pValues, double fallback) const
+		{
+			const uint32_t entry = Find(name);
+			for (uint32_t i{ 0 }; i < 3; ++i)
+			{
+				const Property property = entry == noIndex ? Property{} : GetProperty(tree[entry], 4 + i);
+				pValues[i] = property.pData ? ToReal(property) : fallback;
+			}
+		}
+	};
+
+	enum class Mapping
+	{
+		ByPolygonVertex,
+		ByControlPoint,
+		ByPolygon,
+		AllSame,
+		Unsupported
+	};
+
+	Mapping GetMapping(std::string_view name)
+	{
+		if (name == "ByPolygonVertex") return Mapping::ByPolygonVertex;
+		if (name == "ByControlPoint" || name == "ByVertice" || name == "ByVertex") return Mapping::ByControlPoint;
+		if (name == "ByPolygon") return Mapping::ByPolygon;
+		if (name == "AllSame") return Mapping::AllSame;
+		return Mapping::Unsupported;
+	}
+
+	//A LayerElementNormal/UV/Tangent/Binormal/Material: per corner, control point, polygon or one for all,
+	//directly or through an index array
+	struct LayerElement
+	{
+		bool isPresent{};
+		Mapping mapping{};
+		bool isIndexed{};
+		std::vector<double> values{};
+		std::vector<int32_t> indices{};
+		uint32_t componentCount{};
+
+		//The element a corner uses, noIndex when out of range
+		uint32_t Resolve(size_t corner, size_t polygon, uint32_t controlPoint) const
+		{
+			size_t index{};
+			switch (mapping)
+			{
+			case Mapping::ByPolygonVertex: index = corner; break;
+			case Mapping::ByControlPoint: index = controlPoint; break;
+			case Mapping::ByPolygon: index = polygon; break;
+			default: index = 0; break;
+			}
+			if (isIndexed)
+			{
+				if (index >= indices.size() || indices[index] < 0)
+					return noIndex;
+				index = static_cast<size_t>(indices[index]);
+			}
+			return index < values.size() / componentCount ? static_cast<uint32_t>(index) : noIndex;
+		}
+	};
+
+	struct Cluster
+	{
+		uint32_t bone{};
+		std::vector<int32_t> controlPoints{};
+		std::vector<double> weights{};
+	};
+
+	struct Geometry
+	{
+		uint32_t node{};
+		Transform transform{};
+		std::vector<uint32_t> materials{};	//the model's material slots, into Scene::materials
+		std::vector<double> positions{};
+		std::vector<int32_t> polygonVertices{};
+		LayerElement normals{}, uvs{}, tangents{}, binormals{};
+		LayerElement materialSlots{};		//integers in values' place, see ReadMaterialLayer
+		std::vector<int32_t> materialValues{};
+		std::vector<Cluster> clusters{};
+	};
+
+	//Open addressing map from a corner's control point and attributes to the vertex it became
+	class VertexMap final
+	{
+	public:
+		explicit VertexMap(size_t expectedCount)
+		{
+			size_t capacity{ 64 };
+			while (capacity < expectedCount * 2) capacity *= 2;
+			m_Slots.assign(capacity, noIndex);
+		}
+
+		uint32_t FindOrAdd(const Vertex& vertex, uint32_t controlPoint, std::vector<Vertex>& vertices, std::vector<uint32_t>& controlPoints)
+		{
+			if ((vertices.size() + 1) * 2 > m_Slots.size())
+				Grow(vertices, controlPoints);
+
+			const size_t mask = m_Slots.size() - 1;
+			for (size_t i = Hash(vertex, controlPoint) & mask; ; i = (i + 1) & mask)
+			{
+				const uint32_t slot = m_Slots[i];
+				if (slot == noIndex)
+				{
+					m_Slots[i] = static_cast<uint32_t>(vertices.size());
+					vertices.push_back(vertex);
+					controlPoints.push_back(controlPoint);
+					return m_Slots[i];
+				}
+				if (controlPoints[slot] == controlPoint && std::memcmp(&vertices[slot], &vertex, sizeof(Vertex)) == 0)
+					return slot;
+			}
+		}
+
+	private:
+		std::vector<uint32_t> m_Slots{};
+
+		static size_t Hash(const Vertex& vertex, uint32_t controlPoint)
+		{
+			uint32_t words[sizeof(Vertex) / sizeof(uint32_t)];
+			std::memcpy(words, &vertex, sizeof(Vertex));
+			uint64_t hash = controlPoint * 0x9E3779B97F4A7C15ull;
+			for (const uint32_t word : words)
+			{
+				hash = (hash ^ word) * 0x100000001B3ull;
+			}
+			return static_cast<size_t>(hash ^ (hash >> 29));
+		}
+
+		void Grow(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& controlPoints)
+		{
+			m_Slots.assign(m_Slots.size() * 2, noIndex);
+			const size_t mask = m_Slots.size() - 1;
+			for (uint32_t vertex{ 0 }; vertex < vertices.size(); ++vertex)
+			{
+				size_t i = Hash(vertices[vertex], controlPoints[vertex]) & mask;
+				while (m_Slots[i] != noIndex) i = (i + 1) & mask;
+				m_Slots[i] = vertex;
+			}
+		}
+	};
+
+	//Everything the import reads from the object graph
+	class SceneReader final
+	{
+	public:
+		explicit SceneReader(const NodeTree& tree)
+			: m_Tree{ tree }
+		{
+		}
+
+		bool Read(const FBX::ImportSettings& settings, FBX::Scene& scene, std::vector<Geometry>& geometries, std::vector<ArrayJob>& jobs)
+		{
+			const uint32_t objects = m_Tree.FindChild(noIndex, "Objects");
+			const uint32_t connections = m_Tree.FindChild(noIndex, "Connections");
+			if (objects == noIndex)
+				return false;
+
+			for (uint32_t child = m_Tree.GetFirstChild(objects); child != noIndex; child = m_Tree[child].nextSibling)
+			{
+				m_Objects.try_emplace(ToInteger(GetProperty(m_Tree[child], 0)), child);
+			}
+			for (uint32_t child = m_Tree.GetFirstChild(connections == noIndex ? objects : connections); connections != noIndex && child != noIndex; child = m_Tree[child].nextSibling)
+			{
+				const Node& node = m_Tree[child];
+				if (node.name != "C")
+					continue;
+				m_Connections.push_back({ ToInteger(GetProperty(node, 1)), ToInteger(GetProperty(node, 2)), ToString(GetProperty(node, 3)) });
+			}
+
+			const Transform axisTransform = GetAxisTransform();
+			for (uint32_t child = m_Tree.GetFirstChild(objects); child != noIndex; child = m_Tree[child].nextSibling)
+			{
+				const Node& node = m_Tree[child];
+				if (node.name != "Geometry" || ToString(GetProperty(node, 2)) != "Mesh")
+					continue;
+
+				Geometry& geometry = geometries.emplace_back();
+				geometry.node = child;
+
+				//The first model using it places it; instancing the same geometry in several models isn't supported
+				const int64_t id = ToInteger(GetProperty(node, 0));
+				const uint32_t model = FindParent(id, "Model");
+				geometry.transform = axisTransform;
+				if (model != noIndex)
+				{
+					geometry.transform = axisTransform * GetGlobalTransform(model) * GetGeometricTransform(model);
+					for (const Connection& connection : m_Connections)
+					{
+						const uint32_t material = connection.parent == ToInteger(GetProperty(m_Tree[model], 0)) ? FindObject(connection.child, "Material") : noIndex;
+						if (material != noIndex)
+							geometry.materials.push_back(AddMaterial(connection.child, material, scene));
+					}
+				}
+
+				if (!ReadGeometry(child, settings, geometry, jobs))
+					return false;
+				if (settings.importSkin)
+					ReadSkin(id, geometry, scene, jobs);
+			}
+			return true;
+		}
+
+	private:
+		struct Connection
+		{
+			int64_t child{};
+			int64_t parent{};
+			std::string_view property{};
+		};
+
+		const NodeTree& m_Tree;
+		std::unordered_map<int64_t, uint32_t> m_Objects{};
+		std::vector<Connection> m_Connections{};
+		std::unordered_map<int64_t, uint32_t> m_Materials{};	//object id -> Scene::materials
+		std::unordered_map<int64_t, uint16_t> m_Bones{};		//model id -> Scene::bones
+
+		//The object node with this id and name (Model, Material, ...), noIndex for anything else
+		uint32_t FindObject(int64_t id, std::string_view name) const
+		{
+			const auto it = m_Objects.find(id);
+			return it != m_Objects.end() && m_Tree[it->second].name == name ? it->second : noIndex;
+		}
+
+		uint32_t FindParent(int64_t child, std::string_view name) const
+		{
+			for (const Connection& connection : m_Connections)
+			{
+				const uint32_t parent = connection.child == child ? FindObject(connection.parent, name) : noIndex;
+				if (parent != noIndex)
+					return parent;
+			}
+			return noIndex;
+		}
+
+		Properties70 GetProperties(uint32_t node) const
+		{
+			return { m_Tree, node == noIndex ? noIndex : m_Tree.FindChild(node, "Properties70") };
+		}
+
+		//GlobalSettings' axes: the coord axis becomes x, up y and front z, so the mesh ends up in the Y up right-handed
+		//space the OBJ import works in
+		Transform GetAxisTransform() const
+		{
+			const Properties70 properties = GetProperties(m_Tree.FindChild(noIndex, "GlobalSettings"));
+			const int64_t axes[3]{ properties.GetInteger("CoordAxis", 0), properties.GetInteger("UpAxis", 1), properties.GetInteger("FrontAxis", 2) };
+			const int64_t signs[3]{ properties.GetInteger("CoordAxisSign", 1), properties.GetInteger("UpAxisSign", 1), properties.GetInteger("FrontAxisSign", 1) };
+
+			Transform result{};
+			for (int row{ 0 }; row < 3; ++row)
+			{
+				if (axes[row] < 0 || axes[row] > 2 || axes[0] == axes[1] || axes[1] == axes[2] || axes[0] == axes[2])
+					return {};
+				result.linear[row][row] = 0.0;
+			}
+			for (int row{ 0 }; row < 3; ++row)
+			{
+				result.linear[row][axes[row]] = signs[row] < 0 ? -1.0 : 1.0;
+			}
+			return result;
+		}
+
+		//Lcl Translation * PreRotation * Lcl Rotation * Lcl Scaling, up the parent models
+		Transform GetGlobalTransform(uint32_t model) const
+		{
+			Transform result{};
+			for (uint32_t depth{ 0 }; model != noIndex && depth < maxDepth; ++depth)
+			{
+				const Properties70 properties = GetProperties(model);
+				double translation[3], preRotation[3], rotation[3], scaling[3];
+				properties.GetVector("Lcl Translation", translation, 0.0);
+				properties.GetVector("PreRotation", preRotation, 0.0);
+				properties.GetVector("Lcl Rotation", rotation, 0.0);
+				properties.GetVector("Lcl Scaling", scaling, 1.0);
+				const int64_t order = properties.GetInteger("RotationOrder", 0);
+
+				const Transform local = Transform::CreateTranslation(translation) * Transform::CreateEuler(preRotation, 0)
+					* Transform::CreateEuler(rotation, order) * Transform::CreateScale(scaling);
+				result = local * result;
+				model = FindParent(ToInteger(GetProperty(m_Tree[model], 0)), "Model");
+			}
+			return result;
+		}
+
+		//Moves only the geometry, not the model's children
+		Transform GetGeometricTransform(uint32_t model) const
+		{
+			const Properties70 properties = GetProperties(model);
+			double translation[3], rotation[3], scaling[3];
+			properties.GetVector("GeometricTranslation", translation, 0.0);
+			properties.GetVector("GeometricRotation", rotation, 0.0);
+			properties.GetVector("GeometricScaling", scaling, 1.0);
+			return Transform::CreateTranslation(translation) * Transform::CreateEuler(rotation, 0) * Transform::CreateScale(scaling);
+		}
+
+		uint32_t AddMaterial(int64_t id, uint32_t node, FBX::Scene& scene)
+		{
+			const auto [it, isNew] = m_Materials.try_emplace(id, static_cast<uint32_t>(scene.materials.size()));
+			if (!isNew)
+				return it->second;
+
+			FBX::Material& material = scene.materials.emplace_back();
+			material.name = GetObjectName(m_Tree[node]);
+			for (const Connection& connection : m_Connections)
+			{
+				const uint32_t texture = connection.parent == id ? FindObject(connection.child, "Texture") : noIndex;
+				if (texture == noIndex)
+					continue;
+
+				uint32_t fileName = m_Tree.FindChild(texture, "RelativeFilename");
+				if (fileName == noIndex || ToString(GetProperty(m_Tree[fileName], 0)).empty())
+					fileName = m_Tree.FindChild(texture, "FileName");
+				const std::string path{ fileName == noIndex ? std::string_view{} : ToString(GetProperty(m_Tree[fileName], 0)) };
+
+				const std::string_view slot = connection.property;
+				if (slot == "DiffuseColor")
+					material.diffuseTexture = path;
+				else if (slot == "NormalMap" || slot == "Bump")
+					material.normalTexture = path;
+				else if (slot == "SpecularColor" || slot == "SpecularFactor")
+					material.specularTexture = path;
+				else if (slot == "ShininessExponent" || slot == "Shininess")
+					material.glossTexture = path;
+			}
+			return it->second;
+		}
+
+		void AddJob(uint32_t node, std::vector<double>* pReals, std::vector<int32_t>* pIntegers, std::vector<ArrayJob>& jobs) const
+		{
+			if (node != noIndex)
+				jobs.push_back({ GetProperty(m_Tree[node], 0), pReals, pIntegers });
+		}
+
+		//The layer element of this kind with the index the settings ask for, or the first one
+		uint32_t FindLayerElement(uint32_t geometry, std::string_view name, int index) const
+		{
+			uint32_t first{ noIndex };
+			for (uint32_t child = m_Tree.GetFirstChild(geometry); child != noIndex; child = m_Tree[child].nextSibling)
+			{
+				if (m_Tree[child].name != name)
+					continue;
+				if (ToInteger(GetProperty(m_Tree[child], 0)) == index)
+					return child;
+				if (first == noIndex)
+					first = child;
+			}
+			return first;
+		}
+
+		void ReadLayerElement(uint32_t geometry, std::string_view elementName, std::string_view valuesName, uint32_t componentCount, int index,
+			LayerElement& element, std::vector<ArrayJob>& jobs) const
+		{
+			const uint32_t node = FindLayerElement(geometry, elementName, index);
+			if (node == noIndex)
+				return;
+
+			const uint32_t mapping = m_Tree.FindChild(node, "MappingInformationType");
+			const uint32_t reference = m_Tree.FindChild(node, "ReferenceInformationType");
+			const uint32_t values = m_Tree.FindChild(node, valuesName);
+			element.mapping = mapping == noIndex ? Mapping::Unsupported : GetMapping(ToString(GetProperty(m_Tree[mapping], 0)));
+			if (element.mapping == Mapping::Unsupported || values == noIndex)
+				return;
+
+			const std::string_view referenceType = reference == noIndex ? std::string_view{ "Direct" } : ToString(GetProperty(m_Tree[reference], 0));
+			element.isIndexed = referenceType == "IndexToDirect" || referenceType == "Index";
+			element.componentCount = componentCount;
+			element.isPresent = true;
+			AddJob(values, &element.values, nullptr, jobs);
+			if (element.isIndexed)
+			{
+				//"Normals" -> "NormalsIndex", "UV" -> "UVIndex", ...
+				AddJob(m_Tree.FindChild(node, std::string{ valuesName } + "Index"), nullptr, &element.indices, jobs);
+			}
+		}
+
+		bool ReadGeometry(uint32_t node, const FBX::ImportSettings& settings, Geometry& geometry, std::vector<ArrayJob>& jobs) const
+		{
+			const uint32_t positions = m_Tree.FindChild(node, "Vertices");
+			const uint32_t polygonVertices = m_Tree.FindChild(node, "PolygonVertexIndex");
+			if (positions == noIndex || polygonVertices == noIndex)
+				return false;
+
+			AddJob(positions, &geometry.positions, nullptr, jobs);
+			AddJob(polygonVertices, nullptr, &geometry.polygonVertices, jobs);
+			ReadLayerElement(node, "LayerElementNormal", "Normals", 3, 0, geometry.normals, jobs);
+			ReadLayerElement(node, "LayerElementUV", "UV", 2, settings.uvSet, geometry.uvs, jobs);
+			ReadLayerElement(node, "LayerElementTangent", "Tangents", 3, 0, geometry.tangents, jobs);
+			ReadLayerElement(node, "LayerElementBinormal", "Binormals", 3, 0, geometry.binormals, jobs);
+
+			//Slot numbers per polygon (or one for all), never indexed
+			const uint32_t materialLayer = FindLayerElement(node, "LayerElementMaterial", 0);
+			const uint32_t materialMapping = materialLayer == noIndex ? noIndex : m_Tree.FindChild(materialLayer, "MappingInformationType");
+			const uint32_t materialValues = materialLayer == noIndex ? noIndex : m_Tree.FindChild(materialLayer, "Materials");
+			if (materialMapping != noIndex && materialValues != noIndex)
+			{
+				geometry.materialSlots.mapping = GetMapping(ToString(GetProperty(m_Tree[materialMapping], 0)));
+				geometry.materialSlots.isPresent = geometry.materialSlots.mapping == Mapping::ByPolygon || geometry.materialSlots.mapping == Mapping::AllSame;
+				if (geometry.materialSlots.isPresent)
+					AddJob(materialValues, nullptr, &geometry.materialValues, jobs);
+			}
+			return true;
+		}
+
+		//Skin deformer -> clusters -> the bone model each one moves
+		void ReadSkin(int64_t geometryId, Geometry& geometry, FBX::Scene& scene, std::vector<ArrayJob>& jobs)
+		{
+			int64_t skinId{};
+			for (const Connection& connection : m_Connections)
+			{
+				const uint32_t deformer = connection.parent == geometryId ? FindObject(connection.child, "Deformer") : noIndex;
+				if (deformer != noIndex && ToString(GetProperty(m_Tree[deformer], 2)) == "Skin")
+				{
+					skinId = connection.child;
+					break;
+				}
+			}
+			if (skinId == 0)
+				return;
+
+			size_t clusterCount{ 0 };
+			for (const Connection& connection : m_Connections)
+			{
+				const uint32_t cluster = connection.parent == skinId ? FindObject(connection.child, "Deformer") : noIndex;
+				clusterCount += cluster != noIndex && ToString(GetProperty(m_Tree[cluster], 2)) == "Cluster";
+			}
+			//The jobs point into the clusters, so they mustn't move
+			geometry.clusters.reserve(clusterCount);
+
+			for (const Connection& connection : m_Connections)
+			{
+				const uint32_t cluster = connection.parent == skinId ? FindObject(connection.child, "Deformer") : noIndex;
+				if (cluster == noIndex || ToString(GetProperty(m_Tree[cluster], 2)) != "Cluster")
+					continue;
+				const uint32_t indexes = m_Tree.FindChild(cluster, "Indexes");
+				const uint32_t weights = m_Tree.FindChild(cluster, "Weights");
+				if (indexes == noIndex || weights == noIndex)
+					continue;
+
+				//The bone is the model connected to the cluster, named after it; a cluster without one is its own bone
+				int64_t boneId{ connection.child };
+				uint32_t bone{ cluster };
+				for (const Connection& link : m_Connections)
+				{
+					const uint32_t model = link.parent == connection.child ? FindObject(link.child, "Model") : noIndex;
+					if (model != noIndex)
+					{
+						boneId = link.child;
+						bone = model;
+						break;
+					}
+				}
+				const auto [it, isNew] = m_Bones.try_emplace(boneId, static_cast<uint16_t>(scene.bones.size()));
+				if (isNew)
+					scene.bones.emplace_back(GetObjectName(m_Tree[bone]));
+
+				Cluster& skinCluster = geometry.clusters.emplace_back();
+				skinCluster.bone = it->second;
+				AddJob(indexes, nullptr, &skinCluster.controlPoints, jobs);
+				AddJob(weights, &skinCluster.weights, nullptr, jobs);
+			}
+		}
+	};
+
+	//The 4 heaviest influences of every control point
+	std::vector<FBX::SkinWeights> GetControlPointWeights(const Geometry& geometry, size_t controlPointCount)
+	{
+		std::vector<FBX::SkinWeights> weights(controlPointCount);
+		for (const Cluster& cluster : geometry.clusters)
+		{
+			const size_t count = std::min(cluster.controlPoints.size(), cluster.weights.size());
+			for (size_t i{ 0 }; i < count; ++i)
+			{
+				const int32_t controlPoint = cluster.controlPoints[i];
+				const float weight = static_cast<float>(cluster.weights[i]);
+				if (controlPoint < 0 || static_cast<size_t>(controlPoint) >= controlPointCount || !(weight > 0.f))
+					continue;
+
+				//Insertion into the sorted 4, dropping the lightest
+				FBX::SkinWeights& target = weights[controlPoint];
+				int slot{ 4 };
+				while (slot > 0 && target.weights[slot - 1] < weight)
+					--slot;
+				if (slot == 4)
+					continue;
+				for (int j{ 3 }; j > slot; --j)
+				{
+					target.weights[j] = target.weights[j - 1];
+					target.bones[j] = target.bones[j - 1];
+				}
+				target.weights[slot] = weight;
+				target.bones[slot] = static_cast<uint16_t>(cluster.bone);
+			}
+		}
+
+		for (FBX::SkinWeights& target : weights)
+		{
+			const float sum = target.weights[0] + target.weights[1] + target.weights[2] + target.weights[3];
+			if (sum > 0.f)
+			{
+				for (float& weight : target.weights)
+					weight /= sum;
+			}
+		}
+		return weights;
+	}
+
+	struct ImportState
+	{
+		std::vector<Vertex>& vertices;
+		std::vector<uint32_t>& indices;
+		std::vector<uint32_t> controlPoints{};		//per vertex, numbered across all geometries
+		std::vector<uint32_t> triangleMaterials{};	//per triangle, into Scene::materials
+		size_t cornerCount{};
+		bool hasFileTangents{ true };
+	};
+
+	//Polygons as triangle fans, corners welded into vertices
+	bool AddGeometry(const Geometry& geometry, const FBX::ImportSettings& settings, uint32_t firstControlPoint, VertexMap& vertexMap, ImportState& state)
+	{
+		const size_t controlPointCount = geometry.positions.size() / 3;
+		const bool useFileTangents = geometry.normals.isPresent && geometry.tangents.isPresent && geometry.binormals.isPresent;
+		state.hasFileTangents &= useFileTangents;
+
+		//Without a transform the values are only narrowed, which also keeps the signs of zeros like the OBJ import does
+		const bool isIdentity = geometry.transform.IsIdentity();
+		const auto toVector3 = [](const double* p) { return Vector3{ static_cast<float>(p[0]), static_cast<float>(p[1]), static_cast<float>(p[2]) }; };
+
+		std::vector<Vector3> positions(controlPointCount);
+		for (size_t i{ 0 }; i < controlPointCount; ++i)
+		{
+			positions[i] = isIdentity ? toVector3(&geometry.positions[i * 3]) : geometry.transform.TransformPoint(&geometry.positions[i * 3]);
+		}
+
+		//The attribute values transformed once, the corners then only pick them
+		const Transform normalTransform = geometry.transform.GetNormalTransform();
+		const auto transformElements = [isIdentity, &toVector3](const LayerElement& element, const Transform& transform)
+			{
+				std::vector<Vector3> result(element.isPresent ? element.values.size() / 3 : 0);
+				const bool renormalize = !transform.IsOrthonormal();
+				for (size_t i{ 0 }; i < result.size(); ++i)
+				{
+					result[i] = isIdentity ? toVector3(&element.values[i * 3]) : transform.TransformVector(&element.values[i * 3]);
+					if (renormalize)
+						result[i] = result[i].Normalized();
+				}
+				return result;
+			};
+		const std::vector<Vector3> normals = transformElements(geometry.normals, normalTransform);
+		const std::vector<Vector3> tangents = useFileTangents ? transformElements(geometry.tangents, geometry.transform) : std::vector<Vector3>{};
+		const std::vector<Vector3> binormals = useFileTangents ? transformElements(geometry.binormals, geometry.transform) : std::vector<Vector3>{};
+
+		//Mirroring transforms turn the polygons around, so they flip the winding like the axis flip does
+		const bool flipWinding = settings.flipAxisAndWinding != (geometry.transform.GetDeterminant() < 0.0);
+
+		std::vector<uint32_t> polygon{};
+		polygon.reserve(16);
+		size_t polygonIndex{ 0 };
+		for (size_t corner{ 0 }; corner < geometry.polygonVertices.size(); ++corner)
+		{
+			//The last corner of every polygon is stored as ~index
+			const int32_t value = geometry.polygonVertices[corner];
+			const bool isLast = value < 0;
+			const uint32_t controlPoint = static_cast<uint32_t>(isLast ? ~value : value);
+			if (controlPoint >= controlPointCount)
+				return false;
+
+			Vertex vertex{};
+			vertex.position = positions[controlPoint];
+			if (geometry.uvs.isPresent)
+			{
+				const uint32_t uv = geometry.uvs.Resolve(corner, polygonIndex, controlPoint);
+				if (uv == noIndex)
+					return false;
+				vertex.uv = { static_cast<float>(geometry.uvs.values[uv * 2]), 1.f - static_cast<float>(geometry.uvs.values[uv * 2 + 1]) };
+			}
+			if (geometry.normals.isPresent)
+			{
+				const uint32_t normal = geometry.normals.Resolve(corner, polygonIndex, controlPoint);
+				if (normal == noIndex)
+					return false;
+				vertex.normal = normals[normal];
+			}
+			if (useFileTangents)
+			{
+				const uint32_t tangent = geometry.tangents.Resolve(corner, polygonIndex, controlPoint);
+				const uint32_t binormal = geometry.binormals.Resolve(corner, polygonIndex, controlPoint);
+				if (tangent == noIndex || binormal == noIndex)
+					return false;
+				const float sign = Vector3::Dot(Vector3::Cross(vertex.normal, tangents[tangent]), binormals[binormal]) < 0.f ? -1.f : 1.f;
+				vertex.tangent = Vector4{ tangents[tangent], sign };
+			}
+
+			const uint32_t globalControlPoint = firstControlPoint + controlPoint;
+			uint32_t vertexIndex = static_cast<uint32_t>(state.vertices.size());
+			if (settings.weldVertices)
+			{
+				vertexIndex = vertexMap.FindOrAdd(vertex, globalControlPoint, state.vertices, state.controlPoints);
+			}
+			else
+			{
+				state.vertices.push_back(vertex);
+				state.controlPoints.push_back(globalControlPoint);
+			}
+			polygon.push_back(vertexIndex);
+			++state.cornerCount;
+
+			if (!isLast)
+				continue;
+
+			uint32_t material{ noIndex };
+			if (geometry.materialSlots.isPresent && !geometry.materialValues.empty())
+			{
+				const size_t slotIndex = geometry.materialSlots.mapping == Mapping::ByPolygon ? polygonIndex : 0;
+				const int32_t slot = slotIndex < geometry.materialValues.size() ? geometry.materialValues[slotIndex] : -1;
+				if (slot >= 0 && static_cast<size_t>(slot) < geometry.materials.size())
+					material = geometry.materials[slot];
+			}
+			else if (!geometry.materials.empty())
+			{
+				material = geometry.materials[0];
+			}
+
+			//Points and lines have no triangles
+			for (size_t i{ 1 }; i + 1 < polygon.size(); ++i)
+			{
+				state.indices.push_back(polygon[0]);
+				state.indices.push_back(polygon[flipWinding ? i + 1 : i]);
+				state.indices.push_back(polygon[flipWinding ? i : i + 1]);
+				state.triangleMaterials.push_back(material);
+			}
+			polygon.clear();
+			++polygonIndex;
+		}
+		return true;
+	}
+
+	//Stable counting sort of the triangles by material and one submesh per material that has triangles
+	void GroupByMaterial(ImportState& state, size_t materialCount, std::vector<Submesh>& submeshes)
+	{
+		submeshes.clear();
+		if (materialCount == 0)
+			return;
+
+		//Triangles without a material go to the end, after the last material
+		const auto getGroup = [materialCount](uint32_t material) { return material < materialCount ? material : static_cast<uint32_t>(materialCount); };
+		std::vector<uint32_t> firstTriangles(materialCount + 2, 0);
+		for (const uint32_t material : state.triangleMaterials)
+		{
+			++firstTriangles[getGroup(material) + 1];
+		}
+		for (size_t group{ 1 }; group < firstTriangles.size(); ++group)
+		{
+			firstTriangles[group] += firstTriangles[group - 1];
+		}
+
+		const std::vector<uint32_t> sourceIndices = state.indices;
+		std::vector<uint32_t> nextTriangles(firstTriangles.begin(), firstTriangles.end() - 1);
+		for (size_t triangle{ 0 }; triangle < state.triangleMaterials.size(); ++triangle)
+		{
+			const uint32_t target = nextTriangles[getGroup(state.triangleMaterials[triangle])]++;
+			std::copy_n(sourceIndices.begin() + triangle * 3, 3, state.indices.begin() + size_t(target) * 3);
+		}
+
+		for (uint32_t material{ 0 }; material <= materialCount; ++material)
+		{
+			const uint32_t first = firstTriangles[material], end = firstTriangles[material + 1];
+			if (first == end)
+				continue;
+
+			Vector3 min = state.vertices[state.indices[size_t(first) * 3]].position, max = min;
+			for (size_t index = size_t(first) * 3; index < size_t(end) * 3; ++index)
+			{
+				const Vector3& position = state.vertices[state.indices[index]].position;
+				min = { std::min(min.x, position.x), std::min(min.y, position.y), std::min(min.z, position.z) };
+				max = { std::max(max.x, position.x), std::max(max.y, position.y), std::max(max.z, position.z) };
+			}
+			submeshes.push_back({ first * 3, (end - first) * 3, 0, material < materialCount ? material : noIndex, AABB::FromMinMax(min, max) });
+		}
+	}
+}
+
+namespace FBX
+{
+	bool Import(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const ImportSettings& settings, ImportStats* pStats, Scene* pScene)
+	{
+		const MappedFile file{ filename };
+		if (!file.IsOpen() || file.GetSize() < headerSize || std::memcmp(file.GetData(), magic, sizeof(magic)) != 0)
+			return false;
+		const uint32_t version = ReadValue<uint32_t>(file.GetData() + 23);
+		if (version < minVersion)
+			return false;
+
+		vertices.clear();
+		indices.clear();
+
+		NodeTree tree{};
+		if (!tree.Parse(file.GetData(), file.GetSize(), version))
+			return false;
+
+		Scene scene{};
+		std::vector<Geometry> geometries{};
+		std::vector<ArrayJob> jobs{};
+		SceneReader reader{ tree };
+		if (!reader.Read(settings, scene, geometries, jobs) || geometries.empty())
+			return false;
+
+		//Biggest arrays first, every thread takes the next one when it is done: the time is about the biggest array's
+		std::vector<uint32_t> order(jobs.size());
+		for (uint32_t i{ 0 }; i < order.size(); ++i) order[i] = i;
+		std::stable_sort(order.begin(), order.end(), [&jobs](uint32_t a, uint32_t b) { return jobs[a].property.size > jobs[b].property.size; });
+
+		const unsigned threadCount = Parallel::GetThreadCount(settings.threadCount);
+		std::atomic<size_t> nextJob{ 0 };
+		const unsigned decodeThreadCount = static_cast<unsigned>(std::min<size_t>(threadCount, jobs.size()));
+		Parallel::ForRanges(decodeThreadCount, decodeThreadCount, [&](unsigned, size_t, size_t)
+			{
+				for (size_t i = nextJob++; i < order.size(); i = nextJob++)
+				{
+					ArrayJob& job = jobs[order[i]];
+					job.isDecoded = job.pReals ? DecodeArray(job.property, *job.pReals) : DecodeArray(job.property, *job.pIntegers);
+				}
+			});
+
+		size_t arrayCount{ 0 }, compressedBytes{ 0 }, inflatedBytes{ 0 };
+		for (const ArrayJob& job : jobs)
+		{
+			if (!job.isDecoded)
+				return false;
+			++arrayCount;
+			if (job.property.isCompressed)
+			{
+				compressedBytes += job.property.size;
+				inflatedBytes += size_t(job.property.count) * GetElementSize(job.property.type);
+			}
+		}
+
+		size_t totalCorners{ 0 }, totalControlPoints{ 0 };
+		for (const Geometry& geometry : geometries)
+		{
+			totalCorners += geometry.polygonVertices.size();
+			totalControlPoints += geometry.positions.size() / 3;
+		}
+		if (totalControlPoints >= noIndex)
+			return false;
+
+		ImportState state{ vertices, indices };
+		vertices.reserve(settings.weldVertices ? totalControlPoints * 2 : totalCorners);
+		indices.reserve(totalCorners * 3);
+		state.controlPoints.reserve(vertices.capacity());
+		state.hasFileTangents = !geometries.empty();
+
+		VertexMap vertexMap{ settings.weldVertices ? totalControlPoints * 2 : 0 };
+		uint32_t firstControlPoint{ 0 };
+		for (const Geometry& geometry : geometries)
+		{
+			if (!AddGeometry(geometry, settings, firstControlPoint, vertexMap, state))
+				return false;
+			firstControlPoint += static_cast<uint32_t>(geometry.positions.size() / 3);
+		}
+
+		GroupByMaterial(state, scene.materials.size(), scene.submeshes);
+
+		if (!state.hasFileTangents)
+		{
+			//Vertices split on mirrored uv seams are appended, their corners tell which vertex they were copied from
+			const std::vector<uint32_t> unsplitIndices = settings.importSkin ? indices : std::vector<uint32_t>{};
+			const size_t unsplitCount = vertices.size();
+			TangentSpace::Generate(vertices, indices, threadCount);
+
+			state.controlPoints.resize(vertices.size());
+			for (size_t i{ 0 }; i < unsplitIndices.size(); ++i)
+			{
+				if (indices[i] >= unsplitCount)
+					state.controlPoints[indices[i]] = state.controlPoints[unsplitIndices[i]];
+			}
+		}
+
+		if (settings.flipAxisAndWinding)
+		{
+			for (Vertex& vertex : vertices)
+			{
+				vertex.position.z *= -1.f;
+				vertex.normal.z *= -1.f;
+				vertex.tangent.z *= -1.f;
+				vertex.tangent.w *= -1.f;
+			}
+			for (Submesh& submesh : scene.submeshes)
+			{
+				submesh.bounds.center.z *= -1.f;
+			}
+		}
+
+		if (settings.importSkin && !scene.bones.empty())
+		{
+			scene.skinWeights.assign(vertices.size(), {});
+			firstControlPoint = 0;
+			for (const Geometry& geometry : geometries)
+			{
+				const size_t controlPointCount = geometry.positions.size() / 3;
+				if (!geometry.clusters.empty())
+				{
+					const std::vector<SkinWeights> weights = GetControlPointWeights(geometry, controlPointCount);
+					for (size_t vertex{ 0 }; vertex < vertices.size(); ++vertex)
+					{
+						const uint32_t controlPoint = state.controlPoints[vertex] - firstControlPoint;
+						if (controlPoint < controlPointCount)
+							scene.skinWeights[vertex] = weights[controlPoint];
+					}
+				}
+				firstControlPoint += static_cast<uint32_t>(controlPointCount);
+			}
+		}
+
+		if (pStats)
+			*pStats = { state.cornerCount, vertices.size(), indices.size(), geometries.size(), arrayCount, compressedBytes, inflatedBytes };
+		if (pScene)
+			*pScene = std::move(scene);
+		return true;
+	}
+}
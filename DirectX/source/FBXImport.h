@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DataTypes.h"
+
+//Binary FBX (7100 up to 7700) import straight into Vertex/index arrays (FBXImport.cpp).
+//The file is memory-mapped and its node tree read in place; only the arrays the geometry needs are inflated.
+namespace FBX
+{
+	struct ImportSettings
+	{
+		//Like the OBJ import: the file's right-handed space, Y up after its axis settings, mirrored to left-handed
+		bool flipAxisAndWinding{ true };
+		//Corners with the same control point, uv, normal and tangent share one vertex
+		bool weldVertices{ true };
+		//> 1 (or 0 for all hardware threads): the zlib-compressed arrays are inflated in parallel and tangents generated
+		//on that many threads. The result is identical to the single-threaded import.
+		unsigned threadCount{ 1 };
+		//LayerElementUV with this index, the first one if there is none
+		int uvSet{ 0 };
+		bool importSkin{ false };
+	};
+
+	//A Material object and the file names of the textures connected to it, as the file stores them
+	struct Material
+	{
+		std::string name{};
+		std::string diffuseTexture{};
+		std::string normalTexture{};
+		std::string specularTexture{};
+		std::string glossTexture{};
+	};
+
+	//The 4 heaviest bone influences of a vertex, weights normalized to a sum of 1 (all 0 for unskinned vertices)
+	struct SkinWeights
+	{
+		uint16_t bones[4]{};
+		float weights[4]{};
+	};
+
+	//What the import found besides the vertices and indices
+	struct Scene
+	{
+		std::vector<Material> materials{};
+		//Triangles are grouped by material: one submesh per material that has any, materialIndex into materials
+		std::vector<Submesh> submeshes{};
+		//Names of the models the skin clusters move and the weights per vertex, importSkin only and empty for unskinned files
+		std::vector<std::string> bones{};
+		std::vector<SkinWeights> skinWeights{};
+	};
+
+	struct ImportStats
+	{
+		size_t cornerCount{};		//vertices without welding (one per polygon corner)
+		size_t vertexCount{};
+		size_t indexCount{};
+		size_t geometryCount{};
+		size_t arrayCount{};		//property arrays read
+		size_t compressedBytes{};	//of the arrays that were zlib-compressed
+		size_t inflatedBytes{};
+	};
+
+	//Imports every mesh in the file into one vertex and index array: polygons as triangle fans, each geometry moved by its
+	//model's Lcl and geometric translation, (pre)rotation and scaling up to the root (pivots and offsets are ignored).
+	//Tangents come from the file when every geometry has tangents and binormals, otherwise TangentSpace::Generate makes them.
+	//ASCII FBX files aren't supported.
+	bool Import(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const ImportSettings& settings = {},
+		ImportStats* pStats = nullptr, Scene* pScene = nullptr);
+}
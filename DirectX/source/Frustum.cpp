@@ -0,0 +1,132 @@
+#include "pch.h"
+#include "Frustum.h"
+
+#include "SIMD.h"
+
+namespace
+{
+#if defined(MATH_USE_SSE)
+	using namespace SIMD;
+
+	//Groups of 8 objects: one AVX register, or two SSE registers
+#if defined(__AVX__)
+	using Lane = __m256;
+	constexpr size_t lanesPerGroup{ 1 };
+#else
+	using Lane = __m128;
+	constexpr size_t lanesPerGroup{ 2 };
+#endif
+	constexpr size_t groupSize{ 8 };
+	constexpr size_t laneWidth{ groupSize / lanesPerGroup };
+
+	//Every plane broadcast once, with |n| precomputed for the box radius
+	struct PlaneLanes
+	{
+		Lane normalX[Frustum::PlaneCount], normalY[Frustum::PlaneCount], normalZ[Frustum::PlaneCount];
+		Lane absNormalX[Frustum::PlaneCount], absNormalY[Frustum::PlaneCount], absNormalZ[Frustum::PlaneCount];
+		Lane distance[Frustum::PlaneCount];
+
+		explicit PlaneLanes(const Frustum& frustum)
+		{
+			for (int i{ 0 }; i < Frustum::PlaneCount; ++i)
+			{
+				const Plane& plane = frustum.planes[i];
+				normalX[i] = Broadcast<Lane>(plane.normal.x);
+				normalY[i] = Broadcast<Lane>(plane.normal.y);
+				normalZ[i] = Broadcast<Lane>(plane.normal.z);
+				absNormalX[i] = Broadcast<Lane>(std::abs(plane.normal.x));
+				absNormalY[i] = Broadcast<Lane>(std::abs(plane.normal.y));
+				absNormalZ[i] = Broadcast<Lane>(std::abs(plane.normal.z));
+				distance[i] = Broadcast<Lane>(plane.distance);
+			}
+		}
+
+		Lane SignedDistance(int i, Lane x, Lane y, Lane z) const
+		{
+			return MulAdd(x, normalX[i], MulAdd(y, normalY[i], MulAdd(z, normalZ[i], distance[i])));
+		}
+	};
+
+	//One bit per object of the group, set when it is outside any plane
+	uint32_t BoxesOutside(const PlaneLanes& planes, const AABBArray& boxes, size_t first)
+	{
+		uint32_t outsideBits{ 0 };
+		for (size_t lane{ 0 }; lane < lanesPerGroup; ++lane, first += laneWidth)
+		{
+			const Lane x = Load<Lane>(&boxes.centerX[first]), y = Load<Lane>(&boxes.centerY[first]), z = Load<Lane>(&boxes.centerZ[first]);
+			const Lane ex = Load<Lane>(&boxes.extentX[first]), ey = Load<Lane>(&boxes.extentY[first]), ez = Load<Lane>(&boxes.extentZ[first]);
+			const Lane zero = Broadcast<Lane>(0.f);
+
+			Lane outside = zero;
+			for (int i{ 0 }; i < Frustum::PlaneCount; ++i)
+			{
+				const Lane radius = MulAdd(ex, planes.absNormalX[i], MulAdd(ey, planes.absNormalY[i], Mul(ez, planes.absNormalZ[i])));
+				outside = Or(outside, Less(Add(planes.SignedDistance(i, x, y, z), radius), zero));
+			}
+			outsideBits |= static_cast<uint32_t>(MoveMask(outside)) << (lane * laneWidth);
+		}
+		return outsideBits;
+	}
+
+	uint32_t SpheresOutside(const PlaneLanes& planes, const SphereArray& spheres, size_t first)
+	{
+		uint32_t outsideBits{ 0 };
+		for (size_t lane{ 0 }; lane < lanesPerGroup; ++lane, first += laneWidth)
+		{
+			const Lane x = Load<Lane>(&spheres.centerX[first]), y = Load<Lane>(&spheres.centerY[first]), z = Load<Lane>(&spheres.centerZ[first]);
+			const Lane radius = Load<Lane>(&spheres.radius[first]);
+			const Lane zero = Broadcast<Lane>(0.f);
+
+			Lane outside = zero;
+			for (int i{ 0 }; i < Frustum::PlaneCount; ++i)
+			{
+				outside = Or(outside, Less(Add(planes.SignedDistance(i, x, y, z), radius), zero));
+			}
+			outsideBits |= static_cast<uint32_t>(MoveMask(outside)) << (lane * laneWidth);
+		}
+		return outsideBits;
+	}
+#endif
+}
+
+void Frustum::Cull(const AABBArray& boxes, std::vector<uint32_t>& visibility) const
+{
+	const size_t count = boxes.Size();
+	visibility.assign((count + 31) / 32, 0u);
+
+	size_t i{ 0 };
+#if defined(MATH_USE_SSE)
+	const PlaneLanes planeLanes{ *this };
+	for (; i + groupSize <= count; i += groupSize)
+	{
+		visibility[i / 32] |= (~BoxesOutside(planeLanes, boxes, i) & 0xFFu) << (i % 32);
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		const AABB box{ { boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i] }, { boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i] } };
+		if (Intersects(box))
+			visibility[i / 32] |= 1u << (i % 32);
+	}
+}
+
+void Frustum::Cull(const SphereArray& spheres, std::vector<uint32_t>& visibility) const
+{
+	const size_t count = spheres.Size();
+	visibility.assign((count + 31) / 32, 0u);
+
+	size_t i{ 0 };
+#if defined(MATH_USE_SSE)
+	const PlaneLanes planeLanes{ *this };
+	for (; i + groupSize <= count; i += groupSize)
+	{
+		visibility[i / 32] |= (~SpheresOutside(planeLanes, spheres, i) & 0xFFu) << (i % 32);
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		const BoundingSphere sphere{ { spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i] }, spheres.radius[i] };
+		if (Intersects(sphere))
+			visibility[i / 32] |= 1u << (i % 32);
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Matrix.h"
+#include "Bounds.h"
+
+//n . p + d, positive on the inside
+struct Plane
+{
+	Vector3 normal{};
+	float distance{};
+
+	constexpr float SignedDistance(const Vector3& p) const noexcept
+	{
+		return Vector3::Dot(normal, p) + distance;
+	}
+};
+
+//Bounds of many objects in SoA form (one array per component), so the culling kernels load 8 objects per register
+struct AABBArray
+{
+	std::vector<float> centerX{}, centerY{}, centerZ{};
+	std::vector<float> extentX{}, extentY{}, extentZ{};
+
+	size_t Size() const { return centerX.size(); }
+
+	void Add(const AABB& box)
+	{
+		centerX.push_back(box.center.x); centerY.push_back(box.center.y); centerZ.push_back(box.center.z);
+		extentX.push_back(box.extents.x); extentY.push_back(box.extents.y); extentZ.push_back(box.extents.z);
+	}
+
+	void Clear()
+	{
+		centerX.clear(); centerY.clear(); centerZ.clear();
+		extentX.clear(); extentY.clear(); extentZ.clear();
+	}
+};
+
+struct SphereArray
+{
+	std::vector<float> centerX{}, centerY{}, centerZ{};
+	std::vector<float> radius{};
+
+	size_t Size() const { return centerX.size(); }
+
+	void Add(const BoundingSphere& sphere)
+	{
+		centerX.push_back(sphere.center.x); centerY.push_back(sphere.center.y); centerZ.push_back(sphere.center.z);
+		radius.push_back(sphere.radius);
+	}
+
+	void Clear()
+	{
+		centerX.clear(); centerY.clear(); centerZ.clear();
+		radius.clear();
+	}
+};
+
+struct Frustum
+{
+	enum PlaneIndex { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+	Plane planes[PlaneCount]{};
+
+	//Gribb/Hartmann on a row-vector view * projection: clip = (p, 1) * M, so every plane is a sum of the matrix columns.
+	//D3D clip space, near is 0 <= z instead of -w <= z.
+	static Frustum FromViewProjection(const Matrix& viewProjection) noexcept
+	{
+		const auto column = [&viewProjection](int c) { return Vector4{ viewProjection[0][c], viewProjection[1][c], viewProjection[2][c], viewProjection[3][c] }; };
+		const Vector4 x = column(0), y = column(1), z = column(2), w = column(3);
+
+		const Vector4 equations[PlaneCount]{ w + x, w - x, w + y, w - y, z, w - z };
+
+		Frustum frustum{};
+		for (int i{ 0 }; i < PlaneCount; ++i)
+		{
+			const Vector3 normal{ equations[i] };
+			const float invLength = 1.f / normal.Magnitude();
+			frustum.planes[i] = { normal * invLength, equations[i].w * invLength };
+		}
+		return frustum;
+	}
+
+	//Conservative: boxes/spheres that straddle two planes outside a corner still count as visible
+	bool Intersects(const AABB& box) const noexcept
+	{
+		for (const Plane& plane : planes)
+		{
+			const float radius = std::abs(plane.normal.x) * box.extents.x + std::abs(plane.normal.y) * box.extents.y + std::abs(plane.normal.z) * box.extents.z;
+			if (plane.SignedDistance(box.center) + radius < 0.f)
+				return false;
+		}
+		return true;
+	}
+
+	bool Intersects(const BoundingSphere& sphere) const noexcept
+	{
+		for (const Plane& plane : planes)
+		{
+			if (plane.SignedDistance(sphere.center) + sphere.radius < 0.f)
+				return false;
+		}
+		return true;
+	}
+
+	//Visibility bitmask: bit (i % 32) of visibility[i / 32] is set when object i is (partially) inside.
+	//Same tests as Intersects(), 8 objects per iteration in SoA form (Frustum.cpp).
+	void Cull(const AABBArray& boxes, std::vector<uint32_t>& visibility) const;
+	void Cull(const SphereArray& spheres, std::vector<uint32_t>& visibility) const;
+
+	static bool IsVisible(const std::vector<uint32_t>& visibility, size_t index) noexcept
+	{
+		return (visibility[index / 32] >> (index % 32)) & 1u;
+	}
+};
@@ -0,0 +1,165 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+MappedFile::MappedFile(const std::string& path)
+{
+	const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	m_FileHandle = file;
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(file, &size))
+		return;
+
+	m_Size = static_cast<size_t>(size.QuadPart);
+	if (m_Size == 0)
+	{
+		m_IsOpen = true;
+		return;
+	}
+
+	m_MappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_MappingHandle)
+		return;
+
+	m_pData = MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0);
+	m_IsOpen = m_pData != nullptr;
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_pData) UnmapViewOfFile(m_pData);
+	if (m_MappingHandle) CloseHandle(m_MappingHandle);
+	if (m_FileHandle) CloseHandle(m_FileHandle);
+}
+#else
+MappedFile::MappedFile(const std::string& path)
+{
+	const int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return;
+
+	struct stat status {};
+	if (fstat(file, &status) == 0)
+	{
+		m_Size = static_cast<size_t>(status.st_size);
+		if (m_Size == 0)
+		{
+			m_IsOpen = true;
+		}
+		else
+		{
+			void* pData = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (pData != MAP_FAILED)
+			{
+				madvise(pData, m_Size, MADV_SEQUENTIAL);
+				m_pData = pData;
+				m_IsOpen = true;
+			}
+		}
+	}
+
+	//The mapping stays valid after the descriptor is closed
+	close(file);
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_pData) munmap(m_pData, m_Size);
+}
+#endif
+
+namespace
+{
+	//The murmur3 finalizer: every input bit reaches every output bit
+	uint64_t Mix(uint64_t hash)
+	{
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ull;
+		return hash ^ (hash >> 33);
+	}
+}
+
+bool WriteFileAtomically(const std::string& path, std::span<const FileBlob> blobs)
+{
+	const std::string tempPath = path + ".tmp";
+	std::error_code error{};
+	{
+		std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+		uint64_t written{ 0 };
+		for (const FileBlob& blob : blobs)
+		{
+			if (!file || blob.offset < written)
+				break;
+			static constexpr char zeros[256]{};
+			while (written < blob.offset)
+			{
+				const uint64_t padding = std::min<uint64_t>(blob.offset - written, sizeof(zeros));
+				file.write(zeros, static_cast<std::streamsize>(padding));
+				written += padding;
+			}
+			file.write(static_cast<const char*>(blob.pData), static_cast<std::streamsize>(blob.size));
+			written += blob.size;
+		}
+
+		const bool isComplete = file && (blobs.empty() || written == blobs.back().offset + blobs.back().size);
+		file.close();
+		if (!isComplete || !file)
+		{
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, path, error);
+	if (error)
+	{
+		std::error_code removeError{};
+		std::filesystem::remove(tempPath, removeError);
+		return false;
+	}
+	return true;
+}
+
+uint64_t HashContent(std::span<const uint8_t> data, uint64_t seed)
+{
+	uint64_t hash = Mix(seed ^ data.size());
+	size_t position{ 0 };
+	for (; position + sizeof(uint64_t) <= data.size(); position += sizeof(uint64_t))
+	{
+		uint64_t word{};
+		std::memcpy(&word, &data[position], sizeof(uint64_t));
+		hash = std::rotl(hash ^ word, 27) * 0x9E3779B97F4A7C15ull;
+	}
+	uint64_t tail{ 0 };
+	if (position < data.size())
+		std::memcpy(&tail, data.data() + position, data.size() - position);
+	return Mix(hash ^ tail);
+}
+
+uint64_t HashFile(const std::string& path, uint64_t seed)
+{
+	const MappedFile file{ path };
+	if (!file.IsOpen())
+		return 0;
+	return HashContent({ reinterpret_cast<const uint8_t*>(file.GetData()), file.GetSize() }, seed);
+}
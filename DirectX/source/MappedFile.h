@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+//Read-only memory mapping of a whole file (MapViewOfFile / mmap), so parsers scan the bytes in place
+//instead of copying them through a stream.
+class MappedFile final
+{
+public:
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile(MappedFile&&) noexcept = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile& operator=(MappedFile&&) noexcept = delete;
+
+	//An empty file is open with a size of 0 and no data
+	bool IsOpen() const { return m_IsOpen; }
+	const char* GetData() const { return static_cast<const char*>(m_pData); }
+	size_t GetSize() const { return m_Size; }
+
+private:
+	void* m_pData{};
+	size_t m_Size{};
+	bool m_IsOpen{ false };
+
+#if defined(_WIN32)
+	void* m_FileHandle{};
+	void* m_MappingHandle{};
+#endif
+};
+
+//size bytes of a file written by WriteFileAtomically, starting at offset
+struct FileBlob
+{
+	uint64_t offset{};
+	const void* pData{};
+	uint64_t size{};
+};
+
+//Writes the blobs, in increasing offset order and zero-filling the gaps between them, to path + ".tmp" and renames
+//that over path, so a reader never maps half a file. The .tmp file is removed when anything fails.
+bool WriteFileAtomically(const std::string& path, std::span<const FileBlob> blobs);
+
+//64-bit hash of bytes, 8 at a time; not cryptographic, only for the cooked file caches to notice changed content
+uint64_t HashContent(std::span<const uint8_t> data, uint64_t seed = 0);
+//HashContent of a whole file's bytes, 0 when it can't be read
+uint64_t HashFile(const std::string& path, uint64_t seed = 0);
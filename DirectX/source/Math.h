@@ -4,4 +4,8 @@
 #include "Vector3.h"
 #include "Vector4.h"
 #include "Matrix.h"
+#include "Quaternion.h"
+#include "AffineTransform.h"
+#include "Bounds.h"
+#include "Frustum.h"
 #include "MathHelpers.h"
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <cmath>
+#include <cfloat>
 
 
 /* --- HELPER STRUCTS --- */
@@ -20,36 +21,37 @@ constexpr auto TO_DEGREES = (180.0f / PI);
 constexpr auto TO_RADIANS(PI / 180.0f);
 
 /* --- HELPER FUNCTIONS --- */
-inline float Square(float a)
+constexpr float Square(float a) noexcept
 {
 	return a * a;
 }
 
-inline float Lerpf(float a, float b, float factor)
+constexpr float Lerpf(float a, float b, float factor) noexcept
 {
 	return ((1 - factor) * a) + (factor * b);
 }
 
-inline bool AreEqual(float a, float b, float epsilon = FLT_EPSILON)
+constexpr bool AreEqual(float a, float b, float epsilon = FLT_EPSILON) noexcept
 {
-	return abs(a - b) < epsilon;
+	const float difference = a - b;
+	return (difference < 0.f ? -difference : difference) < epsilon;
 }
 
-inline int Clamp(const int v, int min, int max)
+constexpr int Clamp(const int v, int min, int max) noexcept
 {
 	if (v < min) return min;
 	if (v > max) return max;
 	return v;
 }
 
-inline float Clamp(const float v, float min, float max)
+constexpr float Clamp(const float v, float min, float max) noexcept
 {
 	if (v < min) return min;
 	if (v > max) return max;
 	return v;
 }
 
-inline float Saturate(const float v)
+constexpr float Saturate(const float v) noexcept
 {
 	if (v < 0.f) return 0.f;
 	if (v > 1.f) return 1.f;
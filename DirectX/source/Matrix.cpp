@@ -4,284 +4,325 @@
 
 #include <cassert>
 
-#include "MathHelpers.h"
-#include <cmath>
-
-Matrix::Matrix(const Vector3& xAxis, const Vector3& yAxis, const Vector3& zAxis, const Vector3& t) :
-	Matrix({ xAxis, 0 }, { yAxis, 0 }, { zAxis, 0 }, { t, 1 })
-{
-}
-
-Matrix::Matrix(const Vector4& xAxis, const Vector4& yAxis, const Vector4& zAxis, const Vector4& t)
-{
-	data[0] = xAxis;
-	data[1] = yAxis;
-	data[2] = zAxis;
-	data[3] = t;
-}
-
-Matrix::Matrix(const Matrix& m)
-{
-	data[0] = m[0];
-	data[1] = m[1];
-	data[2] = m[2];
-	data[3] = m[3];
-}
-
-Vector3 Matrix::TransformVector(const Vector3& v) const
-{
-	return TransformVector(v.x, v.y, v.z);
-}
-
-Vector3 Matrix::TransformVector(float x, float y, float z) const
-{
-	return Vector3{
-		data[0].x * x + data[1].x * y + data[2].x * z,
-		data[0].y * x + data[1].y * y + data[2].y * z,
-		data[0].z * x + data[1].z * y + data[2].z * z
-	};
-}
-
-Vector3 Matrix::TransformPoint(const Vector3& p) const
-{
-	return TransformPoint(p.x, p.y, p.z);
-}
-
-Vector3 Matrix::TransformPoint(float x, float y, float z) const
-{
-	return Vector3{
-		data[0].x * x + data[1].x * y + data[2].x * z + data[3].x,
-		data[0].y * x + data[1].y * y + data[2].y * z + data[3].y,
-		data[0].z * x + data[1].z * y + data[2].z * z + data[3].z,
-	};
-}
-
-Vector4 Matrix::TransformPoint(const Vector4& p) const
-{
-	return TransformPoint(p.x, p.y, p.z, p.w);
-}
-
-Vector4 Matrix::TransformPoint(float x, float y, float z, float w) const
-{
-	return Vector4{
-		data[0].x * x + data[1].x * y + data[2].x * z + data[3].x,
-		data[0].y * x + data[1].y * y + data[2].y * z + data[3].y,
-		data[0].z * x + data[1].z * y + data[2].z * z + data[3].z,
-		data[0].w * x + data[1].w * y + data[2].w * z + data[3].w
-	};
-}
-
-const Matrix& Matrix::Transpose()
-{
-	Matrix result{};
-	for (int r{ 0 }; r < 4; ++r)
+//Matrix itself is header-only; this file only holds the batched SoA transform kernels.
+namespace
+{
+	//Batched transforms work on SoA lanes: one register holds the x (or y, z, w) of 4 (SSE) or 8 (AVX) elements
+#if defined(__AVX__)
+	using Lane = __m256;
+	constexpr size_t laneWidth{ 8 };
+
+	inline Lane LoadLane(const float* p) { return _mm256_load_ps(p); }
+	inline void StoreLane(float* p, Lane v) { _mm256_store_ps(p, v); }
+	inline Lane Combine(__m128 low, __m128 high) { return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1); }
+	inline __m128 LowHalf(Lane v) { return _mm256_castps256_ps128(v); }
+	inline __m128 HighHalf(Lane v) { return _mm256_extractf128_ps(v, 1); }
+#elif defined(MATH_USE_SSE)
+	using Lane = __m128;
+	constexpr size_t laneWidth{ 4 };
+
+	inline Lane LoadLane(const float* p) { return _mm_load_ps(p); }
+	inline void StoreLane(float* p, Lane v) { _mm_store_ps(p, v); }
+#endif
+
+#if defined(MATH_USE_SSE)
+	using SIMD::Mul;
+	using SIMD::MulAdd;
+	using SIMD::Sub;
+
+	inline Lane Broadcast(float f) { return SIMD::Broadcast<Lane>(f); }
+#endif
+
+#if defined(MATH_USE_SSE)
+	//Every matrix element broadcast once, so the inner loop is nothing but multiply-adds
+	struct MatrixLanes
 	{
-		for (int c{ 0 }; c < 4; ++c)
+		Lane m[4][4];
+
+		explicit MatrixLanes(const float* pMatrix)
 		{
-			result[r][c] = data[c][r];
+			for (int r{ 0 }; r < 4; ++r)
+				for (int c{ 0 }; c < 4; ++c)
+					m[r][c] = Broadcast(pMatrix[r * 4 + c]);
 		}
-	}
 
-	data[0] = result[0];
-	data[1] = result[1];
-	data[2] = result[2];
-	data[3] = result[3];
+		//Column c of the result for a w = 0 (vector) or w = 1 (point) input
+		Lane Vector(int c, Lane x, Lane y, Lane z) const { return MulAdd(x, m[0][c], MulAdd(y, m[1][c], Mul(z, m[2][c]))); }
+		Lane Point(int c, Lane x, Lane y, Lane z) const { return MulAdd(x, m[0][c], MulAdd(y, m[1][c], MulAdd(z, m[2][c], m[3][c]))); }
+		Lane Point(int c, Lane x, Lane y, Lane z, Lane w) const { return MulAdd(x, m[0][c], MulAdd(y, m[1][c], MulAdd(z, m[2][c], Mul(w, m[3][c])))); }
+	};
 
-	return *this;
-}
+	//4 packed Vector3s (x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3) <-> x, y, z registers
+	inline void LoadXYZ4(const float* p, __m128& x, __m128& y, __m128& z)
+	{
+		const __m128 a = _mm_loadu_ps(p + 0);
+		const __m128 b = _mm_loadu_ps(p + 4);
+		const __m128 c = _mm_loadu_ps(p + 8);
 
-const Matrix& Matrix::Inverse()
-{
-	//Optimized Inverse as explained in FGED1 - used widely in other libraries too.
-	const Vector3& a = data[0];
-	const Vector3& b = data[1];
-	const Vector3& c = data[2];
-	const Vector3& d = data[3];
-
-	const float x = data[0][3];
-	const float y = data[1][3];
-	const float z = data[2][3];
-	const float w = data[3][3];
-
-	Vector3 s = Vector3::Cross(a, b);
-	Vector3 t = Vector3::Cross(c, d);
-	Vector3 u = a * y - b * x;
-	Vector3 v = c * w - d * z;
-
-	const float det = Vector3::Dot(s, v) + Vector3::Dot(t, u);
-	assert((!AreEqual(det, 0.f)) && "ERROR: determinant is 0, there is no INVERSE!");
-	const float invDet = 1.f / det;
-
-	s *= invDet; t *= invDet; u *= invDet; v *= invDet;
-
-	const Vector3 r0 = Vector3::Cross(b, v) + t * y;
-	const Vector3 r1 = Vector3::Cross(v, a) - t * x;
-	const Vector3 r2 = Vector3::Cross(d, u) + s * w;
-	//Vector3 r3 = Vector3::Cross(u, c) - s * z;
-
-	data[0] = Vector4{ r0.x, r1.x, r2.x, 0.f };
-	data[1] = Vector4{ r0.y, r1.y, r2.y, 0.f };
-	data[2] = Vector4{ r0.z, r1.z, r2.z, 0.f };
-	data[3] = { -Vector3::Dot(b, t),Vector3::Dot(a, t),-Vector3::Dot(d, s),Vector3::Dot(c, s) };
-
-	return *this;
-}
+		const __m128 xHigh = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+		x = _mm_shuffle_ps(a, xHigh, _MM_SHUFFLE(2, 0, 3, 0));
 
-Matrix Matrix::Transpose(const Matrix& m)
-{
-	Matrix out{ m };
-	out.Transpose();
+		const __m128 yLow = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 1));
+		const __m128 yHigh = _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 2, 0, 3));
+		y = _mm_shuffle_ps(yLow, yHigh, _MM_SHUFFLE(2, 0, 2, 0));
 
-	return out;
-}
+		const __m128 zLow = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+		const __m128 zHigh = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+		z = _mm_shuffle_ps(zLow, zHigh, _MM_SHUFFLE(2, 0, 2, 0));
+	}
 
-Matrix Matrix::Inverse(const Matrix& m)
-{
-	Matrix out{ m };
-	out.Inverse();
+	inline void StoreXYZ4(float* p, __m128 x, __m128 y, __m128 z)
+	{
+		__m128 p0 = x, p1 = y, p2 = z, p3 = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(p0, p1, p2, p3);
 
-	return out;
-}
+		const __m128 a = _mm_shuffle_ps(p0, _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(0, 0, 2, 2)), _MM_SHUFFLE(2, 0, 1, 0));
+		const __m128 b = _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(1, 0, 2, 1));
+		const __m128 c = _mm_shuffle_ps(_mm_shuffle_ps(p2, p3, _MM_SHUFFLE(0, 0, 2, 2)), p3, _MM_SHUFFLE(2, 1, 2, 0));
 
-Matrix Matrix::CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up)
-{
-	assert(false && "Not Implemented");
-	return {};
-}
+		_mm_storeu_ps(p + 0, a);
+		_mm_storeu_ps(p + 4, b);
+		_mm_storeu_ps(p + 8, c);
+	}
 
-Matrix Matrix::CreatePerspectiveFovLH(float fov, float aspect, float zn, float zf)
-{
-	return
+	//laneWidth packed Vector3s <-> lanes
+	inline void LoadXYZ(const float* p, Lane& x, Lane& y, Lane& z)
 	{
-		{ 1.0f / (aspect * fov), 0.0f, 0.0f, 0.0f },
-		{ 0.0f, 1.0f / fov, 0.0f, 0.0f },
-		{ 0.0f, 0.0f, zf / (zf - zn), 1.0f},
-		{ 0.0f, 0.0f, -(zf * zn) / (zf - zn), 0.0f }
-	};
-}
-
-Vector3 Matrix::GetAxisX() const
-{
-	return data[0];
-}
+#if defined(__AVX__)
+		__m128 x0, y0, z0, x1, y1, z1;
+		LoadXYZ4(p, x0, y0, z0);
+		LoadXYZ4(p + 12, x1, y1, z1);
+		x = Combine(x0, x1);
+		y = Combine(y0, y1);
+		z = Combine(z0, z1);
+#else
+		LoadXYZ4(p, x, y, z);
+#endif
+	}
 
-Vector3 Matrix::GetAxisY() const
-{
-	return data[1];
-}
+	inline void StoreXYZ(float* p, Lane x, Lane y, Lane z)
+	{
+#if defined(__AVX__)
+		StoreXYZ4(p, LowHalf(x), LowHalf(y), LowHalf(z));
+		StoreXYZ4(p + 12, HighHalf(x), HighHalf(y), HighHalf(z));
+#else
+		StoreXYZ4(p, x, y, z);
+#endif
+	}
 
-Vector3 Matrix::GetAxisZ() const
-{
-	return data[2];
-}
+	//laneWidth packed Vector4s <-> lanes
+	inline void LoadXYZW(const float* p, Lane& x, Lane& y, Lane& z, Lane& w)
+	{
+		__m128 r[laneWidth];
+		for (size_t i{ 0 }; i < laneWidth; ++i) r[i] = _mm_loadu_ps(p + i * 4);
+		_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+#if defined(__AVX__)
+		_MM_TRANSPOSE4_PS(r[4], r[5], r[6], r[7]);
+		x = Combine(r[0], r[4]);
+		y = Combine(r[1], r[5]);
+		z = Combine(r[2], r[6]);
+		w = Combine(r[3], r[7]);
+#else
+		x = r[0]; y = r[1]; z = r[2]; w = r[3];
+#endif
+	}
 
-Vector3 Matrix::GetTranslation() const
-{
-	return data[3];
-}
+	inline void StoreXYZW(float* p, Lane x, Lane y, Lane z, Lane w)
+	{
+#if defined(__AVX__)
+		__m128 r[laneWidth]{ LowHalf(x), LowHalf(y), LowHalf(z), LowHalf(w), HighHalf(x), HighHalf(y), HighHalf(z), HighHalf(w) };
+		_MM_TRANSPOSE4_PS(r[4], r[5], r[6], r[7]);
+#else
+		__m128 r[laneWidth]{ x, y, z, w };
+#endif
+		_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+		for (size_t i{ 0 }; i < laneWidth; ++i) _mm_storeu_ps(p + i * 4, r[i]);
+	}
 
-Matrix Matrix::CreateTranslation(float x, float y, float z)
-{
-	return CreateTranslation({ x, y, z });
-}
+	//Strided fields can't be shuffled into place, so they go through a small aligned staging buffer
+	struct alignas(32) StridedLanes
+	{
+		float x[laneWidth];
+		float y[laneWidth];
+		float z[laneWidth];
 
-Matrix Matrix::CreateTranslation(const Vector3& t)
-{
-	return { Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, t };
-}
+		void Gather(const std::byte* pSrc, size_t stride)
+		{
+			for (size_t i{ 0 }; i < laneWidth; ++i)
+			{
+				const float* pElement = reinterpret_cast<const float*>(pSrc + i * stride);
+				x[i] = pElement[0];
+				y[i] = pElement[1];
+				z[i] = pElement[2];
+			}
+		}
 
-Matrix Matrix::CreateRotationX(float pitch)
-{
-	return {
-		{1, 0, 0, 0},
-		{0, cos(pitch), -sin(pitch), 0},
-		{0, sin(pitch), cos(pitch), 0},
-		{0, 0, 0, 1}
+		void Scatter(std::byte* pDst, size_t stride) const
+		{
+			for (size_t i{ 0 }; i < laneWidth; ++i)
+			{
+				float* pElement = reinterpret_cast<float*>(pDst + i * stride);
+				pElement[0] = x[i];
+				pElement[1] = y[i];
+				pElement[2] = z[i];
+			}
+		}
 	};
-}
+#endif
 
-Matrix Matrix::CreateRotationY(float yaw)
-{
-	return {
-		{cos(yaw), 0, -sin(yaw), 0},
-		{0, 1, 0, 0},
-		{sin(yaw), 0, cos(yaw), 0},
-		{0, 0, 0, 1}
-	};
-}
+	template<bool IsPoint>
+	void TransformVector3s(const Matrix& matrix, const std::byte* pSrc, size_t srcStride, std::byte* pDst, size_t dstStride, size_t count)
+	{
+		size_t i{ 0 };
+#if defined(MATH_USE_SSE)
+		const MatrixLanes m{ reinterpret_cast<const float*>(&matrix) };
+		const bool isPacked = srcStride == sizeof(Vector3) && dstStride == sizeof(Vector3);
 
-Matrix Matrix::CreateRotationZ(float roll)
-{
-	return {
-		{cos(roll), sin(roll), 0, 0},
-		{-sin(roll), cos(roll), 0, 0},
-		{0, 0, 1, 0},
-		{0, 0, 0, 1}
-	};
+		for (; i + laneWidth <= count; i += laneWidth)
+		{
+			Lane x, y, z;
+			StridedLanes staging;
+			if (isPacked)
+			{
+				LoadXYZ(reinterpret_cast<const float*>(pSrc + i * srcStride), x, y, z);
+			}
+			else
+			{
+				staging.Gather(pSrc + i * srcStride, srcStride);
+				x = LoadLane(staging.x);
+				y = LoadLane(staging.y);
+				z = LoadLane(staging.z);
+			}
+
+			const Lane outX = IsPoint ? m.Point(0, x, y, z) : m.Vector(0, x, y, z);
+			const Lane outY = IsPoint ? m.Point(1, x, y, z) : m.Vector(1, x, y, z);
+			const Lane outZ = IsPoint ? m.Point(2, x, y, z) : m.Vector(2, x, y, z);
+
+			if (isPacked)
+			{
+				StoreXYZ(reinterpret_cast<float*>(pDst + i * dstStride), outX, outY, outZ);
+			}
+			else
+			{
+				StoreLane(staging.x, outX);
+				StoreLane(staging.y, outY);
+				StoreLane(staging.z, outZ);
+				staging.Scatter(pDst + i * dstStride, dstStride);
+			}
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			const Vector3& v = *reinterpret_cast<const Vector3*>(pSrc + i * srcStride);
+			*reinterpret_cast<Vector3*>(pDst + i * dstStride) = IsPoint ? matrix.TransformPoint(v) : matrix.TransformVector(v);
+		}
+	}
 }
 
-Matrix Matrix::CreateRotation(float pitch, float yaw, float roll)
+void Matrix::TransformPoints(std::span<const Vector3> points, std::span<Vector3> out) const
 {
-	return CreateRotation({ pitch, yaw, roll });
+	assert(out.size() >= points.size());
+	TransformVector3s<true>(*this, reinterpret_cast<const std::byte*>(points.data()), sizeof(Vector3),
+		reinterpret_cast<std::byte*>(out.data()), sizeof(Vector3), points.size());
 }
 
-Matrix Matrix::CreateRotation(const Vector3& r)
+void Matrix::TransformVectors(std::span<const Vector3> vectors, std::span<Vector3> out) const
 {
-	return CreateRotationX(r[0]) * CreateRotationY(r[1]) * CreateRotationZ(r[2]);
+	assert(out.size() >= vectors.size());
+	TransformVector3s<false>(*this, reinterpret_cast<const std::byte*>(vectors.data()), sizeof(Vector3),
+		reinterpret_cast<std::byte*>(out.data()), sizeof(Vector3), vectors.size());
 }
 
-Matrix Matrix::CreateScale(float sx, float sy, float sz)
+void Matrix::TransformPoints(std::span<const Vector3> points, std::span<Vector4> out) const
 {
-	return { {sx, 0, 0}, {0, sy, 0}, {0, 0, sz}, Vector3::Zero };
+	assert(out.size() >= points.size());
+	size_t i{ 0 };
+#if defined(MATH_USE_SSE)
+	const MatrixLanes m{ reinterpret_cast<const float*>(data) };
+	for (; i + laneWidth <= points.size(); i += laneWidth)
+	{
+		Lane x, y, z;
+		LoadXYZ(&points[i].x, x, y, z);
+		StoreXYZW(&out[i].x, m.Point(0, x, y, z), m.Point(1, x, y, z), m.Point(2, x, y, z), m.Point(3, x, y, z));
+	}
+#endif
+	for (; i < points.size(); ++i)
+	{
+		out[i] = TransformPoint(points[i].x, points[i].y, points[i].z, 1.f);
+	}
 }
 
-Matrix Matrix::CreateScale(const Vector3& s)
+void Matrix::TransformPoints(std::span<const Vector4> points, std::span<Vector4> out) const
 {
-	return CreateScale(s[0], s[1], s[2]);
+	assert(out.size() >= points.size());
+	size_t i{ 0 };
+#if defined(MATH_USE_SSE)
+	const MatrixLanes m{ reinterpret_cast<const float*>(data) };
+	for (; i + laneWidth <= points.size(); i += laneWidth)
+	{
+		Lane x, y, z, w;
+		LoadXYZW(&points[i].x, x, y, z, w);
+		StoreXYZW(&out[i].x, m.Point(0, x, y, z, w), m.Point(1, x, y, z, w), m.Point(2, x, y, z, w), m.Point(3, x, y, z, w));
+	}
+#endif
+	for (; i < points.size(); ++i)
+	{
+		out[i] = TransformPoint(points[i]);
+	}
 }
 
-#pragma region Operator Overloads
-Vector4& Matrix::operator[](int index)
+void Matrix::TransformPointsStrided(const void* pSrc, size_t srcStride, void* pDst, size_t dstStride, size_t count) const
 {
-	assert(index <= 3 && index >= 0);
-	return data[index];
+	TransformVector3s<true>(*this, static_cast<const std::byte*>(pSrc), srcStride, static_cast<std::byte*>(pDst), dstStride, count);
 }
 
-Vector4 Matrix::operator[](int index) const
+void Matrix::TransformVectorsStrided(const void* pSrc, size_t srcStride, void* pDst, size_t dstStride, size_t count) const
 {
-	assert(index <= 3 && index >= 0);
-	return data[index];
+	TransformVector3s<false>(*this, static_cast<const std::byte*>(pSrc), srcStride, static_cast<std::byte*>(pDst), dstStride, count);
 }
 
-Matrix Matrix::operator*(const Matrix& m) const
+void Matrix::CreateRotations(std::span<const Vector3> eulerAngles, std::span<Matrix> out)
 {
-	Matrix result{};
-	Matrix m_transposed = Transpose(m);
-
-	for (int r{ 0 }; r < 4; ++r)
+	assert(out.size() >= eulerAngles.size());
+	size_t i{ 0 };
+#if defined(MATH_USE_SSE)
+	const Lane zero = Broadcast(0.f);
+	for (; i + laneWidth <= eulerAngles.size(); i += laneWidth)
 	{
-		for (int c{ 0 }; c < 4; ++c)
+		Lane x, y, z;
+		LoadXYZ(&eulerAngles[i].x, x, y, z);
+
+		Lane sx, cx, sy, cy, sz, cz;
+		SIMD::SinCos(x, sx, cx);
+		SIMD::SinCos(y, sy, cy);
+		SIMD::SinCos(z, sz, cz);
+
+		//Same closed form as CreateRotation, one lane per matrix
+		const Lane negSxSy = Sub(zero, Mul(sx, sy)), cxSy = Mul(cx, sy);
+		alignas(32) float e[9][laneWidth];
+		StoreLane(e[0], Mul(cy, cz));
+		StoreLane(e[1], Mul(cy, sz));
+		StoreLane(e[2], Sub(zero, sy));
+		StoreLane(e[3], Sub(Mul(negSxSy, cz), Mul(cx, sz)));
+		StoreLane(e[4], MulAdd(negSxSy, sz, Mul(cx, cz)));
+		StoreLane(e[5], Mul(Sub(zero, sx), cy));
+		StoreLane(e[6], Sub(Mul(cxSy, cz), Mul(sx, sz)));
+		StoreLane(e[7], MulAdd(cxSy, sz, Mul(sx, cz)));
+		StoreLane(e[8], Mul(cx, cy));
+
+		for (size_t k{ 0 }; k < laneWidth; ++k)
 		{
-			result[r][c] = Vector4::Dot(data[r], m_transposed[c]);
+			out[i + k] = Matrix{
+				Vector4{ e[0][k], e[1][k], e[2][k], 0.f },
+				Vector4{ e[3][k], e[4][k], e[5][k], 0.f },
+				Vector4{ e[6][k], e[7][k], e[8][k], 0.f },
+				Vector4{ 0.f, 0.f, 0.f, 1.f }
+			};
 		}
 	}
-
-	return result;
-}
-
-const Matrix& Matrix::operator*=(const Matrix& m)
-{
-	Matrix copy{ *this };
-	Matrix m_transposed = Transpose(m);
-
-	for (int r{ 0 }; r < 4; ++r)
+#endif
+	for (; i < eulerAngles.size(); ++i)
 	{
-		for (int c{ 0 }; c < 4; ++c)
-		{
-			data[r][c] = Vector4::Dot(copy[r], m_transposed[c]);
-		}
+		out[i] = CreateRotation(eulerAngles[i]);
 	}
-
-	return *this;
 }
-#pragma endregion
\ No newline at end of file
@@ -1,64 +1,293 @@
 #pragma once
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+#include "MathHelpers.h"
+#include "SIMD.h"
 #include "Vector3.h"
 #include "Vector4.h"
 
 struct Matrix
 {
-	Matrix() = default;
-	Matrix(
+	constexpr Matrix() noexcept = default;
+	constexpr Matrix(
 		const Vector3& xAxis,
 		const Vector3& yAxis,
 		const Vector3& zAxis,
-		const Vector3& t);
+		const Vector3& t) noexcept :
+		Matrix({ xAxis, 0 }, { yAxis, 0 }, { zAxis, 0 }, { t, 1 })
+	{
+	}
 
-	Matrix(
+	constexpr Matrix(
 		const Vector4& xAxis,
 		const Vector4& yAxis,
 		const Vector4& zAxis,
-		const Vector4& t);
-
-	Matrix(const Matrix& m);
-
-	Vector3 TransformVector(const Vector3& v) const;
-	Vector3 TransformVector(float x, float y, float z) const;
-	Vector3 TransformPoint(const Vector3& p) const;
-	Vector3 TransformPoint(float x, float y, float z) const;
-
-	Vector4 TransformPoint(const Vector4& p) const;
-	Vector4 TransformPoint(float x, float y, float z, float w) const;
-
-	const Matrix& Transpose();
-	const Matrix& Inverse();
-
-	Vector3 GetAxisX() const;
-	Vector3 GetAxisY() const;
-	Vector3 GetAxisZ() const;
-	Vector3 GetTranslation() const;
-
-	static Matrix CreateTranslation(float x, float y, float z);
-	static Matrix CreateTranslation(const Vector3& t);
-	static Matrix CreateRotationX(float pitch);
-	static Matrix CreateRotationY(float yaw);
-	static Matrix CreateRotationZ(float roll);
-	static Matrix CreateRotation(float pitch, float yaw, float roll);
-	static Matrix CreateRotation(const Vector3& r);
-	static Matrix CreateScale(float sx, float sy, float sz);
-	static Matrix CreateScale(const Vector3& s);
-	static Matrix Transpose(const Matrix& m);
-	static Matrix Inverse(const Matrix& m);
-
-	static Matrix CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up);
-	static Matrix CreatePerspectiveFovLH(float fovy, float aspect, float zn, float zf);
-
-	Vector4& operator[](int index);
-	Vector4 operator[](int index) const;
-	Matrix operator*(const Matrix& m) const;
-	const Matrix& operator*=(const Matrix& m);
+		const Vector4& t) noexcept :
+		data{ xAxis, yAxis, zAxis, t }
+	{
+	}
+
+	constexpr Vector3 TransformVector(const Vector3& v) const noexcept
+	{
+		return TransformVector(v.x, v.y, v.z);
+	}
+
+	constexpr Vector3 TransformVector(float x, float y, float z) const noexcept
+	{
+		return Vector3{
+			data[0].x * x + data[1].x * y + data[2].x * z,
+			data[0].y * x + data[1].y * y + data[2].y * z,
+			data[0].z * x + data[1].z * y + data[2].z * z
+		};
+	}
+
+	constexpr Vector3 TransformPoint(const Vector3& p) const noexcept
+	{
+		return TransformPoint(p.x, p.y, p.z);
+	}
+
+	constexpr Vector3 TransformPoint(float x, float y, float z) const noexcept
+	{
+		return Vector3{
+			data[0].x * x + data[1].x * y + data[2].x * z + data[3].x,
+			data[0].y * x + data[1].y * y + data[2].y * z + data[3].y,
+			data[0].z * x + data[1].z * y + data[2].z * z + data[3].z,
+		};
+	}
+
+	constexpr Vector4 TransformPoint(const Vector4& p) const noexcept
+	{
+		return TransformPoint(p.x, p.y, p.z, p.w);
+	}
+
+	constexpr Vector4 TransformPoint(float x, float y, float z, float w) const noexcept
+	{
+		return Vector4{
+			data[0].x * x + data[1].x * y + data[2].x * z + data[3].x * w,
+			data[0].y * x + data[1].y * y + data[2].y * z + data[3].y * w,
+			data[0].z * x + data[1].z * y + data[2].z * z + data[3].z * w,
+			data[0].w * x + data[1].w * y + data[2].w * z + data[3].w * w
+		};
+	}
+
+	//Batched transforms, 4 (SSE) or 8 (AVX) elements per instruction in SoA form (Matrix.cpp).
+	//out has to be at least as large as the input; in-place (out == in) is allowed.
+	void TransformPoints(std::span<const Vector3> points, std::span<Vector3> out) const;
+	void TransformVectors(std::span<const Vector3> vectors, std::span<Vector3> out) const;
+	void TransformPoints(std::span<const Vector3> points, std::span<Vector4> out) const; //homogeneous result (w not divided)
+	void TransformPoints(std::span<const Vector4> points, std::span<Vector4> out) const;
+
+	//Strided variants for Vector3 fields inside larger structs (e.g. Vertex::position / normal / tangent).
+	//Strides are in bytes; source and destination may be the same memory.
+	void TransformPointsStrided(const void* pSrc, size_t srcStride, void* pDst, size_t dstStride, size_t count) const;
+	void TransformVectorsStrided(const void* pSrc, size_t srcStride, void* pDst, size_t dstStride, size_t count) const;
+
+	constexpr const Matrix& Transpose() noexcept
+	{
+		const Matrix copy{ *this };
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			for (int c{ 0 }; c < 4; ++c)
+			{
+				data[r][c] = copy.data[c][r];
+			}
+		}
+
+		return *this;
+	}
+
+	constexpr const Matrix& Inverse()
+	{
+		//Optimized Inverse as explained in FGED1 - used widely in other libraries too.
+		const Vector3 a = data[0];
+		const Vector3 b = data[1];
+		const Vector3 c = data[2];
+		const Vector3 d = data[3];
+
+		const float x = data[0][3];
+		const float y = data[1][3];
+		const float z = data[2][3];
+		const float w = data[3][3];
+
+		Vector3 s = Vector3::Cross(a, b);
+		Vector3 t = Vector3::Cross(c, d);
+		Vector3 u = a * y - b * x;
+		Vector3 v = c * w - d * z;
+
+		const float det = Vector3::Dot(s, v) + Vector3::Dot(t, u);
+		assert((!AreEqual(det, 0.f)) && "ERROR: determinant is 0, there is no INVERSE!");
+		const float invDet = 1.f / det;
+
+		s *= invDet; t *= invDet; u *= invDet; v *= invDet;
+
+		const Vector3 r0 = Vector3::Cross(b, v) + t * y;
+		const Vector3 r1 = Vector3::Cross(v, a) - t * x;
+		const Vector3 r2 = Vector3::Cross(d, u) + s * w;
+		//Vector3 r3 = Vector3::Cross(u, c) - s * z;
+
+		data[0] = Vector4{ r0.x, r1.x, r2.x, 0.f };
+		data[1] = Vector4{ r0.y, r1.y, r2.y, 0.f };
+		data[2] = Vector4{ r0.z, r1.z, r2.z, 0.f };
+		data[3] = { -Vector3::Dot(b, t),Vector3::Dot(a, t),-Vector3::Dot(d, s),Vector3::Dot(c, s) };
+
+		return *this;
+	}
+
+	constexpr Vector3 GetAxisX() const noexcept { return data[0]; }
+	constexpr Vector3 GetAxisY() const noexcept { return data[1]; }
+	constexpr Vector3 GetAxisZ() const noexcept { return data[2]; }
+	constexpr Vector3 GetTranslation() const noexcept { return data[3]; }
+
+	static constexpr Matrix CreateTranslation(float x, float y, float z) noexcept
+	{
+		return CreateTranslation({ x, y, z });
+	}
+
+	static constexpr Matrix CreateTranslation(const Vector3& t) noexcept
+	{
+		return { Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, t };
+	}
+
+	static Matrix CreateRotationX(float pitch) noexcept
+	{
+		const float c = std::cos(pitch), s = std::sin(pitch);
+		return {
+			{1, 0, 0, 0},
+			{0, c, -s, 0},
+			{0, s, c, 0},
+			{0, 0, 0, 1}
+		};
+	}
+
+	static Matrix CreateRotationY(float yaw) noexcept
+	{
+		const float c = std::cos(yaw), s = std::sin(yaw);
+		return {
+			{c, 0, -s, 0},
+			{0, 1, 0, 0},
+			{s, 0, c, 0},
+			{0, 0, 0, 1}
+		};
+	}
+
+	static Matrix CreateRotationZ(float roll) noexcept
+	{
+		const float c = std::cos(roll), s = std::sin(roll);
+		return {
+			{c, s, 0, 0},
+			{-s, c, 0, 0},
+			{0, 0, 1, 0},
+			{0, 0, 0, 1}
+		};
+	}
+
+	static Matrix CreateRotation(float pitch, float yaw, float roll) noexcept
+	{
+		return CreateRotation({ pitch, yaw, roll });
+	}
+
+	//CreateRotationX(r.x) * CreateRotationY(r.y) * CreateRotationZ(r.z) multiplied out by hand,
+	//with all three sine/cosine pairs coming from a single SinCos call
+	static Matrix CreateRotation(const Vector3& r) noexcept
+	{
+		float s[4], c[4];
+		SinCos(r.x, r.y, r.z, 0.f, s, c);
+
+		const float sxsy = s[0] * s[1], cxsy = c[0] * s[1];
+		return {
+			{ c[1] * c[2], c[1] * s[2], -s[1], 0 },
+			{ -sxsy * c[2] - c[0] * s[2], -sxsy * s[2] + c[0] * c[2], -s[0] * c[1], 0 },
+			{ cxsy * c[2] - s[0] * s[2], cxsy * s[2] + s[0] * c[2], c[0] * c[1], 0 },
+			{ 0, 0, 0, 1 }
+		};
+	}
+
+	//Batch variant: out[i] = CreateRotation(eulerAngles[i]), 4 (SSE) or 8 (AVX) matrices per SinCos (Matrix.cpp).
+	static void CreateRotations(std::span<const Vector3> eulerAngles, std::span<Matrix> out);
+
+	static constexpr Matrix CreateScale(float sx, float sy, float sz) noexcept
+	{
+		return { {sx, 0, 0}, {0, sy, 0}, {0, 0, sz}, Vector3::Zero };
+	}
+
+	static constexpr Matrix CreateScale(const Vector3& s) noexcept
+	{
+		return CreateScale(s.x, s.y, s.z);
+	}
+
+	static constexpr Matrix Transpose(const Matrix& m) noexcept
+	{
+		Matrix out{ m };
+		out.Transpose();
+
+		return out;
+	}
+
+	static constexpr Matrix Inverse(const Matrix& m)
+	{
+		Matrix out{ m };
+		out.Inverse();
+
+		return out;
+	}
+
+	static Matrix CreateLookAtLH(const Vector3& /*origin*/, const Vector3& /*forward*/, const Vector3& /*up*/)
+	{
+		assert(false && "Not Implemented");
+		return {};
+	}
+
+	static constexpr Matrix CreatePerspectiveFovLH(float fov, float aspect, float zn, float zf) noexcept
+	{
+		//DirectX Implementation => https://learn.microsoft.com/en-us/windows/win32/direct3d9/d3dxmatrixperspectivefovlh
+		return
+		{
+			{ 1.0f / (aspect * fov), 0.0f, 0.0f, 0.0f },
+			{ 0.0f, 1.0f / fov, 0.0f, 0.0f },
+			{ 0.0f, 0.0f, zf / (zf - zn), 1.0f},
+			{ 0.0f, 0.0f, -(zf * zn) / (zf - zn), 0.0f }
+		};
+	}
+
+#pragma region Operator Overloads
+	constexpr Vector4& operator[](int index)
+	{
+		assert(index <= 3 && index >= 0);
+		return data[index];
+	}
+
+	constexpr Vector4 operator[](int index) const
+	{
+		assert(index <= 3 && index >= 0);
+		return data[index];
+	}
+
+	constexpr Matrix operator*(const Matrix& m) const noexcept
+	{
+		Matrix result;
+		Multiply(*this, m, result);
+
+		return result;
+	}
+
+	constexpr const Matrix& operator*=(const Matrix& m) noexcept
+	{
+		Multiply(*this, m, *this);
+
+		return *this;
+	}
+#pragma endregion
+
+	static const Matrix Identity;
 
 private:
 
-	//Row-Major Matrix
-	Vector4 data[4]
+	//Row-Major Matrix, 16-byte aligned so every row is a single SSE load/store
+	alignas(16) Vector4 data[4]
 	{
 		{1,0,0,0}, //xAxis
 		{0,1,0,0}, //yAxis
@@ -70,4 +299,81 @@ private:
 	// v1x v1y v1z v1w
 	// v2x v2y v2z v2w
 	// v3x v3y v3z v3w
-};
\ No newline at end of file
+
+	//out = a * b: every output row is a linear combination of the rows of b, weighted by the matching row of a.
+	//All rows of b are read before anything is written, so out may alias a or b.
+	static constexpr void Multiply(const Matrix& lhs, const Matrix& rhs, Matrix& out) noexcept
+	{
+		if (std::is_constant_evaluated())
+		{
+			const Matrix b{ rhs };
+			for (int r{ 0 }; r < 4; ++r)
+			{
+				const Vector4 row = lhs.data[r];
+				out.data[r] = b.data[0] * row.x + b.data[1] * row.y + b.data[2] * row.z + b.data[3] * row.w;
+			}
+			return;
+		}
+
+		const float* a = &lhs.data[0].x;
+		const float* b = &rhs.data[0].x;
+		float* o = &out.data[0].x;
+#if defined(__AVX__)
+		//Two output rows per iteration: the low lane works on row r, the high lane on row r + 1
+		const __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 0));
+		const __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 4));
+		const __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 8));
+		const __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b + 12));
+
+		for (int r{ 0 }; r < 4; r += 2)
+		{
+			const __m256 rows = _mm256_loadu_ps(a + r * 4);
+			__m256 result = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x00), b0);
+#if defined(__FMA__) || defined(__AVX2__)
+			result = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, 0x55), b1, result);
+			result = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, 0xAA), b2, result);
+			result = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, 0xFF), b3, result);
+#else
+			result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x55), b1));
+			result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0xAA), b2));
+			result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0xFF), b3));
+#endif
+			_mm256_storeu_ps(o + r * 4, result);
+		}
+#elif defined(MATH_USE_SSE)
+		const __m128 b0 = _mm_load_ps(b + 0);
+		const __m128 b1 = _mm_load_ps(b + 4);
+		const __m128 b2 = _mm_load_ps(b + 8);
+		const __m128 b3 = _mm_load_ps(b + 12);
+
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			const __m128 row = _mm_load_ps(a + r * 4);
+			__m128 result = _mm_mul_ps(_mm_shuffle_ps(row, row, 0x00), b0);
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(row, row, 0x55), b1));
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(row, row, 0xAA), b2));
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(row, row, 0xFF), b3));
+			_mm_store_ps(o + r * 4, result);
+		}
+#else
+		float bCopy[16];
+		for (int i{ 0 }; i < 16; ++i) bCopy[i] = b[i];
+
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			const float a0 = a[r * 4 + 0], a1 = a[r * 4 + 1], a2 = a[r * 4 + 2], a3 = a[r * 4 + 3];
+			for (int c{ 0 }; c < 4; ++c)
+			{
+				o[r * 4 + c] = a0 * bCopy[c] + a1 * bCopy[4 + c] + a2 * bCopy[8 + c] + a3 * bCopy[12 + c];
+			}
+		}
+#endif
+	}
+};
+
+inline constexpr Matrix Matrix::Identity{};
+
+static_assert(std::is_trivially_copyable_v<Matrix>, "Matrix is copied with memcpy semantics (SIMD kernels, effect upload)");
+static_assert(alignof(Matrix) == 16 && sizeof(Matrix) == 64, "Matrix rows must be 16-byte aligned float4s");
+static_assert(Matrix::CreateScale(2.f, 3.f, 4.f)[1][1] == 3.f, "fixed matrices are built at compile time");
+static_assert((Matrix::CreateTranslation(1.f, 2.f, 3.f) * Matrix::CreateScale(2.f, 2.f, 2.f)).GetTranslation() == Vector3{ 2.f, 4.f, 6.f });
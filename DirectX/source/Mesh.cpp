@@ -2,40 +2,56 @@
 #include "Mesh.h"
 #include "Effect.h"
 #include "Texture.h"
+#include "Camera.h"
 
-Mesh::Mesh(ID3D11Device* pDevice, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
-	: m_pEffect{ std::make_unique<Effect>(pDevice, L"Resources/PosCol3D.fx") },
-	m_pDiffuseTexture{ std::make_unique<Texture>(pDevice,"Resources/ak47_default.png") },
-	m_pNormalTexture{ std::make_unique<Texture>(pDevice,"Resources/ak47_default_normal.png") },
-	m_pSpecularTexture{ std::make_unique<Texture>(pDevice,"Resources/ak47_default_specular.png") },
-	m_pGlossinessTexture{ std::make_unique<Texture>(pDevice,"Resources/ak47_default_gloss.png") }
+namespace
 {
-	// Create Vertex Layout
-	static constexpr uint32_t numElements{ 4 };
-	D3D11_INPUT_ELEMENT_DESC vertexDesc[numElements]{};
-
-	vertexDesc[0].SemanticName = "POSITION";
-	vertexDesc[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	vertexDesc[0].AlignedByteOffset = 0;
-	vertexDesc[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	//Both single-channel maps go into one texture, the shader reads them from a single sample
+	const TextureFile::ChannelSource surfaceChannels[]{ { "Resources/ak47_default_specular.png", 0 }, { "Resources/ak47_default_gloss.png", 0 } };
+}
 
-	//vertexDesc[1].SemanticName = "COLOR";
-	//vertexDesc[1].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	vertexDesc[1].SemanticName = "TEXCOORD";
-	vertexDesc[1].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	vertexDesc[1].AlignedByteOffset = 12;
-	vertexDesc[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+Mesh::Mesh(ID3D11Device* pDevice, TextureCache& textures, const MeshView& mesh)
+	: Mesh{ pDevice, textures, mesh, VertexLayout::Find(mesh.attributes) }
+{
+}
 
+Mesh::Mesh(ID3D11Device* pDevice, TextureCache& textures, const MeshView& mesh, const VertexLayout::Desc* pLayout)
+	: m_pEffect{ std::make_unique<Effect>(pDevice, L"Resources/PosCol3D.fx") },
+	m_DiffuseTexture{ textures.Load("Resources/ak47_default.png") },
+	m_NormalTexture{ textures.Load("Resources/ak47_default_normal.png", MipChain::Content::Normal) },
+	m_SurfaceTexture{ textures.LoadPacked(surfaceChannels, "Resources/ak47_default_surface.tex") }
+{
+	m_LocalBounds = mesh.bounds;
+	m_Submeshes.assign(mesh.submeshes.begin(), mesh.submeshes.end());
+	if (m_Submeshes.empty())
+		m_Submeshes.push_back({ 0, mesh.indexCount, 0, 0, mesh.bounds });
+	m_LODs.assign(mesh.lods.begin(), mesh.lods.end());
+	if (m_LODs.empty())
+		m_LODs.push_back({ 0, static_cast<uint32_t>(m_Submeshes.size()), 0.f, 0 });
+
+	//Meshlets are in index order, so every submesh's are the ones starting inside it
+	m_Meshlets.assign(mesh.meshlets.begin(), mesh.meshlets.end());
+	m_MeshletSpheres = Meshlets::GetSpheres(m_Meshlets);
+	for (const Submesh& submesh : m_Submeshes)
+	{
+		const auto startsBefore = [](const Meshlet& meshlet, uint32_t index) { return meshlet.firstIndex < index; };
+		const auto first = std::lower_bound(m_Meshlets.begin(), m_Meshlets.end(), submesh.firstIndex, startsBefore);
+		const auto end = std::lower_bound(first, m_Meshlets.end(), submesh.firstIndex + submesh.indexCount, startsBefore);
+		m_SubmeshMeshlets.emplace_back(static_cast<uint32_t>(first - m_Meshlets.begin()), static_cast<uint32_t>(end - first));
+	}
+	DrawWholeLOD();
 
-	vertexDesc[2].SemanticName = "NORMAL";
-	vertexDesc[2].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	vertexDesc[2].AlignedByteOffset = 20;
-	vertexDesc[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	if (!pLayout)
+	{
+		std::cout << "Mesh: vertex format without an input layout\n";
+		return;
+	}
 
-	vertexDesc[3].SemanticName = "TANGENT";
-	vertexDesc[3].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-	vertexDesc[3].AlignedByteOffset = 32;
-	vertexDesc[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	// Every vertex format has its own vertex shader, packed ones also need the quantization range of the positions
+	m_pEffect->SetVertexInput(pLayout->vertexInput);
+	if (pLayout->vertexInput == Effect::VertexInput::Packed)
+		m_pEffect->SetPositionDequantization(mesh.bounds.GetMin(), mesh.bounds.extents * 2.f);
+	m_VertexStride = pLayout->stride;
 
 	// Create Input Layout
 	D3DX11_PASS_DESC passDesc{};
@@ -43,8 +59,8 @@ Mesh::Mesh(ID3D11Device* pDevice, const std::vector<Vertex>& vertices, const std
 
 	HRESULT result{ pDevice->CreateInputLayout
 		(
-			vertexDesc,
-			numElements,
+			pLayout->elements.data(),
+			static_cast<UINT>(pLayout->elements.size()),
 			passDesc.pIAInputSignature,
 			passDesc.IAInputSignatureSize,
 			&m_pInputLayout
@@ -54,25 +70,26 @@ Mesh::Mesh(ID3D11Device* pDevice, const std::vector<Vertex>& vertices, const std
 	// Create vertex buffer
 	D3D11_BUFFER_DESC bd{};
 	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(Vertex) * static_cast<uint32_t>(vertices.size());
+	bd.ByteWidth = m_VertexStride * mesh.vertexCount;
 	bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	bd.CPUAccessFlags = 0;
 	bd.MiscFlags = 0;
 
 	D3D11_SUBRESOURCE_DATA initData{};
-	initData.pSysMem = vertices.data();
+	initData.pSysMem = mesh.pVertices;
 
 	result = pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffer);
 	if (FAILED(result)) return;
 
 	// Create index buffer
-	m_NumIndices = static_cast<uint32_t>(indices.size());
+	m_NumIndices = mesh.indexCount;
+	m_IndexFormat = mesh.indexSize == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(uint32_t) * m_NumIndices;
+	bd.ByteWidth = mesh.indexSize * m_NumIndices;
 	bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	bd.CPUAccessFlags = 0;
 	bd.MiscFlags = 0;
-	initData.pSysMem = indices.data();
+	initData.pSysMem = mesh.pIndices;
 
 	result = pDevice->CreateBuffer(&bd, &initData, &m_pIndexBuffer);
 	if (FAILED(result)) return;
@@ -80,10 +97,12 @@ Mesh::Mesh(ID3D11Device* pDevice, const std::vector<Vertex>& vertices, const std
 
 
 	// Textures
-	m_pEffect->SetDiffuseMap(m_pDiffuseTexture.get());
-	m_pEffect->SetNormalMap(m_pNormalTexture.get());
-	m_pEffect->SetSpecularMap(m_pSpecularTexture.get());
-	m_pEffect->SetGlossingessMap(m_pGlossinessTexture.get());
+	if (m_DiffuseTexture)
+		m_pEffect->SetDiffuseMap(m_DiffuseTexture.Get());
+	if (m_NormalTexture)
+		m_pEffect->SetNormalMap(m_NormalTexture.Get());
+	if (m_SurfaceTexture)
+		m_pEffect->SetSurfaceMap(m_SurfaceTexture.Get(), m_SurfaceTexture->GetChannel(0), m_SurfaceTexture->GetChannel(1));
 
 }
 
@@ -104,12 +123,11 @@ void Mesh::Render(ID3D11DeviceContext* pDeviceContext) const
 	pDeviceContext->IASetInputLayout(m_pInputLayout);
 
 	// 3. Set vertex buffer
-	constexpr UINT stride{ sizeof(Vertex) };
 	constexpr UINT offset{};
-	pDeviceContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
+	pDeviceContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &m_VertexStride, &offset);
 
 	// 4. Set index buffer
-	pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, m_IndexFormat, 0);
 
 	// 5. Draw
 	D3DX11_TECHNIQUE_DESC techniqueDesc{};
@@ -117,7 +135,10 @@ void Mesh::Render(ID3D11DeviceContext* pDeviceContext) const
 	for (UINT p{}; p < techniqueDesc.Passes; ++p)
 	{
 		m_pEffect->GetTechnique()->GetPassByIndex(p)->Apply(0, pDeviceContext);
-		pDeviceContext->DrawIndexed(m_NumIndices, 0, 0);
+		for (const Meshlets::DrawRange& range : m_DrawRanges)
+		{
+			pDeviceContext->DrawIndexed(range.indexCount, range.firstIndex, range.baseVertex);
+		}
 	}
 }
 
@@ -133,22 +154,65 @@ void Mesh::SetFilterTechnique(Effect::FilterMode mode)
 }
 void Mesh::Rotate(const Vector3& axis, float angle)
 {
-	Matrix rotationMatrix;
+	//Rounding slowly pulls the accumulated rotation away from unit length, so renormalize every so often
+	static constexpr uint32_t rotationsPerNormalize{ 64 };
 
-	if (axis == Vector3::UnitX)
-		rotationMatrix = Matrix::CreateRotationX(angle);
-	else if (axis == Vector3::UnitY)
-		rotationMatrix = Matrix::CreateRotationY(angle);
-	else if (axis == Vector3::UnitZ)
-		rotationMatrix = Matrix::CreateRotationZ(angle);
+	m_Rotation *= Quaternion::FromAxisAngle(axis, angle);
 
-	m_RotationMatrix = rotationMatrix * m_RotationMatrix;
+	if (++m_RotationsSinceNormalize >= rotationsPerNormalize)
+	{
+		m_Rotation.Normalize();
+		m_RotationsSinceNormalize = 0;
+	}
 }
 
 void Mesh::UpdateViewMatrices(const Matrix& viewProjectionMatrix, const Matrix& inverseViewMatrix)
 {
-	Matrix world{ m_ScaleMatrix * m_RotationMatrix * m_TranslationMatrix };
+	const AffineTransform world{ GetWorldTransform() };
 	m_pEffect->SetWorldViewProjectionMatrix(world * viewProjectionMatrix);
 	m_pEffect->SetInvViewMatrix(inverseViewMatrix);
-	m_pEffect->SetWorldMatrix(world);
+	m_pEffect->SetWorldMatrix(world.ToMatrix());
+}
+
+void Mesh::SelectLOD(const Camera& camera, float viewportHeight, float maxPixelError)
+{
+	const AABB bounds = GetWorldBounds();
+	const Vector3 min = bounds.GetMin(), max = bounds.GetMax();
+	const Vector3 closest{ std::clamp(camera.origin.x, min.x, max.x), std::clamp(camera.origin.y, min.y, max.y), std::clamp(camera.origin.z, min.z, max.z) };
+	const float distance = (closest - camera.origin).Magnitude();
+
+	//LOD errors are in mesh units, the largest scale bounds how far they move in the world
+	const float scale = std::max({ std::abs(m_Scale.x), std::abs(m_Scale.y), std::abs(m_Scale.z) });
+	m_CurrentLOD = ::SelectLOD(m_LODs, camera.GetPixelsPerUnit(distance, viewportHeight) * scale, maxPixelError);
+	DrawWholeLOD();
+}
+
+void Mesh::CullMeshlets(const Camera& camera)
+{
+	if (m_Meshlets.empty())
+		return;
+
+	//Planes of world * view * projection are the frustum in the mesh's own space
+	const AffineTransform world{ GetWorldTransform() };
+	Frustum::FromViewProjection(world * camera.GetWorldViewProjection()).Cull(m_MeshletSpheres, m_MeshletVisibility);
+	const Vector3 localCamera = world.InverseAffine().TransformPoint(camera.origin);
+	const bool isMirrored = m_Scale.x * m_Scale.y * m_Scale.z < 0.f;
+
+	m_DrawRanges.clear();
+	m_VisibleMeshletCount = 0;
+	const MeshLOD& lod = m_LODs[m_CurrentLOD];
+	for (uint32_t submesh{ lod.firstSubmesh }; submesh < lod.firstSubmesh + lod.submeshCount; ++submesh)
+	{
+		const auto [firstMeshlet, meshletCount] = m_SubmeshMeshlets[submesh];
+		m_VisibleMeshletCount += Meshlets::AppendVisible(m_Meshlets, firstMeshlet, meshletCount, m_MeshletVisibility, localCamera, !isMirrored,
+			m_Submeshes[submesh].baseVertex, m_DrawRanges);
+	}
+}
+
+void Mesh::DrawWholeLOD()
+{
+	m_DrawRanges.clear();
+	const MeshLOD& lod = m_LODs[m_CurrentLOD];
+	for (const Submesh& submesh : std::span<const Submesh>{ m_Submeshes }.subspan(lod.firstSubmesh, lod.submeshCount))
+		m_DrawRanges.push_back({ submesh.firstIndex, submesh.indexCount, submesh.baseVertex });
 }
@@ -4,10 +4,14 @@
 #include "Math.h"
 #include "Vector3.h"
 #include "DataTypes.h"
+#include "VertexLayout.h"
+#include "Meshlets.h"
+#include "TextureCache.h"
 
 class Effect;
 class Matrix;
 class Texture;
+struct Camera;
 
 
 //struct Vertex_PosCol final
@@ -21,7 +25,16 @@ class Mesh final
 {
 
 public:
-	Mesh(ID3D11Device* pDevice, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+	//Any vertex format with a float position; its input layout is picked at compile time.
+	//The material's textures come from the cache, shared with every other mesh that uses them.
+	template<typename VertexType, typename Index>
+	Mesh(ID3D11Device* pDevice, TextureCache& textures, const std::vector<VertexType>& vertices, const std::vector<Index>& indices)
+		: Mesh{ pDevice, textures, MeshView::FromVertices(vertices, indices), &VertexLayout::desc<VertexType> }
+	{
+	}
+	//Uploads straight from the view's pointers, e.g. into a mapped .mesh file (CookedMesh).
+	//The input layout is the one of the VertexFormats entry with the view's attributes, a view in any other format isn't drawn.
+	Mesh(ID3D11Device* pDevice, TextureCache& textures, const MeshView& mesh);
 	Mesh(const Mesh& other) = delete;
 	Mesh& operator=(const Mesh& other) = delete;
 	Mesh(Mesh&& other) = delete;
@@ -35,30 +48,65 @@ public:
 	void SetFilterTechnique(Effect::FilterMode mode);
 
 	/// <summary>
-	/// To rotate around the X-axis, you'd call Rotate(Vector3::UnitX, angle).
-	/// For the Y - axis, it'd be Rotate(Vector3::UnitY, angle).
-	/// And for the Z - axis, it'd be Rotate(Vector3::UnitZ, angle).
+	/// Rotates the mesh around an arbitrary (not necessarily normalized) axis in its local space,
+	/// e.g. Rotate(Vector3::UnitY, angle) or Rotate(Vector3(deltaY, deltaX, 0), angle).
+	/// A zero axis leaves the rotation untouched.
 	/// </summary>
 	/// <param name="Vector3:">X,Y,Z</param>
 	/// <param name="angle:">angle which the mesh is rotated by</param>
 	void Rotate(const Vector3& axis,float angle);
 	void UpdateViewMatrices(const Matrix& viewProjectionMatrix, const Matrix& inverseViewMatrix);
+
+	//Draws the coarsest LOD whose error projects to at most maxPixelError pixels, measured at the point of the world bounds
+	//closest to the camera
+	void SelectLOD(const Camera& camera, float viewportHeight, float maxPixelError = 1.f);
+	size_t GetLODCount() const { return m_LODs.size(); }
+	size_t GetCurrentLOD() const { return m_CurrentLOD; }
+
+	//Limits the current LOD's draws to its meshlets inside the camera's frustum that don't face away from it; meshes
+	//without meshlets draw the whole LOD. Call after SelectLOD, which draws the whole LOD again.
+	void CullMeshlets(const Camera& camera);
+	size_t GetVisibleMeshletCount() const { return m_VisibleMeshletCount; }
+
+	//Bounds of the vertices as passed to the constructor, and those bounds moved by the current world transform
+	const AABB& GetLocalBounds() const { return m_LocalBounds; }
+	AABB GetWorldBounds() const { return m_LocalBounds.Transformed(GetWorldTransform()); }
 private:
+	Mesh(ID3D11Device* pDevice, TextureCache& textures, const MeshView& mesh, const VertexLayout::Desc* pLayout);
+
+	AffineTransform GetWorldTransform() const { return AffineTransform::Create(m_Scale, m_Rotation, m_Position); }
 
 	std::unique_ptr<Effect> m_pEffect{};
-	std::unique_ptr<Texture> m_pDiffuseTexture{};
-	std::unique_ptr<Texture> m_pNormalTexture{};
-	std::unique_ptr<Texture> m_pSpecularTexture{};
-	std::unique_ptr<Texture> m_pGlossinessTexture{};
+	TextureHandle m_DiffuseTexture{};
+	TextureHandle m_NormalTexture{};
+	TextureHandle m_SurfaceTexture{};	//specular intensity and glossiness
 
 	ID3D11InputLayout* m_pInputLayout{};
 
+	UINT m_VertexStride{ sizeof(Vertex) };
 	uint32_t m_NumIndices{};
+	DXGI_FORMAT m_IndexFormat{ DXGI_FORMAT_R32_UINT };
+	std::vector<Submesh> m_Submeshes{};
+	std::vector<MeshLOD> m_LODs{};
+	size_t m_CurrentLOD{};
+
+	//Meshlets of all LODs with their spheres for Frustum::Cull, and the range of them in every submesh
+	std::vector<Meshlet> m_Meshlets{};
+	SphereArray m_MeshletSpheres{};
+	std::vector<uint32_t> m_MeshletVisibility{};
+	std::vector<std::pair<uint32_t, uint32_t>> m_SubmeshMeshlets{};
+	size_t m_VisibleMeshletCount{};
+	std::vector<Meshlets::DrawRange> m_DrawRanges{};
+
+	void DrawWholeLOD();
 
 	ID3D11Buffer* m_pVertexBuffer{};
 	ID3D11Buffer* m_pIndexBuffer{};
 
-	Matrix m_TranslationMatrix{ Vector3::UnitX,Vector3::UnitY,Vector3::UnitZ,Vector3::Zero };
-	Matrix m_RotationMatrix{ Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, Vector3::Zero };
-	Matrix m_ScaleMatrix{ Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, Vector3::Zero };
+	Vector3 m_Position{};
+	Quaternion m_Rotation{};
+	uint32_t m_RotationsSinceNormalize{};
+	Vector3 m_Scale{ 1.f, 1.f, 1.f };
+
+	AABB m_LocalBounds{};
 };
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include "pch.h"
+#include "MeshFile.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+#include "FBXImport.h"
+
+static_assert(std::endian::native == std::endian::little, ".mesh files are little endian and mapped as is");
+static_assert(sizeof(MeshFile::Header) == 152 && std::is_trivially_copyable_v<MeshFile::Header>);
+static_assert(sizeof(VertexAttribute) == 8 && sizeof(Submesh) == 40 && sizeof(MeshLOD) == 16 && sizeof(Meshlet) == 64);
+
+namespace
+{
+	uint64_t AlignUp(uint64_t offset)
+	{
+		return (offset + MeshFile::blobAlignment - 1) / MeshFile::blobAlignment * MeshFile::blobAlignment;
+	}
+
+	//[offset, offset + size) inside the file and aligned for T
+	template<typename T>
+	bool IsInFile(uint64_t offset, uint64_t count, uint64_t fileSize)
+	{
+		return offset % alignof(T) == 0 && offset <= fileSize && count <= (fileSize - offset) / sizeof(T);
+	}
+}
+
+namespace MeshFile
+{
+	bool Write(const std::string& path, const MeshView& mesh, uint64_t sourceHash)
+	{
+		//A mesh without a submesh table is drawn as one
+		std::vector<Submesh> submeshes(mesh.submeshes.begin(), mesh.submeshes.end());
+		if (submeshes.empty())
+			submeshes.push_back({ 0, mesh.indexCount, 0, 0, mesh.bounds });
+		//and without a LOD table as LOD 0 alone
+		std::vector<MeshLOD> lods(mesh.lods.begin(), mesh.lods.end());
+		if (lods.empty())
+			lods.push_back({ 0, static_cast<uint32_t>(submeshes.size()), 0.f, 0 });
+
+		Header header{};
+		header.sourceHash = sourceHash;
+		header.attributeCount = static_cast<uint32_t>(mesh.attributes.size());
+		header.vertexStride = mesh.vertexStride;
+		header.vertexCount = mesh.vertexCount;
+		header.indexSize = mesh.indexSize;
+		header.indexCount = mesh.indexCount;
+		header.submeshCount = static_cast<uint32_t>(submeshes.size());
+		header.lodCount = static_cast<uint32_t>(lods.size());
+		header.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+		header.meshletVertexCount = static_cast<uint32_t>(mesh.meshletVertices.size());
+		//Triangles only come with meshlets
+		const std::span<const uint8_t> meshletTriangles = mesh.meshlets.empty() ? std::span<const uint8_t>{} : mesh.meshletTriangles;
+		if (meshletTriangles.size() != (mesh.meshlets.empty() ? 0 : mesh.indexCount))
+			return false;
+		header.bounds = mesh.bounds;
+
+		uint64_t fileSize{ sizeof(Header) };
+		const auto place = [&fileSize](uint64_t size)
+			{
+				const uint64_t offset = AlignUp(fileSize);
+				fileSize = offset + size;
+				return offset;
+			};
+		header.attributeOffset = place(mesh.attributes.size_bytes());
+		header.submeshOffset = place(submeshes.size() * sizeof(Submesh));
+		header.lodOffset = place(lods.size() * sizeof(MeshLOD));
+		header.meshletOffset = place(mesh.meshlets.size_bytes());
+		header.meshletVertexOffset = place(mesh.meshletVertices.size_bytes());
+		header.meshletTriangleOffset = place(meshletTriangles.size_bytes());
+		header.vertexOffset = place(uint64_t(mesh.vertexCount) * mesh.vertexStride);
+		header.indexOffset = place(uint64_t(mesh.indexCount) * mesh.indexSize);
+		header.fileSize = fileSize;
+
+		const FileBlob blobs[]{
+			{ 0, &header, sizeof(Header) },
+			{ header.attributeOffset, mesh.attributes.data(), mesh.attributes.size_bytes() },
+			{ header.submeshOffset, submeshes.data(), submeshes.size() * sizeof(Submesh) },
+			{ header.lodOffset, lods.data(), lods.size() * sizeof(MeshLOD) },
+			{ header.meshletOffset, mesh.meshlets.data(), mesh.meshlets.size_bytes() },
+			{ header.meshletVertexOffset, mesh.meshletVertices.data(), mesh.meshletVertices.size_bytes() },
+			{ header.meshletTriangleOffset, meshletTriangles.data(), meshletTriangles.size_bytes() },
+			{ header.vertexOffset, mesh.pVertices, uint64_t(mesh.vertexCount) * mesh.vertexStride },
+			{ header.indexOffset, mesh.pIndices, uint64_t(mesh.indexCount) * mesh.indexSize }
+		};
+		return WriteFileAtomically(path, blobs);
+	}
+
+	MeshOptimizer::VertexCacheStats AnalyzeVertexCache(const MeshView& mesh)
+	{
+		const Submesh wholeMesh{ 0, mesh.indexCount, 0, 0, mesh.bounds };
+		const std::span<const Submesh> submeshes = mesh.submeshes.empty() ? std::span<const Submesh>{ &wholeMesh, 1 } : mesh.submeshes;
+		const std::span<const Submesh> lod0 = mesh.lods.empty() ? submeshes : submeshes.subspan(mesh.lods[0].firstSubmesh, mesh.lods[0].submeshCount);
+
+		std::vector<uint32_t> indices{};
+		for (const Submesh& submesh : lod0)
+		{
+			for (uint32_t corner{ submesh.firstIndex }; corner < submesh.firstIndex + submesh.indexCount; ++corner)
+			{
+				const uint32_t index = mesh.indexSize == sizeof(uint16_t) ? static_cast<const uint16_t*>(mesh.pIndices)[corner] : static_cast<const uint32_t*>(mesh.pIndices)[corner];
+				indices.push_back(static_cast<uint32_t>(submesh.baseVertex + static_cast<int32_t>(index)));
+			}
+		}
+		return MeshOptimizer::AnalyzeVertexCache(indices, mesh.vertexCount);
+	}
+
+	bool Import(const std::string& sourcePath, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const Utils::OBJImportSettings& settings,
+		Utils::OBJImportStats* pStats)
+	{
+		std::string extension = std::filesystem::path{ sourcePath }.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		if (extension != ".fbx")
+			return Utils::ParseOBJ(sourcePath, vertices, indices, settings, pStats);
+
+		FBX::ImportSettings fbxSettings{};
+		fbxSettings.flipAxisAndWinding = settings.flipAxisAndWinding;
+		fbxSettings.weldVertices = settings.weldVertices;
+		fbxSettings.threadCount = settings.threadCount;
+		FBX::ImportStats fbxStats{};
+		if (!FBX::Import(sourcePath, vertices, indices, fbxSettings, &fbxStats))
+			return false;
+
+		if (pStats)
+			*pStats = { fbxStats.cornerCount, fbxStats.vertexCount, fbxStats.indexCount };
+		return true;
+	}
+
+	bool Cook(const std::string& sourcePath, const std::string& meshPath, const CookSettings& settings, CookStats* pStats)
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		if (!Import(sourcePath, vertices, indices, settings.import, pStats ? &pStats->import : nullptr))
+			return false;
+
+		//Every level's triangles after the previous one's, each its own submesh and LOD for OptimizeLODs to take apart
+		std::vector<Submesh> submeshes{};
+		std::vector<MeshLOD> lods{};
+		if (!settings.lods.ratios.empty())
+		{
+			std::vector<MeshSimplifier::LODLevel> levels = MeshSimplifier::BuildLODChain(vertices, indices, settings.lods);
+			if (levels.size() > 1)
+			{
+				indices.clear();
+				for (const MeshSimplifier::LODLevel& level : levels)
+				{
+					lods.push_back({ static_cast<uint32_t>(submeshes.size()), 1, level.error, 0 });
+					submeshes.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(level.indices.size()), 0, 0, {} });
+					indices.insert(indices.end(), level.indices.begin(), level.indices.end());
+				}
+			}
+		}
+		MeshOptimizer::OptimizeLODs(vertices, indices, submeshes, lods, pStats ? &pStats->optimize : nullptr);
+
+		std::vector<uint16_t> indices16{};
+		const size_t duplicatedVertexCount = MeshOptimizer::SplitFor16BitIndices(vertices, indices, indices16, submeshes, &lods);
+
+		//On the 16-bit indices, whose chunks are the submeshes meshlets mustn't cross
+		Meshlets::MeshletData meshlets{};
+		if (settings.buildMeshlets)
+			Meshlets::Build(vertices, std::span<uint16_t>{ indices16 }, submeshes, meshlets);
+		const auto addMeshlets = [&meshlets](MeshView view)
+			{
+				view.meshlets = meshlets.meshlets;
+				view.meshletVertices = meshlets.vertices;
+				view.meshletTriangles = meshlets.triangles;
+				return view;
+			};
+		if (pStats)
+		{
+			pStats->optimize.after = AnalyzeVertexCache(MeshView::FromVertices(vertices, indices16, submeshes, lods));
+			pStats->submeshCount = std::max<size_t>(submeshes.size(), 1);
+			pStats->duplicatedVertexCount = duplicatedVertexCount;
+			pStats->meshletCount = meshlets.meshlets.size();
+			pStats->lods.clear();
+			for (const MeshLOD& lod : lods)
+			{
+				size_t indexCount{ 0 };
+				for (uint32_t submesh{ lod.firstSubmesh }; submesh < lod.firstSubmesh + lod.submeshCount; ++submesh)
+					indexCount += submeshes[submesh].indexCount;
+				pStats->lods.push_back({ indexCount / 3, lod.error });
+			}
+			if (pStats->lods.empty())
+				pStats->lods.push_back({ indices.size() / 3, 0.f });
+		}
+
+		if (!settings.packVertices)
+			return Write(meshPath, addMeshlets(MeshView::FromVertices(vertices, indices16, submeshes, lods)), HashSource(sourcePath, settings));
+
+		const AABB bounds = AABB::FromPoints(&vertices.data()->position, sizeof(Vertex), vertices.size());
+		std::vector<PackedVertex> packed(vertices.size());
+		VertexPacking::Encode(vertices, bounds, packed);
+		if (pStats)
+		{
+			std::vector<Vertex> decoded(vertices.size());
+			VertexPacking::Decode(packed, bounds, decoded);
+			pStats->packingError = VertexPacking::MeasureError(vertices, decoded);
+		}
+
+		return Write(meshPath, addMeshlets(MeshView::FromPackedVertices(packed, bounds, indices16, submeshes, lods)), HashSource(sourcePath, settings));
+	}
+
+	uint64_t HashSource(const std::string& sourcePath, const CookSettings& settings)
+	{
+		//The thread count doesn't change the output, the rest does
+		std::vector<uint32_t> cookKey{ version, settings.import.flipAxisAndWinding, settings.import.weldVertices, std::bit_cast<uint32_t>(settings.import.weldEpsilon),
+			settings.packVertices, settings.buildMeshlets, std::bit_cast<uint32_t>(settings.lods.maxError), settings.lods.simplify.lockBorders,
+			std::bit_cast<uint32_t>(settings.lods.simplify.uvWeight), std::bit_cast<uint32_t>(settings.lods.simplify.normalWeight) };
+		for (float ratio : settings.lods.ratios)
+			cookKey.push_back(std::bit_cast<uint32_t>(ratio));
+		const uint64_t seed = HashContent({ reinterpret_cast<const uint8_t*>(cookKey.data()), cookKey.size() * sizeof(uint32_t) });
+		return HashFile(sourcePath, seed);
+	}
+
+	bool IsUpToDate(const std::string& sourcePath, const std::string& cookedPath, const CookSettings& settings)
+	{
+		std::error_code error{};
+		if (!std::filesystem::exists(cookedPath, error))
+			return false;
+
+		Header header{};
+		{
+			std::ifstream file{ cookedPath, std::ios::binary };
+			if (!file.read(reinterpret_cast<char*>(&header), sizeof(Header)) || header.magic != magic || header.version != version)
+				return false;
+		}
+
+		if (!std::filesystem::exists(sourcePath, error))
+			return true;
+		return header.sourceHash == HashSource(sourcePath, settings);
+	}
+}
+
+CookedMesh::CookedMesh(const std::string& path)
+	: m_File{ path }
+{
+	if (!m_File.IsOpen() || m_File.GetSize() < sizeof(MeshFile::Header))
+		return;
+
+	const char* const pData = m_File.GetData();
+	MeshFile::Header header{};
+	std::memcpy(&header, pData, sizeof(MeshFile::Header));
+
+	const uint64_t fileSize = m_File.GetSize();
+	if (header.magic != MeshFile::magic || header.version != MeshFile::version || header.fileSize != fileSize)
+		return;
+
+	if (!IsInFile<VertexAttribute>(header.attributeOffset, header.attributeCount, fileSize)
+		|| !IsInFile<Submesh>(header.submeshOffset, header.submeshCount, fileSize)
+		|| !IsInFile<MeshLOD>(header.lodOffset, header.lodCount, fileSize)
+		|| !IsInFile<Meshlet>(header.meshletOffset, header.meshletCount, fileSize)
+		|| !IsInFile<uint32_t>(header.meshletVertexOffset, header.meshletVertexCount, fileSize)
+		|| !IsInFile<uint8_t>(header.meshletTriangleOffset, header.meshletCount > 0 ? header.indexCount : 0, fileSize)
+		|| (header.indexSize == sizeof(uint16_t) ? !IsInFile<uint16_t>(header.indexOffset, header.indexCount, fileSize)
+			: header.indexSize != sizeof(uint32_t) || !IsInFile<uint32_t>(header.indexOffset, header.indexCount, fileSize)))
+		return;
+
+	//One of the vertex formats Mesh has input layouts for
+	const std::span<const VertexAttribute> attributes{ reinterpret_cast<const VertexAttribute*>(pData + header.attributeOffset), header.attributeCount };
+	const bool isKnownFormat = VertexFormats::Find([&]<typename VertexType>()
+		{
+			return std::ranges::equal(attributes, VertexFormat<VertexType>::attributes)
+				&& header.vertexStride == sizeof(VertexType) && IsInFile<VertexType>(header.vertexOffset, header.vertexCount, fileSize);
+		});
+	if (!isKnownFormat)
+		return;
+
+	const std::span<const Submesh> submeshes{ reinterpret_cast<const Submesh*>(pData + header.submeshOffset), header.submeshCount };
+	for (const Submesh& submesh : submeshes)
+	{
+		if (submesh.firstIndex > header.indexCount || submesh.indexCount > header.indexCount - submesh.firstIndex
+			|| submesh.baseVertex < 0 || uint32_t(submesh.baseVertex) > header.vertexCount)
+			return;
+	}
+
+	//LODs cover consecutive submeshes; the table may be empty, then every submesh is LOD 0
+	const std::span<const MeshLOD> lods{ reinterpret_cast<const MeshLOD*>(pData + header.lodOffset), header.lodCount };
+	for (const MeshLOD& lod : lods)
+	{
+		if (lod.submeshCount == 0 || lod.firstSubmesh > header.submeshCount || lod.submeshCount > header.submeshCount - lod.firstSubmesh)
+			return;
+	}
+
+	//Meshlets are only ever drawn as ranges of the index buffer; their local lists are checked to lie in the file
+	const std::span<const Meshlet> meshlets{ reinterpret_cast<const Meshlet*>(pData + header.meshletOffset), header.meshletCount };
+	for (const Meshlet& meshlet : meshlets)
+	{
+		if (meshlet.firstIndex > header.indexCount || meshlet.triangleCount > (header.indexCount - meshlet.firstIndex) / 3
+			|| meshlet.firstVertex > header.meshletVertexCount || meshlet.vertexCount > header.meshletVertexCount - meshlet.firstVertex)
+			return;
+	}
+
+	m_View.attributes = attributes;
+	m_View.vertexStride = header.vertexStride;
+	m_View.vertexCount = header.vertexCount;
+	m_View.pVertices = pData + header.vertexOffset;
+	m_View.indexSize = header.indexSize;
+	m_View.indexCount = header.indexCount;
+	m_View.pIndices = pData + header.indexOffset;
+	m_View.submeshes = submeshes;
+	m_View.lods = lods;
+	m_View.meshlets = meshlets;
+	m_View.meshletVertices = { reinterpret_cast<const uint32_t*>(pData + header.meshletVertexOffset), header.meshletVertexCount };
+	m_View.meshletTriangles = { reinterpret_cast<const uint8_t*>(pData + header.meshletTriangleOffset), header.meshletCount > 0 ? header.indexCount : 0 };
+	m_View.bounds = header.bounds;
+	m_IsValid = true;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DataTypes.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+#include "Utils.h"
+#include "VertexPacking.h"
+
+//Cooked .mesh files: everything Mesh needs, laid out so a mapped file can be uploaded without parsing.
+//
+//	Header | vertex attributes | submeshes | LODs | meshlets | meshlet vertices | meshlet triangles | vertex blob | index blob
+//
+//Tables and blobs start at multiples of blobAlignment, little endian, no compression.
+namespace MeshFile
+{
+	constexpr uint32_t magic{ 0x4853454D };	//"MESH"
+	//Bump on any change to the layout or to what cooking produces, older files then count as stale
+	constexpr uint32_t version{ 8 };
+	constexpr uint64_t blobAlignment{ 64 };
+
+	struct Header
+	{
+		uint32_t magic{ MeshFile::magic };
+		uint32_t version{ MeshFile::version };
+		uint64_t fileSize{};
+		uint64_t sourceHash{};		//HashSource of what the file was cooked from
+
+		uint32_t attributeCount{};
+		uint32_t vertexStride{};
+		uint32_t vertexCount{};
+		uint32_t indexSize{};		//bytes per index, 2 or 4
+		uint32_t indexCount{};
+		uint32_t submeshCount{};
+		uint32_t lodCount{};
+		uint32_t meshletCount{};
+		uint32_t meshletVertexCount{};	//the meshlet triangles are indexCount bytes when there are meshlets
+		uint32_t reserved{};
+
+		uint64_t attributeOffset{};
+		uint64_t submeshOffset{};
+		uint64_t lodOffset{};
+		uint64_t meshletOffset{};
+		uint64_t meshletVertexOffset{};
+		uint64_t meshletTriangleOffset{};
+		uint64_t vertexOffset{};
+		uint64_t indexOffset{};
+
+		AABB bounds{};
+	};
+
+	bool Write(const std::string& path, const MeshView& mesh, uint64_t sourceHash = 0);
+
+	//LOD 0 through the simulated post-transform cache, every submesh's indices offset by its base vertex
+	MeshOptimizer::VertexCacheStats AnalyzeVertexCache(const MeshView& mesh);
+
+	struct CookSettings
+	{
+		Utils::OBJImportSettings import{};
+		bool packVertices{ false };		//write PackedVertex instead of Vertex
+		//Levels simplified from the imported triangles (no ratios: LOD 0 only)
+		MeshSimplifier::LODChainSettings lods{};
+		bool buildMeshlets{ true };
+	};
+
+	struct CookedLOD
+	{
+		size_t triangleCount{};
+		float error{};
+	};
+
+	struct CookStats
+	{
+		Utils::OBJImportStats import{};
+		//LOD 0 as imported, and as written: Meshlets::Build reorders the optimizer's triangles, so after is measured on the
+		//file's indices
+		MeshOptimizer::OptimizeStats optimize{};
+		size_t submeshCount{};
+		std::vector<CookedLOD> lods{};
+		size_t meshletCount{};
+		size_t duplicatedVertexCount{};	//copied into more than one 16-bit chunk
+		VertexPacking::PackingError packingError{};	//measured by decoding the packed vertices again, zero when not packed
+	};
+
+	//Imports a binary .fbx (FBX::Import) or, for any other extension, an OBJ (Utils::ParseOBJ) with the same axis, welding and
+	//thread settings. weldEpsilon only applies to OBJ files.
+	bool Import(const std::string& sourcePath, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const Utils::OBJImportSettings& settings = {},
+		Utils::OBJImportStats* pStats = nullptr);
+
+	//Imports the source file, simplifies it into a LOD chain, reorders it for the vertex cache, overdraw and vertex fetch,
+	//narrows the indices to 16 bits (splitting it into submeshes when it has more than 65536 vertices), groups the triangles
+	//into meshlets, optionally packs the vertices and writes it as a .mesh
+	bool Cook(const std::string& sourcePath, const std::string& meshPath, const CookSettings& settings = {}, CookStats* pStats = nullptr);
+
+	//The source file's bytes together with the settings that change what cooking produces, 0 when it can't be read
+	uint64_t HashSource(const std::string& sourcePath, const CookSettings& settings);
+
+	//True when the cooked file has the current version and was cooked from the source's current bytes with these settings.
+	//A missing source counts as up to date, so cooked files can ship on their own.
+	bool IsUpToDate(const std::string& sourcePath, const std::string& cookedPath, const CookSettings& settings);
+}
+
+//A mapped .mesh file. The view points into the mapping, so it is only valid while this object lives.
+class CookedMesh final
+{
+public:
+	explicit CookedMesh(const std::string& path);
+
+	CookedMesh(const CookedMesh&) = delete;
+	CookedMesh(CookedMesh&&) noexcept = delete;
+	CookedMesh& operator=(const CookedMesh&) = delete;
+	CookedMesh& operator=(CookedMesh&&) noexcept = delete;
+
+	//False for missing, truncated or foreign files, other versions and vertex formats not in VertexFormats
+	bool IsValid() const { return m_IsValid; }
+	const MeshView& GetView() const { return m_View; }
+
+private:
+	MappedFile m_File;
+	MeshView m_View{};
+	bool m_IsValid{ false };
+};
@@ -0,0 +1,562 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+	constexpr uint32_t noVertex{ ~0u };
+
+	//FIFO cache as timestamps: a vertex is cached while fewer than cacheSize misses happened since its own
+	class FIFOCache final
+	{
+	public:
+		FIFOCache(size_t vertexCount, uint32_t cacheSize)
+			: m_Timestamps(vertexCount, 0)
+			, m_CacheSize{ cacheSize }
+			, m_Time{ cacheSize + 1 }
+		{
+		}
+
+		bool Access(uint32_t vertex)
+		{
+			if (m_Time - m_Timestamps[vertex] <= m_CacheSize)
+				return false;
+			m_Timestamps[vertex] = m_Time++;
+			return true;
+		}
+
+		uint32_t GetAge(uint32_t vertex) const { return m_Time - m_Timestamps[vertex]; }
+		void Flush() { m_Time += m_CacheSize + 1; }
+
+	private:
+		std::vector<uint32_t> m_Timestamps;
+		uint32_t m_CacheSize;
+		uint32_t m_Time;
+	};
+
+	//|cross| weighted triangle centroids and the summed cross products of a range of triangles
+	struct ClusterShape
+	{
+		Vector3 weightedCentroid{};
+		Vector3 normal{};
+		float weight{};
+	};
+
+	ClusterShape GetClusterShape(std::span<const uint32_t> indices, const std::vector<Vertex>& vertices, uint32_t firstTriangle, uint32_t endTriangle)
+	{
+		ClusterShape shape{};
+		for (uint32_t triangle{ firstTriangle }; triangle < endTriangle; ++triangle)
+		{
+			const Vector3& p0 = vertices[indices[triangle * 3]].position;
+			const Vector3& p1 = vertices[indices[triangle * 3 + 1]].position;
+			const Vector3& p2 = vertices[indices[triangle * 3 + 2]].position;
+
+			//Clockwise front faces in a left-handed space: this points out of the visible side
+			const Vector3 normal = Vector3::Cross(p1 - p0, p2 - p0);
+			const float weight = normal.Magnitude();
+			shape.weightedCentroid += (p0 + p1 + p2) * (weight / 3.f);
+			shape.normal += normal;
+			shape.weight += weight;
+		}
+		return shape;
+	}
+
+	//Cuts the triangles into clusters whose ACMR is within maxClusterAcmr, counted from a flushed cache since a cluster can
+	//end up after any other one, and writes them to out with the ones facing away from the mesh centre first
+	void SortClusters(std::span<const uint32_t> indices, std::span<uint32_t> out, const std::vector<Vertex>& vertices, FIFOCache& cache, float maxClusterAcmr)
+	{
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		std::vector<uint32_t> splits{ 0 };
+		cache.Flush();
+		uint32_t clusterMisses{ 0 };
+		for (uint32_t triangle{ 0 }; triangle + 1 < triangleCount; ++triangle)
+		{
+			clusterMisses += cache.Access(indices[triangle * 3]) + cache.Access(indices[triangle * 3 + 1]) + cache.Access(indices[triangle * 3 + 2]);
+			if (static_cast<float>(clusterMisses) <= maxClusterAcmr * static_cast<float>(triangle + 1 - splits.back()))
+			{
+				splits.push_back(triangle + 1);
+				clusterMisses = 0;
+				cache.Flush();
+			}
+		}
+		splits.push_back(triangleCount);
+
+		const size_t clusterCount = splits.size() - 1;
+		std::vector<ClusterShape> shapes(clusterCount);
+		double centroid[3]{};
+		double weight{ 0.0 };
+		for (size_t cluster{ 0 }; cluster < clusterCount; ++cluster)
+		{
+			shapes[cluster] = GetClusterShape(indices, vertices, splits[cluster], splits[cluster + 1]);
+			centroid[0] += shapes[cluster].weightedCentroid.x;
+			centroid[1] += shapes[cluster].weightedCentroid.y;
+			centroid[2] += shapes[cluster].weightedCentroid.z;
+			weight += shapes[cluster].weight;
+		}
+		if (!(weight > 0.0))
+		{
+			std::copy(indices.begin(), indices.end(), out.begin());
+			return;
+		}
+
+		const Vector3 meshCentroid{ float(centroid[0] / weight), float(centroid[1] / weight), float(centroid[2] / weight) };
+
+		//How far out the cluster faces, clusters on the outside facing away from the centre occlude the most
+		std::vector<float> sortKeys(clusterCount, 0.f);
+		for (size_t cluster{ 0 }; cluster < clusterCount; ++cluster)
+		{
+			const ClusterShape& shape = shapes[cluster];
+			const float normalLength = shape.normal.Magnitude();
+			if (shape.weight > 0.f && normalLength > 0.f)
+			{
+				sortKeys[cluster] = Vector3::Dot(shape.weightedCentroid / shape.weight - meshCentroid, shape.normal) / normalLength;
+			}
+		}
+
+		std::vector<uint32_t> order(clusterCount);
+		for (uint32_t cluster{ 0 }; cluster < clusterCount; ++cluster)
+		{
+			order[cluster] = cluster;
+		}
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		uint32_t* pOutput = out.data();
+		for (const uint32_t cluster : order)
+		{
+			pOutput = std::copy(indices.begin() + splits[cluster] * 3, indices.begin() + splits[cluster + 1] * 3, pOutput);
+		}
+	}
+
+	//Consecutive triangle ranges that use at most maxVertices vertices each
+	std::vector<Submesh> PartitionByVertexCount(std::span<const uint32_t> indices, size_t vertexCount, uint32_t maxVertices)
+	{
+		std::vector<Submesh> submeshes{};
+		std::vector<uint32_t> stamps(vertexCount, 0);
+		uint32_t stamp{ 1 };
+		uint32_t firstIndex{ 0 };
+		uint32_t usedCount{ 0 };
+
+		const uint32_t indexCount = static_cast<uint32_t>(indices.size() / 3 * 3);
+		for (uint32_t firstCorner{ 0 }; firstCorner < indexCount; firstCorner += 3)
+		{
+			uint32_t newVertexCount{ 0 };
+			for (uint32_t corner{ 0 }; corner < 3; ++corner)
+			{
+				newVertexCount += stamps[indices[firstCorner + corner]] != stamp;
+			}
+			if (usedCount + newVertexCount > maxVertices)
+			{
+				submeshes.push_back({ firstIndex, firstCorner - firstIndex, 0, 0, {} });
+				firstIndex = firstCorner;
+				usedCount = 0;
+				++stamp;
+			}
+
+			for (uint32_t corner{ 0 }; corner < 3; ++corner)
+			{
+				uint32_t& vertexStamp = stamps[indices[firstCorner + corner]];
+				usedCount += vertexStamp != stamp;
+				vertexStamp = stamp;
+			}
+		}
+		submeshes.push_back({ firstIndex, indexCount - firstIndex, 0, 0, {} });
+		return submeshes;
+	}
+}
+
+namespace MeshOptimizer
+{
+	VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize, CacheModel model)
+	{
+		VertexCacheStats stats{};
+		if (indices.size() < 3 || vertexCount == 0)
+			return stats;
+
+		if (model == CacheModel::FIFO)
+		{
+			FIFOCache cache{ vertexCount, cacheSize };
+			for (const uint32_t index : indices)
+			{
+				stats.transformCount += cache.Access(index);
+			}
+		}
+		else
+		{
+			//Most recent first; small enough that a linear search beats anything cleverer
+			std::vector<uint32_t> cache{};
+			cache.reserve(cacheSize + 1);
+			for (const uint32_t index : indices)
+			{
+				const auto it = std::find(cache.begin(), cache.end(), index);
+				if (it != cache.end())
+				{
+					std::rotate(cache.begin(), it, it + 1);
+					continue;
+				}
+
+				++stats.transformCount;
+				cache.insert(cache.begin(), index);
+				if (cache.size() > cacheSize)
+					cache.pop_back();
+			}
+		}
+
+		std::vector<bool> isReferenced(vertexCount, false);
+		size_t referencedCount{ 0 };
+		for (const uint32_t index : indices)
+		{
+			if (!isReferenced[index])
+			{
+				isReferenced[index] = true;
+				++referencedCount;
+			}
+		}
+
+		stats.acmr = static_cast<float>(double(stats.transformCount) / double(indices.size() / 3));
+		stats.atvr = static_cast<float>(double(stats.transformCount) / double(referencedCount));
+		return stats;
+	}
+
+	void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (triangleCount == 0)
+			return;
+
+		//Triangles around every vertex, and how many of them are still to be emitted
+		std::vector<uint32_t> liveCounts(vertexCount, 0);
+		for (const uint32_t index : indices)
+		{
+			++liveCounts[index];
+		}
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+		{
+			adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveCounts[vertex];
+		}
+
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+		{
+			std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32_t i{ 0 }; i < triangleCount * 3; ++i)
+			{
+				adjacency[cursors[indices[i]]++] = i / 3;
+			}
+		}
+
+		FIFOCache cache{ vertexCount, cacheSize };
+		std::vector<uint8_t> isEmitted(triangleCount, 0);
+		std::vector<uint32_t> deadEnds{};
+		deadEnds.reserve(indices.size());
+		std::vector<uint32_t> candidates{};
+		std::vector<uint32_t> output(triangleCount * 3);
+		uint32_t outputCount{ 0 };
+		uint32_t sweep{ 0 };
+
+		const auto findNextLive = [&]()
+			{
+				//The most recently used vertex that still has triangles, then the next one in index order
+				while (!deadEnds.empty())
+				{
+					const uint32_t vertex = deadEnds.back();
+					deadEnds.pop_back();
+					if (liveCounts[vertex] > 0)
+						return vertex;
+				}
+				while (sweep < vertexCount && liveCounts[sweep] == 0) ++sweep;
+				return sweep < vertexCount ? sweep : noVertex;
+			};
+
+		uint32_t fan = findNextLive();
+		while (fan != noVertex)
+		{
+			//Every remaining triangle around the fanning vertex
+			candidates.clear();
+			for (uint32_t i{ adjacencyOffsets[fan] }; i < adjacencyOffsets[fan + 1]; ++i)
+			{
+				const uint32_t triangle = adjacency[i];
+				if (isEmitted[triangle])
+					continue;
+				isEmitted[triangle] = 1;
+
+				for (uint32_t corner{ 0 }; corner < 3; ++corner)
+				{
+					const uint32_t vertex = indices[triangle * 3 + corner];
+					output[outputCount++] = vertex;
+					deadEnds.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveCounts[vertex];
+					cache.Access(vertex);
+				}
+			}
+
+			//Next fan: the oldest candidate that will still be cached after its remaining triangles are emitted
+			uint32_t next{ noVertex };
+			int64_t bestPriority{ -1 };
+			for (const uint32_t vertex : candidates)
+			{
+				if (liveCounts[vertex] == 0)
+					continue;
+
+				const uint32_t age = cache.GetAge(vertex);
+				const int64_t priority = age + 2 * int64_t(liveCounts[vertex]) <= cacheSize ? age : 0;
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					next = vertex;
+				}
+			}
+
+			if (next == noVertex)
+			{
+				next = findNextLive();
+			}
+			fan = next;
+		}
+
+		std::copy(output.begin(), output.end(), indices.begin());
+	}
+
+	void OptimizeOverdraw(std::span<uint32_t> indices, const std::vector<Vertex>& vertices, uint32_t cacheSize, float threshold)
+	{
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (triangleCount == 0)
+			return;
+
+		FIFOCache cache{ vertices.size(), cacheSize };
+		const auto countMisses = [&](std::span<const uint32_t> order)
+			{
+				cache.Flush();
+				uint64_t misses{ 0 };
+				for (uint32_t corner{ 0 }; corner < triangleCount * 3; ++corner)
+				{
+					misses += cache.Access(order[corner]);
+				}
+				return misses;
+			};
+
+		//The budget is the ACMR of the whole input order, with the cache warm across it. Tipsify's restart runs are too short
+		//to measure against: they average a handful of triangles, so their cold ACMR is far above what the whole order reaches.
+		const uint64_t inputMisses = countMisses(indices);
+		const float inputAcmr = static_cast<float>(inputMisses) / static_cast<float>(triangleCount);
+
+		//Clusters cut right at the budget add up to about the budget, and the last one (whatever the input order left for its
+		//end) can push the sorted order over it. Then they are cut again against a tighter bound, and when that doesn't help
+		//either the input order stays.
+		constexpr int maxAttempts{ 4 };
+		const std::vector<uint32_t> source(indices.begin(), indices.end());
+		float clusterThreshold{ threshold };
+		for (int attempt{ 0 }; attempt < maxAttempts; ++attempt)
+		{
+			SortClusters(source, indices, vertices, cache, clusterThreshold * inputAcmr);
+			if (static_cast<float>(countMisses(indices)) <= threshold * static_cast<float>(inputMisses))
+				return;
+			clusterThreshold = 1.f + (clusterThreshold - 1.f) * 0.5f;
+		}
+		std::copy(source.begin(), source.end(), indices.begin());
+	}
+
+	void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::span<uint32_t> indices)
+	{
+		std::vector<uint32_t> remap(vertices.size(), noVertex);
+		std::vector<Vertex> fetchOrder{};
+		fetchOrder.reserve(vertices.size());
+
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == noVertex)
+			{
+				remap[index] = static_cast<uint32_t>(fetchOrder.size());
+				fetchOrder.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+
+		vertices.swap(fetchOrder);
+	}
+
+	size_t SplitFor16BitIndices(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, std::vector<uint16_t>& indices16, std::vector<Submesh>& submeshes,
+		std::vector<MeshLOD>* pLODs)
+	{
+		indices16.resize(indices.size());
+		if (vertices.size() <= maxVerticesPer16BitIndex)
+		{
+			std::transform(indices.begin(), indices.end(), indices16.begin(), [](uint32_t index) { return static_cast<uint16_t>(index); });
+			return 0;
+		}
+
+		std::vector<Submesh> sourceSubmeshes{};
+		sourceSubmeshes.swap(submeshes);
+		if (sourceSubmeshes.empty())
+		{
+			sourceSubmeshes.push_back({ 0, static_cast<uint32_t>(indices.size()), 0, 0, {} });
+		}
+
+		std::vector<Vertex> chunkVertices{};
+		chunkVertices.reserve(vertices.size() + vertices.size() / 16);
+
+		//A vertex has a slot in the current chunk when its stamp is the chunk's
+		std::vector<uint32_t> chunkStamps(vertices.size(), 0);
+		std::vector<uint16_t> localIndices(vertices.size());
+		uint32_t chunkStamp{ 0 };
+
+		Submesh chunk{};
+		const auto beginChunk = [&](const Submesh& source, uint32_t firstIndex)
+			{
+				chunk = { firstIndex, 0, static_cast<int32_t>(chunkVertices.size()), source.materialIndex, {} };
+				++chunkStamp;
+			};
+		const auto endChunk = [&](uint32_t endIndex)
+			{
+				chunk.indexCount = endIndex - chunk.firstIndex;
+				const size_t chunkVertexCount = chunkVertices.size() - chunk.baseVertex;
+				if (chunkVertexCount > 0)
+					chunk.bounds = AABB::FromPoints(&chunkVertices[chunk.baseVertex].position, sizeof(Vertex), chunkVertexCount);
+				submeshes.push_back(chunk);
+			};
+
+		//The chunks every source submesh was cut into start here
+		std::vector<uint32_t> firstChunks{};
+		firstChunks.reserve(sourceSubmeshes.size() + 1);
+		for (const Submesh& source : sourceSubmeshes)
+		{
+			firstChunks.push_back(static_cast<uint32_t>(submeshes.size()));
+			const uint32_t endIndex = source.firstIndex + source.indexCount;
+			beginChunk(source, source.firstIndex);
+			for (uint32_t firstCorner{ source.firstIndex }; firstCorner + 2 < endIndex; firstCorner += 3)
+			{
+				//Counts a corner repeated within the triangle twice, which only ever ends a chunk a triangle early
+				uint32_t newVertexCount{ 0 };
+				for (uint32_t corner{ 0 }; corner < 3; ++corner)
+				{
+					newVertexCount += chunkStamps[source.baseVertex + indices[firstCorner + corner]] != chunkStamp;
+				}
+				if (chunkVertices.size() - chunk.baseVertex + newVertexCount > maxVerticesPer16BitIndex)
+				{
+					endChunk(firstCorner);
+					beginChunk(source, firstCorner);
+				}
+
+				for (uint32_t corner{ 0 }; corner < 3; ++corner)
+				{
+					const uint32_t vertex = source.baseVertex + indices[firstCorner + corner];
+					if (chunkStamps[vertex] != chunkStamp)
+					{
+						chunkStamps[vertex] = chunkStamp;
+						localIndices[vertex] = static_cast<uint16_t>(chunkVertices.size() - chunk.baseVertex);
+						chunkVertices.push_back(vertices[vertex]);
+					}
+					indices16[firstCorner + corner] = localIndices[vertex];
+				}
+			}
+			endChunk(endIndex);
+		}
+		firstChunks.push_back(static_cast<uint32_t>(submeshes.size()));
+
+		if (pLODs)
+		{
+			for (MeshLOD& lod : *pLODs)
+			{
+				const uint32_t firstChunk = firstChunks[lod.firstSubmesh];
+				lod.submeshCount = firstChunks[lod.firstSubmesh + lod.submeshCount] - firstChunk;
+				lod.firstSubmesh = firstChunk;
+			}
+		}
+
+		const size_t duplicatedCount = chunkVertices.size() > vertices.size() ? chunkVertices.size() - vertices.size() : 0;
+		vertices.swap(chunkVertices);
+		return duplicatedCount;
+	}
+
+	void OptimizeLODs(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Submesh>& submeshes, std::vector<MeshLOD>& lods, OptimizeStats* pStats)
+	{
+		//Every LOD's index range, from its first submesh's start to its last one's end
+		struct Range
+		{
+			uint32_t firstIndex{};
+			uint32_t indexCount{};
+			float error{};
+		};
+		std::vector<Range> ranges{};
+		if (lods.empty())
+		{
+			ranges.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.f });
+		}
+		for (const MeshLOD& lod : lods)
+		{
+			const Submesh& first = submeshes[lod.firstSubmesh];
+			const Submesh& last = submeshes[lod.firstSubmesh + lod.submeshCount - 1];
+			ranges.push_back({ first.firstIndex, last.firstIndex + last.indexCount - first.firstIndex, lod.error });
+		}
+
+		if (pStats)
+		{
+			pStats->before = AnalyzeVertexCache(std::span<const uint32_t>{ indices }.subspan(ranges[0].firstIndex, ranges[0].indexCount), vertices.size());
+		}
+
+		submeshes.clear();
+		lods.clear();
+		for (const Range& range : ranges)
+		{
+			const std::span<uint32_t> lodIndices = std::span<uint32_t>{ indices }.subspan(range.firstIndex, range.indexCount);
+			OptimizeVertexCache(lodIndices, vertices.size());
+
+			//Cut while the order is still local: after the overdraw sort neighbouring triangles can be far apart
+			std::vector<Submesh> parts{};
+			if (vertices.size() > maxVerticesPer16BitIndex)
+				parts = PartitionByVertexCount(lodIndices, vertices.size(), maxVerticesPer16BitIndex);
+			else
+				parts.push_back({ 0, range.indexCount, 0, 0, {} });
+
+			for (const Submesh& part : parts)
+			{
+				OptimizeOverdraw(lodIndices.subspan(part.firstIndex, part.indexCount), vertices);
+			}
+
+			lods.push_back({ static_cast<uint32_t>(submeshes.size()), static_cast<uint32_t>(parts.size()), range.error, 0 });
+			for (Submesh& part : parts)
+			{
+				part.firstIndex += range.firstIndex;
+				submeshes.push_back(part);
+			}
+		}
+
+		OptimizeVertexFetch(vertices, indices);
+
+		if (pStats)
+		{
+			pStats->after = AnalyzeVertexCache(std::span<const uint32_t>{ indices }.subspan(ranges[0].firstIndex, ranges[0].indexCount), vertices.size());
+		}
+
+		//One LOD that fits 16-bit indices needs neither table
+		if (lods.size() == 1 && submeshes.size() == 1)
+		{
+			submeshes.clear();
+			lods.clear();
+			return;
+		}
+
+		for (Submesh& submesh : submeshes)
+		{
+			Vector3 min{ FLT_MAX, FLT_MAX, FLT_MAX }, max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (uint32_t corner{ submesh.firstIndex }; corner < submesh.firstIndex + submesh.indexCount; ++corner)
+			{
+				const Vector3& p = vertices[indices[corner]].position;
+				min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+				max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+			}
+			if (submesh.indexCount > 0)
+				submesh.bounds = AABB::FromMinMax(min, max);
+		}
+	}
+
+	void Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Submesh>& submeshes, OptimizeStats* pStats)
+	{
+		std::vector<MeshLOD> lods{};
+		submeshes.clear();
+		OptimizeLODs(vertices, indices, submeshes, lods, pStats);
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "DataTypes.h"
+
+//Index and vertex buffer passes run when a mesh is cooked (MeshOptimizer.cpp).
+//None of them changes what is drawn, only the order and format triangles and vertices reach the GPU in.
+namespace MeshOptimizer
+{
+	//Vertices a 16-bit index can address from one base vertex
+	constexpr uint32_t maxVerticesPer16BitIndex{ 1u << 16 };
+
+	//Post-transform cache size the optimizer and the default analysis aim at
+	constexpr uint32_t vertexCacheSize{ 16 };
+	//How much worse than the ACMR of the cache-optimized order OptimizeOverdraw's clusters and sorted result may be
+	constexpr float overdrawThreshold{ 1.05f };
+
+	enum class CacheModel
+	{
+		FIFO,
+		LRU
+	};
+
+	struct VertexCacheStats
+	{
+		float acmr{};				//vertex shader invocations per triangle, 0.5 is the best a closed mesh can do
+		float atvr{};				//invocations per referenced vertex, 1 is perfect
+		uint64_t transformCount{};	//cache misses
+	};
+
+	//Replays the index buffer through a simulated post-transform cache
+	VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = vertexCacheSize, CacheModel model = CacheModel::FIFO);
+
+	//Reorders the triangles for the post-transform cache with Tipsify (Sander, Nehab, Barczak 2007)
+	void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize = vertexCacheSize);
+
+	//Splits the cache-optimized triangles into clusters and draws the ones facing away from the mesh centre first,
+	//so they occlude the rest. The sorted order may be at most threshold worse than the input order's ACMR: clusters are
+	//cut where their ACMR from a cold cache is within that, tighter cuts are tried when the result still comes out over
+	//it, and failing those the input order stays.
+	//MeshFile::Cook doesn't keep this order: Meshlets::Build regroups every submesh's triangles into meshlets afterwards.
+	void OptimizeOverdraw(std::span<uint32_t> indices, const std::vector<Vertex>& vertices, uint32_t cacheSize = vertexCacheSize,
+		float threshold = overdrawThreshold);
+
+	//Rewrites the vertex buffer in the order the indices first use the vertices and drops unreferenced ones
+	void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::span<uint32_t> indices);
+
+	//Narrows the indices to 16 bits. Meshes with more vertices than that can address are cut into runs of consecutive
+	//triangles using at most maxVerticesPer16BitIndex vertices each. Every run becomes a submesh with its own base vertex
+	//and its own copy of the vertices, in first-use order. Triangle order is kept.
+	//submeshes is read (empty: one for all indices) and replaced, the LODs' submesh ranges follow. Returns how many vertices
+	//had to be duplicated; LODs drawing the same vertices from different chunks each get their own copies.
+	size_t SplitFor16BitIndices(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, std::vector<uint16_t>& indices16, std::vector<Submesh>& submeshes,
+		std::vector<MeshLOD>* pLODs = nullptr);
+
+	struct OptimizeStats
+	{
+		VertexCacheStats before{};
+		VertexCacheStats after{};
+	};
+
+	//All three passes, in the order they depend on each other.
+	//Meshes too big for 16-bit indices get submeshes of at most maxVerticesPer16BitIndex vertices, cut before the overdraw pass
+	//(which then sorts within each) so SplitFor16BitIndices only copies the vertices on the cuts. Otherwise submeshes is emptied.
+	void Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Submesh>& submeshes, OptimizeStats* pStats = nullptr);
+
+	//Optimize for LOD chains sharing one vertex buffer: indices holds every LOD's triangles, each LOD's submeshes one
+	//contiguous range of them. Triangles are reordered within their LOD, then the vertices for all LODs together, so
+	//LOD 0 comes out in fetch order. submeshes and lods are replaced: a submesh per LOD (or per 16-bit partition of it)
+	//with its bounds, or both emptied for a single LOD that needs no partitions. pStats is about LOD 0.
+	void OptimizeLODs(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Submesh>& submeshes, std::vector<MeshLOD>& lods,
+		OptimizeStats* pStats = nullptr);
+}
@@ -0,0 +1,695 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+	constexpr uint32_t noVertex{ UINT32_MAX };
+	//u, v and the normal, each scaled by its weight
+	constexpr int attributeCount{ 5 };
+	//Planes through open edges weigh this much more than the surface, so border and seam vertices slide along them, not off
+	constexpr float borderWeight{ 10.f };
+	//A collapse is refused when it turns a triangle's normal by more than acos of this
+	constexpr float minFlipCosine{ 0.25f };
+
+	//Ends a vertex's run of open edges when it has more than one in the same direction
+	constexpr uint32_t severalVertices{ UINT32_MAX - 1 };
+
+	enum class VertexKind : uint8_t
+	{
+		Manifold,	//inside the surface, moves onto any neighbour
+		Border,		//on an open edge, moves along it
+		Seam,		//one of the two vertices of a position on a uv or normal seam, moves along the seam together with the other
+		Locked
+	};
+
+	//Area-weighted sum of squared distances to planes and of squared differences to the attributes' linear
+	//interpolation over those planes: p^T A p + 2 b.p + c + sum over attributes of (a^2 w - 2 a (g.p + d)).
+	//The distances are also summed on their own, the attributes only decide which collapse goes first.
+	struct Quadric
+	{
+		float a00{}, a11{}, a22{}, a01{}, a02{}, a12{};
+		float b0{}, b1{}, b2{}, c{};
+		float weight{};
+		float g[attributeCount][3]{};
+		float d[attributeCount]{};
+		float attributeWeight{};
+		float planes[10]{};
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			const float* pOther = &other.a00;
+			float* pThis = &a00;
+			for (size_t i{ 0 }; i < sizeof(Quadric) / sizeof(float); ++i)
+				pThis[i] += pOther[i];
+			return *this;
+		}
+
+		//(n.p + offset)^2 * w, n a unit normal
+		void AddPlane(const Vector3& n, float offset, float w)
+		{
+			AddGradient(n, offset, w);
+			weight += w;
+			const float terms[10]{ n.x * n.x, n.y * n.y, n.z * n.z, n.x * n.y, n.x * n.z, n.y * n.z, n.x * offset, n.y * offset, n.z * offset, offset * offset };
+			for (int i{ 0 }; i < 10; ++i)
+				planes[i] += w * terms[i];
+		}
+
+		//The attribute is value at p0 and changes by gradient over the triangle's plane
+		void AddAttribute(int attribute, const Vector3& gradient, float offset, float w)
+		{
+			AddGradient(gradient, offset, w);
+			g[attribute][0] += w * gradient.x;
+			g[attribute][1] += w * gradient.y;
+			g[attribute][2] += w * gradient.z;
+			d[attribute] += w * offset;
+		}
+
+		float Evaluate(const Vector3& p, const float* pAttributes) const
+		{
+			float r = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z + 2.f * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z)
+				+ 2.f * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+			for (int attribute{ 0 }; attribute < attributeCount; ++attribute)
+			{
+				const float a = pAttributes[attribute];
+				r += a * a * attributeWeight - 2.f * a * (g[attribute][0] * p.x + g[attribute][1] * p.y + g[attribute][2] * p.z + d[attribute]);
+			}
+			//Rounding can take it slightly below 0
+			return std::max(r, 0.f) / std::max(weight, FLT_MIN);
+		}
+
+		//The mean squared distance of p to the planes
+		float EvaluateDistance(const Vector3& p) const
+		{
+			const float r = planes[0] * p.x * p.x + planes[1] * p.y * p.y + planes[2] * p.z * p.z
+				+ 2.f * (planes[3] * p.x * p.y + planes[4] * p.x * p.z + planes[5] * p.y * p.z)
+				+ 2.f * (planes[6] * p.x + planes[7] * p.y + planes[8] * p.z) + planes[9];
+			return std::max(r, 0.f) / std::max(weight, FLT_MIN);
+		}
+
+	private:
+		void AddGradient(const Vector3& n, float offset, float w)
+		{
+			a00 += w * n.x * n.x; a11 += w * n.y * n.y; a22 += w * n.z * n.z;
+			a01 += w * n.x * n.y; a02 += w * n.x * n.z; a12 += w * n.y * n.z;
+			b0 += w * n.x * offset; b1 += w * n.y * offset; b2 += w * n.z * offset;
+			c += w * offset * offset;
+		}
+	};
+
+	static_assert(sizeof(Quadric) == (22 + attributeCount * 4) * sizeof(float), "Quadric::operator+= adds it as an array of floats");
+
+	//vertex moves onto target; for seams sibling (the other vertex at vertex's position) moves onto siblingTarget as well
+	struct Collapse
+	{
+		uint32_t vertex{};
+		uint32_t target{};
+		uint32_t sibling{ noVertex };
+		uint32_t siblingTarget{ noVertex };
+		float error{};		//with the attributes
+		float distance{};	//squared, how far the surface moves
+	};
+
+	class Simplifier final
+	{
+	public:
+		Simplifier(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const MeshSimplifier::SimplifySettings& settings)
+			: m_Indices{ indices }, m_Vertices{ vertices }, m_Settings{ settings }
+		{
+		}
+
+		MeshSimplifier::SimplifyResult Run(size_t targetIndexCount, float targetError)
+		{
+			MeshSimplifier::SimplifyResult result{};
+			if (!NormalizePositions())
+				return result;
+
+			ClassifyVertices(result.lockedVertexCount);
+			FillQuadrics();
+
+			const float errorLimit = targetError * targetError;
+			float maxError{ 0.f };
+			m_Remap.resize(m_Vertices.size());
+			std::iota(m_Remap.begin(), m_Remap.end(), 0u);
+			m_IsTouched.resize(m_Vertices.size());
+			while (m_Indices.size() > targetIndexCount)
+			{
+				BuildAdjacency();
+				FindOpenEdges();
+				FindCollapses(errorLimit);
+				if (m_Collapses.empty())
+					break;
+
+				//Independent collapses, cheapest first, until the pass has removed the triangles still to go
+				const size_t trianglesToRemove = (m_Indices.size() - targetIndexCount + 2) / 3;
+				size_t removedTriangles{ 0 };
+				std::fill(m_IsTouched.begin(), m_IsTouched.end(), uint8_t{ 0 });
+				for (const Collapse& collapse : m_Collapses)
+				{
+					if (removedTriangles >= trianglesToRemove)
+						break;
+					const bool isSeam = collapse.sibling != noVertex;
+					if (m_IsTouched[collapse.vertex] || m_IsTouched[collapse.target]
+						|| (isSeam && (m_IsTouched[collapse.sibling] || m_IsTouched[collapse.siblingTarget])))
+						continue;
+
+					//Both sides of a seam move or neither does
+					uint32_t edgeTriangles = CountCollapsedTriangles(collapse.vertex, collapse.target);
+					if (edgeTriangles == 0)
+						continue;
+					if (isSeam)
+					{
+						const uint32_t siblingTriangles = CountCollapsedTriangles(collapse.sibling, collapse.siblingTarget);
+						if (siblingTriangles == 0)
+							continue;
+						edgeTriangles += siblingTriangles;
+						ApplyCollapse(collapse.sibling, collapse.siblingTarget);
+					}
+					ApplyCollapse(collapse.vertex, collapse.target);
+					removedTriangles += edgeTriangles;
+					maxError = std::max(maxError, collapse.distance);
+					++result.collapseCount;
+				}
+				if (removedTriangles == 0)
+					break;
+
+				RemapIndices();
+			}
+
+			result.error = std::sqrt(maxError) * m_Scale;
+			return result;
+		}
+
+	private:
+		std::vector<uint32_t>& m_Indices;
+		const std::vector<Vertex>& m_Vertices;
+		const MeshSimplifier::SimplifySettings& m_Settings;
+
+		//Positions moved and scaled into the unit cube, so errors and the attribute weights don't depend on the mesh's size
+		std::vector<Vector3> m_Positions{};
+		float m_Scale{};
+		//Vertices by the first vertex with their position, and for seam vertices the other vertex at it
+		std::vector<uint32_t> m_PositionIds{};
+		std::vector<uint32_t> m_Siblings{};
+		std::vector<VertexKind> m_Kinds{};
+		std::vector<Quadric> m_Quadrics{};
+
+		//Triangles around each vertex in the current index buffer
+		std::vector<uint32_t> m_FirstTriangles{};
+		std::vector<uint32_t> m_Triangles{};
+		//The vertex across each vertex's open edge leaving it and the one across the open edge arriving at it, in the
+		//current index buffer: noVertex without one, severalVertices with more than one. An edge is open when no triangle
+		//uses it in the other direction, which besides the mesh's borders includes both sides of every seam.
+		std::vector<uint32_t> m_OpenOut{};
+		std::vector<uint32_t> m_OpenIn{};
+		std::vector<uint64_t> m_HalfEdges{};
+
+		std::vector<Collapse> m_Collapses{};
+		std::vector<uint32_t> m_Remap{};
+		std::vector<uint8_t> m_IsTouched{};
+		std::vector<uint32_t> m_VertexNeighbours{}, m_TargetNeighbours{};
+
+		bool NormalizePositions()
+		{
+			Vector3 min{ FLT_MAX, FLT_MAX, FLT_MAX }, max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (const uint32_t index : m_Indices)
+			{
+				const Vector3& p = m_Vertices[index].position;
+				min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+				max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+			}
+			m_Scale = std::max({ max.x - min.x, max.y - min.y, max.z - min.z });
+			if (!(m_Scale > 0.f))
+				return false;
+
+			const float invScale = 1.f / m_Scale;
+			m_Positions.resize(m_Vertices.size());
+			for (size_t i{ 0 }; i < m_Vertices.size(); ++i)
+			{
+				m_Positions[i] = (m_Vertices[i].position - min) * invScale;
+			}
+			return true;
+		}
+
+		void ApplyCollapse(uint32_t vertex, uint32_t target)
+		{
+			m_Remap[vertex] = target;
+			m_IsTouched[vertex] = 1;
+			m_IsTouched[target] = 1;
+			if (m_Kinds[target] != VertexKind::Locked)
+				m_Quadrics[target] += m_Quadrics[vertex];
+		}
+
+		void GetAttributes(uint32_t vertex, float* pAttributes) const
+		{
+			const Vertex& v = m_Vertices[vertex];
+			pAttributes[0] = v.uv.x * m_Settings.uvWeight;
+			pAttributes[1] = v.uv.y * m_Settings.uvWeight;
+			pAttributes[2] = v.normal.x * m_Settings.normalWeight;
+			pAttributes[3] = v.normal.y * m_Settings.normalWeight;
+			pAttributes[4] = v.normal.z * m_Settings.normalWeight;
+		}
+
+		//Positions are classified by their edges (open, inside the surface or non-manifold) and how many vertices stand for them.
+		//A seam position has exactly two vertices, each with one open edge in and one out along the seam; positions with more
+		//vertices (seams meeting), non-manifold edges or (when locked) open edges are locked, and so are vertices whose
+		//open edges don't form one simple run.
+		void ClassifyVertices(size_t& lockedCount)
+		{
+			const size_t vertexCount = m_Vertices.size();
+			std::vector<uint8_t> isReferenced(vertexCount, 0);
+			for (const uint32_t index : m_Indices)
+				isReferenced[index] = 1;
+
+			//Sorting by the position's bits groups the vertices of every position
+			std::vector<uint32_t> order{};
+			order.reserve(vertexCount);
+			for (uint32_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+			{
+				if (isReferenced[vertex])
+					order.push_back(vertex);
+			}
+			const auto getKey = [this](uint32_t vertex)
+				{
+					std::array<uint32_t, 3> key{};
+					std::memcpy(key.data(), &m_Vertices[vertex].position, sizeof(Vector3));
+					return key;
+				};
+			std::sort(order.begin(), order.end(), [&getKey](uint32_t a, uint32_t b)
+				{
+					const auto keyA = getKey(a), keyB = getKey(b);
+					return keyA != keyB ? keyA < keyB : a < b;
+				});
+
+			std::vector<uint32_t> positionIds(vertexCount, noVertex);
+			std::vector<uint32_t> wedgeCounts(vertexCount, 0);
+			m_Siblings.assign(vertexCount, noVertex);
+			for (size_t first{ 0 }; first < order.size();)
+			{
+				size_t end{ first + 1 };
+				while (end < order.size() && getKey(order[end]) == getKey(order[first]))
+					++end;
+				for (size_t i{ first }; i < end; ++i)
+					positionIds[order[i]] = order[first];
+				wedgeCounts[order[first]] = static_cast<uint32_t>(end - first);
+				if (end - first == 2)
+				{
+					m_Siblings[order[first]] = order[first + 1];
+					m_Siblings[order[first + 1]] = order[first];
+				}
+				first = end;
+			}
+
+			//Undirected position edges: used once they are open, twice in opposite directions inside the surface, anything else
+			//is non-manifold
+			struct Edge
+			{
+				uint64_t key{};
+				bool isForward{};
+			};
+			std::vector<Edge> edges{};
+			edges.reserve(m_Indices.size());
+			for (size_t corner{ 0 }; corner < m_Indices.size(); ++corner)
+			{
+				const size_t next = corner % 3 == 2 ? corner - 2 : corner + 1;
+				const uint32_t a = positionIds[m_Indices[corner]], b = positionIds[m_Indices[next]];
+				edges.push_back({ uint64_t(std::min(a, b)) << 32 | std::max(a, b), a < b });
+			}
+			std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.key != b.key ? a.key < b.key : a.isForward < b.isForward; });
+
+			std::vector<VertexKind> positionKinds(vertexCount, VertexKind::Manifold);
+			const auto mark = [&positionKinds](uint64_t key, VertexKind kind)
+				{
+					for (const uint32_t position : { static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key) })
+						positionKinds[position] = std::max(positionKinds[position], kind);
+				};
+			for (size_t first{ 0 }; first < edges.size();)
+			{
+				size_t end{ first + 1 };
+				while (end < edges.size() && edges[end].key == edges[first].key)
+					++end;
+				if (end - first == 1)
+					mark(edges[first].key, m_Settings.lockBorders ? VertexKind::Locked : VertexKind::Border);
+				else if (end - first > 2 || edges[first].isForward == edges[first + 1].isForward)
+					mark(edges[first].key, VertexKind::Locked);
+				first = end;
+			}
+
+			FindOpenEdges();
+			const auto hasOneOpenRun = [this](uint32_t vertex)
+				{
+					return m_OpenOut[vertex] < severalVertices && m_OpenIn[vertex] < severalVertices;
+				};
+			m_Kinds.assign(vertexCount, VertexKind::Manifold);
+			lockedCount = 0;
+			for (const uint32_t vertex : order)
+			{
+				const uint32_t position = positionIds[vertex];
+				VertexKind kind = positionKinds[position];
+				switch (wedgeCounts[position])
+				{
+				case 1:
+					//Inside the surface but at the end of a seam, its triangles touch both sides
+					if (kind == VertexKind::Manifold && (m_OpenOut[vertex] != noVertex || m_OpenIn[vertex] != noVertex))
+						kind = VertexKind::Locked;
+					else if (kind == VertexKind::Border && !hasOneOpenRun(vertex))
+						kind = VertexKind::Locked;
+					break;
+				case 2:
+					kind = kind == VertexKind::Manifold && hasOneOpenRun(vertex) && hasOneOpenRun(m_Siblings[vertex]) ? VertexKind::Seam : VertexKind::Locked;
+					break;
+				default:
+					kind = VertexKind::Locked;
+					break;
+				}
+				m_Kinds[vertex] = kind;
+				lockedCount += kind == VertexKind::Locked;
+			}
+			m_PositionIds = std::move(positionIds);
+		}
+
+		//m_OpenOut and m_OpenIn for the current index buffer
+		void FindOpenEdges()
+		{
+			m_HalfEdges.resize(m_Indices.size());
+			for (size_t corner{ 0 }; corner < m_Indices.size(); ++corner)
+			{
+				const size_t next = corner % 3 == 2 ? corner - 2 : corner + 1;
+				m_HalfEdges[corner] = uint64_t(m_Indices[corner]) << 32 | m_Indices[next];
+			}
+			std::sort(m_HalfEdges.begin(), m_HalfEdges.end());
+
+			m_OpenOut.assign(m_Vertices.size(), noVertex);
+			m_OpenIn.assign(m_Vertices.size(), noVertex);
+			const auto add = [](uint32_t& open, uint32_t vertex) { open = open == noVertex ? vertex : severalVertices; };
+			for (const uint64_t halfEdge : m_HalfEdges)
+			{
+				const uint32_t a = static_cast<uint32_t>(halfEdge >> 32), b = static_cast<uint32_t>(halfEdge);
+				if (std::binary_search(m_HalfEdges.begin(), m_HalfEdges.end(), uint64_t(b) << 32 | a))
+					continue;
+				add(m_OpenOut[a], b);
+				add(m_OpenIn[b], a);
+			}
+		}
+
+		void FillQuadrics()
+		{
+			m_Quadrics.assign(m_Vertices.size(), Quadric{});
+			for (size_t first{ 0 }; first + 2 < m_Indices.size(); first += 3)
+			{
+				const uint32_t corners[3]{ m_Indices[first], m_Indices[first + 1], m_Indices[first + 2] };
+				const Vector3& p0 = m_Positions[corners[0]];
+				const Vector3 e1 = m_Positions[corners[1]] - p0, e2 = m_Positions[corners[2]] - p0;
+				const Vector3 cross = Vector3::Cross(e1, e2);
+				const float doubleArea = cross.Magnitude();
+				if (!(doubleArea > 0.f))
+					continue;
+
+				const float area = doubleArea * 0.5f;
+				const Vector3 normal = cross / doubleArea;
+				Quadric triangle{};
+				triangle.AddPlane(normal, -Vector3::Dot(normal, p0), area);
+
+				//The attributes interpolate linearly over the triangle: a(p) = gradient.p + offset
+				const float d11 = Vector3::Dot(e1, e1), d12 = Vector3::Dot(e1, e2), d22 = Vector3::Dot(e2, e2);
+				const float determinant = d11 * d22 - d12 * d12;
+				if (determinant > 0.f)
+				{
+					float attributes[3][attributeCount];
+					for (int corner{ 0 }; corner < 3; ++corner)
+						GetAttributes(corners[corner], attributes[corner]);
+
+					const float invDeterminant = 1.f / determinant;
+					for (int attribute{ 0 }; attribute < attributeCount; ++attribute)
+					{
+						const float delta1 = attributes[1][attribute] - attributes[0][attribute], delta2 = attributes[2][attribute] - attributes[0][attribute];
+						const float alpha = (delta1 * d22 - delta2 * d12) * invDeterminant;
+						const float beta = (delta2 * d11 - delta1 * d12) * invDeterminant;
+						const Vector3 gradient = e1 * alpha + e2 * beta;
+						triangle.AddAttribute(attribute, gradient, attributes[0][attribute] - Vector3::Dot(gradient, p0), area);
+					}
+					triangle.attributeWeight = area;
+				}
+
+				for (int corner{ 0 }; corner < 3; ++corner)
+				{
+					const uint32_t vertex = corners[corner];
+					if (m_Kinds[vertex] != VertexKind::Locked)
+						m_Quadrics[vertex] += triangle;
+				}
+
+				//Planes through the open edges (borders and seams), perpendicular to the triangle
+				for (int corner{ 0 }; corner < 3; ++corner)
+				{
+					const uint32_t a = corners[corner], b = corners[(corner + 1) % 3];
+					if (std::binary_search(m_HalfEdges.begin(), m_HalfEdges.end(), uint64_t(b) << 32 | a))
+						continue;
+
+					const Vector3 edge = m_Positions[b] - m_Positions[a];
+					const float length = edge.Magnitude();
+					if (!(length > 0.f))
+						continue;
+					const Vector3 borderNormal = Vector3::Cross(edge / length, normal).Normalized();
+					Quadric border{};
+					border.AddPlane(borderNormal, -Vector3::Dot(borderNormal, m_Positions[a]), length * length * borderWeight);
+					for (const uint32_t vertex : { a, b })
+					{
+						if (m_Kinds[vertex] != VertexKind::Locked)
+							m_Quadrics[vertex] += border;
+					}
+				}
+			}
+		}
+
+		void BuildAdjacency()
+		{
+			const size_t vertexCount = m_Vertices.size();
+			m_FirstTriangles.assign(vertexCount + 1, 0);
+			for (const uint32_t index : m_Indices)
+				++m_FirstTriangles[index + 1];
+			for (size_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+				m_FirstTriangles[vertex + 1] += m_FirstTriangles[vertex];
+
+			m_Triangles.resize(m_Indices.size());
+			std::vector<uint32_t> next(m_FirstTriangles.begin(), m_FirstTriangles.end() - 1);
+			for (size_t corner{ 0 }; corner < m_Indices.size(); ++corner)
+				m_Triangles[next[m_Indices[corner]]++] = static_cast<uint32_t>(corner / 3);
+		}
+
+		Collapse GetCollapse(uint32_t vertex, uint32_t target) const
+		{
+			float attributes[attributeCount];
+			GetAttributes(target, attributes);
+			const Quadric& quadric = m_Quadrics[vertex];
+			Collapse collapse{ vertex, target };
+			collapse.error = quadric.Evaluate(m_Positions[target], attributes);
+			collapse.distance = quadric.EvaluateDistance(m_Positions[target]);
+			return collapse;
+		}
+
+		//Every unlocked vertex's cheapest collapse onto a neighbour, cheapest first. Border vertices only move along their
+		//open edges; seam vertices move along the seam together with their sibling, which lands at the same position.
+		void FindCollapses(float errorLimit)
+		{
+			m_Collapses.clear();
+			std::vector<uint32_t> neighbours{};
+			for (uint32_t vertex{ 0 }; vertex < m_Vertices.size(); ++vertex)
+			{
+				const VertexKind kind = m_Kinds[vertex];
+				if (kind == VertexKind::Locked || m_FirstTriangles[vertex] == m_FirstTriangles[vertex + 1])
+					continue;
+
+				Collapse best{ vertex, noVertex };
+				best.error = FLT_MAX;
+				const auto consider = [&best](const Collapse& collapse)
+					{
+						if (collapse.error < best.error)
+							best = collapse;
+					};
+				if (kind == VertexKind::Manifold)
+				{
+					neighbours.clear();
+					for (uint32_t i{ m_FirstTriangles[vertex] }; i < m_FirstTriangles[vertex + 1]; ++i)
+					{
+						const uint32_t first = m_Triangles[i] * 3;
+						for (uint32_t corner{ 0 }; corner < 3; ++corner)
+						{
+							if (m_Indices[first + corner] != vertex)
+								neighbours.push_back(m_Indices[first + corner]);
+						}
+					}
+					std::sort(neighbours.begin(), neighbours.end());
+					neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+
+					for (const uint32_t target : neighbours)
+						consider(GetCollapse(vertex, target));
+				}
+				else if (kind == VertexKind::Border)
+				{
+					for (const uint32_t target : { m_OpenOut[vertex], m_OpenIn[vertex] })
+					{
+						if (target < severalVertices && m_Kinds[target] != VertexKind::Manifold)
+							consider(GetCollapse(vertex, target));
+					}
+				}
+				else
+				{
+					//Every pair is looked at from its lower vertex
+					const uint32_t sibling = m_Siblings[vertex];
+					if (sibling < vertex && m_FirstTriangles[sibling] != m_FirstTriangles[sibling + 1])
+						continue;
+
+					for (const uint32_t target : { m_OpenOut[vertex], m_OpenIn[vertex] })
+					{
+						if (target >= severalVertices || (m_Kinds[target] != VertexKind::Seam && m_Kinds[target] != VertexKind::Locked))
+							continue;
+
+						//The sibling's open neighbour at the target's position
+						uint32_t siblingTarget{ noVertex };
+						for (const uint32_t candidate : { m_OpenOut[sibling], m_OpenIn[sibling] })
+						{
+							if (candidate < severalVertices && candidate != target && m_PositionIds[candidate] == m_PositionIds[target])
+								siblingTarget = candidate;
+						}
+						if (siblingTarget == noVertex)
+							continue;
+
+						Collapse collapse = GetCollapse(vertex, target);
+						const Collapse siblingCollapse = GetCollapse(sibling, siblingTarget);
+						collapse.sibling = sibling;
+						collapse.siblingTarget = siblingTarget;
+						collapse.error += siblingCollapse.error;
+						collapse.distance = std::max(collapse.distance, siblingCollapse.distance);
+						consider(collapse);
+					}
+				}
+				if (best.target != noVertex && best.distance <= errorLimit)
+					m_Collapses.push_back(best);
+			}
+
+			std::sort(m_Collapses.begin(), m_Collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error != b.error ? a.error < b.error : a.vertex < b.vertex; });
+		}
+
+		//The vertices of the triangles around vertex after this pass' collapses so far, without vertex itself
+		void GatherNeighbours(uint32_t vertex, std::vector<uint32_t>& neighbours) const
+		{
+			neighbours.clear();
+			for (uint32_t i{ m_FirstTriangles[vertex] }; i < m_FirstTriangles[vertex + 1]; ++i)
+			{
+				const uint32_t first = m_Triangles[i] * 3;
+				for (uint32_t corner{ 0 }; corner < 3; ++corner)
+				{
+					const uint32_t neighbour = m_Remap[m_Indices[first + corner]];
+					if (neighbour != vertex)
+						neighbours.push_back(neighbour);
+				}
+			}
+			std::sort(neighbours.begin(), neighbours.end());
+			neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+		}
+
+		//How many triangles moving vertex onto target removes, 0 when the collapse would turn a triangle over or pinch the
+		//surface (the two share a neighbour that isn't across one of their edge's triangles)
+		uint32_t CountCollapsedTriangles(uint32_t vertex, uint32_t target)
+		{
+			const Vector3& from = m_Positions[vertex];
+			const Vector3& to = m_Positions[target];
+			uint32_t edgeTriangles{ 0 };
+			for (uint32_t i{ m_FirstTriangles[vertex] }; i < m_FirstTriangles[vertex + 1]; ++i)
+			{
+				const uint32_t first = m_Triangles[i] * 3;
+				uint32_t corners[3]{ m_Remap[m_Indices[first]], m_Remap[m_Indices[first + 1]], m_Remap[m_Indices[first + 2]] };
+				if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2])
+					continue;
+				if (corners[0] == target || corners[1] == target || corners[2] == target)
+				{
+					++edgeTriangles;
+					continue;
+				}
+
+				//Rotated so vertex comes first
+				while (corners[0] != vertex)
+					std::rotate(corners, corners + 1, corners + 3);
+				const Vector3& b = m_Positions[corners[1]];
+				const Vector3& c = m_Positions[corners[2]];
+				const Vector3 before = Vector3::Cross(b - from, c - from);
+				const Vector3 after = Vector3::Cross(b - to, c - to);
+				if (Vector3::Dot(before, after) <= minFlipCosine * before.Magnitude() * after.Magnitude())
+					return 0;
+			}
+			if (edgeTriangles == 0)
+				return 0;
+
+			GatherNeighbours(vertex, m_VertexNeighbours);
+			GatherNeighbours(target, m_TargetNeighbours);
+			size_t sharedCount{ 0 };
+			for (auto a = m_VertexNeighbours.begin(), b = m_TargetNeighbours.begin(); a != m_VertexNeighbours.end() && b != m_TargetNeighbours.end();)
+			{
+				if (*a < *b) ++a;
+				else if (*b < *a) ++b;
+				else { ++sharedCount; ++a; ++b; }
+			}
+			return sharedCount == edgeTriangles ? edgeTriangles : 0;
+		}
+
+		//Applies the pass' collapses and drops the triangles that lost an edge
+		void RemapIndices()
+		{
+			size_t write{ 0 };
+			for (size_t first{ 0 }; first + 2 < m_Indices.size(); first += 3)
+			{
+				const uint32_t a = m_Remap[m_Indices[first]], b = m_Remap[m_Indices[first + 1]], c = m_Remap[m_Indices[first + 2]];
+				if (a == b || b == c || a == c)
+					continue;
+				m_Indices[write++] = a;
+				m_Indices[write++] = b;
+				m_Indices[write++] = c;
+			}
+			m_Indices.resize(write);
+		}
+	};
+}
+
+namespace MeshSimplifier
+{
+	SimplifyResult Simplify(std::span<const uint32_t> indices, const std::vector<Vertex>& vertices, size_t targetIndexCount, float targetError,
+		std::vector<uint32_t>& result, const SimplifySettings& settings)
+	{
+		result.assign(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+		if (result.size() <= targetIndexCount)
+			return {};
+
+		Simplifier simplifier{ result, vertices, settings };
+		return simplifier.Run(targetIndexCount, targetError);
+	}
+
+	std::vector<LODLevel> BuildLODChain(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const LODChainSettings& settings)
+	{
+		std::vector<LODLevel> levels(1);
+		levels[0].indices = indices;
+
+		const size_t triangleCount = indices.size() / 3;
+		for (const float ratio : settings.ratios)
+		{
+			const LODLevel& previous = levels.back();
+			const size_t targetIndexCount = static_cast<size_t>(static_cast<double>(triangleCount) * ratio) * 3;
+			if (targetIndexCount >= previous.indices.size())
+				continue;
+
+			LODLevel level{};
+			const SimplifyResult result = Simplify(previous.indices, vertices, targetIndexCount, settings.maxError, level.indices, settings.simplify);
+			if (level.indices.empty() || level.indices.size() > previous.indices.size() / 10 * 9)
+				break;
+
+			level.error = previous.error + result.error;
+			levels.push_back(std::move(level));
+		}
+		return levels;
+	}
+}
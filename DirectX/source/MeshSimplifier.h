@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "DataTypes.h"
+
+//Edge-collapse simplification driven by quadric error metrics (Garland, Heckbert 1997), with the attribute quadrics of
+//Hoppe 1999 for uvs and normals (MeshSimplifier.cpp). Vertices only ever collapse onto one of their neighbours, so every
+//simplified index buffer still indexes the original vertices and LODs can share one vertex buffer.
+namespace MeshSimplifier
+{
+	struct SimplifySettings
+	{
+		//Open edges keep their vertices; off, border vertices may still slide along the border
+		bool lockBorders{ true };
+		//How much a uv or normal difference counts against a distance when ordering the collapses, positions being scaled to
+		//the unit cube
+		float uvWeight{ 0.25f };
+		float normalWeight{ 0.25f };
+	};
+
+	struct SimplifyResult
+	{
+		size_t collapseCount{};
+		size_t lockedVertexCount{};	//where seams meet or end, on borders (if locked) or on non-manifold edges
+		float error{};				//furthest a collapse moved the surface, in the units of the positions
+	};
+
+	//Collapses edges of the triangles in indices, cheapest first, until at most targetIndexCount indices are left or the next
+	//collapse would move the surface further than targetError (relative to the mesh's largest extent).
+	//The two vertices of a position on a uv seam or hard edge only move along that seam and always together, so it doesn't
+	//tear; positions with more vertices stay where they are. Collapses that would turn a triangle over by more than ~75
+	//degrees are skipped.
+	//Writes the remaining triangles to result, which must not be the vector indices points into.
+	SimplifyResult Simplify(std::span<const uint32_t> indices, const std::vector<Vertex>& vertices, size_t targetIndexCount, float targetError,
+		std::vector<uint32_t>& result, const SimplifySettings& settings = {});
+
+	struct LODLevel
+	{
+		std::vector<uint32_t> indices{};
+		float error{};		//bound on how far this level is from LOD 0, in the units of the positions
+	};
+
+	struct LODChainSettings
+	{
+		//Triangle count of every level relative to LOD 0, coarser ones later
+		std::vector<float> ratios{ 0.5f, 0.25f, 0.125f };
+		//Largest error of a single level's collapses (relative to the mesh's largest extent); a level that reaches it stops short
+		//of its ratio
+		float maxError{ 0.05f };
+		SimplifySettings simplify{};
+	};
+
+	//LOD 0 is indices itself, every further level simplifies the previous one and sums the errors.
+	//A level that can't get below 90% of the previous one's triangles ends the chain.
+	std::vector<LODLevel> BuildLODChain(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const LODChainSettings& settings = {});
+}
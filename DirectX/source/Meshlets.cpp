@@ -0,0 +1,313 @@
+#include "pch.h"
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	//A cone is only worth testing while every normal is within ~84 degrees of its axis
+	constexpr float minConeCosine{ 0.1f };
+	//A meshlet ends before a triangle more than 60 degrees off its average normal, once it has this many triangles:
+	//on the AK-47 that doubles the triangles whose cones cull them against full-size meshlets
+	constexpr float splitConeCosine{ 0.5f };
+	constexpr uint32_t minTrianglesBeforeConeSplit{ 16 };
+	//With no connected triangle left, the nearest of this many untaken ones in cache order may still join a meshlet
+	constexpr uint32_t disconnectedCandidates{ 32 };
+
+	Vector3 GetTriangleNormal(const Vector3& a, const Vector3& b, const Vector3& c)
+	{
+		const Vector3 cross = Vector3::Cross(b - a, c - a);
+		const float length = cross.Magnitude();
+		return length > 0.f ? cross / length : Vector3{};
+	}
+
+	//Sphere around the bounds' centre, cone from the triangle normals as meshoptimizer computes it: the axis is their
+	//average, the apex sits far enough behind every triangle's plane that the cone holds all of them
+	void ComputeBounds(Meshlet& meshlet, const std::vector<Vertex>& vertices, std::span<const uint32_t> meshletVertices, int32_t baseVertex,
+		std::span<const uint8_t> triangles)
+	{
+		const auto getPosition = [&](uint32_t local) -> const Vector3& { return vertices[baseVertex + meshletVertices[local]].position; };
+
+		Vector3 min{ FLT_MAX, FLT_MAX, FLT_MAX }, max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (uint32_t local{ 0 }; local < meshletVertices.size(); ++local)
+		{
+			const Vector3& p = getPosition(local);
+			min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+			max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+		}
+		const Vector3 center = (min + max) * 0.5f;
+		float radiusSquared{ 0.f };
+		for (uint32_t local{ 0 }; local < meshletVertices.size(); ++local)
+			radiusSquared = std::max(radiusSquared, (getPosition(local) - center).SqrMagnitude());
+		meshlet.bounds = { center, std::sqrt(radiusSquared) };
+
+		Vector3 normalSum{};
+		for (size_t corner{ 0 }; corner + 2 < triangles.size(); corner += 3)
+			normalSum += GetTriangleNormal(getPosition(triangles[corner]), getPosition(triangles[corner + 1]), getPosition(triangles[corner + 2]));
+		const float sumLength = normalSum.Magnitude();
+		if (!(sumLength > 0.f))
+			return;
+		const Vector3 axis = normalSum / sumLength;
+
+		float minDot{ 1.f };
+		for (size_t corner{ 0 }; corner + 2 < triangles.size(); corner += 3)
+		{
+			const Vector3 normal = GetTriangleNormal(getPosition(triangles[corner]), getPosition(triangles[corner + 1]), getPosition(triangles[corner + 2]));
+			minDot = std::min(minDot, Vector3::Dot(normal, axis));
+		}
+		if (minDot <= minConeCosine)
+			return;
+
+		float maxT{ 0.f };
+		for (size_t corner{ 0 }; corner + 2 < triangles.size(); corner += 3)
+		{
+			const Vector3& p0 = getPosition(triangles[corner]);
+			const Vector3 normal = GetTriangleNormal(p0, getPosition(triangles[corner + 1]), getPosition(triangles[corner + 2]));
+			const float normalDot = Vector3::Dot(normal, axis);
+			if (normalDot > 0.f)
+				maxT = std::max(maxT, Vector3::Dot(center - p0, normal) / normalDot);
+		}
+		meshlet.coneApex = center - axis * maxT;
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+	}
+
+	//Grows meshlets over shared vertices: each one starts at the first triangle not taken yet (so the cache order still
+	//decides where they go) and takes the neighbouring triangle that adds the fewest vertices, the one closest to its
+	//normal cone's axis among those. The triangles are rewritten in meshlet order within their submesh.
+	template<typename Index>
+	void BuildMeshlets(const std::vector<Vertex>& vertices, std::span<Index> indices, std::span<const Submesh> submeshes, Meshlets::MeshletData& data)
+	{
+		data.meshlets.clear();
+		data.vertices.clear();
+		data.triangles.assign(indices.size(), 0);
+
+		const Submesh wholeMesh{ 0, static_cast<uint32_t>(indices.size()), 0, 0, {} };
+		if (submeshes.empty())
+			submeshes = { &wholeMesh, 1 };
+
+		uint32_t maxIndex{ 0 };
+		for (const Index index : indices)
+			maxIndex = std::max<uint32_t>(maxIndex, index);
+		const size_t indexRange = size_t(maxIndex) + 1;
+		//An index has a slot in the current meshlet when its stamp is the meshlet's
+		std::vector<uint32_t> stamps(indexRange, 0);
+		std::vector<uint8_t> localIndices(indexRange, 0);
+		uint32_t stamp{ 0 };
+
+		std::vector<uint32_t> firstTriangles(indexRange + 1);
+		std::vector<uint32_t> liveCounts(indexRange);
+		std::vector<uint32_t> adjacency{};
+		std::vector<Vector3> normals{};
+		std::vector<uint8_t> isTaken{};
+		std::vector<Index> ordered{};
+
+		for (const Submesh& submesh : submeshes)
+		{
+			const uint32_t triangleCount = submesh.indexCount / 3;
+			const std::span<Index> submeshIndices = indices.subspan(submesh.firstIndex, triangleCount * 3);
+			const auto getPosition = [&](Index index) -> const Vector3& { return vertices[submesh.baseVertex + index].position; };
+
+			//Triangles around every index, each list shrinking as its triangles are taken
+			std::fill(firstTriangles.begin(), firstTriangles.end(), 0u);
+			for (const Index index : submeshIndices)
+				++firstTriangles[size_t(index) + 1];
+			for (size_t index{ 0 }; index < indexRange; ++index)
+				firstTriangles[index + 1] += firstTriangles[index];
+			std::fill(liveCounts.begin(), liveCounts.end(), 0u);
+			adjacency.resize(submeshIndices.size());
+			for (uint32_t corner{ 0 }; corner < submeshIndices.size(); ++corner)
+			{
+				const Index index = submeshIndices[corner];
+				adjacency[firstTriangles[index] + liveCounts[index]++] = corner / 3;
+			}
+
+			normals.resize(triangleCount);
+			for (uint32_t triangle{ 0 }; triangle < triangleCount; ++triangle)
+			{
+				normals[triangle] = GetTriangleNormal(getPosition(submeshIndices[triangle * 3]), getPosition(submeshIndices[triangle * 3 + 1]),
+					getPosition(submeshIndices[triangle * 3 + 2]));
+			}
+			isTaken.assign(triangleCount, 0);
+			ordered.clear();
+
+			Meshlet meshlet{};
+			Vector3 normalSum{};
+			Vector3 min{}, max{};
+			std::vector<uint32_t> meshletIndices{};
+			const auto begin = [&]()
+				{
+					meshlet = {};
+					meshlet.firstIndex = submesh.firstIndex + static_cast<uint32_t>(ordered.size());
+					meshlet.firstVertex = static_cast<uint32_t>(data.vertices.size());
+					normalSum = {};
+					min = { FLT_MAX, FLT_MAX, FLT_MAX };
+					max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+					meshletIndices.clear();
+					++stamp;
+				};
+			const auto end = [&]()
+				{
+					if (meshlet.triangleCount == 0)
+						return;
+					ComputeBounds(meshlet, vertices, std::span<const uint32_t>{ data.vertices }.subspan(meshlet.firstVertex, meshlet.vertexCount), submesh.baseVertex,
+						std::span<const uint8_t>{ data.triangles }.subspan(meshlet.firstIndex, meshlet.triangleCount * 3));
+					data.meshlets.push_back(meshlet);
+				};
+			const auto countNewVertices = [&](uint32_t triangle)
+				{
+					uint32_t count{ 0 };
+					for (uint32_t corner{ 0 }; corner < 3; ++corner)
+						count += stamps[submeshIndices[triangle * 3 + corner]] != stamp;
+					return count;
+				};
+			const auto take = [&](uint32_t triangle)
+				{
+					isTaken[triangle] = 1;
+					for (uint32_t corner{ 0 }; corner < 3; ++corner)
+					{
+						const Index index = submeshIndices[triangle * 3 + corner];
+						if (stamps[index] != stamp)
+						{
+							const Vector3& p = getPosition(index);
+							min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+							max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+							stamps[index] = stamp;
+							localIndices[index] = static_cast<uint8_t>(meshlet.vertexCount++);
+							data.vertices.push_back(index);
+							meshletIndices.push_back(index);
+						}
+						data.triangles[submesh.firstIndex + ordered.size()] = localIndices[index];
+						ordered.push_back(index);
+
+						uint32_t* const pLive = &adjacency[firstTriangles[index]];
+						uint32_t& liveCount = liveCounts[index];
+						*std::find(pLive, pLive + liveCount, triangle) = pLive[liveCount - 1];
+						--liveCount;
+					}
+					++meshlet.triangleCount;
+					normalSum += normals[triangle];
+				};
+
+			uint32_t nextSeed{ 0 };
+			begin();
+			while (ordered.size() < submeshIndices.size())
+			{
+				//The cheapest live triangle around the meshlet's vertices
+				uint32_t best{ UINT32_MAX };
+				uint32_t bestNewVertices{ 3 };
+				float bestDot{ -FLT_MAX };
+				const Vector3 axis = normalSum.Normalized();
+				for (const uint32_t index : meshletIndices)
+				{
+					for (uint32_t i{ firstTriangles[index] }; i < firstTriangles[index] + liveCounts[index]; ++i)
+					{
+						const uint32_t triangle = adjacency[i];
+						const uint32_t newVertices = countNewVertices(triangle);
+						const float dot = Vector3::Dot(normals[triangle], axis);
+						if (newVertices < bestNewVertices || (newVertices == bestNewVertices && dot > bestDot))
+						{
+							best = triangle;
+							bestNewVertices = newVertices;
+							bestDot = dot;
+						}
+					}
+				}
+
+				//Nothing connected left: the untaken triangle nearest to the meshlet among the next ones in cache order, as
+				//long as it lies within the meshlet's bounds grown by half their size; otherwise the meshlet ends
+				if (best == UINT32_MAX && meshlet.triangleCount > 0)
+				{
+					while (isTaken[nextSeed])
+						++nextSeed;
+					const Vector3 center = (min + max) * 0.5f;
+					const Vector3 reach = max - min;
+					float bestDistance{ FLT_MAX };
+					for (uint32_t triangle{ nextSeed }, candidates{ 0 }; triangle < triangleCount && candidates < disconnectedCandidates; ++triangle)
+					{
+						if (isTaken[triangle])
+							continue;
+						++candidates;
+						const Vector3 centroid = (getPosition(submeshIndices[triangle * 3]) + getPosition(submeshIndices[triangle * 3 + 1])
+							+ getPosition(submeshIndices[triangle * 3 + 2])) / 3.f;
+						const Vector3 offset = centroid - center;
+						const float distance = offset.SqrMagnitude();
+						if (std::abs(offset.x) <= reach.x && std::abs(offset.y) <= reach.y && std::abs(offset.z) <= reach.z && distance < bestDistance)
+						{
+							best = triangle;
+							bestDistance = distance;
+						}
+					}
+					if (best != UINT32_MAX)
+					{
+						bestNewVertices = countNewVertices(best);
+						bestDot = Vector3::Dot(normals[best], axis);
+					}
+				}
+
+				const bool isDisconnected = best == UINT32_MAX;
+				const bool isFull = meshlet.vertexCount + bestNewVertices > Meshlets::maxVertices || meshlet.triangleCount == Meshlets::maxTriangles;
+				const bool isTurning = meshlet.triangleCount >= minTrianglesBeforeConeSplit && bestDot <= splitConeCosine;
+				if (isDisconnected || isFull || isTurning)
+				{
+					end();
+					begin();
+					//A fresh meshlet starts from cache order again
+					while (isTaken[nextSeed])
+						++nextSeed;
+					best = nextSeed;
+				}
+				take(best);
+			}
+			end();
+			std::copy(ordered.begin(), ordered.end(), submeshIndices.begin());
+		}
+	}
+}
+
+namespace Meshlets
+{
+	void Build(const std::vector<Vertex>& vertices, std::span<uint16_t> indices, std::span<const Submesh> submeshes, MeshletData& data)
+	{
+		BuildMeshlets(vertices, indices, submeshes, data);
+	}
+
+	void Build(const std::vector<Vertex>& vertices, std::span<uint32_t> indices, std::span<const Submesh> submeshes, MeshletData& data)
+	{
+		BuildMeshlets(vertices, indices, submeshes, data);
+	}
+
+	SphereArray GetSpheres(std::span<const Meshlet> meshlets)
+	{
+		SphereArray spheres{};
+		for (const Meshlet& meshlet : meshlets)
+			spheres.Add(meshlet.bounds);
+		return spheres;
+	}
+
+	size_t AppendVisible(std::span<const Meshlet> meshlets, uint32_t firstMeshlet, uint32_t meshletCount, const std::vector<uint32_t>& visibility,
+		const Vector3& camera, bool cullBackfaces, int32_t baseVertex, std::vector<DrawRange>& ranges)
+	{
+		size_t visibleCount{ 0 };
+		bool isExtending{ false };
+		for (uint32_t i{ firstMeshlet }; i < firstMeshlet + meshletCount; ++i)
+		{
+			const Meshlet& meshlet = meshlets[i];
+			if (!Frustum::IsVisible(visibility, i) || (cullBackfaces && IsBackfacing(meshlet, camera)))
+			{
+				isExtending = false;
+				continue;
+			}
+
+			++visibleCount;
+			if (isExtending)
+				ranges.back().indexCount += meshlet.triangleCount * 3;
+			else
+				ranges.push_back({ meshlet.firstIndex, meshlet.triangleCount * 3, baseVertex });
+			isExtending = true;
+		}
+		return visibleCount;
+	}
+}
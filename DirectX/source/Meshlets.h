@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "DataTypes.h"
+
+//Meshlets: small runs of consecutive triangles with a bounding sphere and a normal cone, built when a mesh is cooked
+//(Meshlets.cpp) so the CPU can skip the parts of a mesh that are outside the view or face away from it.
+//Every meshlet's triangles are consecutive in the index buffer, so a visible set is drawn as ranges of the index buffer
+//Mesh already has.
+namespace Meshlets
+{
+	//The meshlet size GPU vendors recommend for mesh shaders, 124 so the triangles' bytes stay a multiple of 4
+	constexpr uint32_t maxVertices{ 64 };
+	constexpr uint32_t maxTriangles{ 124 };
+
+	struct MeshletData
+	{
+		std::vector<Meshlet> meshlets{};
+		std::vector<uint32_t> vertices{};
+		std::vector<uint8_t> triangles{};	//one per index
+	};
+
+	//Groups every submesh's triangles (empty: all indices are one submesh) into meshlets and rewrites them in meshlet order
+	//within the submesh. A meshlet grows from the first triangle left in the current order over its neighbours, fewest new
+	//vertices first (then a nearby unconnected one), and ends at maxVertices, maxTriangles, a triangle that would widen its
+	//normal cone too far or when nothing is near.
+	//Positions are read at the submesh's base vertex plus the index.
+	void Build(const std::vector<Vertex>& vertices, std::span<uint16_t> indices, std::span<const Submesh> submeshes, MeshletData& data);
+	void Build(const std::vector<Vertex>& vertices, std::span<uint32_t> indices, std::span<const Submesh> submeshes, MeshletData& data);
+
+	//The meshlets' spheres in the SoA form Frustum::Cull takes
+	SphereArray GetSpheres(std::span<const Meshlet> meshlets);
+
+	inline bool IsBackfacing(const Meshlet& meshlet, const Vector3& camera)
+	{
+		const Vector3 toApex = meshlet.coneApex - camera;
+		return Vector3::Dot(toApex, meshlet.coneAxis) >= meshlet.coneCutoff * toApex.Magnitude();
+	}
+
+	//One DrawIndexed call
+	struct DrawRange
+	{
+		uint32_t firstIndex{};
+		uint32_t indexCount{};
+		int32_t baseVertex{};
+	};
+
+	//The runtime pass over meshlets [firstMeshlet, firstMeshlet + meshletCount) of one submesh: those whose bit is set in
+	//visibility (Frustum::Cull over GetSpheres) and that don't face away from camera are appended to ranges, consecutive
+	//ones merged into one range. Frustum and camera are in the mesh's space, where culling stays exact for any world
+	//transform that doesn't mirror (cullBackfaces off for mirroring ones). Returns how many meshlets are visible.
+	size_t AppendVisible(std::span<const Meshlet> meshlets, uint32_t firstMeshlet, uint32_t meshletCount, const std::vector<uint32_t>& visibility,
+		const Vector3& camera, bool cullBackfaces, int32_t baseVertex, std::vector<DrawRange>& ranges);
+}
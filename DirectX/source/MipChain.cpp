@@ -0,0 +1,351 @@
+#include "pch.h"
+#include "MipChain.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#include "Parallel.h"
+#include "SIMD.h"
+
+namespace
+{
+	constexpr float pi{ 3.14159265f };
+	//The Kaiser window's width in texels of the smaller level and its shape, as NVTT uses it
+	constexpr float kaiserRadius{ 3.f };
+	constexpr float kaiserAlpha{ 4.f };
+	//Passes over fewer texels than this per thread stay on fewer threads
+	constexpr size_t minTexelsPerThread{ 1 << 15 };
+
+	//Which texels of the larger level, with what weights, make up each texel of the smaller one along one axis.
+	//Every texel has count taps; sources are already wrapped.
+	struct Taps
+	{
+		uint32_t count{};
+		std::vector<uint32_t> sources{};
+		std::vector<float> weights{};
+	};
+
+	float BesselI0(float x)
+	{
+		//Power series, converged well before 20 terms for the arguments the window uses
+		const float quarterSquare = x * x * 0.25f;
+		float term{ 1.f }, sum{ 1.f };
+		for (int k{ 1 }; k < 20; ++k)
+		{
+			term *= quarterSquare / float(k * k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	float Sinc(float x)
+	{
+		return x == 0.f ? 1.f : std::sin(pi * x) / (pi * x);
+	}
+
+	Taps GetTaps(uint32_t sourceSize, uint32_t size, MipChain::Filter filter)
+	{
+		Taps taps{};
+		if (sourceSize == size)
+		{
+			taps.count = 1;
+			taps.sources.resize(size);
+			for (uint32_t i{ 0 }; i < size; ++i)
+				taps.sources[i] = i;
+			taps.weights.assign(size, 1.f);
+			return taps;
+		}
+
+		const float scale = float(sourceSize) / float(size);
+		const float reach = kaiserRadius * scale;
+		const float windowNormalization = 1.f / BesselI0(kaiserAlpha);
+		//A box only straddles one more texel when the scale isn't whole
+		taps.count = filter == MipChain::Filter::Box ? uint32_t(std::ceil(scale)) + (sourceSize % size != 0 ? 1 : 0) : uint32_t(std::ceil(2.f * reach)) + 2;
+		taps.sources.resize(size_t(size) * taps.count);
+		taps.weights.resize(size_t(size) * taps.count);
+
+		for (uint32_t x{ 0 }; x < size; ++x)
+		{
+			const float begin = x * scale, end = (x + 1) * scale, center = (x + 0.5f) * scale;
+			const int64_t first = filter == MipChain::Filter::Box ? int64_t(std::floor(begin)) : int64_t(std::floor(center - reach));
+			float* const pWeights = &taps.weights[size_t(x) * taps.count];
+			float sum{ 0.f };
+			for (uint32_t tap{ 0 }; tap < taps.count; ++tap)
+			{
+				const int64_t source = first + tap;
+				float weight{};
+				if (filter == MipChain::Filter::Box)
+				{
+					//The part of the source texel inside the destination texel
+					weight = std::max(0.f, std::min(float(source + 1), end) - std::max(float(source), begin));
+				}
+				else
+				{
+					const float distance = (float(source) + 0.5f - center) / scale;
+					const float ratio = distance / kaiserRadius;
+					if (ratio * ratio < 1.f)
+						weight = Sinc(distance) * BesselI0(kaiserAlpha * std::sqrt(1.f - ratio * ratio)) * windowNormalization;
+				}
+				pWeights[tap] = weight;
+				sum += weight;
+				taps.sources[size_t(x) * taps.count + tap] = uint32_t(((source % sourceSize) + sourceSize) % sourceSize);
+			}
+			for (uint32_t tap{ 0 }; tap < taps.count; ++tap)
+				pWeights[tap] /= sum;
+		}
+		return taps;
+	}
+
+	const std::array<float, 256>& GetSRGBToLinear()
+	{
+		static const std::array<float, 256> table = []()
+			{
+				std::array<float, 256> values{};
+				for (size_t i{ 0 }; i < values.size(); ++i)
+				{
+					const float c = float(i) / 255.f;
+					values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+				}
+				return values;
+			}();
+		return table;
+	}
+
+	//Linear -> sRGB code, exactly rounded: thresholds are the linear values halfway between neighbouring codes, and the
+	//code at the start of each of the buckets. Buckets are narrower than the closest two thresholds (3e-4 apart near
+	//black), so a value is at most one threshold past its bucket's code.
+	struct SRGBEncoder
+	{
+		static constexpr size_t bucketCount{ 4096 };
+		std::array<float, 256> thresholds{};
+		std::array<uint8_t, bucketCount + 1> bucketCodes{};
+
+		SRGBEncoder()
+		{
+			for (size_t i{ 0 }; i < 255; ++i)
+			{
+				const float c = (float(i) + 0.5f) / 255.f;
+				thresholds[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			thresholds[255] = FLT_MAX;
+			for (size_t bucket{ 0 }; bucket <= bucketCount; ++bucket)
+			{
+				const float start = float(bucket) / bucketCount;
+				bucketCodes[bucket] = uint8_t(std::upper_bound(thresholds.begin(), thresholds.begin() + 255, start) - thresholds.begin());
+			}
+		}
+
+		uint8_t Encode(float linear) const
+		{
+			linear = std::clamp(linear, 0.f, 1.f);
+			const uint8_t code = bucketCodes[size_t(linear * bucketCount)];
+			return linear >= thresholds[code] ? code + 1 : code;
+		}
+	};
+
+	//What the rgb bytes decode to, alpha being linear for every content
+	std::array<float, 256> GetDecodeTable(MipChain::Content content)
+	{
+		std::array<float, 256> values{};
+		for (size_t i{ 0 }; i < values.size(); ++i)
+		{
+			values[i] = content == MipChain::Content::Color ? GetSRGBToLinear()[i]
+				: content == MipChain::Content::Normal ? float(i) * (2.f / 255.f) - 1.f : float(i) / 255.f;
+		}
+		return values;
+	}
+
+	void DecodeRow(const uint8_t* pRow, uint32_t width, const std::array<float, 256>& toFloat, float* pOut)
+	{
+		for (uint32_t i{ 0 }; i < width * 4; i += 4)
+		{
+			pOut[i] = toFloat[pRow[i]];
+			pOut[i + 1] = toFloat[pRow[i + 1]];
+			pOut[i + 2] = toFloat[pRow[i + 2]];
+			pOut[i + 3] = pRow[i + 3] / 255.f;
+		}
+	}
+
+	uint8_t ToUnorm(float value)
+	{
+		return uint8_t(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+	}
+
+	void Encode(const float* pTexels, uint32_t width, MipChain::Content content, size_t beginRow, size_t endRow, uint8_t* pPixels)
+	{
+		static const SRGBEncoder srgb{};
+		for (size_t i{ beginRow * width * 4 }; i < endRow * width * 4; i += 4)
+		{
+			for (size_t channel{ 0 }; channel < 3; ++channel)
+			{
+				const float value = pTexels[i + channel];
+				pPixels[i + channel] = content == MipChain::Content::Color ? srgb.Encode(value)
+					: content == MipChain::Content::Normal ? ToUnorm(value * 0.5f + 0.5f) : ToUnorm(value);
+			}
+			pPixels[i + 3] = ToUnorm(pTexels[i + 3]);
+		}
+	}
+
+	//Horizontal pass: rows [beginRow, endRow) of the source (getRow(y) gives one as floats), narrowed to the destination's width
+	template<typename GetRow>
+	void FilterRows(const GetRow& getRow, float* pDestination, uint32_t width, const Taps& taps, size_t beginRow, size_t endRow)
+	{
+		for (size_t y{ beginRow }; y < endRow; ++y)
+		{
+			const float* pRow = getRow(y);
+			float* pOut = pDestination + y * width * 4;
+			for (uint32_t x{ 0 }; x < width; ++x)
+			{
+				const uint32_t* pSources = &taps.sources[size_t(x) * taps.count];
+				const float* pWeights = &taps.weights[size_t(x) * taps.count];
+#if defined(MATH_USE_SSE)
+				//One texel's 4 channels per register
+				__m128 sum = _mm_setzero_ps();
+				for (uint32_t tap{ 0 }; tap < taps.count; ++tap)
+					sum = SIMD::MulAdd(_mm_set1_ps(pWeights[tap]), _mm_loadu_ps(pRow + size_t(pSources[tap]) * 4), sum);
+				_mm_storeu_ps(pOut + size_t(x) * 4, sum);
+#else
+				float sum[4]{};
+				for (uint32_t tap{ 0 }; tap < taps.count; ++tap)
+				{
+					for (size_t channel{ 0 }; channel < 4; ++channel)
+						sum[channel] += pWeights[tap] * pRow[size_t(pSources[tap]) * 4 + channel];
+				}
+				std::memcpy(pOut + size_t(x) * 4, sum, sizeof(sum));
+#endif
+			}
+		}
+	}
+
+	//destination += weight * source over count floats
+	void AccumulateRow(float* pDestination, const float* pSource, float weight, size_t count)
+	{
+		size_t i{ 0 };
+#if defined(MATH_USE_SSE)
+#if defined(__AVX__)
+		using Lane = __m256;
+#else
+		using Lane = __m128;
+#endif
+		constexpr size_t laneWidth{ sizeof(Lane) / sizeof(float) };
+		const Lane laneWeight = SIMD::Broadcast<Lane>(weight);
+		for (; i + laneWidth <= count; i += laneWidth)
+			SIMD::Store(pDestination + i, SIMD::MulAdd(laneWeight, SIMD::Load<Lane>(pSource + i), SIMD::Load<Lane>(pDestination + i)));
+#endif
+		for (; i < count; ++i)
+			pDestination[i] += weight * pSource[i];
+	}
+
+	//Vertical pass: destination rows [beginRow, endRow) from the horizontally filtered rows, normals renormalized
+	void FilterColumns(const float* pSource, uint32_t width, float* pDestination, const Taps& taps, bool renormalize, size_t beginRow, size_t endRow)
+	{
+		const size_t rowFloats = size_t(width) * 4;
+		for (size_t y{ beginRow }; y < endRow; ++y)
+		{
+			float* pOut = pDestination + y * rowFloats;
+			std::fill(pOut, pOut + rowFloats, 0.f);
+			for (uint32_t tap{ 0 }; tap < taps.count; ++tap)
+			{
+				const float weight = taps.weights[y * taps.count + tap];
+				if (weight != 0.f)
+					AccumulateRow(pOut, pSource + taps.sources[y * taps.count + tap] * rowFloats, weight, rowFloats);
+			}
+
+			if (!renormalize)
+				continue;
+			for (size_t x{ 0 }; x < rowFloats; x += 4)
+			{
+				const float lengthSq = pOut[x] * pOut[x] + pOut[x + 1] * pOut[x + 1] + pOut[x + 2] * pOut[x + 2];
+				if (lengthSq > 1e-12f)
+				{
+					const float invLength = 1.f / std::sqrt(lengthSq);
+					pOut[x] *= invLength;
+					pOut[x + 1] *= invLength;
+					pOut[x + 2] *= invLength;
+				}
+				else
+				{
+					//Opposite normals cancelled out: straight up
+					pOut[x] = pOut[x + 1] = 0.f;
+					pOut[x + 2] = 1.f;
+				}
+			}
+		}
+	}
+}
+
+namespace MipChain
+{
+	uint32_t GetLevelCount(uint32_t width, uint32_t height)
+	{
+		return std::bit_width(std::max({ width, height, 1u }));
+	}
+
+	void Generate(const uint8_t* pPixels, uint32_t width, uint32_t height, uint32_t pitch, const Settings& settings, Image& image)
+	{
+		const uint32_t levelCount = GetLevelCount(width, height);
+		image.levels.resize(levelCount);
+		uint64_t byteCount{ 0 };
+		for (uint32_t level{ 0 }; level < levelCount; ++level)
+		{
+			image.levels[level] = { std::max(width >> level, 1u), std::max(height >> level, 1u), byteCount };
+			byteCount += size_t(image.levels[level].width) * image.levels[level].height * 4;
+		}
+		image.pixels.resize(byteCount);
+		for (uint32_t y{ 0 }; y < height; ++y)
+			std::memcpy(image.pixels.data() + size_t(y) * width * 4, pPixels + size_t(y) * pitch, size_t(width) * 4);
+		if (levelCount == 1)
+			return;
+
+		const unsigned threadCount = Parallel::GetThreadCount(settings.threadCount);
+		const auto forRows = [threadCount](size_t rows, size_t texelsPerRow, const auto& work)
+			{
+				const size_t useful = std::max<size_t>(rows * texelsPerRow / minTexelsPerThread, 1);
+				Parallel::ForRanges(rows, static_cast<unsigned>(std::min<size_t>(threadCount, useful)),
+					[&work](unsigned, size_t begin, size_t end) { work(begin, end); });
+			};
+
+		//Level 1 reads the bytes a row at a time, every further level the float version of the previous one, so rounding
+		//doesn't add up down the chain
+		const std::array<float, 256> toFloat = GetDecodeTable(settings.content);
+		std::vector<float> source{}, rows{}, destination{};
+
+		for (uint32_t level{ 1 }; level < levelCount; ++level)
+		{
+			const TextureLevel& previous = image.levels[level - 1];
+			const TextureLevel& current = image.levels[level];
+			const Taps columnTaps = GetTaps(previous.width, current.width, settings.filter);
+			const Taps rowTaps = GetTaps(previous.height, current.height, settings.filter);
+
+			rows.resize(size_t(current.width) * previous.height * 4);
+			forRows(previous.height, current.width, [&](size_t begin, size_t end)
+				{
+					if (level > 1)
+					{
+						FilterRows([&](size_t y) { return source.data() + y * previous.width * 4; }, rows.data(), current.width, columnTaps, begin, end);
+						return;
+					}
+					std::vector<float> decoded(size_t(width) * 4);
+					const auto decode = [&](size_t y)
+						{
+							DecodeRow(pPixels + y * pitch, width, toFloat, decoded.data());
+							return decoded.data();
+						};
+					FilterRows(decode, rows.data(), current.width, columnTaps, begin, end);
+				});
+
+			destination.resize(size_t(current.width) * current.height * 4);
+			const bool renormalize = settings.content == Content::Normal;
+			forRows(current.height, current.width * rowTaps.count, [&](size_t begin, size_t end)
+				{
+					FilterColumns(rows.data(), current.width, destination.data(), rowTaps, renormalize, begin, end);
+					Encode(destination.data(), current.width, settings.content, begin, end, image.pixels.data() + current.offset);
+				});
+			std::swap(source, destination);
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "DataTypes.h"
+
+//Full mip chains for RGBA8 textures, built on the CPU at load time (MipChain.cpp)
+namespace MipChain
+{
+	//What the texels hold decides how they are averaged
+	enum class Content
+	{
+		Color,		//sRGB rgb, filtered in linear light; alpha is linear
+		Linear,		//data maps (specular, gloss), filtered as stored
+		Normal		//tangent-space normals in rgb, renormalized on every level
+	};
+
+	enum class Filter
+	{
+		Box,		//average of the texels a level's texel covers
+		Kaiser		//Kaiser-windowed sinc over 3 texels of the smaller level each way, sharper at some ringing
+	};
+
+	struct Settings
+	{
+		Content content{ Content::Color };
+		Filter filter{ Filter::Box };
+		unsigned threadCount{ 0 };	//0: one per hardware thread
+	};
+
+	//Every RGBA8 level of one texture in a single allocation, largest first, as D3D11 expects the subresources
+	struct Image
+	{
+		std::vector<TextureLevel> levels{};
+		std::vector<uint8_t> pixels{};
+
+		const uint8_t* GetPixels(size_t level) const { return pixels.data() + levels[level].offset; }
+		uint32_t GetPitch(size_t level) const { return levels[level].width * 4; }
+		TextureView GetView() const { return { TextureFormat::RGBA8, levels, pixels.data() }; }
+	};
+
+	//Levels down to 1x1, each half the size of the previous one rounded down (D3D's rule)
+	uint32_t GetLevelCount(uint32_t width, uint32_t height);
+
+	//Level 0 is a copy of pixels (pitch bytes per row), every further one is filtered from the previous one with wrapping
+	//addressing, matching the samplers in PosCol3D.fx. Rows are split over the threads, 4 channels at a time in SIMD.
+	void Generate(const uint8_t* pPixels, uint32_t width, uint32_t height, uint32_t pitch, const Settings& settings, Image& image);
+}
@@ -0,0 +1,179 @@
+#include "pch.h"
+#include "PNG.h"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+#include "MappedFile.h"
+#include "Zlib.h"
+
+namespace
+{
+	constexpr uint8_t signature[8]{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	enum ColorType : uint8_t
+	{
+		Gray = 0,
+		RGB = 2,
+		Palette = 3,
+		GrayAlpha = 4,
+		RGBA = 6
+	};
+
+	uint32_t ReadBigEndian32(const uint8_t* p)
+	{
+		return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+	}
+
+	uint8_t GetChannelCount(uint8_t colorType)
+	{
+		switch (colorType)
+		{
+		case Gray: return 1;
+		case RGB: return 3;
+		case Palette: return 1;
+		case GrayAlpha: return 2;
+		case RGBA: return 4;
+		default: return 0;
+		}
+	}
+
+	uint8_t Paeth(uint8_t a, uint8_t b, uint8_t c)
+	{
+		const int p = int(a) + b - c;
+		const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+		return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+	}
+
+	//Undoes the per-row filters in place (RFC 2083 6), each row's filter byte followed by its bytes
+	bool Unfilter(uint8_t* pData, uint32_t height, size_t rowBytes, uint32_t texelBytes)
+	{
+		const std::vector<uint8_t> zeroRow(rowBytes, 0);
+		const uint8_t* pPrevious = zeroRow.data();
+		for (uint32_t y{ 0 }; y < height; ++y)
+		{
+			const uint8_t filter = pData[y * (rowBytes + 1)];
+			uint8_t* pRow = pData + y * (rowBytes + 1) + 1;
+			switch (filter)
+			{
+			case 0:
+				break;
+			case 1:
+				for (size_t i{ texelBytes }; i < rowBytes; ++i)
+					pRow[i] += pRow[i - texelBytes];
+				break;
+			case 2:
+				for (size_t i{ 0 }; i < rowBytes; ++i)
+					pRow[i] += pPrevious[i];
+				break;
+			case 3:
+				for (size_t i{ 0 }; i < rowBytes; ++i)
+					pRow[i] += uint8_t(((i >= texelBytes ? pRow[i - texelBytes] : 0) + pPrevious[i]) / 2);
+				break;
+			case 4:
+				for (size_t i{ 0 }; i < rowBytes; ++i)
+				{
+					pRow[i] += i >= texelBytes ? Paeth(pRow[i - texelBytes], pPrevious[i], pPrevious[i - texelBytes]) : Paeth(0, pPrevious[i], 0);
+				}
+				break;
+			default:
+				return false;
+			}
+			pPrevious = pRow;
+		}
+		return true;
+	}
+}
+
+namespace PNG
+{
+	bool Decode(std::span<const uint8_t> file, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height)
+	{
+		if (file.size() < sizeof(signature) || std::memcmp(file.data(), signature, sizeof(signature)) != 0)
+			return false;
+
+		uint8_t colorType{};
+		bool hasHeader{ false };
+		std::vector<uint8_t> compressed{};
+		std::array<uint8_t, 256 * 4> palette{};
+		palette.fill(255);
+
+		//Chunks: length, type, data, CRC
+		for (size_t position{ sizeof(signature) }; position + 12 <= file.size();)
+		{
+			const uint32_t length = ReadBigEndian32(&file[position]);
+			const uint8_t* pType = &file[position + 4];
+			const uint8_t* pChunk = &file[position + 8];
+			if (length > file.size() - position - 12)
+				return false;
+			position += 12 + size_t(length);
+
+			if (std::memcmp(pType, "IHDR", 4) == 0 && length >= 13)
+			{
+				width = ReadBigEndian32(pChunk);
+				height = ReadBigEndian32(pChunk + 4);
+				const uint8_t bitDepth = pChunk[8];
+				colorType = pChunk[9];
+				const uint8_t interlace = pChunk[12];
+				if (bitDepth != 8 || GetChannelCount(colorType) == 0 || interlace != 0 || width == 0 || height == 0)
+					return false;
+				hasHeader = true;
+			}
+			else if (std::memcmp(pType, "PLTE", 4) == 0)
+			{
+				for (uint32_t entry{ 0 }; entry < length / 3 && entry < 256; ++entry)
+					std::memcpy(&palette[entry * 4], pChunk + entry * 3, 3);
+			}
+			else if (std::memcmp(pType, "tRNS", 4) == 0 && colorType == Palette)
+			{
+				for (uint32_t entry{ 0 }; entry < length && entry < 256; ++entry)
+					palette[entry * 4 + 3] = pChunk[entry];
+			}
+			else if (std::memcmp(pType, "IDAT", 4) == 0)
+			{
+				compressed.insert(compressed.end(), pChunk, pChunk + length);
+			}
+			else if (std::memcmp(pType, "IEND", 4) == 0)
+			{
+				break;
+			}
+		}
+		if (!hasHeader)
+			return false;
+
+		const uint32_t channelCount = GetChannelCount(colorType);
+		const size_t rowBytes = size_t(width) * channelCount;
+		std::vector<uint8_t> filtered(size_t(height) * (rowBytes + 1));
+		if (!Zlib::Inflate(compressed, filtered) || !Unfilter(filtered.data(), height, rowBytes, channelCount))
+			return false;
+
+		pixels.resize(size_t(width) * height * 4);
+		for (uint32_t y{ 0 }; y < height; ++y)
+		{
+			const uint8_t* pRow = &filtered[y * (rowBytes + 1) + 1];
+			uint8_t* pOut = &pixels[size_t(y) * width * 4];
+			for (uint32_t x{ 0 }; x < width; ++x, pOut += 4)
+			{
+				const uint8_t* pTexel = pRow + size_t(x) * channelCount;
+				switch (colorType)
+				{
+				case Gray: pOut[0] = pOut[1] = pOut[2] = pTexel[0]; pOut[3] = 255; break;
+				case GrayAlpha: pOut[0] = pOut[1] = pOut[2] = pTexel[0]; pOut[3] = pTexel[1]; break;
+				case RGB: std::memcpy(pOut, pTexel, 3); pOut[3] = 255; break;
+				case Palette: std::memcpy(pOut, &palette[pTexel[0] * 4], 4); break;
+				default: std::memcpy(pOut, pTexel, 4); break;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool Load(const std::string& path, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height)
+	{
+		const MappedFile file{ path };
+		if (!file.IsOpen())
+			return false;
+		return Decode({ reinterpret_cast<const uint8_t*>(file.GetData()), file.GetSize() }, pixels, width, height);
+	}
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+//PNG decoding without SDL_image, for the tools and benchmarks that cook textures (PNG.cpp)
+namespace PNG
+{
+	//8-bit gray, gray + alpha, rgb, rgba and palette images without interlacing, expanded to RGBA8 rows without padding.
+	//The chunk CRCs aren't checked, the zlib stream's Adler-32 is.
+	bool Decode(std::span<const uint8_t> file, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height);
+	bool Load(const std::string& path, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height);
+}
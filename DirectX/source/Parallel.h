@@ -0,0 +1,40 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace Parallel
+{
+	//0 asks for one thread per hardware thread
+	inline unsigned GetThreadCount(unsigned requested)
+	{
+		if (requested != 0)
+			return requested;
+		return std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	//Splits [0, count) into rangeCount contiguous ranges and calls work(range, begin, end) for each on its own thread,
+	//the calling thread doing range 0. The split only depends on count and rangeCount, so results written per range
+	//are deterministic.
+	template<typename Work>
+	void ForRanges(size_t count, unsigned rangeCount, const Work& work)
+	{
+		rangeCount = static_cast<unsigned>(std::clamp<size_t>(rangeCount, 1, std::max<size_t>(count, 1)));
+		const auto getBegin = [count, rangeCount](unsigned range) { return count * range / rangeCount; };
+
+		std::vector<std::thread> threads{};
+		threads.reserve(rangeCount - 1);
+		for (unsigned range{ 1 }; range < rangeCount; ++range)
+		{
+			threads.emplace_back([&work, range, begin = getBegin(range), end = getBegin(range + 1)]() { work(range, begin, end); });
+		}
+
+		work(0u, size_t{ 0 }, getBegin(1));
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <cmath>
+
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Matrix.h"
+
+//Unit quaternion rotation (x, y, z = axis * sin(angle / 2), w = cos(angle / 2)).
+//Composing two rotations is one Hamilton product (16 multiplies) instead of a 4x4 matrix multiply (64).
+struct Quaternion
+{
+	float x{};
+	float y{};
+	float z{};
+	float w{ 1.f };
+
+	constexpr Quaternion() noexcept = default;
+	constexpr Quaternion(float _x, float _y, float _z, float _w) noexcept : x(_x), y(_y), z(_z), w(_w) {}
+
+	//Any axis works, it does not need to be normalized; a zero axis gives the identity rotation.
+	//The angle has the sign of Matrix::CreateRotationX/Y/Z: about X it turns +Z towards +Y, about Y +Z towards +X and
+	//about Z +X towards +Y, so FromAxisAngle(UnitX, a).ToMatrix() == CreateRotationX(a). That is a right-handed turn
+	//about (-x, y, z), hence the mirrored x in the vector part.
+	static Quaternion FromAxisAngle(const Vector3& axis, float angle) noexcept
+	{
+		const float sqrMagnitude = axis.SqrMagnitude();
+		if (sqrMagnitude <= FLT_EPSILON * FLT_EPSILON)
+			return {};
+
+		const float s = std::sin(angle * 0.5f) / std::sqrt(sqrMagnitude);
+		return { -axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f) };
+	}
+
+	static constexpr float Dot(const Quaternion& q1, const Quaternion& q2) noexcept
+	{
+		return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+	}
+
+	constexpr float SqrMagnitude() const noexcept
+	{
+		return Dot(*this, *this);
+	}
+
+	float Normalize() noexcept
+	{
+		const float m = std::sqrt(SqrMagnitude());
+		const float invM = 1.f / m;
+		x *= invM;
+		y *= invM;
+		z *= invM;
+		w *= invM;
+
+		return m;
+	}
+
+	Quaternion Normalized() const noexcept
+	{
+		Quaternion q{ *this };
+		q.Normalize();
+		return q;
+	}
+
+	//Inverse of a unit quaternion
+	constexpr Quaternion Conjugate() const noexcept
+	{
+		return { -x, -y, -z, w };
+	}
+
+	//v' = v + 2w(u x v) + 2u x (u x v), with u the vector part
+	constexpr Vector3 Rotate(const Vector3& v) const noexcept
+	{
+		const Vector3 u{ x, y, z };
+		const Vector3 t = Vector3::Cross(u, v) * 2.f;
+		return v + t * w + Vector3::Cross(u, t);
+	}
+
+	//Row-major (row-vector) rotation matrix, rows are the rotated unit axes
+	constexpr Matrix ToMatrix() const noexcept
+	{
+		const float xx = x * x, yy = y * y, zz = z * z;
+		const float xy = x * y, xz = x * z, yz = y * z;
+		const float wx = w * x, wy = w * y, wz = w * z;
+
+		return {
+			Vector4{ 1.f - 2.f * (yy + zz), 2.f * (xy + wz), 2.f * (xz - wy), 0.f },
+			Vector4{ 2.f * (xy - wz), 1.f - 2.f * (xx + zz), 2.f * (yz + wx), 0.f },
+			Vector4{ 2.f * (xz + wy), 2.f * (yz - wx), 1.f - 2.f * (xx + yy), 0.f },
+			Vector4{ 0.f, 0.f, 0.f, 1.f }
+		};
+	}
+
+#pragma region Operator Overloads
+	//Hamilton product: (q1 * q2) rotates by q2 first, then by q1
+	constexpr Quaternion operator*(const Quaternion& q) const noexcept
+	{
+		return {
+			w * q.x + x * q.w + y * q.z - z * q.y,
+			w * q.y - x * q.z + y * q.w + z * q.x,
+			w * q.z + x * q.y - y * q.x + z * q.w,
+			w * q.w - x * q.x - y * q.y - z * q.z
+		};
+	}
+
+	constexpr Quaternion& operator*=(const Quaternion& q) noexcept
+	{
+		*this = *this * q;
+		return *this;
+	}
+#pragma endregion
+
+	static const Quaternion Identity;
+};
+
+inline constexpr Quaternion Quaternion::Identity{};
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "Renderer.h"
 #include "Mesh.h"
+#include "MeshFile.h"
 #include "Utils.h"
 
 
@@ -22,11 +23,59 @@ Renderer::Renderer(SDL_Window* pWindow) :
 		std::cout << "DirectX initialization failed!\n";
 	}
 	m_Camera.Initialize(45.f, { 0.f,0.f,-132.827f }, static_cast<float>(m_Width) / m_Height);
+	m_pTextureCache = std::make_unique<TextureCache>(m_pDevice);
 	// Create some date for our mesh
-	std::vector<Vertex> vertices{};
-	std::vector<uint32_t> indices{};
-	Utils::ParseOBJ("Resources/CS_AK.obj", vertices, indices);
-	m_pMesh = new Mesh{ m_pDevice, vertices, indices };
+	//The FBX is cooked to a .mesh once, later launches map that and upload it without parsing
+	const std::string sourcePath{ "Resources/AK47_CS2.fbx" };
+	const std::string meshPath{ "Resources/AK47_CS2.mesh" };
+	MeshFile::CookSettings cookSettings{};
+	cookSettings.import.threadCount = 0;
+	cookSettings.packVertices = true;
+	if (!MeshFile::IsUpToDate(sourcePath, meshPath, cookSettings))
+	{
+		MeshFile::CookStats cookStats{};
+		if (MeshFile::Cook(sourcePath, meshPath, cookSettings, &cookStats))
+		{
+			const Utils::OBJImportStats& importStats = cookStats.import;
+			const MeshOptimizer::OptimizeStats& optimizeStats = cookStats.optimize;
+			std::cout << "Cooked " << sourcePath << ": " << importStats.cornerCount << " corners welded to " << importStats.vertexCount << " vertices ("
+				<< importStats.cornerCount * sizeof(Vertex) / 1024 << " KB -> " << importStats.vertexCount * sizeof(Vertex) / 1024 << " KB vertex buffer)\n";
+			std::cout << "Vertex cache (FIFO " << MeshOptimizer::vertexCacheSize << "): ACMR " << optimizeStats.before.acmr << " -> " << optimizeStats.after.acmr
+				<< ", ATVR " << optimizeStats.before.atvr << " -> " << optimizeStats.after.atvr << "\n";
+			std::cout << "Indices: 16-bit in " << cookStats.submeshCount << " submesh(es), " << cookStats.duplicatedVertexCount << " vertices duplicated at the splits ("
+				<< importStats.indexCount * sizeof(uint32_t) / 1024 << " KB -> " << importStats.indexCount * sizeof(uint16_t) / 1024 << " KB index buffer)\n";
+			const VertexPacking::PackingError& packingError = cookStats.packingError;
+			std::cout << "Packed vertices: " << sizeof(Vertex) << " -> " << sizeof(PackedVertex) << " bytes, max error " << packingError.position << " position, "
+				<< packingError.uv << " uv, " << packingError.normalDegrees << " deg normal, " << packingError.tangentDegrees << " deg tangent\n";
+			std::cout << "LODs:";
+			for (const MeshFile::CookedLOD& lod : cookStats.lods)
+				std::cout << " " << lod.triangleCount << " triangles (error " << lod.error << ")";
+			std::cout << "\n";
+			std::cout << "Meshlets: " << cookStats.meshletCount << " of up to " << Meshlets::maxVertices << " vertices, " << Meshlets::maxTriangles << " triangles\n";
+		}
+	}
+
+	const CookedMesh cookedMesh{ meshPath };
+	if (cookedMesh.IsValid())
+	{
+		m_pMesh = new Mesh{ m_pDevice, *m_pTextureCache, cookedMesh.GetView() };
+	}
+	else
+	{
+		//Read-only resources folder or a foreign .mesh: import every launch
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		MeshFile::Import(sourcePath, vertices, indices, cookSettings.import);
+		std::vector<Submesh> submeshes{};
+		MeshOptimizer::Optimize(vertices, indices, submeshes);
+		std::vector<uint16_t> indices16{};
+		MeshOptimizer::SplitFor16BitIndices(vertices, indices, indices16, submeshes);
+		m_pMesh = new Mesh{ m_pDevice, *m_pTextureCache, MeshView::FromVertices(vertices, indices16, submeshes) };
+	}
+
+	const auto& textureStats = m_pTextureCache->GetStats();
+	std::cout << "Textures: " << textureStats.residentCount << " loaded, " << textureStats.residentBytes / 1e6 << " MB of a " << textureStats.budgetBytes / 1e6 << " MB budget, "
+		<< textureStats.hits << " hits, " << textureStats.misses << " misses\n";
 }
 
 Renderer::~Renderer()
@@ -37,6 +86,7 @@ Renderer::~Renderer()
 		m_pDeviceContext->Flush();
 		m_pDeviceContext->Release();
 		delete m_pMesh;
+		m_pTextureCache.reset();
 	}
 }
 
@@ -49,6 +99,13 @@ void Renderer::Update(const Timer* pTimer)
 		m_pMesh->Rotate(Vector3::UnitY, m_RotationSpeed * TO_RADIANS * pTimer->GetElapsed());
 	}
 	m_pMesh->UpdateViewMatrices(m_Camera.GetWorldViewProjection(), m_Camera.GetInvMatrix());
+	m_pMesh->SelectLOD(m_Camera, static_cast<float>(m_Height));
+	m_pMesh->CullMeshlets(m_Camera);
+
+	//Only meshes whose world bounds touch the frustum get submitted in Render
+	m_MeshBounds.Clear();
+	m_MeshBounds.Add(m_pMesh->GetWorldBounds());
+	m_Camera.GetFrustum().Cull(m_MeshBounds, m_MeshVisibility);
 
 	HandleFilterModeChange();
 	HandleInspectModeToggle();
@@ -74,9 +131,9 @@ void Renderer::Render() const
 	m_pDeviceContext->ClearRenderTargetView(m_pRenderTargetView, color);
 	m_pDeviceContext->ClearDepthStencilView(m_pDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0.0f);
 
-	//2. Set pipeline + invoke draw call
-
-	m_pMesh->Render(m_pDeviceContext);
+	//2. Set pipeline + invoke draw call (culled meshes are skipped, nothing is culled before the first Update)
+	if (m_MeshVisibility.empty() || Frustum::IsVisible(m_MeshVisibility, 0))
+		m_pMesh->Render(m_pDeviceContext);
 
 	//3. present backbuffer (swap)
 	m_pSwapChain->Present(0, 0);
@@ -5,6 +5,7 @@
 struct SDL_Window;
 struct SDL_Surface;
 class Mesh;
+class TextureCache;
 
 class Renderer final
 {
@@ -41,8 +42,14 @@ private:
 	ID3D11RenderTargetView* m_pRenderTargetView;
 
 	Camera m_Camera;
+	//Shared by every mesh, released after them and before the device
+	std::unique_ptr<TextureCache> m_pTextureCache{};
 	Mesh* m_pMesh;
 
+	//World bounds of every mesh (SoA) and the frustum culling result, refreshed in Update
+	AABBArray m_MeshBounds{};
+	std::vector<uint32_t> m_MeshVisibility{};
+
 	//...
 	bool m_DisableMeshRotation{ false };
 	bool m_InspectMode{ false };
@@ -0,0 +1,234 @@
+#pragma once
+#include <cassert>
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//Shares loaded resources by key. Acquire hands out ref-counted handles: the first one for a key loads the resource
+//(a miss), later ones share it (hits). A resource no handle refers to any more stays loaded, so it costs nothing to
+//acquire again, until the resident bytes exceed the budget: then the least recently released ones are destroyed
+//first. Resources still referenced are never evicted, so the budget can be exceeded while they are all in use.
+//
+//Resource needs a GetSizeInBytes() const. Not thread-safe, and handles must not outlive their cache: its destructor
+//destroys every resource still resident.
+template<typename Resource>
+class ResourceCache final
+{
+public:
+	//Typed, ref-counted reference to a cached resource; empty when default constructed or when the load failed
+	class Handle final
+	{
+	public:
+		Handle() = default;
+		Handle(const Handle& other)
+			: m_pCache{ other.m_pCache }, m_Slot{ other.m_Slot }
+		{
+			if (m_pCache)
+				m_pCache->AddReference(m_Slot);
+		}
+		Handle(Handle&& other) noexcept
+			: m_pCache{ std::exchange(other.m_pCache, nullptr) }, m_Slot{ other.m_Slot }
+		{
+		}
+		Handle& operator=(Handle other) noexcept
+		{
+			std::swap(m_pCache, other.m_pCache);
+			std::swap(m_Slot, other.m_Slot);
+			return *this;
+		}
+		~Handle()
+		{
+			Reset();
+		}
+
+		void Reset()
+		{
+			if (m_pCache)
+				std::exchange(m_pCache, nullptr)->RemoveReference(m_Slot);
+		}
+
+		Resource* Get() const { return m_pCache ? m_pCache->m_Entries[m_Slot].pResource.get() : nullptr; }
+		Resource* operator->() const { return Get(); }
+		explicit operator bool() const { return m_pCache != nullptr; }
+		bool operator==(const Handle& other) const { return m_pCache == other.m_pCache && (!m_pCache || m_Slot == other.m_Slot); }
+
+	private:
+		friend class ResourceCache;
+		Handle(ResourceCache* pCache, uint32_t slot)
+			: m_pCache{ pCache }, m_Slot{ slot }
+		{
+			m_pCache->AddReference(m_Slot);
+		}
+
+		ResourceCache* m_pCache{};
+		uint32_t m_Slot{};
+	};
+
+	struct Stats
+	{
+		uint64_t hits{};
+		uint64_t misses{};			//loads, failed ones included
+		uint64_t evictions{};
+		uint64_t residentBytes{};
+		uint64_t budgetBytes{};
+		size_t residentCount{};
+		size_t referencedCount{};	//resident resources at least one handle refers to
+	};
+
+	explicit ResourceCache(uint64_t budgetBytes)
+	{
+		m_Stats.budgetBytes = budgetBytes;
+	}
+	ResourceCache(const ResourceCache&) = delete;
+	ResourceCache(ResourceCache&&) noexcept = delete;
+	ResourceCache& operator=(const ResourceCache&) = delete;
+	ResourceCache& operator=(ResourceCache&&) noexcept = delete;
+	~ResourceCache()
+	{
+		assert(m_Stats.referencedCount == 0 && "a handle outlives its cache");
+		for (Entry& entry : m_Entries)
+			entry.pResource.reset();
+	}
+
+	//The resource under key, loaded with load() (returning a std::unique_ptr<Resource>, null on failure) when it isn't
+	//resident. Failed loads aren't cached, the next Acquire tries again.
+	template<typename Load>
+	Handle Acquire(const std::string& key, Load&& load)
+	{
+		if (const auto found = m_Slots.find(key); found != m_Slots.end())
+		{
+			++m_Stats.hits;
+			return Handle{ this, found->second };
+		}
+
+		++m_Stats.misses;
+		std::unique_ptr<Resource> pResource = load();
+		if (!pResource)
+			return {};
+
+		uint32_t slot{};
+		if (m_FreeSlots.empty())
+		{
+			slot = static_cast<uint32_t>(m_Entries.size());
+			m_Entries.emplace_back();
+		}
+		else
+		{
+			slot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+		Entry& entry = m_Entries[slot];
+		entry.key = key;
+		entry.bytes = pResource->GetSizeInBytes();
+		entry.pResource = std::move(pResource);
+		entry.unusedPosition = m_Unused.end();
+		m_Slots.emplace(key, slot);
+		m_Stats.residentBytes += entry.bytes;
+		++m_Stats.residentCount;
+
+		Handle handle{ this, slot };
+		EvictOverBudget();
+		return handle;
+	}
+
+	bool IsResident(const std::string& key) const { return m_Slots.count(key) != 0; }
+
+	//Evicts right away when the resident bytes are over the new budget
+	void SetBudget(uint64_t budgetBytes)
+	{
+		m_Stats.budgetBytes = budgetBytes;
+		EvictOverBudget();
+	}
+
+	//Destroys every resource no handle refers to
+	void Trim()
+	{
+		while (!m_Unused.empty())
+			Evict(m_Unused.front());
+	}
+
+	const Stats& GetStats() const { return m_Stats; }
+
+private:
+	struct Entry
+	{
+		std::string key{};
+		std::unique_ptr<Resource> pResource{};
+		uint64_t bytes{};
+		uint32_t referenceCount{};
+		typename std::list<uint32_t>::iterator unusedPosition{};	//in m_Unused while no handle refers to it
+	};
+
+	std::vector<Entry> m_Entries{};
+	std::vector<uint32_t> m_FreeSlots{};
+	std::unordered_map<std::string, uint32_t> m_Slots{};
+	//Unreferenced resident slots, least recently released first
+	std::list<uint32_t> m_Unused{};
+	Stats m_Stats{};
+
+	void AddReference(uint32_t slot)
+	{
+		Entry& entry = m_Entries[slot];
+		if (entry.referenceCount++ == 0)
+		{
+			++m_Stats.referencedCount;
+			if (entry.unusedPosition != m_Unused.end())
+			{
+				m_Unused.erase(entry.unusedPosition);
+				entry.unusedPosition = m_Unused.end();
+			}
+		}
+	}
+
+	void RemoveReference(uint32_t slot)
+	{
+		Entry& entry = m_Entries[slot];
+		assert(entry.referenceCount > 0);
+		if (--entry.referenceCount == 0)
+		{
+			--m_Stats.referencedCount;
+			entry.unusedPosition = m_Unused.insert(m_Unused.end(), slot);
+			EvictOverBudget();
+		}
+	}
+
+	void EvictOverBudget()
+	{
+		while (m_Stats.residentBytes > m_Stats.budgetBytes && !m_Unused.empty())
+			Evict(m_Unused.front());
+	}
+
+	void Evict(uint32_t slot)
+	{
+		Entry& entry = m_Entries[slot];
+		m_Unused.erase(entry.unusedPosition);
+		m_Slots.erase(entry.key);
+		m_Stats.residentBytes -= entry.bytes;
+		--m_Stats.residentCount;
+		++m_Stats.evictions;
+		entry = Entry{};
+		m_FreeSlots.push_back(slot);
+	}
+};
+
+//The same file however it is spelled: absolute, "." and ".." resolved, forward slashes, and lowercase on Windows, whose
+//file systems ignore case
+inline std::string NormalizeResourcePath(const std::string& path)
+{
+	std::error_code error{};
+	std::filesystem::path absolute = std::filesystem::absolute(path, error);
+	if (error)
+		absolute = path;
+	std::string normalized = absolute.lexically_normal().generic_string();
+#ifdef _WIN32
+	for (char& character : normalized)
+		character = static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+#endif
+	return normalized;
+}
@@ -1,6 +1,6 @@
 //-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //
-//// Shader Purpose: This shader performs lighting calculations using diffuse, normal, and specular maps.
+//// Shader Purpose: This shader performs lighting calculations using diffuse, normal, specular and glossiness maps.
 //
 //-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 
@@ -8,12 +8,15 @@
 float4x4 gWorldViewProj : WorldViewProjection;
 float4x4 gWorldMatrix : World;
 float4x4 gViewInverseMatrix : ViewInverse;
+float3 gPositionOffset : PositionOffset; // Packed vertices: object space position of the quantized (0, 0, 0)
+float3 gPositionScale : PositionScale; // Packed vertices: object space size of the quantization range
 
 /// Textures
 Texture2D gDiffuseMap : DiffuseMap; // Diffuse map for surface color
 Texture2D gNormalMap : NormalMap; // Normal map for surface normals
-Texture2D gSpecularMap : SpecularMap; // Specular map for surface highlights
-Texture2D gGlossinessMap : GlossinessMap; // Glossiness map for specular shininess
+Texture2D gSurfaceMap : SurfaceMap; // Specular intensity and glossiness packed into one texture
+float4 gSpecularChannel : SpecularChannel = float4(1.0f, 0.0f, 0.0f, 0.0f); // Selects the surface map channel holding specular intensity
+float4 gGlossinessChannel : GlossinessChannel = float4(0.0f, 1.0f, 0.0f, 0.0f); // Selects the surface map channel holding glossiness
 
 /// Mathematical Constants
 float gPI = 3.14159265358979311600; //Speaks for itself I hope
@@ -58,7 +61,22 @@ struct VS_INPUT
     float3 Position : POSITION; // Vertex position in object space
     float2 UV : TEXCOORD; // Texture coordinates
     float3 Normal : NORMAL; // Vertex normal
-    float3 Tangent : TANGENT; // Vertex tangent
+    float4 Tangent : TANGENT; // Vertex tangent, w is the bitangent sign
+};
+
+// Packed vertex (PackedVertex in DataTypes.h): positions in [0, 1] inside the mesh bounds,
+// normal and tangent as one quaternion whose w sign is the bitangent sign
+struct VS_INPUT_PACKED
+{
+    float4 Position : POSITION; // R16G16B16A16_UNORM, w unused
+    float2 UV : TEXCOORD; // R16G16_FLOAT
+    float4 Frame : TANGENT; // R16G16B16A16_SNORM quaternion
+};
+
+// Position only (PositionVertex in DataTypes.h)
+struct VS_INPUT_POSITION
+{
+    float3 Position : POSITION;
 };
 
 struct VS_OUTPUT
@@ -67,7 +85,7 @@ struct VS_OUTPUT
     float4 WorldPosition : TEXCOORD0; // World position of the vertex
     float2 UV : TEXCOORD1; // Output texture coordinates
     float3 Normal : NORMAL; // Transformed vertex normal
-    float3 Tangent : TANGENT; // Transformed vertex tangent
+    float4 Tangent : TANGENT; // Transformed vertex tangent, w is the bitangent sign
 };
 
 
@@ -100,10 +118,12 @@ float CalculatePhong(float ks, float exp, float3 l, float3 v, float3 n)
 // Pixel shader performing lighting calculations
 float4 PS_Phong(VS_OUTPUT input, SamplerState state) : SV_TARGET
 {
-    // Tangent space transformation for normal mapping
-    const float3 binormal = cross(input.Normal, input.Tangent);
-    const float4x4 tangentSpaceAxis = float4x4(float4(input.Tangent, 0.0f), float4(binormal, 0.0f), float4(input.Normal, 0.0), float4(0.0f, 0.0f, 0.0f, 1.0f));
-    const float3 currentNormalMap = 2.0f * gNormalMap.Sample(state, input.UV).rgb - float3(1.0f, 1.0f, 1.0f);
+    // Tangent space transformation for normal mapping, mirrored uvs flip the binormal
+    const float3 binormal = cross(input.Normal, input.Tangent.xyz) * input.Tangent.w;
+    const float4x4 tangentSpaceAxis = float4x4(float4(input.Tangent.xyz, 0.0f), float4(binormal, 0.0f), float4(input.Normal, 0.0), float4(0.0f, 0.0f, 0.0f, 1.0f));
+    // The normal map is BC5 (x and y only), z is rebuilt from the unit length
+    const float2 normalXY = 2.0f * gNormalMap.Sample(state, input.UV).rg - float2(1.0f, 1.0f);
+    const float3 currentNormalMap = float3(normalXY, sqrt(saturate(1.0f - dot(normalXY, normalXY))));
     const float3 normal = mul(float4(currentNormalMap, 0.0f), tangentSpaceAxis);
 
     const float3 viewDirection = normalize(input.WorldPosition.xyz - gViewInverseMatrix[3].xyz);
@@ -111,8 +131,10 @@ float4 PS_Phong(VS_OUTPUT input, SamplerState state) : SV_TARGET
     // Lighting calculations
     const float observedArea = saturate(dot(normal, -gLightDirection));
     const float4 lambert = CalculateLambert(1.0f, gDiffuseMap.Sample(state, input.UV));
-    const float specularExp = gShininess * gGlossinessMap.Sample(state, input.UV).r;
-    const float4 specular = gSpecularMap.Sample(state, input.UV) * CalculatePhong(1.0f, specularExp, -gLightDirection, viewDirection, input.Normal);
+    // One sample for both maps, identical maps share a channel
+    const float4 surface = gSurfaceMap.Sample(state, input.UV);
+    const float specularExp = gShininess * dot(surface, gGlossinessChannel);
+    const float4 specular = float4(dot(surface, gSpecularChannel).xxx, 1.0f) * CalculatePhong(1.0f, specularExp, -gLightDirection, viewDirection, input.Normal);
 
     return (gLightIntensity * lambert + specular) * observedArea; // Final lighting calculation
 }
@@ -129,10 +151,41 @@ VS_OUTPUT VS(VS_INPUT input)
     output.Position = mul(float4(input.Position, 1.f),gWorldViewProj);
     output.UV = input.UV; //UV -> Pass UV to pixel shader
     output.Normal = mul(normalize(input.Normal), (float3x3) gWorldMatrix);
-    output.Tangent = mul(normalize(input.Tangent), (float3x3) gWorldMatrix);
+    output.Tangent = float4(mul(normalize(input.Tangent.xyz), (float3x3) gWorldMatrix), input.Tangent.w);
+    return output;
+}
+
+// The rotated x and z axes of the (normalized) frame quaternion, same math as VertexPacking::Decode
+float3 QuaternionToTangent(float4 q)
+{
+    return float3(1.f - 2.f * (q.y * q.y + q.z * q.z), 2.f * (q.x * q.y + q.w * q.z), 2.f * (q.x * q.z - q.w * q.y));
+}
+
+float3 QuaternionToNormal(float4 q)
+{
+    return float3(2.f * (q.x * q.z + q.w * q.y), 2.f * (q.y * q.z - q.w * q.x), 1.f - 2.f * (q.x * q.x + q.y * q.y));
+}
+
+VS_OUTPUT VS_Packed(VS_INPUT_PACKED input)
+{
+    VS_OUTPUT output = (VS_OUTPUT) 0;
+    const float3 position = gPositionOffset + input.Position.xyz * gPositionScale;
+    const float4 frame = normalize(input.Frame);
+    output.Position = mul(float4(position, 1.f), gWorldViewProj);
+    output.UV = input.UV;
+    output.Normal = mul(QuaternionToNormal(frame), (float3x3) gWorldMatrix);
+    output.Tangent = float4(mul(QuaternionToTangent(frame), (float3x3) gWorldMatrix), frame.w < 0.f ? -1.f : 1.f);
     return output;
 }
 
+// No normals or uvs: the pixel shader shades the faces from the world position
+VS_OUTPUT VS_Position(VS_INPUT_POSITION input)
+{
+    VS_OUTPUT output = (VS_OUTPUT) 0;
+    output.Position = mul(float4(input.Position, 1.f), gWorldViewProj);
+    output.WorldPosition = mul(float4(input.Position, 1.f), gWorldMatrix);
+    return output;
+}
 
 //-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //
@@ -154,6 +207,14 @@ float4 PixelShader_Anisotropic(VS_OUTPUT input) : SV_TARGET
     return PS_Phong(input, gSamAnisotropic);
 }
 
+// Flat gray lambert with the face normal taken from the screen space derivatives of the world position
+float4 PixelShader_Flat(VS_OUTPUT input) : SV_TARGET
+{
+    const float3 normal = normalize(cross(ddx(input.WorldPosition.xyz), ddy(input.WorldPosition.xyz)));
+    const float observedArea = saturate(dot(normal, -gLightDirection));
+    return float4(0.2f, 0.2f, 0.2f, 1.f) + float4(0.6f, 0.6f, 0.6f, 0.f) * observedArea;
+}
+
 //-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //
 // TECHNIQUES
@@ -185,4 +246,40 @@ technique11 AnisotropicFilterTechnique
         SetGeometryShader(NULL);
         SetPixelShader(CompileShader(ps_5_0, PixelShader_Anisotropic()));
     }
+}
+technique11 PointFilterPackedTechnique
+{
+    pass P0
+    {
+        SetVertexShader(CompileShader(vs_5_0, VS_Packed()));
+        SetGeometryShader(NULL);
+        SetPixelShader(CompileShader(ps_5_0, PixelShader_Point()));
+    }
+}
+technique11 LinearFilterPackedTechnique
+{
+    pass P0
+    {
+        SetVertexShader(CompileShader(vs_5_0, VS_Packed()));
+        SetGeometryShader(NULL);
+        SetPixelShader(CompileShader(ps_5_0, PixelShader_Linear()));
+    }
+}
+technique11 AnisotropicFilterPackedTechnique
+{
+    pass P0
+    {
+        SetVertexShader(CompileShader(vs_5_0, VS_Packed()));
+        SetGeometryShader(NULL);
+        SetPixelShader(CompileShader(ps_5_0, PixelShader_Anisotropic()));
+    }
+}
+technique11 PositionOnlyTechnique
+{
+    pass P0
+    {
+        SetVertexShader(CompileShader(vs_5_0, VS_Position()));
+        SetGeometryShader(NULL);
+        SetPixelShader(CompileShader(ps_5_0, PixelShader_Flat()));
+    }
 }
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <immintrin.h>
+#define MATH_USE_SSE
+#endif
+
+//Thin overloads over the raw SSE (__m128) and AVX (__m256) registers, so a kernel is written once as a template
+//and runs 4 or 8 wide depending on the register type it is instantiated with.
+namespace SIMD
+{
+#if defined(MATH_USE_SSE)
+	template<typename V> V Broadcast(float f);
+	template<typename V> V Load(const float* p); //unaligned
+
+	template<> inline __m128 Broadcast<__m128>(float f) { return _mm_set1_ps(f); }
+	template<> inline __m128 Load<__m128>(const float* p) { return _mm_loadu_ps(p); }
+	inline void Store(float* p, __m128 a) { _mm_storeu_ps(p, a); }
+	inline __m128 Add(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+	inline __m128 Sub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+	inline __m128 Mul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+	inline __m128 Div(__m128 a, __m128 b) { return _mm_div_ps(a, b); }
+	inline __m128 Sqrt(__m128 a) { return _mm_sqrt_ps(a); }
+	inline __m128 Min(__m128 a, __m128 b) { return _mm_min_ps(a, b); }
+	inline __m128 Max(__m128 a, __m128 b) { return _mm_max_ps(a, b); }
+	inline __m128 MulAdd(__m128 a, __m128 b, __m128 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+	inline __m128 And(__m128 a, __m128 b) { return _mm_and_ps(a, b); }
+	inline __m128 Or(__m128 a, __m128 b) { return _mm_or_ps(a, b); }
+	inline __m128 Xor(__m128 a, __m128 b) { return _mm_xor_ps(a, b); }
+	inline __m128 Equal(__m128 a, __m128 b) { return _mm_cmpeq_ps(a, b); }
+	inline __m128 GreaterEqual(__m128 a, __m128 b) { return _mm_cmpge_ps(a, b); }
+	inline __m128 Less(__m128 a, __m128 b) { return _mm_cmplt_ps(a, b); }
+	inline int MoveMask(__m128 mask) { return _mm_movemask_ps(mask); } //one bit per lane
+	inline __m128 Select(__m128 mask, __m128 ifTrue, __m128 ifFalse) { return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse)); }
+	inline __m128 Round(__m128 a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+	inline __m128 Floor(__m128 a)
+	{
+		const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+		return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a), _mm_set1_ps(1.f)));
+	}
+
+#if defined(__AVX__)
+	template<> inline __m256 Broadcast<__m256>(float f) { return _mm256_set1_ps(f); }
+	template<> inline __m256 Load<__m256>(const float* p) { return _mm256_loadu_ps(p); }
+	inline void Store(float* p, __m256 a) { _mm256_storeu_ps(p, a); }
+	inline __m256 Add(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+	inline __m256 Sub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+	inline __m256 Mul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+	inline __m256 Div(__m256 a, __m256 b) { return _mm256_div_ps(a, b); }
+	inline __m256 Sqrt(__m256 a) { return _mm256_sqrt_ps(a); }
+	inline __m256 Min(__m256 a, __m256 b) { return _mm256_min_ps(a, b); }
+	inline __m256 Max(__m256 a, __m256 b) { return _mm256_max_ps(a, b); }
+#if defined(__FMA__) || defined(__AVX2__)
+	inline __m256 MulAdd(__m256 a, __m256 b, __m256 c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+	inline __m256 MulAdd(__m256 a, __m256 b, __m256 c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+	inline __m256 And(__m256 a, __m256 b) { return _mm256_and_ps(a, b); }
+	inline __m256 Or(__m256 a, __m256 b) { return _mm256_or_ps(a, b); }
+	inline __m256 Xor(__m256 a, __m256 b) { return _mm256_xor_ps(a, b); }
+	inline __m256 Equal(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	inline __m256 GreaterEqual(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	inline __m256 Less(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	inline int MoveMask(__m256 mask) { return _mm256_movemask_ps(mask); }
+	inline __m256 Select(__m256 mask, __m256 ifTrue, __m256 ifFalse) { return _mm256_blendv_ps(ifFalse, ifTrue, mask); }
+	inline __m256 Round(__m256 a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	inline __m256 Floor(__m256 a) { return _mm256_floor_ps(a); }
+#endif
+
+	//sin and cos of every lane in one pass (Cephes sinf/cosf polynomials).
+	//The angle is reduced to [-PI/4, PI/4] around the nearest multiple of PI/2, that quadrant picks which polynomial
+	//ends up in which output and its sign. Max error ~2 ulp for |angle| < 8192, which covers any Euler angle.
+	template<typename V>
+	inline void SinCos(V angles, V& sines, V& cosines)
+	{
+		const V quadrant = Round(Mul(angles, Broadcast<V>(0.636619772367581343f))); //2 / PI
+
+		//Cody-Waite: PI / 2 split in three parts so the reduction stays exact for large quadrants
+		V r = MulAdd(quadrant, Broadcast<V>(-1.5703125f), angles);
+		r = MulAdd(quadrant, Broadcast<V>(-4.837512969970703125e-4f), r);
+		r = MulAdd(quadrant, Broadcast<V>(-7.54978995489188216e-8f), r);
+
+		const V r2 = Mul(r, r);
+
+		V s = MulAdd(r2, Broadcast<V>(-1.9515295891e-4f), Broadcast<V>(8.3321608736e-3f));
+		s = MulAdd(s, r2, Broadcast<V>(-1.6666654611e-1f));
+		s = MulAdd(Mul(s, r2), r, r);
+
+		V c = MulAdd(r2, Broadcast<V>(2.443315711809948e-5f), Broadcast<V>(-1.388731625493765e-3f));
+		c = MulAdd(c, r2, Broadcast<V>(4.166664568298827e-2f));
+		c = MulAdd(Mul(c, r2), r2, MulAdd(r2, Broadcast<V>(-0.5f), Broadcast<V>(1.f)));
+
+		//quadrant mod 4, without integer SIMD (AVX1 has none)
+		const V quarter = Mul(quadrant, Broadcast<V>(0.25f));
+		const V n = Mul(Sub(quarter, Floor(quarter)), Broadcast<V>(4.f));
+
+		const V one = Broadcast<V>(1.f), two = Broadcast<V>(2.f), three = Broadcast<V>(3.f);
+		const V signBit = Broadcast<V>(-0.f);
+		const V swap = Or(Equal(n, one), Equal(n, three));
+		const V sinNegate = GreaterEqual(n, two);
+		const V cosNegate = Or(Equal(n, one), Equal(n, two));
+
+		sines = Xor(Select(swap, c, s), And(sinNegate, signBit));
+		cosines = Xor(Select(swap, s, c), And(cosNegate, signBit));
+	}
+
+	//acos of every lane in [-1, 1], Abramowitz & Stegun 4.4.46: acos(|x|) = sqrt(1 - |x|) * p(|x|), max error 2e-8.
+	//Negative inputs use acos(x) = PI - acos(-x).
+	template<typename V>
+	inline V Acos(V x)
+	{
+		const V signBit = Broadcast<V>(-0.f);
+		const V absX = Xor(x, And(x, signBit));
+
+		V p = MulAdd(absX, Broadcast<V>(-0.0012624911f), Broadcast<V>(0.0066700901f));
+		p = MulAdd(p, absX, Broadcast<V>(-0.0170881256f));
+		p = MulAdd(p, absX, Broadcast<V>(0.0308918810f));
+		p = MulAdd(p, absX, Broadcast<V>(-0.0501743046f));
+		p = MulAdd(p, absX, Broadcast<V>(0.0889789874f));
+		p = MulAdd(p, absX, Broadcast<V>(-0.2145988016f));
+		p = MulAdd(p, absX, Broadcast<V>(1.5707963050f));
+		p = Mul(p, Sqrt(Max(Sub(Broadcast<V>(1.f), absX), Broadcast<V>(0.f))));
+
+		return Select(Less(x, Broadcast<V>(0.f)), Sub(Broadcast<V>(3.14159265358979f), p), p);
+	}
+#endif
+}
+
+//sin and cos of 4 angles at once. The angles go straight into a register (no memory roundtrip), so this stays cheap
+//enough for single matrix builders like Matrix::CreateRotation.
+inline void SinCos(float a0, float a1, float a2, float a3, float* pSines, float* pCosines) noexcept
+{
+#if defined(MATH_USE_SSE)
+	__m128 s, c;
+	SIMD::SinCos(_mm_setr_ps(a0, a1, a2, a3), s, c);
+	_mm_storeu_ps(pSines, s);
+	_mm_storeu_ps(pCosines, c);
+#else
+	const float angles[4]{ a0, a1, a2, a3 };
+	for (int i{ 0 }; i < 4; ++i)
+	{
+		pSines[i] = std::sin(angles[i]);
+		pCosines[i] = std::cos(angles[i]);
+	}
+#endif
+}
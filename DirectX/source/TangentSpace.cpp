@@ -0,0 +1,319 @@
+#include "pch.h"
+#include "TangentSpace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+
+#include "Parallel.h"
+#include "SIMD.h"
+
+namespace
+{
+	constexpr uint32_t noIndex{ UINT32_MAX };
+
+	//The bitangent signs of the triangles around a vertex. A triangle without a usable uv mapping has neither.
+	enum SignBits : uint8_t
+	{
+		PositiveSign = 1,
+		NegativeSign = 2
+	};
+
+	//Squared lengths and uv areas up to this count as zero, like NotZero in the reference
+	constexpr float minValue{ FLT_MIN };
+
+	//Unit vector perpendicular to the normal, for vertices no triangle gave a tangent
+	Vector3 GetAnyTangent(const Vector3& normal)
+	{
+		const float normalLengthSq = normal.SqrMagnitude();
+		if (!(normalLengthSq > minValue))
+			return Vector3::UnitX;
+
+		const Vector3 axis = normal.x * normal.x < 0.81f * normalLengthSq ? Vector3::UnitX : Vector3::UnitY;
+		return (axis - normal * (Vector3::Dot(normal, axis) / normalLengthSq)).Normalized();
+	}
+
+#if defined(MATH_USE_SSE)
+	using namespace SIMD;
+
+#if defined(__AVX__)
+	using Lane = __m256;
+#else
+	using Lane = __m128;
+#endif
+	constexpr size_t laneWidth{ sizeof(Lane) / sizeof(float) };
+
+	struct Lane3
+	{
+		Lane x, y, z;
+	};
+
+	inline Lane Dot(const Lane3& a, const Lane3& b)
+	{
+		return MulAdd(a.x, b.x, MulAdd(a.y, b.y, Mul(a.z, b.z)));
+	}
+
+	inline Lane3 Subtract(const Lane3& a, const Lane3& b)
+	{
+		return { Sub(a.x, b.x), Sub(a.y, b.y), Sub(a.z, b.z) };
+	}
+
+	inline Lane3 Scale(const Lane3& a, Lane s)
+	{
+		return { Mul(a.x, s), Mul(a.y, s), Mul(a.z, s) };
+	}
+
+	//Zero for (near) zero vectors instead of NaN
+	inline Lane3 Normalize(const Lane3& a)
+	{
+		const Lane lengthSq = Dot(a, a);
+		return Scale(a, And(Less(Broadcast<Lane>(minValue), lengthSq), Div(Broadcast<Lane>(1.f), Sqrt(lengthSq))));
+	}
+
+	//a without its part along the unit normal n, normalized
+	inline Lane3 ProjectNormalized(const Lane3& a, const Lane3& n)
+	{
+		return Normalize(Subtract(a, Scale(n, Dot(n, a))));
+	}
+
+	//Angle weighted corner tangents and the sign bits of count triangles starting at pTriangles.
+	//count < laneWidth repeats the last triangle in the unused lanes. A lane's result doesn't depend on which lane it is in,
+	//so where the thread ranges cut the triangles doesn't change anything.
+	void TriangleLanes(const Vertex* pVertices, const uint32_t* pTriangles, size_t count, Vector3* pCornerTangents, uint8_t* pSigns)
+	{
+		enum Row { PX, PY, PZ, U, V, NX, NY, NZ, RowCount };
+		alignas(32) float rows[3][RowCount][laneWidth];
+		for (size_t lane{ 0 }; lane < laneWidth; ++lane)
+		{
+			const uint32_t* pTriangle = pTriangles + std::min(lane, count - 1) * 3;
+			for (int corner{ 0 }; corner < 3; ++corner)
+			{
+				const Vertex& vertex = pVertices[pTriangle[corner]];
+				float (&row)[RowCount][laneWidth] = rows[corner];
+				row[PX][lane] = vertex.position.x; row[PY][lane] = vertex.position.y; row[PZ][lane] = vertex.position.z;
+				row[U][lane] = vertex.uv.x; row[V][lane] = vertex.uv.y;
+				row[NX][lane] = vertex.normal.x; row[NY][lane] = vertex.normal.y; row[NZ][lane] = vertex.normal.z;
+			}
+		}
+
+		Lane3 positions[3], normals[3];
+		Lane us[3], vs[3];
+		for (int corner{ 0 }; corner < 3; ++corner)
+		{
+			positions[corner] = { Load<Lane>(rows[corner][PX]), Load<Lane>(rows[corner][PY]), Load<Lane>(rows[corner][PZ]) };
+			normals[corner] = Normalize({ Load<Lane>(rows[corner][NX]), Load<Lane>(rows[corner][NY]), Load<Lane>(rows[corner][NZ]) });
+			us[corner] = Load<Lane>(rows[corner][U]);
+			vs[corner] = Load<Lane>(rows[corner][V]);
+		}
+
+		const Lane zero = Broadcast<Lane>(0.f), signBit = Broadcast<Lane>(-0.f);
+		const Lane3 d1 = Subtract(positions[1], positions[0]), d2 = Subtract(positions[2], positions[0]);
+		const Lane s1 = Sub(us[1], us[0]), t1 = Sub(vs[1], vs[0]);
+		const Lane s2 = Sub(us[2], us[0]), t2 = Sub(vs[2], vs[0]);
+		const Lane area = Sub(Mul(s1, t2), Mul(s2, t1));
+		const Lane areaSign = And(area, signBit);
+
+		//dP/du times |area|: the reference's vOs with the orientation sign applied
+		const Lane3 os = Subtract(Scale(d1, t2), Scale(d2, t1));
+		const Lane3 dPdu = { Xor(os.x, areaSign), Xor(os.y, areaSign), Xor(os.z, areaSign) };
+		const Lane isValid = And(Less(Broadcast<Lane>(minValue), Xor(area, areaSign)), Less(Broadcast<Lane>(minValue), Dot(os, os)));
+
+		//sign(dot(cross(N, dP/du), dP/dv)), with the triangle's mean normal and whichever winding the indices have
+		const Lane3 faceNormal = { Sub(Mul(d1.y, d2.z), Mul(d1.z, d2.y)), Sub(Mul(d1.z, d2.x), Mul(d1.x, d2.z)), Sub(Mul(d1.x, d2.y), Mul(d1.y, d2.x)) };
+		const Lane3 normalSum = { Add(Add(normals[0].x, normals[1].x), normals[2].x), Add(Add(normals[0].y, normals[1].y), normals[2].y), Add(Add(normals[0].z, normals[1].z), normals[2].z) };
+		const Lane isNegative = Less(Xor(Dot(normalSum, faceNormal), areaSign), zero);
+
+		alignas(32) float tangents[3][3][laneWidth];
+		for (int corner{ 0 }; corner < 3; ++corner)
+		{
+			const Lane3& normal = normals[corner];
+			const Lane3 edge0 = ProjectNormalized(Subtract(positions[(corner + 1) % 3], positions[corner]), normal);
+			const Lane3 edge1 = ProjectNormalized(Subtract(positions[(corner + 2) % 3], positions[corner]), normal);
+			const Lane angle = Acos(Min(Max(Dot(edge0, edge1), Broadcast<Lane>(-1.f)), Broadcast<Lane>(1.f)));
+
+			const Lane3 tangent = Scale(ProjectNormalized(dPdu, normal), And(isValid, angle));
+			Store(tangents[corner][0], tangent.x);
+			Store(tangents[corner][1], tangent.y);
+			Store(tangents[corner][2], tangent.z);
+		}
+
+		const int validBits = MoveMask(isValid), negativeBits = MoveMask(isNegative);
+		for (size_t lane{ 0 }; lane < count; ++lane)
+		{
+			for (int corner{ 0 }; corner < 3; ++corner)
+			{
+				pCornerTangents[lane * 3 + corner] = { tangents[corner][0][lane], tangents[corner][1][lane], tangents[corner][2][lane] };
+			}
+			pSigns[lane] = (validBits >> lane & 1) == 0 ? 0 : (negativeBits >> lane & 1) != 0 ? NegativeSign : PositiveSign;
+		}
+	}
+#else
+	Vector3 NormalizeOrZero(const Vector3& a)
+	{
+		const float lengthSq = a.SqrMagnitude();
+		return lengthSq > minValue ? a / std::sqrt(lengthSq) : Vector3::Zero;
+	}
+
+	//TriangleLanes one triangle at a time
+	void TriangleScalar(const Vertex* pVertices, const uint32_t* pTriangle, Vector3* pCornerTangents, uint8_t& sign)
+	{
+		const Vertex* corners[3]{ &pVertices[pTriangle[0]], &pVertices[pTriangle[1]], &pVertices[pTriangle[2]] };
+		const Vector3 d1 = corners[1]->position - corners[0]->position, d2 = corners[2]->position - corners[0]->position;
+		const float s1 = corners[1]->uv.x - corners[0]->uv.x, t1 = corners[1]->uv.y - corners[0]->uv.y;
+		const float s2 = corners[2]->uv.x - corners[0]->uv.x, t2 = corners[2]->uv.y - corners[0]->uv.y;
+		const float area = s1 * t2 - s2 * t1;
+
+		const Vector3 os = d1 * t2 - d2 * t1;
+		const Vector3 dPdu = area < 0.f ? -os : os;
+		const bool isValid = std::abs(area) > minValue && os.SqrMagnitude() > minValue;
+
+		Vector3 normals[3], normalSum{};
+		for (int corner{ 0 }; corner < 3; ++corner)
+		{
+			normals[corner] = NormalizeOrZero(corners[corner]->normal);
+			normalSum += normals[corner];
+		}
+		const bool isNegative = (Vector3::Dot(normalSum, Vector3::Cross(d1, d2)) < 0.f) != (area < 0.f);
+		sign = !isValid ? 0 : isNegative ? NegativeSign : PositiveSign;
+
+		for (int corner{ 0 }; corner < 3; ++corner)
+		{
+			const Vector3& normal = normals[corner];
+			const auto projectNormalized = [&normal](const Vector3& a) { return NormalizeOrZero(a - normal * Vector3::Dot(normal, a)); };
+			const Vector3 edge0 = projectNormalized(corners[(corner + 1) % 3]->position - corners[corner]->position);
+			const Vector3 edge1 = projectNormalized(corners[(corner + 2) % 3]->position - corners[corner]->position);
+			const float angle = std::acos(std::clamp(Vector3::Dot(edge0, edge1), -1.f, 1.f));
+			pCornerTangents[corner] = isValid ? projectNormalized(dPdu) * angle : Vector3::Zero;
+		}
+	}
+#endif
+}
+
+namespace TangentSpace
+{
+	size_t Generate(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, unsigned threadCount)
+	{
+		threadCount = Parallel::GetThreadCount(threadCount);
+		const size_t triangleCount = indices.size() / 3;
+
+		//The corner tangents go through memory for every thread count, so whichever thread sums them adds the same values.
+		//Every vertex collects the signs meeting at it on the way; OR doesn't care about the order, so the result is the
+		//same for every interleaving.
+		std::vector<Vector3> cornerTangents(triangleCount * 3);
+		std::vector<uint8_t> triangleSigns(triangleCount);
+		std::vector<uint8_t> vertexSigns(vertices.size(), 0);
+		Parallel::ForRanges(triangleCount, threadCount, [&](unsigned, size_t begin, size_t end)
+			{
+#if defined(MATH_USE_SSE)
+				for (size_t i = begin; i < end; i += laneWidth)
+				{
+					TriangleLanes(vertices.data(), &indices[i * 3], std::min(laneWidth, end - i), &cornerTangents[i * 3], &triangleSigns[i]);
+				}
+#else
+				for (size_t i = begin; i < end; ++i)
+				{
+					TriangleScalar(vertices.data(), &indices[i * 3], &cornerTangents[i * 3], triangleSigns[i]);
+				}
+#endif
+				for (size_t i = begin * 3; i < end * 3; ++i)
+				{
+					const uint8_t sign = triangleSigns[i / 3];
+					std::atomic_ref<uint8_t> vertexSign{ vertexSigns[indices[i]] };
+					if ((vertexSign.load(std::memory_order_relaxed) & sign) != sign)
+						vertexSign.fetch_or(sign, std::memory_order_relaxed);
+				}
+			});
+
+		//Mirrored uv seams inside one vertex: the positive triangles keep it, the negative ones move to a copy
+		const size_t originalCount = vertices.size();
+		std::vector<uint32_t> negativeCopies{};
+		for (size_t i = 0; i < originalCount; ++i)
+		{
+			if (vertexSigns[i] != (PositiveSign | NegativeSign))
+				continue;
+
+			if (negativeCopies.empty())
+				negativeCopies.assign(originalCount, noIndex);
+			negativeCopies[i] = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(vertices[i]);
+			vertexSigns[i] = PositiveSign;
+			vertexSigns.push_back(NegativeSign);
+		}
+		if (!negativeCopies.empty())
+		{
+			Parallel::ForRanges(triangleCount, threadCount, [&](unsigned, size_t begin, size_t end)
+				{
+					for (size_t i = begin * 3; i < end * 3; ++i)
+					{
+						if (triangleSigns[i / 3] == NegativeSign && negativeCopies[indices[i]] != noIndex)
+							indices[i] = negativeCopies[indices[i]];
+					}
+				});
+		}
+
+		std::vector<Vector3> tangentSums(vertices.size());
+		if (threadCount == 1)
+		{
+			for (size_t i = 0; i < indices.size(); ++i)
+			{
+				tangentSums[indices[i]] += cornerTangents[i];
+			}
+		}
+		else
+		{
+			//Which triangle range uses each vertex: one range, or shared by several. Whatever the interleaving, a vertex
+			//touched by two ranges ends up shared.
+			constexpr uint32_t unused{ UINT32_MAX }, shared{ UINT32_MAX - 1 };
+			std::vector<uint32_t> owners(vertices.size(), unused);
+			Parallel::ForRanges(triangleCount, threadCount, [&](unsigned range, size_t begin, size_t end)
+				{
+					for (size_t i = begin * 3; i < end * 3; ++i)
+					{
+						std::atomic_ref<uint32_t> owner{ owners[indices[i]] };
+						uint32_t current = owner.load(std::memory_order_relaxed);
+						if (current == unused && owner.compare_exchange_strong(current, range, std::memory_order_relaxed))
+							continue;
+						if (current != range && current != shared)
+							owner.store(shared, std::memory_order_relaxed);
+					}
+				});
+
+			//A vertex owned by one range gets all its corners from that thread, in order. Shared ones are added after,
+			//range by range, so every vertex sums its corners in index order like the single-threaded loop.
+			std::vector<std::vector<uint32_t>> sharedCorners(threadCount);
+			Parallel::ForRanges(triangleCount, threadCount, [&](unsigned range, size_t begin, size_t end)
+				{
+					for (size_t i = begin * 3; i < end * 3; ++i)
+					{
+						const uint32_t vertex = indices[i];
+						if (owners[vertex] == range)
+							tangentSums[vertex] += cornerTangents[i];
+						else
+							sharedCorners[range].push_back(static_cast<uint32_t>(i));
+					}
+				});
+
+			for (const auto& corners : sharedCorners)
+			{
+				for (const uint32_t corner : corners)
+				{
+					tangentSums[indices[corner]] += cornerTangents[corner];
+				}
+			}
+		}
+
+		Parallel::ForRanges(vertices.size(), threadCount, [&](unsigned, size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const Vector3& sum = tangentSums[i];
+					const float lengthSq = sum.SqrMagnitude();
+					const Vector3 tangent = lengthSq > minValue ? sum / std::sqrt(lengthSq) : GetAnyTangent(vertices[i].normal);
+					vertices[i].tangent = Vector4{ tangent, vertexSigns[i] == NegativeSign ? -1.f : 1.f };
+				}
+			});
+
+		return vertices.size() - originalCount;
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "DataTypes.h"
+
+//Per-vertex tangent frames the way MikkTSpace (Mikkelsen 2008, the reference baking tools use) builds them (TangentSpace.cpp)
+namespace TangentSpace
+{
+	//Every corner adds its triangle's normalized uv derivative dP/du, projected onto the vertex normal and weighted by the
+	//corner angle; the sum is normalized. tangent.w is the bitangent sign: bitangent = cross(normal, tangent.xyz) * w.
+	//A vertex used by triangles of both signs (mirrored uvs) is split: the negative triangles get an appended copy.
+	//Triangles with (near) zero uv area or uv derivative add nothing; a vertex left without a tangent gets an arbitrary
+	//one perpendicular to its normal.
+	//Unlike the reference, vertices are only split by sign, not by unconnected fans sharing one vertex.
+	//threadCount > 1 (0: all hardware threads) gives the same result bit for bit: every vertex sums its corners in index order.
+	//Returns how many vertices were split off.
+	size_t Generate(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, unsigned threadCount = 1);
+}
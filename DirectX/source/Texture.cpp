@@ -1,52 +1,181 @@
 #include "pch.h"
 #include "Texture.h"
+#include "TextureFile.h"
 #include "Vector2.h"
 #include <SDL_image.h>
 #include <algorithm>
+#include <cstring>
 
 
-    Texture::Texture(ID3D11Device* pDevice, const std::string& path)
+    namespace
     {
-        //Do this resource/resource view creation when you load the texture, so only once!
-        SDL_Surface* pSurface = IMG_Load(path.c_str());
+        //PNG::Load handles the usual 8-bit PNGs without SDL, SDL_image the rest (16-bit, interlaced, other formats)
+        bool LoadRGBA(const std::string& path, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height)
+        {
+            if (PNG::Load(path, pixels, width, height))
+                return true;
+
+            SDL_Surface* pLoadedSurface = IMG_Load(path.c_str());
+            if (!pLoadedSurface)
+            {
+                std::cout << "Could not load " << path << ": " << IMG_GetError() << "\n";
+                return false;
+            }
+            //The mip chain is built from RGBA bytes, whatever the file stored
+            SDL_Surface* pSurface = SDL_ConvertSurfaceFormat(pLoadedSurface, SDL_PIXELFORMAT_RGBA32, 0);
+            SDL_FreeSurface(pLoadedSurface);
+            if (!pSurface)
+            {
+                std::cout << "Could not convert " << path << ": " << SDL_GetError() << "\n";
+                return false;
+            }
+
+            width = pSurface->w;
+            height = pSurface->h;
+            pixels.resize(size_t{ width } * height * 4);
+            for (uint32_t y{ 0 }; y < height; ++y)
+                std::memcpy(&pixels[size_t{ y } * width * 4], static_cast<const uint8_t*>(pSurface->pixels) + size_t{ y } * pSurface->pitch, size_t{ width } * 4);
+            SDL_FreeSurface(pSurface);
+            return true;
+        }
+
+        TextureFile::CookSettings GetCookSettings(MipChain::Content content, MipChain::Filter filter, BlockCompression::Quality quality)
+        {
+            TextureFile::CookSettings cookSettings{};
+            cookSettings.content = content;
+            cookSettings.filter = filter;
+            cookSettings.quality = quality;
+            cookSettings.pLoadImage = &LoadRGBA;
+            return cookSettings;
+        }
+
+        void PrintStats(const char* pAction, const std::string& path, const TextureFile::CookStats& stats)
+        {
+            std::cout << pAction << path << ": " << GetTextureFormatName(stats.format) << " " << stats.width << "x" << stats.height << ", " << stats.levelCount << " levels, "
+                << stats.uncompressedBytes / 1e6 << " MB -> " << stats.cookedBytes / 1e6 << " MB, PSNR " << stats.compress.psnr << " dB, " << stats.seconds * 1e3 << " ms\n";
+        }
+    }
+
+    Texture::Texture(ID3D11Device* pDevice, const std::string& path, MipChain::Content content, MipChain::Filter filter, BlockCompression::Quality quality)
+    {
+        //The image is cooked to a .tex once, later launches map that and upload its levels without decoding anything
+        const TextureFile::CookSettings cookSettings{ GetCookSettings(content, filter, quality) };
+        const std::string cookedPath = TextureFile::GetCookedPath(path);
+        if (!TextureFile::IsUpToDate(path, cookedPath, cookSettings))
+        {
+            TextureFile::CookStats stats{};
+            if (TextureFile::Cook(path, cookedPath, cookSettings, &stats))
+                PrintStats("Cooked ", path, stats);
+        }
+        if (LoadCooked(pDevice, cookedPath))
+            return;
+
+        //A read-only resources folder or a foreign .tex: build it every launch
+        BlockCompression::Image image{};
+        TextureFile::CookStats stats{};
+        if (!TextureFile::Build(path, cookSettings, image, &stats))
+            return;
+        PrintStats("", path, stats);
+        Create(pDevice, image.GetView());
+    }
+
+    Texture::Texture(ID3D11Device* pDevice, std::span<const TextureFile::ChannelSource> channels, const std::string& cookedPath, MipChain::Filter filter,
+        BlockCompression::Quality quality)
+    {
+        const TextureFile::CookSettings cookSettings{ GetCookSettings(MipChain::Content::Linear, filter, quality) };
+        if (!TextureFile::IsUpToDate(channels, cookedPath, cookSettings))
+        {
+            TextureFile::CookStats stats{};
+            if (TextureFile::CookPacked(channels, cookedPath, cookSettings, &stats))
+                PrintStats("Cooked ", cookedPath, stats);
+        }
+        if (LoadCooked(pDevice, cookedPath))
+            return;
 
+        BlockCompression::Image image{};
+        TextureFile::CookStats stats{};
+        if (!TextureFile::BuildPacked(channels, cookSettings, image, m_SourceChannels, &stats))
+        {
+            std::cout << "Could not pack " << cookedPath << "\n";
+            return;
+        }
+        PrintStats("", cookedPath, stats);
+        Create(pDevice, image.GetView());
+    }
+
+    bool Texture::LoadCooked(ID3D11Device* pDevice, const std::string& cookedPath)
+    {
+        const CookedTexture cookedTexture{ cookedPath };
+        if (!cookedTexture.IsValid())
+            return false;
+        m_SourceChannels = cookedTexture.GetSourceChannels();
+        Create(pDevice, cookedTexture.GetView());
+        return true;
+    }
+
+    Texture::Texture(ID3D11Device* pDevice, const TextureView& view)
+    {
+        Create(pDevice, view);
+    }
+
+    void Texture::Create(ID3D11Device* pDevice, const TextureView& view)
+    {
         //!Texture
-        const DXGI_FORMAT format{ DXGI_FORMAT_R8G8B8A8_UNORM };
+        DXGI_FORMAT format{ DXGI_FORMAT_R8G8B8A8_UNORM };
+        switch (view.format)
+        {
+        case TextureFormat::BC1: format = DXGI_FORMAT_BC1_UNORM; break;
+        case TextureFormat::BC4: format = DXGI_FORMAT_BC4_UNORM; break;
+        case TextureFormat::BC5: format = DXGI_FORMAT_BC5_UNORM; break;
+        case TextureFormat::BC7: format = DXGI_FORMAT_BC7_UNORM; break;
+        default: break;
+        }
+        const UINT levelCount{ static_cast<UINT>(view.levels.size()) };
         D3D11_TEXTURE2D_DESC desc{};
-        desc.Width = pSurface->w;
-        desc.Height = pSurface->h;
-        desc.MipLevels = 1;
+        desc.Width = view.levels[0].width;
+        desc.Height = view.levels[0].height;
+        desc.MipLevels = levelCount;
         desc.ArraySize = 1;
         desc.Format = format;
         desc.SampleDesc.Count = 1;
         desc.SampleDesc.Quality = 0;
-        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.Usage = D3D11_USAGE_IMMUTABLE;
         desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
         desc.CPUAccessFlags = 0;
         desc.MiscFlags = 0;
 
-        //!Init SDL_Surface
-        D3D11_SUBRESOURCE_DATA initData{};
-        initData.pSysMem = pSurface->pixels;
-        initData.SysMemPitch = static_cast<UINT>(pSurface->pitch);
-        initData.SysMemSlicePitch = static_cast<UINT>(pSurface->h * pSurface->pitch);
+        //!One subresource per mip level, the pitch of BC formats is per row of 4x4 blocks
+        std::vector<D3D11_SUBRESOURCE_DATA> initData(levelCount);
+        for (UINT level{ 0 }; level < levelCount; ++level)
+        {
+            initData[level].pSysMem = view.GetLevelData(level);
+            initData[level].SysMemPitch = view.GetRowPitch(level);
+            initData[level].SysMemSlicePitch = static_cast<UINT>(view.GetLevelSize(level));
+        }
 
-        HRESULT hr = pDevice->CreateTexture2D(&desc, &initData, &m_pResource);
+        HRESULT hr = pDevice->CreateTexture2D(&desc, initData.data(), &m_pResource);
+        if (FAILED(hr))
+            return;
 
         //!ShaderResourceView
         D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc{};
         SRVDesc.Format = format;
         SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-        SRVDesc.Texture2D.MipLevels = 1;
+        SRVDesc.Texture2D.MostDetailedMip = 0;
+        SRVDesc.Texture2D.MipLevels = levelCount;
 
         hr = pDevice->CreateShaderResourceView(m_pResource, &SRVDesc, &m_pShaderResourceView);
-
-        //After pushing the data from the SDL_Surface to the resource, the SDL_Surface is no longer needed in memory, thus free it using SDL_FreeSurface.
-        SDL_FreeSurface(pSurface);
+        if (FAILED(hr))
+            return;
+        for (size_t level{ 0 }; level < view.levels.size(); ++level)
+            m_SizeInBytes += view.GetLevelSize(level);
     }
 
     Texture::~Texture()
     {
+        if (m_pShaderResourceView) m_pShaderResourceView->Release();
+        if (m_pResource) m_pResource->Release();
+
         if (m_pSurface)
         {
             SDL_FreeSurface(m_pSurface);
@@ -101,4 +230,12 @@
     ID3D11ShaderResourceView* Texture::GetShaderResourceView() const
     {
         return m_pShaderResourceView;
+    }
+    uint32_t Texture::GetChannel(size_t source) const
+    {
+        return m_SourceChannels[source];
+    }
+    uint64_t Texture::GetSizeInBytes() const
+    {
+        return m_SizeInBytes;
     }
\ No newline at end of file
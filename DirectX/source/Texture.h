@@ -4,6 +4,9 @@
 #include "ColorRGB.h"
 #include <memory>
 #include "Vector3.h"
+#include "BlockCompression.h"
+#include "MipChain.h"
+#include "TextureFile.h"
 
 
 struct Vector2;
@@ -15,9 +18,24 @@ public:
 
 	///Just for my reference (different textures directX) below parameters
 	//! https://docs.microsoft.com/en-us/windows/win32/direct3dhlsl/dx-graphics-hlsl-to-type
-	Texture(ID3D11Device* pDevice, const std::string& path);
+	//Uploads the image with its full mip chain, filtered as content says and block-compressed in the format that suits it.
+	//Maps the cooked .tex next to it, cooking that first when it is missing or the image changed.
+	Texture(ID3D11Device* pDevice, const std::string& path, MipChain::Content content = MipChain::Content::Color, MipChain::Filter filter = MipChain::Filter::Box,
+		BlockCompression::Quality quality = BlockCompression::Quality::Normal);
+	//Packs single channels of data maps (Linear) into one texture cooked to cookedPath, see TextureFile::BuildPacked.
+	//GetChannel says where each source ended up.
+	Texture(ID3D11Device* pDevice, std::span<const TextureFile::ChannelSource> channels, const std::string& cookedPath, MipChain::Filter filter = MipChain::Filter::Box,
+		BlockCompression::Quality quality = BlockCompression::Quality::Normal);
+	//Uploads already built (and possibly compressed) levels as they are
+	Texture(ID3D11Device* pDevice, const TextureView& view);
 	~Texture();
 
+	//Owns its D3D resource and view, released once in the destructor
+	Texture(const Texture&) = delete;
+	Texture(Texture&&) noexcept = delete;
+	Texture& operator=(const Texture&) = delete;
+	Texture& operator=(Texture&&) noexcept = delete;
+
 	//static std::unique_ptr<Texture> LoadFromFile(const std::string& path);
 	//dae::ColorRGB Sample(const Vector2& uv) const;
 	//dae::Vector3 SampleNormal(const Vector2& uv) const;
@@ -25,7 +43,13 @@ public:
 
 	ID3D11Texture2D* GetResource() const;
 	ID3D11ShaderResourceView* GetShaderResourceView() const;
+	//The channel holding the source'th channel the texture was packed from, the source'th channel itself when it wasn't
+	uint32_t GetChannel(size_t source) const;
+	//Video memory of all levels as uploaded, 0 when creating the texture failed
+	uint64_t GetSizeInBytes() const;
 private:
+	bool LoadCooked(ID3D11Device* pDevice, const std::string& cookedPath);
+	void Create(ID3D11Device* pDevice, const TextureView& view);
 
 	SDL_Surface* m_pSurface{ nullptr };
 	uint32_t* m_pSurfacePixels{ nullptr };
@@ -33,4 +57,6 @@ private:
 
 	ID3D11Texture2D* m_pResource{};
 	ID3D11ShaderResourceView* m_pShaderResourceView{};
+	TextureFile::ChannelMap m_SourceChannels{ TextureFile::identityChannels };
+	uint64_t m_SizeInBytes{};
 };
@@ -0,0 +1,43 @@
+#include "pch.h"
+#include "TextureCache.h"
+
+namespace
+{
+	std::string GetSettingsKey(MipChain::Filter filter, BlockCompression::Quality quality)
+	{
+		return "|" + std::to_string(static_cast<int>(filter)) + "|" + std::to_string(static_cast<int>(quality));
+	}
+
+	//Textures whose D3D resource couldn't be created aren't cached, a later Load tries again
+	std::unique_ptr<Texture> KeepCreated(std::unique_ptr<Texture> pTexture)
+	{
+		return pTexture->GetShaderResourceView() ? std::move(pTexture) : nullptr;
+	}
+}
+
+TextureCache::TextureCache(ID3D11Device* pDevice, uint64_t budgetBytes)
+	: m_pDevice{ pDevice },
+	m_Cache{ budgetBytes }
+{
+}
+
+TextureHandle TextureCache::Load(const std::string& path, MipChain::Content content, MipChain::Filter filter, BlockCompression::Quality quality)
+{
+	const std::string key = NormalizeResourcePath(path) + "|" + std::to_string(static_cast<int>(content)) + GetSettingsKey(filter, quality);
+	return m_Cache.Acquire(key, [&]()
+		{
+			return KeepCreated(std::make_unique<Texture>(m_pDevice, path, content, filter, quality));
+		});
+}
+
+TextureHandle TextureCache::LoadPacked(std::span<const TextureFile::ChannelSource> channels, const std::string& cookedPath, MipChain::Filter filter,
+	BlockCompression::Quality quality)
+{
+	std::string key = NormalizeResourcePath(cookedPath) + GetSettingsKey(filter, quality);
+	for (const TextureFile::ChannelSource& source : channels)
+		key += "|" + NormalizeResourcePath(source.path) + ":" + std::to_string(source.channel);
+	return m_Cache.Acquire(key, [&]()
+		{
+			return KeepCreated(std::make_unique<Texture>(m_pDevice, channels, cookedPath, filter, quality));
+		});
+}
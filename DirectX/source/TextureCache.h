@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include "ResourceCache.h"
+#include "Texture.h"
+
+using TextureHandle = ResourceCache<Texture>::Handle;
+
+//Every texture loaded once per device and shared by all meshes that use it (TextureCache.cpp). Keyed by the
+//normalized path and the import settings, so the same image loaded as color and as data is two textures.
+class TextureCache final
+{
+public:
+	static constexpr uint64_t defaultBudgetBytes{ 256ull << 20 };
+
+	explicit TextureCache(ID3D11Device* pDevice, uint64_t budgetBytes = defaultBudgetBytes);
+
+	//Same parameters as the Texture constructors. Empty handles when the image can't be loaded.
+	TextureHandle Load(const std::string& path, MipChain::Content content = MipChain::Content::Color, MipChain::Filter filter = MipChain::Filter::Box,
+		BlockCompression::Quality quality = BlockCompression::Quality::Normal);
+	TextureHandle LoadPacked(std::span<const TextureFile::ChannelSource> channels, const std::string& cookedPath, MipChain::Filter filter = MipChain::Filter::Box,
+		BlockCompression::Quality quality = BlockCompression::Quality::Normal);
+
+	//Video memory kept for textures no mesh uses any more, see ResourceCache
+	void SetBudget(uint64_t budgetBytes) { m_Cache.SetBudget(budgetBytes); }
+	void Trim() { m_Cache.Trim(); }
+	const ResourceCache<Texture>::Stats& GetStats() const { return m_Cache.GetStats(); }
+
+private:
+	ID3D11Device* m_pDevice{};
+	ResourceCache<Texture> m_Cache;
+};
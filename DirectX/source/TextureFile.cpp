@@ -0,0 +1,291 @@
+#include "pch.h"
+#include "TextureFile.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <vector>
+
+#include "PNG.h"
+
+static_assert(std::endian::native == std::endian::little, ".tex files are little endian and mapped as is");
+static_assert(sizeof(TextureFile::Header) == 56 && std::is_trivially_copyable_v<TextureFile::Header>);
+static_assert(sizeof(TextureLevel) == 16);
+
+namespace
+{
+	uint64_t AlignUp(uint64_t offset)
+	{
+		return (offset + TextureFile::blobAlignment - 1) / TextureFile::blobAlignment * TextureFile::blobAlignment;
+	}
+
+	//The cook settings that change the output, the thread count and the loader don't
+	uint64_t HashSettings(const TextureFile::CookSettings& settings, uint32_t packedChannelCount)
+	{
+		const uint32_t cookKey[]{ TextureFile::version, static_cast<uint32_t>(settings.content), static_cast<uint32_t>(settings.filter), static_cast<uint32_t>(settings.quality),
+			packedChannelCount };
+		return HashContent({ reinterpret_cast<const uint8_t*>(cookKey), sizeof(cookKey) });
+	}
+
+	bool ReadHeader(const std::string& cookedPath, TextureFile::Header& header)
+	{
+		std::error_code error{};
+		if (!std::filesystem::exists(cookedPath, error))
+			return false;
+		std::ifstream file{ cookedPath, std::ios::binary };
+		return file.read(reinterpret_cast<char*>(&header), sizeof(TextureFile::Header)) && header.magic == TextureFile::magic && header.version == TextureFile::version;
+	}
+
+	//RGBA8 pixels to a compressed mip chain, the part Build and BuildPacked share
+	void CompressChain(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, TextureFormat format, const TextureFile::CookSettings& settings,
+		BlockCompression::Image& image, TextureFile::CookStats* pStats)
+	{
+		MipChain::Image chain{};
+		MipChain::Generate(pixels.data(), width, height, width * 4, { settings.content, settings.filter, settings.threadCount }, chain);
+
+		BlockCompression::Settings compressSettings{};
+		compressSettings.format = format;
+		compressSettings.quality = settings.quality;
+		compressSettings.threadCount = settings.threadCount;
+		BlockCompression::Compress(chain.GetView(), compressSettings, image, pStats ? &pStats->compress : nullptr);
+
+		if (pStats)
+		{
+			pStats->uncompressedBytes = chain.pixels.size();
+			pStats->cookedBytes = image.data.size();
+			pStats->format = image.format;
+			pStats->width = width;
+			pStats->height = height;
+			pStats->levelCount = image.levels.size();
+		}
+	}
+}
+
+namespace TextureFile
+{
+	bool Write(const std::string& path, const TextureView& texture, uint64_t sourceHash, const ChannelMap& sourceChannels)
+	{
+		if (texture.levels.empty())
+			return false;
+
+		Header header{};
+		header.sourceHash = sourceHash;
+		header.sourceChannels = sourceChannels;
+		header.format = texture.format;
+		header.width = texture.levels[0].width;
+		header.height = texture.levels[0].height;
+		header.levelCount = static_cast<uint32_t>(texture.levels.size());
+
+		uint64_t fileSize{ sizeof(Header) };
+		const auto place = [&fileSize](uint64_t size)
+			{
+				const uint64_t offset = AlignUp(fileSize);
+				fileSize = offset + size;
+				return offset;
+			};
+		header.levelOffset = place(texture.levels.size_bytes());
+		std::vector<TextureLevel> levels(texture.levels.begin(), texture.levels.end());
+		for (size_t level{ 0 }; level < levels.size(); ++level)
+			levels[level].offset = place(texture.GetLevelSize(level));
+		header.fileSize = fileSize;
+
+		std::vector<FileBlob> blobs{ { 0, &header, sizeof(Header) }, { header.levelOffset, levels.data(), levels.size() * sizeof(TextureLevel) } };
+		for (size_t level{ 0 }; level < levels.size(); ++level)
+			blobs.push_back({ levels[level].offset, texture.GetLevelData(level), texture.GetLevelSize(level) });
+		return WriteFileAtomically(path, blobs);
+	}
+
+	uint64_t HashSource(const std::string& sourcePath, const CookSettings& settings)
+	{
+		return HashFile(sourcePath, HashSettings(settings, 0));
+	}
+
+	uint64_t HashSources(std::span<const ChannelSource> channels, const CookSettings& settings)
+	{
+		uint64_t hash = HashSettings(settings, static_cast<uint32_t>(channels.size()));
+		for (const ChannelSource& source : channels)
+		{
+			hash = HashFile(source.path, HashContent({ reinterpret_cast<const uint8_t*>(&source.channel), sizeof(source.channel) }, hash));
+			if (hash == 0)
+				return 0;
+		}
+		return hash;
+	}
+
+	std::string GetCookedPath(const std::string& sourcePath)
+	{
+		return std::filesystem::path{ sourcePath }.replace_extension(".tex").string();
+	}
+
+	bool Build(const std::string& sourcePath, const CookSettings& settings, BlockCompression::Image& image, CookStats* pStats)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		std::vector<uint8_t> pixels{};
+		uint32_t width{}, height{};
+		if (!settings.pLoadImage(sourcePath, pixels, width, height))
+			return false;
+
+		CompressChain(pixels, width, height, BlockCompression::ChooseFormat(settings.content, settings.quality), settings, image, pStats);
+		if (pStats)
+		{
+			std::error_code error{};
+			pStats->sourceBytes = std::filesystem::file_size(sourcePath, error);
+			pStats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+		return true;
+	}
+
+	bool BuildPacked(std::span<const ChannelSource> channels, const CookSettings& settings, BlockCompression::Image& image, ChannelMap& sourceChannels, CookStats* pStats)
+	{
+		if (channels.empty() || channels.size() > sourceChannels.size())
+			return false;
+		const auto start = std::chrono::steady_clock::now();
+
+		//Each file is decoded once, however many channels come from it
+		struct Source
+		{
+			std::string path{};
+			std::vector<uint8_t> pixels{};
+		};
+		std::vector<Source> sources{};
+		uint32_t width{}, height{};
+		uint64_t sourceBytes{};
+
+		std::vector<std::vector<uint8_t>> planes{};
+		std::vector<uint64_t> planeHashes{};
+		sourceChannels = identityChannels;
+		for (size_t index{ 0 }; index < channels.size(); ++index)
+		{
+			const ChannelSource& channel = channels[index];
+			if (channel.channel > 3)
+				return false;
+
+			auto source = std::find_if(sources.begin(), sources.end(), [&channel](const Source& decoded) { return decoded.path == channel.path; });
+			if (source == sources.end())
+			{
+				Source decoded{ channel.path };
+				uint32_t sourceWidth{}, sourceHeight{};
+				if (!settings.pLoadImage(channel.path, decoded.pixels, sourceWidth, sourceHeight) || (!sources.empty() && (sourceWidth != width || sourceHeight != height)))
+					return false;
+				width = sourceWidth;
+				height = sourceHeight;
+				std::error_code error{};
+				sourceBytes += std::filesystem::file_size(channel.path, error);
+				sources.push_back(std::move(decoded));
+				source = sources.end() - 1;
+			}
+
+			std::vector<uint8_t> plane(size_t{ width } * height);
+			for (size_t texel{ 0 }; texel < plane.size(); ++texel)
+				plane[texel] = source->pixels[texel * 4 + channel.channel];
+
+			//Maps exported twice under different names are stored once
+			const uint64_t hash = HashContent(plane);
+			size_t stored{ 0 };
+			while (stored < planes.size() && (planeHashes[stored] != hash || planes[stored] != plane))
+				++stored;
+			if (stored == planes.size())
+			{
+				planes.push_back(std::move(plane));
+				planeHashes.push_back(hash);
+			}
+			sourceChannels[index] = static_cast<uint8_t>(stored);
+		}
+
+		std::vector<uint8_t> pixels(size_t{ width } * height * 4, 0);
+		for (size_t texel{ 0 }; texel < size_t{ width } * height; ++texel)
+		{
+			pixels[texel * 4 + 3] = 255;
+			for (size_t stored{ 0 }; stored < planes.size(); ++stored)
+				pixels[texel * 4 + stored] = planes[stored][texel];
+		}
+
+		const TextureFormat format = planes.size() == 1 ? TextureFormat::BC4 : planes.size() == 2 ? TextureFormat::BC5 : TextureFormat::BC7;
+		CompressChain(pixels, width, height, format, settings, image, pStats);
+		if (pStats)
+		{
+			pStats->sourceBytes = sourceBytes;
+			pStats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+		return true;
+	}
+
+	bool Cook(const std::string& sourcePath, const std::string& cookedPath, const CookSettings& settings, CookStats* pStats)
+	{
+		BlockCompression::Image image{};
+		return Build(sourcePath, settings, image, pStats) && Write(cookedPath, image.GetView(), HashSource(sourcePath, settings));
+	}
+
+	bool CookPacked(std::span<const ChannelSource> channels, const std::string& cookedPath, const CookSettings& settings, CookStats* pStats)
+	{
+		BlockCompression::Image image{};
+		ChannelMap sourceChannels{};
+		return BuildPacked(channels, settings, image, sourceChannels, pStats) && Write(cookedPath, image.GetView(), HashSources(channels, settings), sourceChannels);
+	}
+
+	bool IsUpToDate(const std::string& sourcePath, const std::string& cookedPath, const CookSettings& settings)
+	{
+		Header header{};
+		if (!ReadHeader(cookedPath, header))
+			return false;
+
+		std::error_code error{};
+		if (!std::filesystem::exists(sourcePath, error))
+			return true;
+		return header.sourceHash == HashSource(sourcePath, settings);
+	}
+
+	bool IsUpToDate(std::span<const ChannelSource> channels, const std::string& cookedPath, const CookSettings& settings)
+	{
+		Header header{};
+		if (!ReadHeader(cookedPath, header))
+			return false;
+
+		std::error_code error{};
+		for (const ChannelSource& source : channels)
+		{
+			if (!std::filesystem::exists(source.path, error))
+				return true;
+		}
+		return header.sourceHash == HashSources(channels, settings);
+	}
+}
+
+CookedTexture::CookedTexture(const std::string& path)
+	: m_File{ path }
+{
+	if (!m_File.IsOpen() || m_File.GetSize() < sizeof(TextureFile::Header))
+		return;
+
+	const char* const pData = m_File.GetData();
+	TextureFile::Header header{};
+	std::memcpy(&header, pData, sizeof(TextureFile::Header));
+
+	const uint64_t fileSize = m_File.GetSize();
+	if (header.magic != TextureFile::magic || header.version != TextureFile::version || header.fileSize != fileSize
+		|| header.format > TextureFormat::BC7 || header.levelCount == 0 || header.levelCount > 32
+		|| header.levelOffset % alignof(TextureLevel) != 0 || header.levelOffset > fileSize
+		|| header.levelCount > (fileSize - header.levelOffset) / sizeof(TextureLevel)
+		|| std::any_of(header.sourceChannels.begin(), header.sourceChannels.end(), [](uint8_t channel) { return channel > 3; }))
+		return;
+
+	//Each level half the previous one, rounded down, and its blob inside the file
+	const std::span<const TextureLevel> levels{ reinterpret_cast<const TextureLevel*>(pData + header.levelOffset), header.levelCount };
+	for (uint32_t level{ 0 }; level < header.levelCount; ++level)
+	{
+		const TextureLevel& mip = levels[level];
+		if (mip.width != std::max(header.width >> level, 1u) || mip.height != std::max(header.height >> level, 1u)
+			|| mip.offset > fileSize || GetTextureLevelSize(header.format, mip.width, mip.height) > fileSize - mip.offset)
+			return;
+	}
+
+	m_View = { header.format, levels, reinterpret_cast<const uint8_t*>(pData) };
+	m_SourceHash = header.sourceHash;
+	m_SourceChannels = header.sourceChannels;
+	m_IsValid = true;
+}
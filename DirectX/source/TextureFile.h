@@ -0,0 +1,136 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "BlockCompression.h"
+#include "DataTypes.h"
+#include "MappedFile.h"
+#include "MipChain.h"
+#include "PNG.h"
+
+//Cooked .tex files: a texture's mip chain in the format it is uploaded in, so a mapped file goes to the GPU without
+//decoding.
+//
+//	Header | levels (TextureLevel, largest first) | level 0 blob | level 1 blob | ...
+//
+//The level offsets count from the start of the file. Tables and blobs start at multiples of blobAlignment, little endian.
+namespace TextureFile
+{
+	constexpr uint32_t magic{ 0x52545854 };	//"TXTR"
+	//Bump on any change to the layout or to what cooking produces, older files then count as stale
+	constexpr uint32_t version{ 2 };
+	constexpr uint64_t blobAlignment{ 64 };
+
+	//For each source channel of a packed texture, the channel of the texture that holds it
+	using ChannelMap = std::array<uint8_t, 4>;
+	constexpr ChannelMap identityChannels{ 0, 1, 2, 3 };
+
+	struct Header
+	{
+		uint32_t magic{ TextureFile::magic };
+		uint32_t version{ TextureFile::version };
+		uint64_t fileSize{};
+		uint64_t sourceHash{};		//HashSource of what the file was cooked from
+
+		TextureFormat format{};
+		uint32_t width{};
+		uint32_t height{};
+		uint32_t levelCount{};
+		uint64_t levelOffset{};
+		ChannelMap sourceChannels{ identityChannels };
+		uint32_t reserved{};
+	};
+
+	bool Write(const std::string& path, const TextureView& texture, uint64_t sourceHash, const ChannelMap& sourceChannels = identityChannels);
+
+	//Decodes an image file to RGBA8 rows without padding
+	using ImageLoader = bool (*)(const std::string& path, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height);
+
+	struct CookSettings
+	{
+		MipChain::Content content{ MipChain::Content::Color };
+		MipChain::Filter filter{ MipChain::Filter::Box };
+		BlockCompression::Quality quality{ BlockCompression::Quality::Normal };
+		unsigned threadCount{ 0 };	//0: one per hardware thread
+		ImageLoader pLoadImage{ &PNG::Load };
+	};
+
+	//One channel of an image, the unit single-channel maps are packed by
+	struct ChannelSource
+	{
+		std::string path{};
+		uint32_t channel{ 0 };
+	};
+
+	struct CookStats
+	{
+		uint64_t sourceBytes{};			//of every image read
+		uint64_t uncompressedBytes{};	//the RGBA8 mip chain
+		uint64_t cookedBytes{};			//the levels as written
+		TextureFormat format{};
+		uint32_t width{};
+		uint32_t height{};
+		size_t levelCount{};
+		BlockCompression::CompressStats compress{};
+		double seconds{};				//decode, mips and compression
+	};
+
+	//The source file's bytes together with the settings that change what cooking produces, 0 when it can't be read
+	uint64_t HashSource(const std::string& sourcePath, const CookSettings& settings);
+	//The same over every image a packed texture takes channels from and which channels, 0 when one can't be read
+	uint64_t HashSources(std::span<const ChannelSource> channels, const CookSettings& settings);
+
+	//name.png -> name.tex, next to the source
+	std::string GetCookedPath(const std::string& sourcePath);
+
+	//Decodes an image (settings.pLoadImage), builds its mip chain and block-compresses it in the format
+	//BlockCompression::ChooseFormat gives its content
+	bool Build(const std::string& sourcePath, const CookSettings& settings, BlockCompression::Image& image, CookStats* pStats = nullptr);
+
+	//Packs up to 4 channels of images of the same size into one texture, the first source in red. Sources whose texels
+	//are identical, whatever file they come from, are stored once: sourceChannels says which channel ended up holding
+	//each. One stored channel is compressed to BC4, two to BC5, more to BC7. The settings' content applies to all of
+	//them, so pack data maps together (Linear).
+	bool BuildPacked(std::span<const ChannelSource> channels, const CookSettings& settings, BlockCompression::Image& image, ChannelMap& sourceChannels,
+		CookStats* pStats = nullptr);
+
+	//Build, then writes the result as a .tex keyed by HashSource
+	bool Cook(const std::string& sourcePath, const std::string& cookedPath, const CookSettings& settings = {}, CookStats* pStats = nullptr);
+	//BuildPacked, then writes the result and its channel map as a .tex keyed by HashSources
+	bool CookPacked(std::span<const ChannelSource> channels, const std::string& cookedPath, const CookSettings& settings = {}, CookStats* pStats = nullptr);
+
+	//True when the cooked file has the current version and was cooked from the source's current bytes with these settings.
+	//Touching a source without changing it doesn't cost a cook. A missing source counts as up to date, so cooked files
+	//can ship on their own.
+	bool IsUpToDate(const std::string& sourcePath, const std::string& cookedPath, const CookSettings& settings);
+	bool IsUpToDate(std::span<const ChannelSource> channels, const std::string& cookedPath, const CookSettings& settings);
+}
+
+//A mapped .tex file. The view points into the mapping, so it is only valid while this object lives.
+class CookedTexture final
+{
+public:
+	explicit CookedTexture(const std::string& path);
+
+	CookedTexture(const CookedTexture&) = delete;
+	CookedTexture(CookedTexture&&) noexcept = delete;
+	CookedTexture& operator=(const CookedTexture&) = delete;
+	CookedTexture& operator=(CookedTexture&&) noexcept = delete;
+
+	//False for missing, truncated or foreign files, other versions and level tables that don't halve down to 1x1
+	bool IsValid() const { return m_IsValid; }
+	const TextureView& GetView() const { return m_View; }
+	uint64_t GetSourceHash() const { return m_SourceHash; }
+	//Identity unless the file was cooked by CookPacked
+	const TextureFile::ChannelMap& GetSourceChannels() const { return m_SourceChannels; }
+
+private:
+	MappedFile m_File;
+	TextureView m_View{};
+	uint64_t m_SourceHash{};
+	TextureFile::ChannelMap m_SourceChannels{ TextureFile::identityChannels };
+	bool m_IsValid{ false };
+};
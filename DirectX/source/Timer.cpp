@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "Timer.h"
 
+#include <SDL_timer.h>
+
 
 Timer::Timer()
 {
@@ -0,0 +1,714 @@
+#include "pch.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "TangentSpace.h"
+
+namespace
+{
+	//'\r' counts as a space, so CRLF files parse like LF ones
+	inline bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline void SkipSpaces(const char*& p, const char* end)
+	{
+		while (p != end && IsSpace(*p)) ++p;
+	}
+
+	inline const char* FindLineEnd(const char* p, const char* end)
+	{
+		const void* pNewLine = std::memchr(p, '\n', static_cast<size_t>(end - p));
+		return pNewLine ? static_cast<const char*>(pNewLine) : end;
+	}
+
+	inline bool ReadFloat(const char*& p, const char* end, float& value)
+	{
+		SkipSpaces(p, end);
+		if (p != end && *p == '+') ++p; //from_chars doesn't take a leading '+', operator>> does
+
+		const auto [pNext, error] = std::from_chars(p, end, value);
+		if (error != std::errc{})
+			return false;
+
+		p = pNext;
+		return true;
+	}
+
+	inline bool ReadIndex(const char*& p, const char* end, int64_t& value)
+	{
+		const auto [pNext, error] = std::from_chars(p, end, value);
+		if (error != std::errc{})
+			return false;
+		p = pNext;
+		return true;
+	}
+
+	//OBJ indices are 1-based, negative ones count back from the last element defined so far
+	inline bool ResolveIndex(int64_t index, size_t count, size_t& resolved)
+	{
+		if (index > 0 && static_cast<uint64_t>(index) <= count)
+		{
+			resolved = static_cast<size_t>(index - 1);
+			return true;
+		}
+		if (index < 0 && static_cast<uint64_t>(-index) <= count)
+		{
+			resolved = count - static_cast<size_t>(-index);
+			return true;
+		}
+		return false;
+	}
+
+	enum class Command
+	{
+		Position,
+		TexCoord,
+		Normal,
+		Face,
+		Other
+	};
+
+	//Reads the first word of the line and leaves p right after it
+	inline Command ReadCommand(const char*& p, const char* end)
+	{
+		SkipSpaces(p, end);
+		const char* pWord = p;
+		while (p != end && !IsSpace(*p)) ++p;
+
+		const size_t length = static_cast<size_t>(p - pWord);
+		if (length == 1 && pWord[0] == 'v') return Command::Position;
+		if (length == 1 && pWord[0] == 'f') return Command::Face;
+		if (length == 2 && pWord[0] == 'v' && pWord[1] == 't') return Command::TexCoord;
+		if (length == 2 && pWord[0] == 'v' && pWord[1] == 'n') return Command::Normal;
+		return Command::Other;
+	}
+
+	struct LineCounts
+	{
+		size_t positions{};
+		size_t texCoords{};
+		size_t normals{};
+		size_t faces{};
+	};
+
+	LineCounts CountLines(const char* p, const char* end)
+	{
+		LineCounts counts{};
+		while (p < end)
+		{
+			const char* pLineEnd = FindLineEnd(p, end);
+			switch (ReadCommand(p, pLineEnd))
+			{
+			case Command::Position: ++counts.positions; break;
+			case Command::TexCoord: ++counts.texCoords; break;
+			case Command::Normal: ++counts.normals; break;
+			case Command::Face: ++counts.faces; break;
+			default: break;
+			}
+			p = pLineEnd + 1;
+		}
+		return counts;
+	}
+
+	constexpr uint32_t noIndex{ UINT32_MAX };
+
+	//A face corner as attribute indices; uv and normal are noIndex when the face never named one
+	struct CornerKey
+	{
+		uint32_t position{ noIndex }, uv{ noIndex }, normal{ noIndex };
+
+		bool operator==(const CornerKey& other) const = default;
+	};
+
+	//Open addressing map from a face corner's attribute indices to the vertex it became
+	class CornerMap final
+	{
+	public:
+		explicit CornerMap(size_t expectedCount)
+		{
+			size_t capacity{ 64 };
+			while (capacity < expectedCount * 2) capacity *= 2;
+			m_Slots.assign(capacity, Slot{});
+		}
+
+		//Returns the vertex of an identical earlier corner, or remembers newVertex for this one and returns it
+		uint32_t FindOrAdd(const CornerKey& key, uint32_t newVertex)
+		{
+			if ((m_Count + 1) * 2 > m_Slots.size())
+				Grow();
+
+			const size_t mask = m_Slots.size() - 1;
+			for (size_t i = Hash(key) & mask; ; i = (i + 1) & mask)
+			{
+				Slot& slot = m_Slots[i];
+				if (slot.vertex == noIndex)
+				{
+					slot = { key, newVertex };
+					++m_Count;
+					return newVertex;
+				}
+				if (slot.key == key)
+					return slot.vertex;
+			}
+		}
+
+	private:
+		struct Slot
+		{
+			CornerKey key{};
+			uint32_t vertex{ noIndex };
+		};
+
+		std::vector<Slot> m_Slots{};
+		size_t m_Count{};
+
+		static size_t Hash(const CornerKey& key)
+		{
+			uint64_t hash = key.position * 0x9E3779B97F4A7C15ull ^ key.uv * 0xC2B2AE3D27D4EB4Full ^ key.normal * 0x165667B19E3779F9ull;
+			return static_cast<size_t>(hash ^ (hash >> 29));
+		}
+
+		void Grow()
+		{
+			std::vector<Slot> oldSlots(m_Slots.size() * 2, Slot{});
+			oldSlots.swap(m_Slots);
+
+			const size_t mask = m_Slots.size() - 1;
+			for (const Slot& slot : oldSlots)
+			{
+				if (slot.vertex == noIndex)
+					continue;
+
+				size_t i = Hash(slot.key) & mask;
+				while (m_Slots[i].vertex != noIndex) i = (i + 1) & mask;
+				m_Slots[i] = slot;
+			}
+		}
+	};
+
+	inline bool ReadVector3(const char*& p, const char* end, Vector3& value)
+	{
+		return ReadFloat(p, end, value.x) && ReadFloat(p, end, value.y) && ReadFloat(p, end, value.z);
+	}
+
+	inline bool ReadTexCoord(const char*& p, const char* end, Vector2& value)
+	{
+		//v is optional in the format and defaults to 0
+		float u, v{ 0.f };
+		if (!ReadFloat(p, end, u))
+			return false;
+		ReadFloat(p, end, v);
+
+		value = { u, 1 - v };
+		return true;
+	}
+
+	//Corners are p, p/t, p/t/n or p//n, resolved against the attributes defined before the line. Like the stream
+	//parser this replaced, a corner without uv or normal keeps the previous corner's one.
+	bool ReadFaceCorners(const char* p, const char* end, const LineCounts& defined, std::vector<CornerKey>& corners)
+	{
+		CornerKey key{};
+		while (true)
+		{
+			SkipSpaces(p, end);
+			if (p == end || *p == '#')
+				break;
+
+			int64_t index;
+			size_t resolved;
+			if (!ReadIndex(p, end, index) || !ResolveIndex(index, defined.positions, resolved))
+				return false;
+			key.position = static_cast<uint32_t>(resolved);
+
+			if (p != end && *p == '/')
+			{
+				++p;
+				if (p != end && *p != '/')
+				{
+					if (!ReadIndex(p, end, index) || !ResolveIndex(index, defined.texCoords, resolved))
+						return false;
+					key.uv = static_cast<uint32_t>(resolved);
+				}
+
+				if (p != end && *p == '/')
+				{
+					++p;
+					if (!ReadIndex(p, end, index) || !ResolveIndex(index, defined.normals, resolved))
+						return false;
+					key.normal = static_cast<uint32_t>(resolved);
+				}
+			}
+
+			corners.push_back(key);
+		}
+		return corners.size() >= 3;
+	}
+
+	//Polygons become a triangle fan around the first corner
+	void AppendFan(const uint32_t* pCorners, size_t count, bool flipWinding, std::vector<uint32_t>& indices)
+	{
+		for (size_t corner{ 1 }; corner + 1 < count; ++corner)
+		{
+			indices.push_back(pCorners[0]);
+			if (flipWinding)
+			{
+				indices.push_back(pCorners[corner + 1]);
+				indices.push_back(pCorners[corner]);
+			}
+			else
+			{
+				indices.push_back(pCorners[corner]);
+				indices.push_back(pCorners[corner + 1]);
+			}
+		}
+	}
+
+	Vertex MakeVertex(const CornerKey& key, const std::vector<Vector3>& positions, const std::vector<Vector2>& UVs, const std::vector<Vector3>& normals)
+	{
+		Vertex vertex{};
+		vertex.position = positions[key.position];
+		if (key.uv != noIndex) vertex.uv = UVs[key.uv];
+		if (key.normal != noIndex) vertex.normal = normals[key.normal];
+		return vertex;
+	}
+
+	struct OBJAttributes
+	{
+		std::vector<Vector3> positions{};
+		std::vector<Vector2> UVs{};
+		std::vector<Vector3> normals{};
+	};
+
+	bool ParseOBJSingleThreaded(const char* p, const char* pEnd, const Utils::OBJImportSettings& settings, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, size_t& cornerCount)
+	{
+		//One cheap pass over the lines first, so every array is allocated exactly once (for triangle faces)
+		const LineCounts counts = CountLines(p, pEnd);
+
+		OBJAttributes attributes{};
+		attributes.positions.reserve(counts.positions);
+		attributes.UVs.reserve(counts.texCoords);
+		attributes.normals.reserve(counts.normals);
+		indices.reserve(counts.faces * 3);
+
+		//Welded meshes usually end up with about as many vertices as the largest attribute array
+		const size_t expectedWeldedCount = std::max({ counts.positions, counts.texCoords, counts.normals });
+		vertices.reserve(settings.weldVertices ? expectedWeldedCount : counts.faces * 3);
+
+		CornerMap cornerMap{ settings.weldVertices ? expectedWeldedCount : 0 };
+
+		std::vector<CornerKey> faceKeys{};
+		std::vector<uint32_t> faceCorners{};
+		faceKeys.reserve(16);
+		faceCorners.reserve(16);
+
+		while (p < pEnd)
+		{
+			const char* const pLineEnd = FindLineEnd(p, pEnd);
+
+			switch (ReadCommand(p, pLineEnd))
+			{
+			case Command::Position:
+				if (!ReadVector3(p, pLineEnd, attributes.positions.emplace_back()))
+					return false;
+				break;
+			case Command::TexCoord:
+				if (!ReadTexCoord(p, pLineEnd, attributes.UVs.emplace_back()))
+					return false;
+				break;
+			case Command::Normal:
+				if (!ReadVector3(p, pLineEnd, attributes.normals.emplace_back()))
+					return false;
+				break;
+			case Command::Face:
+			{
+				const LineCounts defined{ attributes.positions.size(), attributes.UVs.size(), attributes.normals.size() };
+				faceKeys.clear();
+				if (!ReadFaceCorners(p, pLineEnd, defined, faceKeys))
+					return false;
+
+				faceCorners.clear();
+				for (const CornerKey& key : faceKeys)
+				{
+					const uint32_t newVertex = static_cast<uint32_t>(vertices.size());
+					const uint32_t vertex = settings.weldVertices ? cornerMap.FindOrAdd(key, newVertex) : newVertex;
+					if (vertex == newVertex)
+						vertices.push_back(MakeVertex(key, attributes.positions, attributes.UVs, attributes.normals));
+					faceCorners.push_back(vertex);
+				}
+				cornerCount += faceKeys.size();
+
+				AppendFan(faceCorners.data(), faceCorners.size(), settings.flipAxisAndWinding, indices);
+				break;
+			}
+			default:
+				//Comments, groups, materials, ...
+				break;
+			}
+
+			p = pLineEnd + 1;
+		}
+		return true;
+	}
+
+	//Below this every thread would get too little work to pay for starting it
+	constexpr size_t minChunkBytes{ 1u << 20 };
+
+	//A line-aligned piece of the file and what parsing it produced, indices still local to the chunk
+	struct OBJChunk
+	{
+		const char* pBegin{};
+		const char* pEnd{};
+		LineCounts counts{};
+		LineCounts base{};				//attributes defined by the chunks before this one
+		std::vector<CornerKey> corners{};
+		std::vector<uint32_t> triangles{};	//into corners, later into uniqueCorners
+		std::vector<CornerKey> uniqueCorners{};
+		std::vector<uint32_t> uniqueToVertex{};
+		bool isValid{ true };
+	};
+
+	//Every chunk counts, then parses its lines into its own buffers. The attribute arrays are sized up front from the
+	//counts, so the chunks write their attributes straight into them at the offsets the prefix sum gives them.
+	//Welding stays first-occurrence ordered: chunks weld locally in parallel, then their unique corners are merged in
+	//file order. The result is the same as ParseOBJSingleThreaded's, whatever the thread count.
+	bool ParseOBJMultiThreaded(const char* pData, size_t size, unsigned threadCount, const Utils::OBJImportSettings& settings, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, size_t& cornerCount)
+	{
+		const char* const pDataEnd = pData + size;
+		std::vector<OBJChunk> chunks(threadCount);
+		const char* pChunkBegin = pData;
+		for (unsigned i{ 0 }; i < threadCount; ++i)
+		{
+			OBJChunk& chunk = chunks[i];
+			chunk.pBegin = pChunkBegin;
+			chunk.pEnd = pDataEnd;
+			if (i + 1 < threadCount)
+			{
+				const char* const pSplit = std::max(pData + size * (i + 1) / threadCount, pChunkBegin);
+				chunk.pEnd = pSplit < pDataEnd ? FindLineEnd(pSplit, pDataEnd) : pDataEnd;
+				if (chunk.pEnd != pDataEnd) ++chunk.pEnd; //the newline ends this chunk
+			}
+			pChunkBegin = chunk.pEnd;
+		}
+
+		Parallel::ForRanges(chunks.size(), threadCount, [&](unsigned, size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i) chunks[i].counts = CountLines(chunks[i].pBegin, chunks[i].pEnd);
+			});
+
+		LineCounts totals{};
+		for (OBJChunk& chunk : chunks)
+		{
+			chunk.base = totals;
+			totals.positions += chunk.counts.positions;
+			totals.texCoords += chunk.counts.texCoords;
+			totals.normals += chunk.counts.normals;
+			totals.faces += chunk.counts.faces;
+		}
+
+		OBJAttributes attributes{};
+		attributes.positions.resize(totals.positions);
+		attributes.UVs.resize(totals.texCoords);
+		attributes.normals.resize(totals.normals);
+
+		Parallel::ForRanges(chunks.size(), threadCount, [&](unsigned, size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					OBJChunk& chunk = chunks[i];
+					chunk.corners.reserve(chunk.counts.faces * 3);
+					chunk.triangles.reserve(chunk.counts.faces * 3);
+
+					LineCounts defined = chunk.base;
+					std::vector<uint32_t> faceCorners{};
+					faceCorners.reserve(16);
+
+					for (const char* p = chunk.pBegin; p < chunk.pEnd && chunk.isValid; )
+					{
+						const char* const pLineEnd = FindLineEnd(p, chunk.pEnd);
+						switch (ReadCommand(p, pLineEnd))
+						{
+						case Command::Position:
+							chunk.isValid = ReadVector3(p, pLineEnd, attributes.positions[defined.positions++]);
+							break;
+						case Command::TexCoord:
+							chunk.isValid = ReadTexCoord(p, pLineEnd, attributes.UVs[defined.texCoords++]);
+							break;
+						case Command::Normal:
+							chunk.isValid = ReadVector3(p, pLineEnd, attributes.normals[defined.normals++]);
+							break;
+						case Command::Face:
+						{
+							const size_t firstCorner = chunk.corners.size();
+							chunk.isValid = ReadFaceCorners(p, pLineEnd, defined, chunk.corners);
+							if (!chunk.isValid)
+								break;
+
+							faceCorners.clear();
+							for (size_t corner = firstCorner; corner < chunk.corners.size(); ++corner)
+							{
+								faceCorners.push_back(static_cast<uint32_t>(corner));
+							}
+							AppendFan(faceCorners.data(), faceCorners.size(), settings.flipAxisAndWinding, chunk.triangles);
+							break;
+						}
+						default:
+							break;
+						}
+						p = pLineEnd + 1;
+					}
+
+					if (!chunk.isValid || !settings.weldVertices)
+						continue;
+
+					//Local weld, triangles switch from corners to unique corners
+					CornerMap cornerMap{ chunk.corners.size() / 4 };
+					std::vector<uint32_t> cornerToUnique(chunk.corners.size());
+					for (size_t corner{ 0 }; corner < chunk.corners.size(); ++corner)
+					{
+						const uint32_t newUnique = static_cast<uint32_t>(chunk.uniqueCorners.size());
+						cornerToUnique[corner] = cornerMap.FindOrAdd(chunk.corners[corner], newUnique);
+						if (cornerToUnique[corner] == newUnique)
+							chunk.uniqueCorners.push_back(chunk.corners[corner]);
+					}
+					for (uint32_t& corner : chunk.triangles)
+					{
+						corner = cornerToUnique[corner];
+					}
+				}
+			});
+
+		size_t vertexCount{ 0 };
+		for (OBJChunk& chunk : chunks)
+		{
+			if (!chunk.isValid)
+				return false;
+			cornerCount += chunk.corners.size();
+		}
+
+		//Global vertex numbers: first occurrence in file order, the same as the single-threaded weld
+		std::vector<CornerKey> vertexKeys{};
+		if (settings.weldVertices)
+		{
+			CornerMap cornerMap{ std::max({ totals.positions, totals.texCoords, totals.normals }) };
+			for (OBJChunk& chunk : chunks)
+			{
+				chunk.uniqueToVertex.resize(chunk.uniqueCorners.size());
+				for (size_t unique{ 0 }; unique < chunk.uniqueCorners.size(); ++unique)
+				{
+					const uint32_t newVertex = static_cast<uint32_t>(vertexKeys.size());
+					chunk.uniqueToVertex[unique] = cornerMap.FindOrAdd(chunk.uniqueCorners[unique], newVertex);
+					if (chunk.uniqueToVertex[unique] == newVertex)
+						vertexKeys.push_back(chunk.uniqueCorners[unique]);
+				}
+			}
+			vertexCount = vertexKeys.size();
+		}
+		else
+		{
+			vertexCount = cornerCount;
+		}
+
+		std::vector<size_t> firstIndices(chunks.size() + 1, 0);
+		std::vector<size_t> firstCorners(chunks.size() + 1, 0);
+		for (size_t i{ 0 }; i < chunks.size(); ++i)
+		{
+			firstIndices[i + 1] = firstIndices[i] + chunks[i].triangles.size();
+			firstCorners[i + 1] = firstCorners[i] + chunks[i].corners.size();
+		}
+
+		vertices.resize(vertexCount);
+		indices.resize(firstIndices.back());
+
+		Parallel::ForRanges(chunks.size(), threadCount, [&](unsigned, size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const OBJChunk& chunk = chunks[i];
+					uint32_t* const pIndices = indices.data() + firstIndices[i];
+					if (settings.weldVertices)
+					{
+						for (size_t index{ 0 }; index < chunk.triangles.size(); ++index)
+						{
+							pIndices[index] = chunk.uniqueToVertex[chunk.triangles[index]];
+						}
+					}
+					else
+					{
+						const uint32_t firstVertex = static_cast<uint32_t>(firstCorners[i]);
+						for (size_t index{ 0 }; index < chunk.triangles.size(); ++index)
+						{
+							pIndices[index] = firstVertex + chunk.triangles[index];
+						}
+						for (size_t corner{ 0 }; corner < chunk.corners.size(); ++corner)
+						{
+							vertices[firstVertex + corner] = MakeVertex(chunk.corners[corner], attributes.positions, attributes.UVs, attributes.normals);
+						}
+					}
+				}
+			});
+
+		if (settings.weldVertices)
+		{
+			Parallel::ForRanges(vertexCount, threadCount, [&](unsigned, size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; ++i)
+					{
+						vertices[i] = MakeVertex(vertexKeys[i], attributes.positions, attributes.UVs, attributes.normals);
+					}
+				});
+		}
+		return true;
+	}
+
+	inline bool IsNear(float a, float b, float epsilon)
+	{
+		return std::abs(a - b) <= epsilon;
+	}
+
+	inline bool IsNear(const Vertex& a, const Vertex& b, float epsilon)
+	{
+		return IsNear(a.position.x, b.position.x, epsilon) && IsNear(a.position.y, b.position.y, epsilon) && IsNear(a.position.z, b.position.z, epsilon)
+			&& IsNear(a.uv.x, b.uv.x, epsilon) && IsNear(a.uv.y, b.uv.y, epsilon)
+			&& IsNear(a.normal.x, b.normal.x, epsilon) && IsNear(a.normal.y, b.normal.y, epsilon) && IsNear(a.normal.z, b.normal.z, epsilon);
+	}
+
+	//21 bits per axis; distant cells that wrap onto the same key only cost a few extra comparisons
+	inline uint64_t GetCellKey(int64_t x, int64_t y, int64_t z)
+	{
+		constexpr uint64_t mask{ (1ull << 21) - 1 };
+		return (static_cast<uint64_t>(x) & mask) | (static_cast<uint64_t>(y) & mask) << 21 | (static_cast<uint64_t>(z) & mask) << 42;
+	}
+}
+
+namespace Utils
+{
+	bool ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const OBJImportSettings& settings, OBJImportStats* pStats)
+	{
+		const MappedFile file{ filename };
+		if (!file.IsOpen())
+			return false;
+
+		vertices.clear();
+		indices.clear();
+
+		const unsigned threadCount = static_cast<unsigned>(std::min<size_t>(Parallel::GetThreadCount(settings.threadCount), file.GetSize() / minChunkBytes + 1));
+		size_t cornerCount{ 0 };
+		const bool isParsed = threadCount > 1
+			? ParseOBJMultiThreaded(file.GetData(), file.GetSize(), threadCount, settings, vertices, indices, cornerCount)
+			: ParseOBJSingleThreaded(file.GetData(), file.GetData() + file.GetSize(), settings, vertices, indices, cornerCount);
+		if (!isParsed)
+			return false;
+
+		if (settings.weldEpsilon > 0.f)
+			WeldVertices(vertices, indices, settings.weldEpsilon);
+
+		TangentSpace::Generate(vertices, indices, threadCount);
+
+		if (settings.flipAxisAndWinding)
+		{
+			for (auto& v : vertices)
+			{
+				v.position.z *= -1.f;
+				v.normal.z *= -1.f;
+				v.tangent.z *= -1.f;
+				//Mirroring an axis mirrors the frame too
+				v.tangent.w *= -1.f;
+			}
+		}
+
+		if (pStats)
+			*pStats = { cornerCount, vertices.size(), indices.size() };
+
+		return true;
+	}
+
+	void WeldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, float epsilon)
+	{
+		if (vertices.empty() || !(epsilon > 0.f))
+			return;
+
+		//Cells twice the size of epsilon: everything within epsilon of a position lies in at most 2 cells per axis
+		const float cellSize = 2.f * epsilon;
+		const float invCellSize = 1.f / cellSize;
+		const auto getCell = [invCellSize](float value) { return static_cast<int64_t>(std::floor(value * invCellSize)); };
+
+		//Kept vertices chained per cell: the first one in cellHeads, the rest through nextInCell
+		std::unordered_map<uint64_t, uint32_t> cellHeads{};
+		cellHeads.reserve(vertices.size());
+		std::vector<uint32_t> nextInCell{};
+		nextInCell.reserve(vertices.size());
+		std::vector<uint32_t> remap(vertices.size());
+
+		uint32_t keptCount{ 0 };
+		for (size_t i{ 0 }; i < vertices.size(); ++i)
+		{
+			const Vertex vertex = vertices[i];
+			const Vector3& position = vertex.position;
+
+			//The earliest kept match, so the result doesn't depend on the hash map's iteration order
+			uint32_t match{ noIndex };
+			for (int64_t z = getCell(position.z - epsilon); z <= getCell(position.z + epsilon); ++z)
+			{
+				for (int64_t y = getCell(position.y - epsilon); y <= getCell(position.y + epsilon); ++y)
+				{
+					for (int64_t x = getCell(position.x - epsilon); x <= getCell(position.x + epsilon); ++x)
+					{
+						const auto it = cellHeads.find(GetCellKey(x, y, z));
+						if (it == cellHeads.end())
+							continue;
+
+						//Newest first, so a later match in the chain is always an earlier vertex
+						for (uint32_t kept = it->second; kept != noIndex; kept = nextInCell[kept])
+						{
+							if (kept < match && IsNear(vertices[kept], vertex, epsilon))
+								match = kept;
+						}
+					}
+				}
+			}
+
+			if (match != noIndex)
+			{
+				remap[i] = match;
+				continue;
+			}
+
+			//Kept vertices are compacted in place, the write never passes the read position
+			vertices[keptCount] = vertex;
+			remap[i] = keptCount;
+
+			const auto [it, isNew] = cellHeads.try_emplace(GetCellKey(getCell(position.x), getCell(position.y), getCell(position.z)), keptCount);
+			nextInCell.push_back(isNew ? noIndex : it->second);
+			it->second = keptCount;
+			++keptCount;
+		}
+
+		vertices.resize(keptCount);
+		for (uint32_t& index : indices)
+		{
+			index = remap[index];
+		}
+	}
+
+	void TransformVertices(std::vector<Vertex>& vertices, const Matrix& transform)
+	{
+		if (vertices.empty())
+			return;
+
+		constexpr size_t stride{ sizeof(Vertex) };
+		transform.TransformPointsStrided(&vertices[0].position, stride, &vertices[0].position, stride, vertices.size());
+		transform.TransformVectorsStrided(&vertices[0].normal, stride, &vertices[0].normal, stride, vertices.size());
+		Vector3* pTangents = reinterpret_cast<Vector3*>(&vertices[0].tangent);
+		transform.TransformVectorsStrided(pTangents, stride, pTangents, stride, vertices.size());
+	}
+}
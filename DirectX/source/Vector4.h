@@ -1,33 +1,121 @@
 #pragma once
+#include <cassert>
+#include <cmath>
+
+#include "Vector2.h"
+#include "Vector3.h"
 
-struct Vector2;
-struct Vector3;
 struct Vector4
 {
-	float x;
-	float y;
-	float z;
-	float w;
+	float x{};
+	float y{};
+	float z{};
+	float w{};
+
+	constexpr Vector4() noexcept = default;
+	constexpr Vector4(float _x, float _y, float _z, float _w) noexcept : x(_x), y(_y), z(_z), w(_w) {}
+	constexpr Vector4(const Vector3& v, float _w) noexcept : x(v.x), y(v.y), z(v.z), w(_w) {}
+
+	float Magnitude() const noexcept
+	{
+		return std::sqrt(x * x + y * y + z * z + w * w);
+	}
+
+	constexpr float SqrMagnitude() const noexcept
+	{
+		return x * x + y * y + z * z + w * w;
+	}
+
+	float Normalize() noexcept
+	{
+		const float m = Magnitude();
+		x /= m;
+		y /= m;
+		z /= m;
+		w /= m;
 
-	Vector4() = default;
-	Vector4(float _x, float _y, float _z, float _w);
-	Vector4(const Vector3& v, float _w);
+		return m;
+	}
 
-	float Magnitude() const;
-	float SqrMagnitude() const;
-	float Normalize();
-	Vector4 Normalized() const;
+	Vector4 Normalized() const noexcept
+	{
+		const float m = Magnitude();
+		return { x / m, y / m, z / m, w / m };
+	}
 
-	Vector2 GetXY() const;
-	Vector3 GetXYZ() const;
+	constexpr Vector2 GetXY() const noexcept
+	{
+		return { x, y };
+	}
 
-	static float Dot(const Vector4& v1, const Vector4& v2);
+	constexpr Vector3 GetXYZ() const noexcept
+	{
+		return { x, y, z };
+	}
 
+	static constexpr float Dot(const Vector4& v1, const Vector4& v2) noexcept
+	{
+		return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w;
+	}
+
+#pragma region Operator Overloads
 	// operator overloading
-	Vector4 operator*(float scale) const;
-	Vector4 operator+(const Vector4& v) const;
-	Vector4 operator-(const Vector4& v) const;
-	Vector4& operator+=(const Vector4& v);
-	float& operator[](int index);
-	float operator[](int index) const;
-};
\ No newline at end of file
+	constexpr Vector4 operator*(float scale) const noexcept
+	{
+		return { x * scale, y * scale, z * scale, w * scale };
+	}
+
+	constexpr Vector4 operator+(const Vector4& v) const noexcept
+	{
+		return { x + v.x, y + v.y, z + v.z, w + v.w };
+	}
+
+	constexpr Vector4 operator-(const Vector4& v) const noexcept
+	{
+		return { x - v.x, y - v.y, z - v.z, w - v.w };
+	}
+
+	constexpr Vector4& operator+=(const Vector4& v) noexcept
+	{
+		x += v.x;
+		y += v.y;
+		z += v.z;
+		w += v.w;
+		return *this;
+	}
+
+	constexpr float& operator[](int index)
+	{
+		assert(index <= 3 && index >= 0);
+
+		if (index == 0)return x;
+		if (index == 1)return y;
+		if (index == 2)return z;
+		return w;
+	}
+
+	constexpr float operator[](int index) const
+	{
+		assert(index <= 3 && index >= 0);
+
+		if (index == 0)return x;
+		if (index == 1)return y;
+		if (index == 2)return z;
+		return w;
+	}
+#pragma endregion
+};
+
+#pragma region Vector3 <-> Vector4
+constexpr Vector3::Vector3(const Vector4& v) noexcept : x(v.x), y(v.y), z(v.z) {}
+
+constexpr Vector4 Vector3::ToPoint4() const noexcept
+{
+	return { x, y, z, 1 };
+}
+
+constexpr Vector4 Vector3::ToVector4() const noexcept
+{
+	return { x, y, z, 0 };
+}
+#pragma endregion
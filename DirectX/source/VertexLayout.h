@@ -0,0 +1,105 @@
+#pragma once
+#include <array>
+#include <span>
+
+#include "DataTypes.h"
+#include "Effect.h"
+
+//D3D11 input layouts generated from the VertexFormat tables at compile time
+namespace VertexLayout
+{
+	constexpr DXGI_FORMAT GetFormat(VertexComponentType type, uint8_t componentCount)
+	{
+		switch (type)
+		{
+		case VertexComponentType::Float32:
+		{
+			constexpr DXGI_FORMAT formats[]{ DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_R32G32_FLOAT, DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32B32A32_FLOAT };
+			return formats[componentCount - 1];
+		}
+		//16-bit formats have no three component version
+		case VertexComponentType::Float16:
+		{
+			constexpr DXGI_FORMAT formats[]{ DXGI_FORMAT_R16_FLOAT, DXGI_FORMAT_R16G16_FLOAT, DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R16G16B16A16_FLOAT };
+			return formats[componentCount - 1];
+		}
+		case VertexComponentType::UNorm16:
+		{
+			constexpr DXGI_FORMAT formats[]{ DXGI_FORMAT_R16_UNORM, DXGI_FORMAT_R16G16_UNORM, DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R16G16B16A16_UNORM };
+			return formats[componentCount - 1];
+		}
+		case VertexComponentType::SNorm16:
+		{
+			constexpr DXGI_FORMAT formats[]{ DXGI_FORMAT_R16_SNORM, DXGI_FORMAT_R16G16_SNORM, DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_R16G16B16A16_SNORM };
+			return formats[componentCount - 1];
+		}
+		}
+		return DXGI_FORMAT_UNKNOWN;
+	}
+
+	//The semantics the VS_INPUT structs in PosCol3D.fx use
+	constexpr const char* GetSemanticName(VertexSemantic semantic)
+	{
+		switch (semantic)
+		{
+		case VertexSemantic::Position: return "POSITION";
+		case VertexSemantic::TexCoord: return "TEXCOORD";
+		case VertexSemantic::Normal: return "NORMAL";
+		case VertexSemantic::Tangent: return "TANGENT";
+		case VertexSemantic::TangentFrame: return "TANGENT";
+		}
+		return nullptr;
+	}
+
+	template<typename VertexType>
+	consteval auto CreateElements()
+	{
+		constexpr auto& attributes = VertexFormat<VertexType>::attributes;
+		std::array<D3D11_INPUT_ELEMENT_DESC, std::size(attributes)> elements{};
+		for (size_t i{ 0 }; i < elements.size(); ++i)
+		{
+			const DXGI_FORMAT format = GetFormat(attributes[i].componentType, attributes[i].componentCount);
+			//Not a constant expression, so a format D3D11 can't read fails to compile here
+			if (format == DXGI_FORMAT_UNKNOWN)
+				throw "vertex attribute without a DXGI format";
+
+			elements[i] = { GetSemanticName(attributes[i].semantic), 0, format, 0, attributes[i].offset, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+		}
+		return elements;
+	}
+
+	//What Mesh binds for one vertex format
+	struct Desc
+	{
+		std::span<const D3D11_INPUT_ELEMENT_DESC> elements{};
+		UINT stride{};
+		Effect::VertexInput vertexInput{};
+	};
+
+	template<typename VertexType>
+	inline constexpr Effect::VertexInput vertexInput{ Effect::VertexInput::Full };
+	template<>
+	inline constexpr Effect::VertexInput vertexInput<PackedVertex>{ Effect::VertexInput::Packed };
+	template<>
+	inline constexpr Effect::VertexInput vertexInput<PositionVertex>{ Effect::VertexInput::PositionOnly };
+
+	template<typename VertexType>
+	inline constexpr auto elements{ CreateElements<VertexType>() };
+
+	template<typename VertexType>
+	inline constexpr Desc desc{ elements<VertexType>, sizeof(VertexType), vertexInput<VertexType> };
+
+	//The desc of the format in VertexFormats with exactly these attributes, nullptr for any other
+	inline const Desc* Find(std::span<const VertexAttribute> attributes)
+	{
+		const Desc* pDesc{ nullptr };
+		VertexFormats::Find([&]<typename VertexType>()
+			{
+				if (!std::ranges::equal(attributes, VertexFormat<VertexType>::attributes))
+					return false;
+				pDesc = &desc<VertexType>;
+				return true;
+			});
+		return pDesc;
+	}
+}
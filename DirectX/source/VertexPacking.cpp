@@ -0,0 +1,411 @@
+#include "pch.h"
+#include "VertexPacking.h"
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+
+#include "SIMD.h"
+
+namespace
+{
+	constexpr float unorm16Max{ 65535.f };
+	constexpr float snorm16Max{ 32767.f };
+	//Smallest w that survives SNORM16 quantization, so its sign (the bitangent sign) does too
+	constexpr float frameBias{ 1.f / snorm16Max };
+	//Shorter normals and tangents count as zero
+	constexpr float minLengthSq{ 1e-20f };
+	constexpr float radiansToDegrees{ 57.2957795f };
+
+	struct Quantization
+	{
+		Vector3 min{};
+		Vector3 scale{};	//steps per unit, 0 for a flat axis
+	};
+
+	Quantization GetQuantization(const AABB& bounds)
+	{
+		const Vector3 range = bounds.extents * 2.f;
+		const auto getScale = [](float axisRange) { return axisRange > 0.f ? unorm16Max / axisRange : 0.f; };
+		return { bounds.GetMin(), { getScale(range.x), getScale(range.y), getScale(range.z) } };
+	}
+
+	//Normal and tangent as the quaternion (x, y, z, w) rotating x to the tangent, y to cross(normal, tangent) and z to the normal,
+	//its w with the sign of tangent.w
+	void EncodeFrame(Vector3 normal, const Vector4& tangent4, float (&frame)[4])
+	{
+		const float normalLengthSq = normal.SqrMagnitude();
+		normal = normalLengthSq >= minLengthSq ? normal / std::sqrt(normalLengthSq) : Vector3::UnitZ;
+
+		const Vector3 tangent = tangent4.GetXYZ();
+		Vector3 t = tangent - normal * Vector3::Dot(normal, tangent);
+		if (t.SqrMagnitude() < minLengthSq)
+		{
+			const Vector3 axis = normal.x * normal.x < 0.81f ? Vector3::UnitX : Vector3::UnitY;
+			t = axis - normal * Vector3::Dot(normal, axis);
+		}
+		t = t / std::sqrt(t.SqrMagnitude());
+		const Vector3 b = Vector3::Cross(normal, t);
+
+		//Shepperd: derive the others from the largest component, the four candidates for 4 * component^2 add up to 4
+		const float m00 = t.x, m10 = t.y, m20 = t.z;
+		const float m01 = b.x, m11 = b.y, m21 = b.z;
+		const float m02 = normal.x, m12 = normal.y, m22 = normal.z;
+		const float tw = 1.f + m00 + m11 + m22, tx = 1.f + m00 - m11 - m22, ty = 1.f - m00 + m11 - m22, tz = 1.f - m00 - m11 + m22;
+		const float tMax = std::max(std::max(tw, tx), std::max(ty, tz));
+		const float big = 0.5f * std::sqrt(tMax);
+		const float s = 0.25f / big;
+
+		float x, y, z, w;
+		if (tw == tMax) { w = big; x = (m21 - m12) * s; y = (m02 - m20) * s; z = (m10 - m01) * s; }
+		else if (tx == tMax) { x = big; w = (m21 - m12) * s; y = (m01 + m10) * s; z = (m02 + m20) * s; }
+		else if (ty == tMax) { y = big; w = (m02 - m20) * s; x = (m01 + m10) * s; z = (m12 + m21) * s; }
+		else { z = big; w = (m10 - m01) * s; x = (m02 + m20) * s; y = (m12 + m21) * s; }
+
+		//q and -q are the same rotation, which frees w's sign for the bitangent sign
+		if (w < 0.f)
+		{
+			x = -x; y = -y; z = -z; w = -w;
+		}
+		w = std::max(w, frameBias);
+		if (tangent4.w < 0.f)
+		{
+			x = -x; y = -y; z = -z; w = -w;
+		}
+		frame[0] = x;
+		frame[1] = y;
+		frame[2] = z;
+		frame[3] = w;
+	}
+
+	inline uint16_t QuantizeUNorm(float steps)
+	{
+		return static_cast<uint16_t>(std::nearbyint(std::clamp(steps, 0.f, unorm16Max)));
+	}
+
+	inline int16_t QuantizeSNorm(float value)
+	{
+		return static_cast<int16_t>(std::nearbyint(std::clamp(value, -1.f, 1.f) * snorm16Max));
+	}
+
+	//Angle between two directions of any length; atan2 stays precise for the tiny angles measured here
+	float GetAngleDegrees(const Vector3& a, const Vector3& b)
+	{
+		return std::atan2(Vector3::Cross(a, b).Magnitude(), Vector3::Dot(a, b)) * radiansToDegrees;
+	}
+
+#if defined(MATH_USE_SSE)
+	using namespace SIMD;
+
+#if defined(__AVX__)
+	using Lane = __m256;
+#else
+	using Lane = __m128;
+#endif
+	constexpr size_t laneWidth{ sizeof(Lane) / sizeof(float) };
+
+#if defined(__F16C__) || defined(__AVX2__)
+	inline void StoreHalfs(uint16_t* pHalfs, __m128 values) { _mm_storel_epi64(reinterpret_cast<__m128i*>(pHalfs), _mm_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT)); }
+#if defined(__AVX__)
+	inline void StoreHalfs(uint16_t* pHalfs, __m256 values) { _mm_storeu_si128(reinterpret_cast<__m128i*>(pHalfs), _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT)); }
+#endif
+#else
+	template<typename V>
+	void StoreHalfs(uint16_t* pHalfs, V values)
+	{
+		float floats[sizeof(V) / sizeof(float)];
+		Store(floats, values);
+		for (size_t lane{ 0 }; lane < sizeof(V) / sizeof(float); ++lane)
+		{
+			pHalfs[lane] = VertexPacking::FloatToHalf(floats[lane]);
+		}
+	}
+#endif
+
+	//EncodeFrame and the position quantization for laneWidth vertices. The vertices are transposed into one row per
+	//float first; count < laneWidth repeats the last vertex in the unused lanes.
+	void EncodeLanes(const Vertex* pVertices, size_t count, const Quantization& quantization, PackedVertex* pPacked)
+	{
+		enum Row { PX, PY, PZ, U, V, NX, NY, NZ, TX, TY, TZ, TW, RowCount };
+		alignas(32) float rows[RowCount][laneWidth];
+		for (size_t lane{ 0 }; lane < laneWidth; ++lane)
+		{
+			const Vertex& vertex = pVertices[std::min(lane, count - 1)];
+			rows[PX][lane] = vertex.position.x; rows[PY][lane] = vertex.position.y; rows[PZ][lane] = vertex.position.z;
+			rows[U][lane] = vertex.uv.x; rows[V][lane] = vertex.uv.y;
+			rows[NX][lane] = vertex.normal.x; rows[NY][lane] = vertex.normal.y; rows[NZ][lane] = vertex.normal.z;
+			rows[TX][lane] = vertex.tangent.x; rows[TY][lane] = vertex.tangent.y; rows[TZ][lane] = vertex.tangent.z; rows[TW][lane] = vertex.tangent.w;
+		}
+
+		const Lane zero = Broadcast<Lane>(0.f), one = Broadcast<Lane>(1.f);
+
+		alignas(32) float positions[3][laneWidth];
+		const float min[3]{ quantization.min.x, quantization.min.y, quantization.min.z };
+		const float scale[3]{ quantization.scale.x, quantization.scale.y, quantization.scale.z };
+		for (int axis{ 0 }; axis < 3; ++axis)
+		{
+			const Lane steps = Mul(Sub(Load<Lane>(rows[PX + axis]), Broadcast<Lane>(min[axis])), Broadcast<Lane>(scale[axis]));
+			Store(positions[axis], Round(Min(Max(steps, zero), Broadcast<Lane>(unorm16Max))));
+		}
+
+		alignas(16) uint16_t us[laneWidth], vs[laneWidth];
+		StoreHalfs(us, Load<Lane>(rows[U]));
+		StoreHalfs(vs, Load<Lane>(rows[V]));
+
+		//Normal, or +z when it is zero
+		Lane nx = Load<Lane>(rows[NX]), ny = Load<Lane>(rows[NY]), nz = Load<Lane>(rows[NZ]);
+		{
+			const Lane lengthSq = MulAdd(nx, nx, MulAdd(ny, ny, Mul(nz, nz)));
+			const Lane isValid = GreaterEqual(lengthSq, Broadcast<Lane>(minLengthSq));
+			const Lane invLength = Div(one, Sqrt(Max(lengthSq, Broadcast<Lane>(minLengthSq))));
+			nx = Select(isValid, Mul(nx, invLength), zero);
+			ny = Select(isValid, Mul(ny, invLength), zero);
+			nz = Select(isValid, Mul(nz, invLength), one);
+		}
+
+		//Tangent with the normal rejected, or x (y when the normal is close to x) with the normal rejected
+		Lane tx, ty, tz;
+		{
+			const Lane tangentX = Load<Lane>(rows[TX]), tangentY = Load<Lane>(rows[TY]), tangentZ = Load<Lane>(rows[TZ]);
+			const Lane dot = MulAdd(nx, tangentX, MulAdd(ny, tangentY, Mul(nz, tangentZ)));
+			tx = Sub(tangentX, Mul(nx, dot));
+			ty = Sub(tangentY, Mul(ny, dot));
+			tz = Sub(tangentZ, Mul(nz, dot));
+
+			const Lane useX = Less(Mul(nx, nx), Broadcast<Lane>(0.81f));
+			const Lane axisX = Select(useX, one, zero), axisY = Select(useX, zero, one);
+			const Lane axisDot = Select(useX, nx, ny);
+			const Lane isValid = GreaterEqual(MulAdd(tx, tx, MulAdd(ty, ty, Mul(tz, tz))), Broadcast<Lane>(minLengthSq));
+			tx = Select(isValid, tx, Sub(axisX, Mul(nx, axisDot)));
+			ty = Select(isValid, ty, Sub(axisY, Mul(ny, axisDot)));
+			tz = Select(isValid, tz, Sub(zero, Mul(nz, axisDot)));
+
+			const Lane invLength = Div(one, Sqrt(MulAdd(tx, tx, MulAdd(ty, ty, Mul(tz, tz)))));
+			tx = Mul(tx, invLength);
+			ty = Mul(ty, invLength);
+			tz = Mul(tz, invLength);
+		}
+
+		const Lane bx = Sub(Mul(ny, tz), Mul(nz, ty));
+		const Lane by = Sub(Mul(nz, tx), Mul(nx, tz));
+		const Lane bz = Sub(Mul(nx, ty), Mul(ny, tx));
+
+		//Shepperd as in EncodeFrame, every case computed and the one with the largest diagonal term selected
+		const Lane m00 = tx, m10 = ty, m20 = tz, m01 = bx, m11 = by, m21 = bz, m02 = nx, m12 = ny, m22 = nz;
+		const Lane tw = Add(Add(one, m00), Add(m11, m22));
+		const Lane tX = Sub(Add(one, m00), Add(m11, m22));
+		const Lane tY = Sub(Add(one, m11), Add(m00, m22));
+		const Lane tZ = Sub(Add(one, m22), Add(m00, m11));
+		const Lane tMax = Max(Max(tw, tX), Max(tY, tZ));
+		const Lane big = Mul(Broadcast<Lane>(0.5f), Sqrt(tMax));
+		const Lane s = Div(Broadcast<Lane>(0.25f), big);
+
+		const Lane a = Mul(Sub(m21, m12), s), b = Mul(Sub(m02, m20), s), c = Mul(Sub(m10, m01), s);
+		const Lane d = Mul(Add(m01, m10), s), e = Mul(Add(m02, m20), s), f = Mul(Add(m12, m21), s);
+		const Lane isW = Equal(tw, tMax), isX = Equal(tX, tMax), isY = Equal(tY, tMax);
+		Lane qw = Select(isW, big, Select(isX, a, Select(isY, b, c)));
+		Lane qx = Select(isW, a, Select(isX, big, Select(isY, d, e)));
+		Lane qy = Select(isW, b, Select(isX, d, Select(isY, big, f)));
+		Lane qz = Select(isW, c, Select(isX, e, Select(isY, f, big)));
+
+		const Lane flip = And(Less(qw, zero), Broadcast<Lane>(-0.f));
+		qx = Xor(qx, flip);
+		qy = Xor(qy, flip);
+		qz = Xor(qz, flip);
+		qw = Max(Xor(qw, flip), Broadcast<Lane>(frameBias));
+
+		const Lane sign = And(Less(Load<Lane>(rows[TW]), zero), Broadcast<Lane>(-0.f));
+		qx = Xor(qx, sign);
+		qy = Xor(qy, sign);
+		qz = Xor(qz, sign);
+		qw = Xor(qw, sign);
+
+		alignas(32) float frames[4][laneWidth];
+		const Lane snormScale = Broadcast<Lane>(snorm16Max);
+		Store(frames[0], Round(Mul(qx, snormScale)));
+		Store(frames[1], Round(Mul(qy, snormScale)));
+		Store(frames[2], Round(Mul(qz, snormScale)));
+		Store(frames[3], Round(Mul(qw, snormScale)));
+
+		for (size_t lane{ 0 }; lane < count; ++lane)
+		{
+			PackedVertex& packed = pPacked[lane];
+			packed.position[0] = static_cast<uint16_t>(positions[0][lane]);
+			packed.position[1] = static_cast<uint16_t>(positions[1][lane]);
+			packed.position[2] = static_cast<uint16_t>(positions[2][lane]);
+			packed.position[3] = 0;
+			packed.uv[0] = us[lane];
+			packed.uv[1] = vs[lane];
+			for (int component{ 0 }; component < 4; ++component)
+			{
+				packed.frame[component] = static_cast<int16_t>(frames[component][lane]);
+			}
+		}
+	}
+#endif
+}
+
+namespace VertexPacking
+{
+	PackingError GetErrorBound(const AABB& bounds, float maxUV)
+	{
+		const Vector3 min = bounds.GetMin(), max = bounds.GetMax();
+		const float maxRange = 2.f * std::max({ bounds.extents.x, bounds.extents.y, bounds.extents.z });
+		const float maxCoordinate = std::max({ std::abs(min.x), std::abs(min.y), std::abs(min.z), std::abs(max.x), std::abs(max.y), std::abs(max.z) });
+
+		PackingError bound{};
+		//Half a step, plus the float rounding of the dequantization
+		bound.position = 0.5f * maxRange / unorm16Max + 4.f * FLT_EPSILON * maxCoordinate;
+		//Halfs keep 11 significant bits, below 2^-14 they have a fixed step of 2^-24
+		bound.uv = std::max(maxUV * 0x1p-11f, 0x1p-25f);
+		//Each quaternion component is off by half a step and w by up to frameBias, which rotates a direction by at most
+		//twice the length of that error
+		const float frameError = std::sqrt(4.f) * 0.5f / snorm16Max + frameBias;
+		bound.normalDegrees = 2.f * frameError * radiansToDegrees;
+		bound.tangentDegrees = bound.normalDegrees;
+		return bound;
+	}
+
+	void Encode(std::span<const Vertex> vertices, const AABB& bounds, std::span<PackedVertex> packed)
+	{
+#if defined(MATH_USE_SSE)
+		const Quantization quantization = GetQuantization(bounds);
+		const size_t count = std::min(vertices.size(), packed.size());
+		for (size_t i{ 0 }; i < count; i += laneWidth)
+		{
+			EncodeLanes(vertices.data() + i, std::min(laneWidth, count - i), quantization, packed.data() + i);
+		}
+#else
+		EncodeScalar(vertices, bounds, packed);
+#endif
+	}
+
+	void EncodeScalar(std::span<const Vertex> vertices, const AABB& bounds, std::span<PackedVertex> packed)
+	{
+		const Quantization quantization = GetQuantization(bounds);
+		const size_t count = std::min(vertices.size(), packed.size());
+		for (size_t i{ 0 }; i < count; ++i)
+		{
+			const Vertex& vertex = vertices[i];
+			PackedVertex& packedVertex = packed[i];
+
+			packedVertex.position[0] = QuantizeUNorm((vertex.position.x - quantization.min.x) * quantization.scale.x);
+			packedVertex.position[1] = QuantizeUNorm((vertex.position.y - quantization.min.y) * quantization.scale.y);
+			packedVertex.position[2] = QuantizeUNorm((vertex.position.z - quantization.min.z) * quantization.scale.z);
+			packedVertex.position[3] = 0;
+			packedVertex.uv[0] = FloatToHalf(vertex.uv.x);
+			packedVertex.uv[1] = FloatToHalf(vertex.uv.y);
+
+			float frame[4];
+			EncodeFrame(vertex.normal, vertex.tangent, frame);
+			for (int component{ 0 }; component < 4; ++component)
+			{
+				packedVertex.frame[component] = QuantizeSNorm(frame[component]);
+			}
+		}
+	}
+
+	void Decode(std::span<const PackedVertex> packed, const AABB& bounds, std::span<Vertex> vertices)
+	{
+		const Vector3 min = bounds.GetMin();
+		const Vector3 range = bounds.extents * 2.f;
+		const size_t count = std::min(vertices.size(), packed.size());
+		for (size_t i{ 0 }; i < count; ++i)
+		{
+			const PackedVertex& packedVertex = packed[i];
+			Vertex& vertex = vertices[i];
+
+			vertex.position.x = min.x + range.x * (packedVertex.position[0] / unorm16Max);
+			vertex.position.y = min.y + range.y * (packedVertex.position[1] / unorm16Max);
+			vertex.position.z = min.z + range.z * (packedVertex.position[2] / unorm16Max);
+			vertex.uv = { HalfToFloat(packedVertex.uv[0]), HalfToFloat(packedVertex.uv[1]) };
+
+			//SNORM: -32768 reads as -1 like -32767
+			float q[4];
+			for (int component{ 0 }; component < 4; ++component)
+			{
+				q[component] = std::max(packedVertex.frame[component] / snorm16Max, -1.f);
+			}
+			const float invLength = 1.f / std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+			const float x = q[0] * invLength, y = q[1] * invLength, z = q[2] * invLength, w = q[3] * invLength;
+
+			//The rotated x and z axes, and w's sign as the bitangent sign
+			vertex.tangent = { 1.f - 2.f * (y * y + z * z), 2.f * (x * y + w * z), 2.f * (x * z - w * y), w < 0.f ? -1.f : 1.f };
+			vertex.normal = { 2.f * (x * z + w * y), 2.f * (y * z - w * x), 1.f - 2.f * (x * x + y * y) };
+		}
+	}
+
+	PackingError MeasureError(std::span<const Vertex> original, std::span<const Vertex> decoded)
+	{
+		PackingError error{};
+		const size_t count = std::min(original.size(), decoded.size());
+		for (size_t i{ 0 }; i < count; ++i)
+		{
+			const Vertex& a = original[i];
+			const Vertex& b = decoded[i];
+
+			error.position = std::max({ error.position, std::abs(a.position.x - b.position.x), std::abs(a.position.y - b.position.y), std::abs(a.position.z - b.position.z) });
+			error.uv = std::max({ error.uv, std::abs(a.uv.x - b.uv.x), std::abs(a.uv.y - b.uv.y) });
+			error.normalDegrees = std::max(error.normalDegrees, GetAngleDegrees(a.normal, b.normal));
+			if (a.tangent.GetXYZ().SqrMagnitude() >= minLengthSq)
+			{
+				//A lost bitangent sign mirrors the normal map, count it as the worst error there is
+				const bool isSameSign = (a.tangent.w < 0.f) == (b.tangent.w < 0.f);
+				error.tangentDegrees = std::max(error.tangentDegrees, isSameSign ? GetAngleDegrees(a.tangent.GetXYZ(), b.tangent.GetXYZ()) : 180.f);
+			}
+		}
+		return error;
+	}
+
+	//Bit tricks after Fabian Giesen's float_to_half_fast3_rtne and half_to_float
+	uint16_t FloatToHalf(float value)
+	{
+		constexpr uint32_t infinity{ 255u << 23 };
+		constexpr uint32_t halfOverflow{ (127u + 16u) << 23 };	//65536, the first float that is infinite as a half
+		constexpr uint32_t subnormalMagic{ ((127u - 15u) + (23u - 10u) + 1u) << 23 };
+
+		uint32_t bits = std::bit_cast<uint32_t>(value);
+		const uint32_t sign = bits & 0x80000000u;
+		bits ^= sign;
+
+		uint32_t half;
+		if (bits >= halfOverflow)
+		{
+			half = bits > infinity ? 0x7E00u : 0x7C00u;
+		}
+		else if (bits < (113u << 23))
+		{
+			//Below the smallest normal half: the float addition does the rounding
+			half = std::bit_cast<uint32_t>(std::bit_cast<float>(bits) + std::bit_cast<float>(subnormalMagic)) - subnormalMagic;
+		}
+		else
+		{
+			const uint32_t isMantissaOdd = (bits >> 13) & 1u;
+			bits += ((15u - 127u) << 23) + 0xFFFu;
+			bits += isMantissaOdd;
+			half = bits >> 13;
+		}
+		return static_cast<uint16_t>(half | (sign >> 16));
+	}
+
+	float HalfToFloat(uint16_t half)
+	{
+		constexpr uint32_t subnormalMagic{ 113u << 23 };
+		constexpr uint32_t exponentMask{ 0x7C00u << 13 };
+
+		uint32_t bits = (half & 0x7FFFu) << 13;
+		const uint32_t exponent = bits & exponentMask;
+		bits += (127u - 15u) << 23;
+		if (exponent == exponentMask)
+		{
+			bits += (128u - 16u) << 23;	//infinity and NaN
+		}
+		else if (exponent == 0)
+		{
+			bits += 1u << 23;
+			bits = std::bit_cast<uint32_t>(std::bit_cast<float>(bits) - std::bit_cast<float>(subnormalMagic));
+		}
+		return std::bit_cast<float>(bits | (uint32_t(half & 0x8000u) << 16));
+	}
+}
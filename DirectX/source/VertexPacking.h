@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+#include "DataTypes.h"
+
+//Conversion between Vertex and the 20-byte PackedVertex (VertexPacking.cpp)
+namespace VertexPacking
+{
+	//Largest difference between vertices and their packed and decoded versions
+	struct PackingError
+	{
+		float position{};		//per axis, in mesh units
+		float uv{};
+		float normalDegrees{};
+		float tangentDegrees{};
+	};
+
+	//What the encoding may cost at most for a mesh with these bounds and uvs up to maxUV in magnitude
+	PackingError GetErrorBound(const AABB& bounds, float maxUV);
+
+	//Positions are quantized inside bounds, which have to contain them (the bounds of the source mesh).
+	//Tangents are orthogonalized against the normal first; a zero tangent gets an arbitrary perpendicular one.
+	//The quaternion's w carries the sign of tangent.w.
+	//Runs 8 (AVX) or 4 (SSE) vertices at a time.
+	void Encode(std::span<const Vertex> vertices, const AABB& bounds, std::span<PackedVertex> packed);
+	//One vertex at a time, the reference Encode is checked against. Both agree to within one step of the packed integers.
+	void EncodeScalar(std::span<const Vertex> vertices, const AABB& bounds, std::span<PackedVertex> packed);
+
+	//The same math as the VS_Packed vertex shader, to validate packed meshes on the CPU
+	void Decode(std::span<const PackedVertex> packed, const AABB& bounds, std::span<Vertex> vertices);
+
+	//Tangents that are zero in original are skipped
+	PackingError MeasureError(std::span<const Vertex> original, std::span<const Vertex> decoded);
+
+	//IEEE half precision, rounded to nearest even
+	uint16_t FloatToHalf(float value);
+	float HalfToFloat(uint16_t half);
+}
@@ -0,0 +1,407 @@
+#include "pch.h"
+#include "Zlib.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	//Reads the stream's bits least significant first (RFC 1951 3.1.1) from a 64-bit buffer.
+	//Past the end it shifts in zeros and counts them, so a truncated stream fails in IsOverrun instead of reading out of bounds.
+	class BitReader final
+	{
+	public:
+		BitReader(const uint8_t* pData, size_t size)
+			: m_pNext{ pData }, m_pEnd{ pData + size }
+		{
+		}
+
+		//At least 56 bits in the buffer afterwards
+		void Refill()
+		{
+			if (m_pEnd - m_pNext >= 8)
+			{
+				uint64_t word;
+				std::memcpy(&word, m_pNext, sizeof(word));
+				m_Bits |= word << m_BitCount;
+				m_pNext += (63 - m_BitCount) >> 3;
+				m_BitCount |= 56;
+				return;
+			}
+
+			while (m_BitCount <= 56)
+			{
+				if (m_pNext < m_pEnd)
+					m_Bits |= uint64_t(*m_pNext++) << m_BitCount;
+				else
+					++m_PaddingBytes;
+				m_BitCount += 8;
+			}
+		}
+
+		uint32_t Peek(uint32_t count) const { return static_cast<uint32_t>(m_Bits & ((1ull << count) - 1)); }
+		void Consume(uint32_t count) { m_Bits >>= count; m_BitCount -= count; }
+
+		uint32_t Read(uint32_t count)
+		{
+			const uint32_t value = Peek(count);
+			Consume(count);
+			return value;
+		}
+
+		//Stored blocks start at a byte boundary
+		void AlignToByte() { Consume(m_BitCount & 7); }
+
+		//Copies whole bytes, first from the bit buffer, then straight from the input
+		bool ReadBytes(uint8_t* pOutput, size_t count)
+		{
+			while (count > 0 && m_BitCount >= 8)
+			{
+				*pOutput++ = static_cast<uint8_t>(Read(8));
+				--count;
+			}
+			if (count > static_cast<size_t>(m_pEnd - m_pNext))
+				return false;
+
+			std::memcpy(pOutput, m_pNext, count);
+			m_pNext += count;
+			return true;
+		}
+
+		//Whether more bits were consumed than the input has
+		bool IsOverrun() const { return m_PaddingBytes * 8 > m_BitCount; }
+
+	private:
+		const uint8_t* m_pNext;
+		const uint8_t* m_pEnd;
+		uint64_t m_Bits{};
+		uint32_t m_BitCount{};
+		size_t m_PaddingBytes{};
+	};
+
+	constexpr uint32_t maxCodeLength{ 15 };
+	constexpr uint32_t fastBits{ 10 };
+
+	//Canonical Huffman decoding: codes up to fastBits long are a single table lookup, longer ones are found by
+	//comparing against the first code of every length (the scheme stb_image and zlib's inflate_fast use)
+	struct HuffmanTable
+	{
+		uint16_t fast[1 << fastBits];		//length << 9 | symbol, 0 for codes longer than fastBits
+		uint32_t firstCode[maxCodeLength + 1];
+		uint32_t firstSymbol[maxCodeLength + 1];
+		uint32_t maxCode[maxCodeLength + 2];	//first code of the next length, left aligned to 16 bits
+		uint16_t symbols[288];				//in canonical order
+	};
+
+	inline uint32_t ReverseBits(uint32_t value, uint32_t count)
+	{
+		uint32_t reversed{ 0 };
+		for (uint32_t i{ 0 }; i < count; ++i)
+		{
+			reversed = reversed << 1 | (value & 1);
+			value >>= 1;
+		}
+		return reversed;
+	}
+
+	//False for over-subscribed length sets. Incomplete ones are valid (a distance code with a single symbol).
+	bool BuildTable(HuffmanTable& table, const uint8_t* pLengths, uint32_t count)
+	{
+		uint32_t lengthCounts[maxCodeLength + 1]{};
+		for (uint32_t i{ 0 }; i < count; ++i)
+		{
+			++lengthCounts[pLengths[i]];
+		}
+		lengthCounts[0] = 0;
+
+		std::memset(table.fast, 0, sizeof(table.fast));
+		uint32_t nextCode[maxCodeLength + 1]{};
+		uint32_t code{ 0 }, symbol{ 0 };
+		for (uint32_t length{ 1 }; length <= maxCodeLength; ++length)
+		{
+			nextCode[length] = code;
+			table.firstCode[length] = code;
+			table.firstSymbol[length] = symbol;
+			code += lengthCounts[length];
+			if (lengthCounts[length] != 0 && code - 1 >= (1u << length))
+				return false;
+			table.maxCode[length] = code << (16 - length);
+			code <<= 1;
+			symbol += lengthCounts[length];
+		}
+		table.maxCode[maxCodeLength + 1] = 1u << 16;
+
+		for (uint32_t i{ 0 }; i < count; ++i)
+		{
+			const uint32_t length = pLengths[i];
+			if (length == 0)
+				continue;
+
+			const uint32_t canonical = nextCode[length] - table.firstCode[length] + table.firstSymbol[length];
+			table.symbols[canonical] = static_cast<uint16_t>(i);
+			if (length <= fastBits)
+			{
+				const uint16_t entry = static_cast<uint16_t>(length << 9 | i);
+				for (uint32_t j = ReverseBits(nextCode[length], length); j < (1u << fastBits); j += 1u << length)
+				{
+					table.fast[j] = entry;
+				}
+			}
+			++nextCode[length];
+		}
+		return true;
+	}
+
+	//Expects a refilled reader. Returns UINT32_MAX for bits that are no code.
+	inline uint32_t Decode(BitReader& reader, const HuffmanTable& table)
+	{
+		const uint16_t entry = table.fast[reader.Peek(fastBits)];
+		if (entry != 0)
+		{
+			reader.Consume(entry >> 9);
+			return entry & 511;
+		}
+
+		const uint32_t code = ReverseBits(reader.Peek(16), 16);
+		uint32_t length{ fastBits + 1 };
+		while (code >= table.maxCode[length])
+			++length;
+		if (length > maxCodeLength)
+			return UINT32_MAX;
+
+		reader.Consume(length);
+		return table.symbols[(code >> (16 - length)) - table.firstCode[length] + table.firstSymbol[length]];
+	}
+
+	constexpr uint16_t lengthBases[29]{ 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	constexpr uint8_t lengthExtraBits[29]{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	constexpr uint16_t distanceBases[30]{ 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+		4097, 6145, 8193, 12289, 16385, 24577 };
+	constexpr uint8_t distanceExtraBits[30]{ 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	struct FixedTables
+	{
+		HuffmanTable literals{};
+		HuffmanTable distances{};
+
+		FixedTables()
+		{
+			uint8_t lengths[288];
+			std::fill(lengths, lengths + 144, uint8_t{ 8 });
+			std::fill(lengths + 144, lengths + 256, uint8_t{ 9 });
+			std::fill(lengths + 256, lengths + 280, uint8_t{ 7 });
+			std::fill(lengths + 280, lengths + 288, uint8_t{ 8 });
+			BuildTable(literals, lengths, 288);
+
+			std::fill(lengths, lengths + 30, uint8_t{ 5 });
+			BuildTable(distances, lengths, 30);
+		}
+	};
+
+	const FixedTables& GetFixedTables()
+	{
+		static const FixedTables tables{};
+		return tables;
+	}
+
+	bool ReadDynamicTables(BitReader& reader, HuffmanTable& literals, HuffmanTable& distances)
+	{
+		reader.Refill();
+		const uint32_t literalCount = reader.Read(5) + 257;
+		const uint32_t distanceCount = reader.Read(5) + 1;
+		const uint32_t codeLengthCount = reader.Read(4) + 4;
+		if (literalCount > 286 || distanceCount > 30)
+			return false;
+
+		constexpr uint8_t codeLengthOrder[19]{ 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+		uint8_t codeLengthLengths[19]{};
+		for (uint32_t i{ 0 }; i < codeLengthCount; ++i)
+		{
+			reader.Refill();
+			codeLengthLengths[codeLengthOrder[i]] = static_cast<uint8_t>(reader.Read(3));
+		}
+
+		HuffmanTable codeLengths;
+		if (!BuildTable(codeLengths, codeLengthLengths, 19))
+			return false;
+
+		//Literal/length and distance code lengths are one sequence, repeats may cross from one into the other
+		uint8_t lengths[286 + 30]{};
+		const uint32_t totalCount = literalCount + distanceCount;
+		for (uint32_t i{ 0 }; i < totalCount; )
+		{
+			reader.Refill();
+			const uint32_t symbol = Decode(reader, codeLengths);
+			if (symbol < 16)
+			{
+				lengths[i++] = static_cast<uint8_t>(symbol);
+				continue;
+			}
+
+			uint8_t value{ 0 };
+			uint32_t repeat;
+			if (symbol == 16)
+			{
+				if (i == 0)
+					return false;
+				value = lengths[i - 1];
+				repeat = 3 + reader.Read(2);
+			}
+			else if (symbol == 17)
+			{
+				repeat = 3 + reader.Read(3);
+			}
+			else if (symbol == 18)
+			{
+				repeat = 11 + reader.Read(7);
+			}
+			else
+			{
+				return false;
+			}
+
+			if (repeat > totalCount - i)
+				return false;
+			std::fill_n(lengths + i, repeat, value);
+			i += repeat;
+		}
+
+		//A block without an end-of-block code could never finish
+		return lengths[256] != 0 && BuildTable(literals, lengths, literalCount) && BuildTable(distances, lengths + literalCount, distanceCount);
+	}
+
+	//Literals and matches until the end-of-block code
+	bool InflateBlock(BitReader& reader, const HuffmanTable& literals, const HuffmanTable& distances, uint8_t* const pBegin, uint8_t*& pOutput, uint8_t* const pEnd)
+	{
+		while (true)
+		{
+			//56 bits cover the longest literal/length code and extra bits plus the longest distance code and extra bits (48)
+			reader.Refill();
+			uint32_t symbol = Decode(reader, literals);
+			if (symbol < 256)
+			{
+				if (pOutput == pEnd)
+					return false;
+				*pOutput++ = static_cast<uint8_t>(symbol);
+				continue;
+			}
+			if (symbol == 256)
+				return !reader.IsOverrun();
+
+			symbol -= 257;
+			if (symbol >= 29)
+				return false;
+			const uint32_t length = lengthBases[symbol] + reader.Read(lengthExtraBits[symbol]);
+
+			const uint32_t distanceSymbol = Decode(reader, distances);
+			if (distanceSymbol >= 30)
+				return false;
+			const uint32_t distance = distanceBases[distanceSymbol] + reader.Read(distanceExtraBits[distanceSymbol]);
+
+			if (distance > static_cast<size_t>(pOutput - pBegin) || length > static_cast<size_t>(pEnd - pOutput))
+				return false;
+
+			const uint8_t* pSource = pOutput - distance;
+			if (distance >= 8 && static_cast<size_t>(pEnd - pOutput) >= length + 8)
+			{
+				//8 bytes at a time: the chunks never overlap their source, and overshooting the match is fine with room left
+				for (uint32_t i{ 0 }; i < length; i += 8)
+				{
+					std::memcpy(pOutput + i, pSource + i, 8);
+				}
+			}
+			else if (distance == 1)
+			{
+				std::memset(pOutput, *pSource, length);
+			}
+			else
+			{
+				for (uint32_t i{ 0 }; i < length; ++i)
+				{
+					pOutput[i] = pSource[i];
+				}
+			}
+			pOutput += length;
+		}
+	}
+}
+
+namespace Zlib
+{
+	bool Inflate(std::span<const uint8_t> input, std::span<uint8_t> output)
+	{
+		//CMF: deflate with a window up to 32 KB, FLG: header check and no preset dictionary. The deflate data runs up to the
+		//4 byte Adler-32 trailer, FBX stores every array's stream with its exact size.
+		if (input.size() < 6)
+			return false;
+		const uint8_t cmf = input[0], flg = input[1];
+		if ((cmf & 15) != 8 || (cmf >> 4) > 7 || (cmf * 256u + flg) % 31 != 0 || (flg & 32) != 0)
+			return false;
+
+		BitReader reader{ input.data() + 2, input.size() - 6 };
+		uint8_t* const pBegin = output.data();
+		uint8_t* const pEnd = pBegin + output.size();
+		uint8_t* pOutput = pBegin;
+
+		HuffmanTable literals, distances;
+		bool isLastBlock{ false };
+		while (!isLastBlock)
+		{
+			reader.Refill();
+			isLastBlock = reader.Read(1) != 0;
+			switch (reader.Read(2))
+			{
+			case 0:
+			{
+				reader.AlignToByte();
+				const uint32_t length = reader.Read(16);
+				if ((length ^ reader.Read(16)) != 0xFFFF || length > static_cast<size_t>(pEnd - pOutput) || !reader.ReadBytes(pOutput, length))
+					return false;
+				pOutput += length;
+				break;
+			}
+			case 1:
+				if (!InflateBlock(reader, GetFixedTables().literals, GetFixedTables().distances, pBegin, pOutput, pEnd))
+					return false;
+				break;
+			case 2:
+				if (!ReadDynamicTables(reader, literals, distances) || !InflateBlock(reader, literals, distances, pBegin, pOutput, pEnd))
+					return false;
+				break;
+			default:
+				return false;
+			}
+		}
+
+		if (pOutput != pEnd || reader.IsOverrun())
+			return false;
+
+		//Big endian, after the last block
+		const uint8_t* const pTrailer = input.data() + input.size() - 4;
+		const uint32_t expected = uint32_t(pTrailer[0]) << 24 | uint32_t(pTrailer[1]) << 16 | uint32_t(pTrailer[2]) << 8 | pTrailer[3];
+		return Adler32(output) == expected;
+	}
+
+	uint32_t Adler32(std::span<const uint8_t> data, uint32_t adler)
+	{
+		//5552 bytes is the most that can be summed before b could overflow 32 bits
+		constexpr uint32_t modulus{ 65521 }, blockSize{ 5552 };
+		uint32_t a = adler & 0xFFFF, b = adler >> 16;
+		const uint8_t* p = data.data();
+		size_t remaining = data.size();
+		while (remaining > 0)
+		{
+			const size_t count = std::min<size_t>(remaining, blockSize);
+			for (size_t i{ 0 }; i < count; ++i)
+			{
+				a += p[i];
+				b += a;
+			}
+			a %= modulus;
+			b %= modulus;
+			p += count;
+			remaining -= count;
+		}
+		return b << 16 | a;
+	}
+}
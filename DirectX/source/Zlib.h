@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+//Decompression of zlib streams (RFC 1950 around RFC 1951 deflate), the encoding binary FBX uses for its arrays (Zlib.cpp)
+namespace Zlib
+{
+	//Inflates input into exactly output.size() bytes and checks the stream's Adler-32.
+	//False for malformed streams, preset dictionaries and output of any other size.
+	bool Inflate(std::span<const uint8_t> input, std::span<uint8_t> output);
+
+	uint32_t Adler32(std::span<const uint8_t> data, uint32_t adler = 1);
+}
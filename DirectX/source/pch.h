@@ -8,6 +8,7 @@
 #include <vector>
 #define NOMINMAX  //for directx
 
+#if defined(_WIN32)
 // SDL Headers
 #include "SDL.h"
 #include "SDL_syswm.h"
@@ -19,6 +20,7 @@
 #include <d3d11.h>
 #include <d3dcompiler.h>
 #include <d3dx11effect.h>
+#endif // _WIN32 - the math/asset code also builds on its own for the portable benchmarks
 
 // Framework Headers
 #include "Timer.h"